@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace netcopy {
+namespace bench {
+
+// One measured scenario. Throughput is derived from bytes/seconds so results
+// from different commits can be compared directly.
+struct BenchResult {
+    std::string suite;          // "micro", "loopback" or "wan"
+    std::string name;           // e.g. "cipher.chacha20_poly1305.encrypt"
+    uint64_t iterations = 0;
+    uint64_t bytes = 0;         // Total payload bytes processed across all iterations
+    double seconds = 0.0;       // Best (minimum) wall time over the repetitions
+    double mean_seconds = 0.0;  // Mean wall time over the repetitions
+    bool ok = true;
+    std::string error;
+
+    double throughput_mib_s() const;
+    double ops_per_second() const;
+};
+
+struct BenchOptions {
+    std::string suite = "all";      // micro | loopback | wan | all
+    std::string filter;             // substring match on result name
+    int repetitions = 3;
+    uint64_t buffer_size = 4ull * 1024ull * 1024ull;
+    uint64_t large_file_size = 512ull * 1024ull * 1024ull;
+    uint32_t small_file_count = 100000;
+    uint32_t small_file_size = 4096;
+    uint32_t parallel_streams = 4;
+    uint64_t wan_file_size = 256ull * 1024ull * 1024ull;
+    // "label:profile" entries for the WAN suite, see network::LinkProfile::parse
+    std::vector<std::string> link_profiles = {
+        "rtt1ms:rtt=1ms",
+        "rtt150ms:rtt=150ms,jitter=2ms,loss=0.1%,seed=1",
+    };
+    uint16_t port = 0;              // 0 = pick a free loopback port
+    std::string work_dir;           // empty = temp directory
+    std::string output_file;        // empty = stdout
+    bool keep_files = false;
+};
+
+class BenchReport {
+public:
+    void add(BenchResult result);
+    const std::vector<BenchResult>& results() const { return results_; }
+
+    // Machine-readable report: {"meta":{...},"results":[...]}
+    std::string to_json(const BenchOptions& options) const;
+    // Human-readable table for the console
+    std::string to_table() const;
+
+private:
+    std::vector<BenchResult> results_;
+};
+
+// Runs `body` `repetitions` times (after one warm-up call unless disabled) and
+// records the best and mean wall time. `setup`, when given, runs untimed before
+// every call of `body`. Exceptions are captured into the result.
+BenchResult measure(const std::string& suite,
+                    const std::string& name,
+                    uint64_t iterations,
+                    uint64_t bytes,
+                    int repetitions,
+                    const std::function<void()>& body,
+                    bool warm_up = true,
+                    const std::function<void()>& setup = {});
+
+bool matches_filter(const BenchOptions& options, const std::string& name);
+
+void run_micro_benchmarks(const BenchOptions& options, BenchReport& report);
+void run_loopback_benchmarks(const BenchOptions& options, BenchReport& report);
+// Loopback uploads through network::LinkEmulator, once per link profile and
+// stream count, to compare window and stream behaviour across RTTs.
+void run_wan_benchmarks(const BenchOptions& options, BenchReport& report);
+
+} // namespace bench
+} // namespace netcopy
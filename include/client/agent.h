@@ -0,0 +1,112 @@
+#pragma once
+
+#include "client/client.h"
+#include "client/connection_pool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace netcopy {
+namespace client {
+
+// One CLI transfer. Requests handed to the agent carry absolute paths,
+// since the agent runs in its own working directory.
+struct TransferRequest {
+    // The agent loads this file, then applies the overrides below
+    std::string config_file;
+    bool create_empty_directories = true;
+    bool auto_create_directories = true;
+    std::string secret_key;
+    std::string password;
+
+    std::string host;
+    uint16_t port = 0;
+    crypto::SecurityLevel security_level = crypto::SecurityLevel::HIGH;
+    bool auto_security_level = false;
+
+    std::string operation; // "upload" or "download"
+    std::string local_path;
+    std::string remote_path;
+    bool recursive = false;
+    bool resume = false;
+    bool force = false;
+};
+
+// Where a remote argument points
+struct RemoteLocation {
+    std::string host; // empty when the argument names no server
+    uint16_t port = 0;
+    std::string path = "/"; // network (Unix) form
+};
+
+// Parses the CLI's remote forms: server:port/path, server:path, server:/path,
+// server, and [ipv6] in place of server. A nonzero port_override is used as
+// the port and the text after the colon is then always a path; without one
+// the port defaults to the standard transfer port. Throws std::runtime_error
+// on malformed input.
+RemoteLocation parse_remote_location(const std::string& spec, uint16_t port_override);
+
+// Runs a transfer on a connected client the way the CLI does, reporting
+// what it starts and finishes through `message`
+void run_transfer_request(Client& client, const TransferRequest& request,
+                          const std::function<void(const std::string& text)>& message);
+
+// What the agent streams back while it runs a request
+struct AgentCallbacks {
+    // The agent's connection is ready; streams is its negotiated stream count
+    std::function<void(uint32_t streams)> started;
+    Client::ProgressCallback progress;
+    Client::OverwriteCallback overwrite;
+    std::function<void(const std::string& text)> message;
+};
+
+// $NETCOPY_AGENT_SOCKET, or agent.sock in the config directory
+std::string default_agent_socket_path();
+
+// Hands a request to the agent listening at socket_path and relays its
+// progress, prompts and messages until it finishes. Returns false when no
+// agent is listening, so the caller can run the request itself; throws
+// with the agent's error message when the request fails.
+bool submit_to_agent(const std::string& socket_path, const TransferRequest& request, const AgentCallbacks& callbacks);
+
+// Long-running local process for scripts that run the CLI many times. It
+// keeps authenticated connections per server warm in a ConnectionPool and
+// runs requests that CLI invocations send over a Unix domain socket, so an
+// invocation costs about one round trip to the server instead of a TCP,
+// TLS and authentication handshake. The socket is only accessible to the
+// user running the agent.
+class ClientAgent {
+public:
+    ClientAgent(std::string socket_path, std::chrono::seconds idle_timeout);
+    ~ClientAgent();
+
+    // Serves requests until stop() or SIGINT/SIGTERM. Throws when the socket
+    // cannot be bound or another agent already listens on it.
+    void run();
+    void stop();
+
+private:
+    struct Session;
+
+    void serve(std::shared_ptr<Session> session);
+    void execute(Session& session, const TransferRequest& request);
+
+    std::string socket_path_;
+    ConnectionPool pool_;
+    std::atomic<bool> stopping_{false};
+    std::function<void()> stop_hook_;
+
+    std::mutex sessions_mutex_;
+    std::condition_variable sessions_done_;
+    std::unordered_set<Session*> sessions_;
+    std::unordered_set<Client*> running_;
+};
+
+} // namespace client
+} // namespace netcopy
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "client/agent.h"
+#include "client/client.h"
+#include "client/connection_pool.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace netcopy {
+namespace client {
+
+// One transfer of a job manifest
+struct JobEntry {
+    size_t line = 0;
+    std::string operation; // "upload" or "download"
+    std::string local_path;
+    RemoteLocation remote;
+    bool recursive = false;
+    bool resume = false;
+    // What to do with files that already exist at the destination
+    Client::OverwriteDecision existing = Client::OverwriteDecision::SKIP;
+};
+
+// Command line options that apply to every entry of a manifest
+struct JobDefaults {
+    uint16_t port_override = 0;
+    bool recursive = false;
+    bool resume = false;
+    bool force = false;
+};
+
+// Reads a job manifest: one transfer per line, written like the CLI's
+// arguments.
+//
+//   upload   <local path>  <server[:port]/remote path>  [options]
+//   download <server[:port]/remote path>  <local path>  [options]
+//
+// Fields are separated by tabs, or by spaces on lines without a tab. The
+// options are recursive (-R), resume, force (-f, overwrite existing files)
+// and delta (delta-sync existing files); without force or delta existing
+// files are skipped. Blank lines and lines starting with # are ignored.
+// Throws std::runtime_error naming the first malformed line.
+std::vector<JobEntry> load_job_manifest(const std::string& path, const JobDefaults& defaults);
+
+enum class JobStatus {
+    PENDING,
+    OK,
+    FAILED,
+    CANCELLED
+};
+
+const char* job_status_name(JobStatus status);
+
+struct JobResult {
+    JobStatus status = JobStatus::PENDING;
+    uint64_t bytes = 0;
+    uint32_t skipped_files = 0; // already at the destination
+    uint32_t attempts = 0;
+    double seconds = 0;
+    std::string error;
+};
+
+struct JobTotals {
+    size_t entries = 0;
+    size_t succeeded = 0;
+    size_t failed = 0;
+    size_t cancelled = 0;
+    size_t running = 0;
+    uint64_t bytes = 0;
+    size_t connections_opened = 0;
+};
+
+// Runs the entries of a manifest in one process. A fixed set of workers
+// takes entries from one queue, largest first so a long transfer does not
+// start last, and each worker keeps its authenticated connection from one
+// entry to the next; a connection is only opened when a worker moves to a
+// server it has no connection to, or after a network error. Connections to
+// a server are shared through a ConnectionPool, so the handshake is paid
+// once per worker and server rather than once per entry.
+class BulkJob {
+public:
+    BulkJob(std::vector<JobEntry> entries, ConnectionProfile profile, size_t workers);
+
+    BulkJob(const BulkJob&) = delete;
+    BulkJob& operator=(const BulkJob&) = delete;
+
+    // Runs every entry and returns when all are finished or cancelled.
+    // progress is called from the calling thread a few times a second and
+    // once at the end.
+    void run(const std::function<void(const JobTotals& totals)>& progress);
+
+    // Stops taking entries and cancels the running transfers. Only stores a
+    // flag, so it may be called from a signal handler.
+    void request_cancel() { cancel_requested_.store(true, std::memory_order_relaxed); }
+
+    const std::vector<JobEntry>& entries() const { return entries_; }
+    // Complete once run() has returned
+    const std::vector<JobResult>& results() const { return results_; }
+    JobTotals totals() const;
+
+    // Machine-readable summary with one record per entry
+    std::string report_json(const std::string& manifest_path) const;
+
+private:
+    // Progress of one entry, kept across its attempts so a retry does not
+    // count bytes twice
+    struct EntryProgress {
+        std::mutex mutex;
+        std::unordered_map<std::string, uint64_t> last_bytes;
+        // Threads whose current file was just skipped: the client reports a
+        // skipped file as complete, which must not count as bytes sent
+        std::unordered_map<std::thread::id, bool> skipping;
+        uint64_t bytes = 0;
+        uint32_t skipped = 0;
+        uint32_t decisions = 0; // overwrite decisions made for existing files
+    };
+
+    void worker();
+    bool take(const std::string& preferred_key, size_t& index);
+    void run_entry(size_t index, ConnectionPool::Lease& lease, std::string& lease_key);
+    void transfer(Client& client, const JobEntry& entry, EntryProgress& progress);
+    static bool prepare_retry(JobEntry& attempt, EntryProgress& progress, bool request_answered);
+    void finish(size_t index, JobResult result);
+    void cancel_running();
+
+    std::vector<JobEntry> entries_;
+    std::vector<std::string> profile_keys_;
+    std::vector<JobResult> results_;
+    ConnectionProfile profile_;
+    const size_t workers_;
+    ConnectionPool pool_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workers_done_;
+    std::vector<size_t> queue_; // entry indices, next first
+    size_t queue_head_ = 0;
+    size_t finished_workers_ = 0;
+    std::unordered_set<Client*> running_;
+    size_t connections_opened_ = 0;
+    double seconds_ = 0;
+
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<bool> cancel_requested_{false};
+};
+
+} // namespace client
+} // namespace netcopy
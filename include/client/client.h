@@ -6,21 +6,26 @@
 #include "crypto/chacha20_poly1305.h"
 #include "crypto/crypto_engine.h"
 #include "crypto/sha3.h"
+#include "crypto/merkle_tree.h"
 #include "config/config_parser.h"
+#include "client/multipath.h"
 #include "protocol/message.h"
 #include "common/chunk_size_manager.h"
 #include "common/bandwidth_limiter.h"
 #include "common/fast_mem.h"
+#include "common/metrics.h"
 #include <memory>
 #include <string>
 #include <functional>
 #include <atomic>
 #include <mutex>
 #include <queue>
+#include <deque>
 #include <thread>
 #include <condition_variable>
 #include <chrono>
 #include <map>
+#include <optional>
 
 namespace netcopy {
 namespace client {
@@ -106,6 +111,9 @@ public:
     std::unique_ptr<AlignedBuffer> acquire() {
         void* ptr = pool_allocator_.allocate();
         if (!ptr) {
+            static auto& misses = common::MetricsRegistry::instance().counter(
+                "netcopy_buffer_pool_misses_total", "Chunk buffers allocated outside the pre-sized pool");
+            misses.add();
             // Fallback: allocate 64-byte aligned memory on the fly
             #if defined(_MSC_VER) || defined(__MINGW32__)
             ptr = _aligned_malloc(buffer_size_, 64);
@@ -136,18 +144,21 @@ struct ReadAheadChunk {
     uint64_t offset;
     std::unique_ptr<BufferPool::AlignedBuffer> data;
     bool is_last;
+    // Non-zero for a hole of the source: no data, sent as a hole chunk
+    uint64_t hole_length = 0;
 };
 
 class ReadAheadQueue {
 public:
     ReadAheadQueue(size_t max_size) : max_size_(max_size), finished_(false) {}
-    ~ReadAheadQueue() = default;
+    ~ReadAheadQueue() { depth_metric().sub(static_cast<int64_t>(queue_.size())); }
     
     void push(ReadAheadChunk chunk) {
         std::unique_lock<std::mutex> lock(mutex_);
         cv_producer_.wait(lock, [this]() { return queue_.size() < max_size_ || finished_; });
         if (finished_) return;
         queue_.push(std::move(chunk));
+        depth_metric().add(1);
         cv_consumer_.notify_one();
     }
     
@@ -157,6 +168,7 @@ public:
         if (queue_.empty() && finished_) return false;
         chunk = std::move(queue_.front());
         queue_.pop();
+        depth_metric().sub(1);
         cv_producer_.notify_one();
         return true;
     }
@@ -168,6 +180,7 @@ public:
         }
         chunk = std::move(queue_.front());
         queue_.pop();
+        depth_metric().sub(1);
         cv_producer_.notify_one();
         return true;
     }
@@ -181,11 +194,19 @@ public:
     
     void clear() {
         std::lock_guard<std::mutex> lock(mutex_);
+        depth_metric().sub(static_cast<int64_t>(queue_.size()));
         while (!queue_.empty()) queue_.pop();
         finished_ = false;
     }
 
 private:
+    // Chunks read ahead but not yet sent, summed over all queues
+    static common::MetricGauge& depth_metric() {
+        static auto& depth = common::MetricsRegistry::instance().gauge(
+            "netcopy_read_ahead_queue_depth", "Chunks read from disk and waiting to be sent");
+        return depth;
+    }
+
     std::queue<ReadAheadChunk> queue_;
     size_t max_size_;
     bool finished_;
@@ -212,6 +233,10 @@ public:
     
     // Security settings
     void set_security_level(crypto::SecurityLevel level);
+    // Let the server pick the authenticated cipher that is fastest on both
+    // machines; the level set above is used with servers that cannot
+    void set_auto_security_level(bool enabled);
+    crypto::SecurityLevel get_negotiated_security_level() const { return negotiated_security_level_; }
     
     // File transfer
     void transfer_file(const std::string& local_path, const std::string& remote_path, bool resume = false);
@@ -219,6 +244,11 @@ public:
     void download_file(const std::string& remote_path, const std::string& local_path, bool resume = false);
     void download_directory(const std::string& remote_path, const std::string& local_path, bool recursive = true, bool resume = false);
     std::vector<protocol::RemoteFileInfo> list_remote_directory(const std::string& remote_path, bool recursive = false);
+    // Conditional listing. `version` is that of a listing the caller holds
+    // (0: none). Returns false when that listing is still current; otherwise
+    // fills entries and version (0 if the server does not version listings).
+    bool list_remote_directory_if_changed(const std::string& remote_path, bool recursive,
+                                          std::vector<protocol::RemoteFileInfo>& entries, uint64_t& version);
     
     // Progress callback
     using ProgressCallback = std::function<void(uint64_t bytes_transferred, uint64_t total_bytes, const std::string& current_file)>;
@@ -258,6 +288,7 @@ public:
 
     // Buffer pool support for parallel streams
     void set_buffer_pool(std::shared_ptr<BufferPool> pool) { buffer_pool_ = pool; }
+    void set_upload_tree(std::shared_ptr<crypto::MerkleTree> tree) { upload_tree_ = std::move(tree); }
 
 private:
     std::unique_ptr<network::Socket> socket_;
@@ -274,20 +305,90 @@ private:
     uint32_t sequence_number_;
     crypto::SecurityLevel security_level_;
     crypto::SecurityLevel negotiated_security_level_;
+    bool auto_security_level_ = false;
     size_t negotiated_max_chunk_size_;
     uint32_t requested_parallel_streams_;
     uint32_t negotiated_parallel_streams_;
     bool server_allows_auto_create_directories_;
     std::string server_address_;
     uint16_t server_port_;
+    // Paths to the server when several are configured, shared with the
+    // stream clients; path_index_ is the one this connection uses
+    std::shared_ptr<PathSelector> path_selector_;
+    size_t path_index_ = PathSelector::kNoPath;
     
     // Buffer Pool sharing
     std::shared_ptr<BufferPool> buffer_pool_;
     
+    // Merkle tree of the parallel upload in progress, fed by every stream
+    std::shared_ptr<crypto::MerkleTree> upload_tree_;
+    uint64_t negotiated_merkle_leaf_size_ = 0;
+    // The server accepts hole chunks for the current upload
+    bool negotiated_sparse_ = false;
+    // The server can fill ranges of the current upload from its own files
+    bool negotiated_block_copy_ = false;
+    // Limits from the server's latest AdmissionUpdate; 0 until one arrives.
+    // Streams are tracked on the root client, chunk sizes per connection.
+    std::atomic<uint32_t> admitted_streams_{0};
+    std::atomic<size_t> admitted_chunk_size_{0};
+    std::atomic<uint64_t> admitted_window_bytes_{0};
+    // Files uploaded in this session by size, kept on the root client and
+    // offered as block copy sources for later files of the same size
+    std::mutex uploaded_files_mutex_;
+    std::map<uint64_t, std::string> uploaded_files_;
+
+    // Pieces of a large upload that idle directory workers may send over
+    // their own connections while the owning worker sends the rest
+    struct SharedUpload {
+        std::string local_path;
+        std::string remote_path;
+        uint64_t total_size = 0;
+        std::shared_ptr<crypto::MerkleTree> tree;
+        std::function<void(uint64_t)> progress;
+        common::BandwidthMonitor monitor;
+
+        struct Piece {
+            uint64_t offset = 0;
+            uint64_t length = 0;
+            // Bytes already reported to progress by an attempt that failed
+            // partway; the piece is sent again from its start
+            uint64_t counted = 0;
+        };
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<Piece> pieces;
+        size_t in_flight = 0;
+        size_t helpers = 0;
+        bool closed = false;
+
+        // With `wait`, blocks while other connections still hold pieces
+        // that might be handed back
+        bool take(Piece& piece, bool wait);
+        void finish(const Piece& piece, bool sent);
+        // Progress for sending `piece` that skips the bytes it already counted
+        std::function<void(uint64_t)> piece_progress(Piece& piece);
+        bool join();
+        void leave();
+        // Stops new helpers and waits for the current ones to leave
+        void close();
+    };
+    // Set by the directory scheduler for files worth sharing
+    bool share_ranges_ = false;
+    std::mutex shared_uploads_mutex_;
+    std::vector<std::shared_ptr<SharedUpload>> shared_uploads_;
+    
+    // Connects this client without path selection
+    void open_connection(const std::string& host, uint16_t port, const std::string& local_address);
+    // After a network error on a multipath connection: marks its path as
+    // failed and reconnects over another. False when there is none.
+    bool fail_over(const std::string& reason);
+
     // Protocol handling
     void perform_handshake();
     void send_message(const protocol::Message& message);
     std::unique_ptr<protocol::Message> receive_message();
+    void apply_admission_update(const protocol::AdmissionUpdate& update);
     
     // Encryption
     std::vector<uint8_t> encrypt_message(const std::vector<uint8_t>& data);
@@ -306,12 +407,24 @@ private:
                          bool is_final_range = false,
                          crypto::Sha3Hasher* stream_hasher = nullptr);
     uint32_t choose_parallel_stream_count(uint64_t transfer_size) const;
+    void verify_upload_tree(const std::string& local_path, const std::string& remote_path, uint64_t total_size);
+    // Asks the server to fill the ranges from `source_path`; returns the
+    // (offset, length) target ranges it copied
+    std::vector<std::pair<uint64_t, uint64_t>> request_block_copy(const std::string& source_path,
+                                                                  const std::vector<protocol::BlockCopyRange>& ranges);
+    void remember_upload(const std::string& remote_path, uint64_t size);
+    // Sends pieces of a shared upload of the root client; false if there
+    // was none left to help with
+    bool help_shared_upload();
+    std::string find_upload_of_size(uint64_t size, const std::string& exclude_path);
+    std::vector<uint64_t> find_mismatched_leaves(const std::string& remote_path);
     void send_file_request(const std::string& local_path,
                            const std::string& remote_path,
                            bool resume,
                            bool truncate_destination,
                            uint64_t& resume_offset,
-                           uint64_t* remote_file_size = nullptr);
+                           uint64_t* remote_file_size = nullptr,
+                           std::optional<std::vector<std::pair<uint64_t, uint64_t>>>* completed_ranges = nullptr);
     
     // Utility functions
     void set_error(const std::string& error);
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "client/client.h"
+#include "exceptions.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace netcopy {
+namespace client {
+
+// Everything a connection is opened with. Connections are only shared
+// between requests with the same profile.
+struct ConnectionProfile {
+    std::string host;
+    uint16_t port = 0;
+    config::ClientConfig config;
+    crypto::SecurityLevel security_level = crypto::SecurityLevel::HIGH;
+    bool auto_security_level = false;
+    uint32_t parallel_streams = 0; // 0 keeps the client's default request
+
+    std::string key() const;
+};
+
+// Authenticated connections kept open between requests of the GUI or the
+// client agent. Listings, status queries and transfers lease a connection
+// and hand it back when done, so only the first request of a profile pays
+// for the handshake. A background thread keeps the configured number of
+// connections per profile open and probes idle ones so dead connections
+// are dropped before they are leased.
+class ConnectionPool {
+public:
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        Client* operator->() const { return client_.get(); }
+        Client& operator*() const { return *client_; }
+        explicit operator bool() const { return client_ != nullptr; }
+
+        // True when the connection was idle in the pool rather than opened
+        // for this lease
+        bool reused() const { return reused_; }
+        // Closes the connection instead of returning it to the pool
+        void discard();
+
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool* pool, std::string key, uint64_t generation,
+              std::unique_ptr<Client> client, bool reused);
+        void release();
+
+        ConnectionPool* pool_ = nullptr;
+        std::string key_;
+        uint64_t generation_ = 0;
+        std::unique_ptr<Client> client_;
+        bool reused_ = false;
+    };
+
+    // Idle connections of profiles not kept warm are closed after idle_timeout
+    explicit ConnectionPool(std::chrono::seconds idle_timeout = std::chrono::seconds(120));
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // An idle connection of this profile, or a new one. Throws when a new
+    // connection cannot be opened.
+    Lease acquire(const ConnectionProfile& profile);
+    // Always opens a new connection
+    Lease acquire_fresh(const ConnectionProfile& profile);
+    // As acquire(), but a pooled connection must first answer a probe; one
+    // that does not is replaced by a new connection
+    Lease acquire_verified(const ConnectionProfile& profile);
+
+    // Runs fn on a leased connection. When a pooled connection fails with a
+    // network error it is replaced by a new one and fn runs once more.
+    template <typename Fn>
+    auto run(const ConnectionProfile& profile, Fn&& fn) -> decltype(fn(std::declval<Client&>())) {
+        Lease lease = acquire(profile);
+        if (lease.reused()) {
+            try {
+                return fn(*lease);
+            } catch (const NetworkException&) {
+                lease.discard();
+                lease = acquire_fresh(profile);
+            }
+        }
+        return fn(*lease);
+    }
+
+    // Keeps `count` connections of this profile open, leased or idle
+    void keep_warm(const ConnectionProfile& profile, size_t count);
+
+    // Closes every idle connection and forgets all profiles. Connections
+    // leased at the time are closed when they are handed back.
+    void clear();
+
+    // Cheap round trip on an idle connection
+    static bool is_alive(Client& client);
+
+private:
+    struct IdleConnection {
+        std::unique_ptr<Client> client;
+        // Handed back by its last lease; probes do not reset it
+        std::chrono::steady_clock::time_point since;
+        std::chrono::steady_clock::time_point last_probe{};
+    };
+
+    struct Slot {
+        ConnectionProfile profile;
+        std::deque<IdleConnection> idle;
+        size_t warm = 0;
+        size_t busy = 0; // leased, being opened or being probed
+        std::chrono::steady_clock::time_point retry_after{};
+    };
+
+    static std::unique_ptr<Client> open(const ConnectionProfile& profile);
+    static void close(std::vector<std::unique_ptr<Client>>& clients);
+    void give_back(const std::string& key, uint64_t generation, std::unique_ptr<Client> client);
+    void maintain();
+
+    const std::chrono::seconds idle_timeout_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::unordered_map<std::string, Slot> slots_;
+    uint64_t generation_ = 0;
+    bool stopping_ = false;
+    std::thread maintainer_;
+};
+
+} // namespace client
+} // namespace netcopy
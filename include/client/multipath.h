@@ -0,0 +1,76 @@
+#pragma once
+
+#include "config/config_parser.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace netcopy {
+namespace client {
+
+// One way to reach the server: a remote address and the local address the
+// connection is bound to
+struct TransferPath {
+    std::string host;
+    uint16_t port = 0;
+    std::string local_address; // empty: the OS picks the route
+
+    std::string name() const;
+};
+
+// Spreads the connections of a client and its transfer streams over the
+// paths configured in [network] server_addresses and local_addresses.
+// A new connection takes the path with the fewest streams relative to the
+// throughput its streams measured, so a faster link carries more of them.
+// A path that fails to connect or drops a connection is left out for a
+// while, and the streams that used it move to the remaining paths.
+class PathSelector {
+public:
+    static constexpr size_t kNoPath = static_cast<size_t>(-1);
+
+    explicit PathSelector(std::vector<TransferPath> paths);
+
+    // Paths to host:port under this configuration; nullptr when it names
+    // no other address to use, so connections go out as before
+    static std::shared_ptr<PathSelector> from_config(const config::ClientConfig& config,
+                                                     const std::string& host, uint16_t port);
+
+    // True when built for this server address
+    bool serves(const std::string& host, uint16_t port) const;
+    size_t size() const { return paths_.size(); }
+    const TransferPath& path(size_t index) const { return paths_[index]; }
+
+    // Picks a path for a new connection and counts it as in use until
+    // release()
+    size_t acquire();
+    void release(size_t index);
+    // Bytes sent or received over a connection on this path
+    void record(size_t index, uint64_t bytes);
+    // Leaves the path out of acquire() for a while
+    void mark_failed(size_t index);
+    bool has_healthy_path() const;
+
+private:
+    struct PathState {
+        std::atomic<uint64_t> bytes{0};
+        uint64_t sampled_bytes = 0;
+        std::chrono::steady_clock::time_point sampled_at{};
+        double stream_rate = 0; // bytes/s per stream, 0 until measured
+        size_t streams = 0;
+        std::chrono::steady_clock::time_point down_until{};
+    };
+
+    void sample_locked(std::chrono::steady_clock::time_point now);
+
+    const std::vector<TransferPath> paths_;
+    std::vector<PathState> states_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace client
+} // namespace netcopy
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace netcopy {
+namespace common {
+
+// Number of per-thread slots each counter/histogram is striped over. Threads
+// are assigned a slot round-robin on first use, so with up to kMetricShards
+// concurrent writers every thread increments its own cache line.
+inline constexpr size_t kMetricShards = 32;
+
+size_t metric_shard_index();
+
+// Monotonic counter. add() is a single relaxed atomic increment on the calling
+// thread's slot; value() sums all slots and is only used when scraping.
+class MetricCounter {
+public:
+    void add(uint64_t delta = 1) {
+        slots_[metric_shard_index()].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Slot, kMetricShards> slots_;
+};
+
+// Point-in-time value (connections, queue depth). Gauges move in both
+// directions from many threads, so a single atomic is used.
+class MetricGauge {
+public:
+    void add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    void sub(int64_t delta) { value_.fetch_sub(delta, std::memory_order_relaxed); }
+    void set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// Fixed-bucket histogram striped like MetricCounter. The sum is kept in
+// micro-units (1e-6 of the observed unit) so it can be accumulated atomically.
+class MetricHistogram {
+public:
+    explicit MetricHistogram(std::vector<double> upper_bounds);
+
+    void observe(double value);
+    void observe_seconds(std::chrono::steady_clock::duration elapsed) {
+        observe(std::chrono::duration<double>(elapsed).count());
+    }
+
+    const std::vector<double>& upper_bounds() const { return upper_bounds_; }
+    // Per-bucket (non-cumulative) counts; the last entry is the +Inf bucket.
+    std::vector<uint64_t> bucket_counts() const;
+    uint64_t count() const;
+    double sum() const;
+
+private:
+    struct alignas(64) Slot {
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum_micros{0};
+    };
+
+    std::vector<double> upper_bounds_;
+    std::array<Slot, kMetricShards> slots_;
+};
+
+// Measures the lifetime of the scope into a histogram.
+class ScopedMetricTimer {
+public:
+    explicit ScopedMetricTimer(MetricHistogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedMetricTimer() { histogram_.observe_seconds(std::chrono::steady_clock::now() - start_); }
+
+    ScopedMetricTimer(const ScopedMetricTimer&) = delete;
+    ScopedMetricTimer& operator=(const ScopedMetricTimer&) = delete;
+
+private:
+    MetricHistogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Process-wide metric registry rendered in the Prometheus text exposition
+// format. Lookups take a mutex, so hot paths resolve their metric once
+// (function-local static or member pointer) and keep the reference; metric
+// objects are never destroyed, so references stay valid for the process.
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    // `labels` is a pre-rendered label set such as `user="alice"` (see
+    // metric_label()); an empty string registers the unlabelled series.
+    MetricCounter& counter(const std::string& name, const std::string& help,
+                           const std::string& labels = "");
+    MetricGauge& gauge(const std::string& name, const std::string& help,
+                       const std::string& labels = "");
+    MetricHistogram& histogram(const std::string& name, const std::string& help,
+                               const std::vector<double>& upper_bounds,
+                               const std::string& labels = "");
+
+    std::string render() const;
+
+    // Latency buckets from 50 us to 10 s, suitable for per-chunk stages.
+    static std::vector<double> latency_buckets();
+
+private:
+    MetricsRegistry() = default;
+
+    enum class Kind { Counter, Gauge, Histogram };
+
+    struct Family {
+        Kind kind = Kind::Counter;
+        std::string help;
+        std::map<std::string, std::unique_ptr<MetricCounter>> counters;
+        std::map<std::string, std::unique_ptr<MetricGauge>> gauges;
+        std::map<std::string, std::unique_ptr<MetricHistogram>> histograms;
+    };
+
+    Family& family(const std::string& name, const std::string& help, Kind kind);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+};
+
+// Renders `key="value"` with Prometheus label escaping applied to the value.
+std::string metric_label(const std::string& key, const std::string& value);
+
+} // namespace common
+} // namespace netcopy
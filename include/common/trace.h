@@ -0,0 +1,178 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace netcopy {
+namespace common {
+
+// Pipeline stages a chunk passes through. Client and server record the same
+// enum so traces from both ends can be merged and read side by side.
+enum class TraceStage : uint8_t {
+    Read,
+    Hash,
+    Compress,
+    Encrypt,
+    Send,
+    Receive,
+    Decrypt,
+    Decompress,
+    Write,
+    Ack
+};
+
+const char* trace_stage_name(TraceStage stage);
+
+// Sampling per-chunk stage tracer with Chrome trace / Perfetto JSON export.
+//
+// Every thread appends to its own fixed-capacity buffer; the owner is the
+// only writer and publishes entries with a release store, so recording never
+// takes a lock. Buffers stop accepting events when full (counted as dropped)
+// rather than wrapping, which keeps concurrent export race-free. When a
+// thread exits its buffer is handed to the next new thread, which appends
+// after the events already in it.
+//
+// Chunks are sampled by a hash of their file offset, so client and server
+// pick the same chunks and events correlate by the `offset` argument.
+class ChunkTracer {
+public:
+    static ChunkTracer& instance();
+
+    // `role` names the process in the trace ("client", "server").
+    // `sample_every` traces one chunk in N (1 = every chunk).
+    // Tracing is meant to be switched on once at startup, before transfers.
+    void enable(const std::string& role, uint32_t sample_every = 1, size_t events_per_thread = 1u << 14);
+    void disable() { enabled_.store(false, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    bool should_sample(uint64_t offset) const;
+
+    void record(TraceStage stage, uint64_t offset, uint64_t bytes,
+                std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end);
+
+    // Offset/size of the chunk the calling thread is currently working on.
+    // Message-level stages (encrypt, send) that do not see the chunk use it.
+    static void set_thread_chunk(uint64_t offset, uint64_t bytes);
+    static void clear_thread_chunk();
+    static bool thread_chunk(uint64_t& offset, uint64_t& bytes);
+
+    std::string to_chrome_json() const;
+    bool write_chrome_trace(const std::string& path) const;
+
+    uint64_t dropped_events() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    ChunkTracer() = default;
+
+    // Buffers outlive their threads so they can be exported later; cap how
+    // many a server running many connections at once can accumulate.
+    static constexpr size_t kMaxThreadBuffers = 256;
+
+    struct Event {
+        uint64_t start_ns;
+        uint64_t duration_ns;
+        uint64_t offset;
+        uint64_t bytes;
+        TraceStage stage;
+    };
+
+    struct ThreadBuffer {
+        uint32_t tid = 0;
+        std::unique_ptr<Event[]> events;
+        size_t capacity = 0;
+        std::atomic<size_t> size{0};
+    };
+
+    // Owned by a thread_local; hands the buffer back when its thread exits
+    struct ThreadSlot {
+        ThreadBuffer* buffer = nullptr;
+        ~ThreadSlot();
+    };
+
+    ThreadBuffer* thread_buffer();
+    void release(ThreadBuffer* buffer);
+
+    std::atomic<bool> enabled_{false};
+    std::atomic<uint32_t> sample_every_{1};
+    size_t events_per_thread_ = 1u << 14;
+    std::string role_ = "netcopy";
+    std::atomic<uint64_t> dropped_{0};
+
+    mutable std::mutex buffers_mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+    // Buffers of exited threads that still have room, reused before new
+    // ones are allocated
+    std::vector<ThreadBuffer*> released_;
+    std::atomic<size_t> released_count_{0};
+    std::atomic<bool> buffers_full_{false};
+};
+
+// Records one stage for one chunk over the lifetime of the scope. When
+// tracing is off, or the chunk is not sampled, it costs a relaxed load.
+class TraceScope {
+public:
+    TraceScope(TraceStage stage, uint64_t offset, uint64_t bytes)
+        : stage_(stage), offset_(offset), bytes_(bytes) {
+        auto& tracer = ChunkTracer::instance();
+        active_ = tracer.enabled() && tracer.should_sample(offset);
+        if (active_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    // Uses the calling thread's current chunk (see set_thread_chunk)
+    explicit TraceScope(TraceStage stage) : stage_(stage), offset_(0), bytes_(0) {
+        auto& tracer = ChunkTracer::instance();
+        active_ = tracer.enabled() && ChunkTracer::thread_chunk(offset_, bytes_) && tracer.should_sample(offset_);
+        if (active_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceScope() {
+        if (active_) {
+            ChunkTracer::instance().record(stage_, offset_, bytes_, start_, std::chrono::steady_clock::now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceStage stage_;
+    uint64_t offset_;
+    uint64_t bytes_;
+    bool active_ = false;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Sets the thread's current chunk for the lifetime of the scope.
+class TraceChunkContext {
+public:
+    TraceChunkContext(uint64_t offset, uint64_t bytes) {
+        if (ChunkTracer::instance().enabled()) {
+            ChunkTracer::set_thread_chunk(offset, bytes);
+            active_ = true;
+        }
+    }
+    ~TraceChunkContext() {
+        if (active_) {
+            ChunkTracer::clear_thread_chunk();
+        }
+    }
+
+    TraceChunkContext(const TraceChunkContext&) = delete;
+    TraceChunkContext& operator=(const TraceChunkContext&) = delete;
+
+private:
+    bool active_ = false;
+};
+
+} // namespace common
+} // namespace netcopy
@@ -35,6 +35,8 @@ bool is_valid_port(int port);
 uint64_t get_available_memory();
 uint64_t get_network_bandwidth();
 void sleep_milliseconds(int ms);
+// Binds the calling thread to one CPU; false where that is not supported
+bool pin_current_thread_to_cpu(unsigned cpu);
 
 // Security utilities
 std::vector<uint8_t> generate_random_bytes(size_t length);
@@ -45,6 +47,17 @@ std::vector<uint8_t> derive_session_key(
     const std::vector<uint8_t>& server_nonce,
     const std::vector<uint8_t>& client_nonce);
 
+// TLS channel binding: each side proves it holds base_key for exactly the
+// TLS session whose exporter value (kTlsBindingLabel) is given. Client and
+// server proofs differ so one cannot be reflected as the other.
+inline constexpr const char* kTlsBindingLabel = "EXPORTER-netcopy-channel-binding";
+inline constexpr size_t kTlsBindingExporterSize = 32;
+std::vector<uint8_t> tls_binding_proof(const std::string& base_key_hex,
+                                       const std::vector<uint8_t>& exporter,
+                                       bool client_side);
+// Constant-time comparison of two proofs
+bool tls_binding_matches(const std::vector<uint8_t>& expected, const std::vector<uint8_t>& received);
+
 // Version information
 std::string get_version_string();
 std::string get_build_info();
@@ -26,6 +26,7 @@ inline constexpr const char* kGuiLogFile = "net_copy_gui.log";
 inline constexpr bool kClientConsoleEnabled = true;
 inline constexpr bool kCreateEmptyDirectories = true;
 inline constexpr bool kAutoCreateDirectories = true;
+inline constexpr bool kClientDownloadDeltaSync = true;
 
 inline constexpr const char* kProxyNone = "none";
 inline constexpr const char* kProxySocks5 = "socks5";
@@ -27,7 +27,14 @@ inline constexpr bool kDefaultTrustedSkipZeroFill = false;
 inline constexpr bool kDefaultCacheHints = false;
 inline constexpr bool kDefaultStreamingVerification = false;
 inline constexpr bool kDefaultTcpInfoWindow = false;
+inline constexpr bool kDefaultSparseFiles = true;
+inline constexpr bool kDefaultBlockCopy = true;
+// Smaller files are not worth a round trip to look for a copy source
+inline constexpr uint64_t kMinBlockCopyFileSize = 1024 * 1024;
 inline constexpr int kMaxBatchChunks = 64;
+// Under TLS, bind the pre-shared key to the TLS session instead of
+// encrypting every payload a second time
+inline constexpr bool kDefaultTlsChannelBinding = true;
 
 inline constexpr const char* kProtocolInternal = "internal";
 inline constexpr const char* kProtocolSsh = "ssh";
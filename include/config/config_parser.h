@@ -94,6 +94,9 @@ struct ServerConfig {
         bool cache_hints = defaults::kDefaultCacheHints;
         bool streaming_verification = defaults::kDefaultStreamingVerification;
         bool tcp_info_window = defaults::kDefaultTcpInfoWindow;
+        bool resume_journal = defaults::kServerResumeJournal;
+        bool sparse_files = defaults::kDefaultSparseFiles;
+        bool block_copy = defaults::kDefaultBlockCopy;
     } internal;
     
     struct ProtocolTls {
@@ -104,6 +107,7 @@ struct ServerConfig {
         bool client_cert_validation = defaults::kServerTlsClientCertValidation;
         bool client_chain_validation = defaults::kServerTlsClientChainValidation;
         std::string trusted_chain_file;
+        bool channel_binding = defaults::kDefaultTlsChannelBinding;
     } tls;
     
     struct ProtocolSsh {
@@ -129,9 +133,23 @@ struct ServerConfig {
         std::string level = defaults::kLogLevelInfo;
     } console;
     
+    // Prometheus /metrics endpoint
+    struct Metrics {
+        bool enable = defaults::kServerMetricsEnabled;
+        std::string listen_address = defaults::kServerMetricsListenAddress;
+        uint16_t port = defaults::kServerMetricsPort;
+    } metrics;
+    
     // Performance and Limits
     uint64_t max_file_size = defaults::kUnlimitedFileSize;
     int max_bandwidth_percent = defaults::kDefaultMaxBandwidthPercent;
+    int max_active_streams = defaults::kServerMaxActiveStreams;
+    uint64_t memory_budget_bytes = defaults::kServerMemoryBudgetBytes;
+    uint64_t chunk_cache_bytes = defaults::kServerChunkCacheBytes;
+    bool durable_writes = defaults::kServerDurableWrites;
+    int durable_commit_window_ms = defaults::kServerDurableCommitWindowMs;
+    int accept_shards = defaults::kServerAcceptShards;
+    bool pin_accept_shards = defaults::kServerPinAcceptShards;
     
     // Integration
     std::string webhook_url;
@@ -148,6 +166,9 @@ struct ServerConfig {
     static ServerConfig get_default();
     static void create_default_file(const std::string& filename);
     static std::vector<ConfigValidationIssue> validate_file(const std::string& filename);
+    // [performance] keys a running server applies on reload (SIGHUP);
+    // the transfer tuning ones may also sit in [protocol.internal]
+    static const std::vector<std::string>& reloadable_keys();
 };
 
 // Client configuration structure
@@ -157,6 +178,10 @@ struct ClientConfig {
     bool keep_alive = defaults::kClientKeepAlive;
     bool udp = defaults::kClientUdpEnabled;
     int socket_buffer_size = defaults::kDefaultSocketBufferSize;
+    // Multipath: more addresses of the same server ("host" or "host:port")
+    // and local addresses to bind stream connections to
+    std::vector<std::string> server_addresses;
+    std::vector<std::string> local_addresses;
     
     // Protocol settings
     std::string default_protocol = defaults::kProtocolInternal;
@@ -183,6 +208,11 @@ struct ClientConfig {
         bool cache_hints = defaults::kDefaultCacheHints;
         bool streaming_verification = defaults::kDefaultStreamingVerification;
         bool tcp_info_window = defaults::kDefaultTcpInfoWindow;
+        // Send local block signatures so re-downloads only fetch changed blocks
+        bool download_delta_sync = defaults::kClientDownloadDeltaSync;
+        // Send holes of sparse files as descriptors instead of zeros
+        bool sparse_files = defaults::kDefaultSparseFiles;
+        bool block_copy = defaults::kDefaultBlockCopy;
     } internal;
     
     struct ProtocolTls {
@@ -193,6 +223,7 @@ struct ClientConfig {
         bool server_cert_validation = defaults::kClientTlsServerCertValidation;
         bool server_chain_validation = defaults::kClientTlsServerChainValidation;
         std::string trusted_chain_file;
+        bool channel_binding = defaults::kDefaultTlsChannelBinding;
     } tls;
     
     struct ProtocolSsh {
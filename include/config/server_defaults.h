@@ -16,6 +16,22 @@ inline constexpr bool kServerRequireAuth = true;
 inline constexpr bool kServerAllowAnonymous = false;
 inline constexpr bool kServerAdaptiveChunkSize = true;
 inline constexpr const char* kServerUsersFile = "users.csv";
+inline constexpr bool kServerResumeJournal = true;
+// Smaller uploads never use parallel streams, so the partial size is enough
+inline constexpr uint64_t kServerResumeJournalMinBytes = 64ull * 1024ull * 1024ull;
+// Parallel streams granted across all clients; 0 sizes it from the CPU count
+inline constexpr int kServerMaxActiveStreams = 0;
+// Transfer buffer memory across all connections; 0 uses a quarter of RAM
+inline constexpr uint64_t kServerMemoryBudgetBytes = 0;
+// Memory for content of files many clients download; 0 disables the cache
+inline constexpr uint64_t kServerChunkCacheBytes = 256ull * 1024ull * 1024ull;
+// Stage uploads and rename them into place after a group-committed flush
+inline constexpr bool kServerDurableWrites = false;
+inline constexpr int kServerDurableCommitWindowMs = 2;
+// SO_REUSEPORT listening sockets, each with its own accept thread; 0 is one per CPU
+inline constexpr int kServerAcceptShards = 1;
+// Only takes effect with one shard per CPU
+inline constexpr bool kServerPinAcceptShards = true;
 
 inline constexpr bool kServerTlsEnabled = false;
 inline constexpr bool kServerTlsClientCertValidation = false;
@@ -29,6 +45,10 @@ inline constexpr const char* kServerLogFile = "server.log";
 inline constexpr const char* kServerAuditFile = "";
 inline constexpr bool kServerConsoleEnabled = true;
 
+inline constexpr bool kServerMetricsEnabled = false;
+inline constexpr const char* kServerMetricsListenAddress = "127.0.0.1";
+inline constexpr uint16_t kServerMetricsPort = 9464;
+
 inline constexpr bool kServerRunAsDaemon = false;
 inline constexpr const char* kServerPidFile = "/var/run/net_copy_server.pid";
 inline constexpr const char* kServerAllowedPath = "/var/lib/net_copy";
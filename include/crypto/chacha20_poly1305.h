@@ -46,6 +46,10 @@ public:
     // Generate random nonce
     static Nonce generate_nonce();
 
+    // Raw ChaCha20 keystream starting at block `counter`, no authentication
+    static void keystream(const Key& key, const Nonce& nonce, uint32_t counter,
+                          uint8_t* output, size_t length);
+
     // Derive key from password using PBKDF2
     static Key derive_key(const std::string& password, 
                          const std::vector<uint8_t>& salt,
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "crypto/chacha20_poly1305.h"
+#include <cstdint>
+#include <string>
+
+namespace netcopy {
+namespace crypto {
+
+// Throughput of the authenticated engines on this machine in MB/s,
+// encrypting and decrypting; 0 means not measured
+struct CipherRates {
+    uint32_t chacha20_poly1305 = 0;
+    uint32_t aes_256_gcm = 0;
+
+    bool known() const { return chacha20_poly1305 != 0 || aes_256_gcm != 0; }
+};
+
+// CPU model and the features the engines' speed depends on (AES-NI, VAES,
+// AVX-512); a cached measurement is only reused on the same signature
+std::string cpu_signature();
+
+// Runs the engines over an in-memory buffer for a fraction of a second
+CipherRates measure_cipher_rates();
+
+// Rates of this machine, measured once per process. The result is cached in
+// the config directory so later runs skip the measurement.
+const CipherRates& local_cipher_rates();
+
+// Authenticated level with the highest min(local, peer) rate. ChaCha20 wins
+// ties and is the answer when either side has not measured.
+SecurityLevel choose_fastest_cipher(const CipherRates& local, const CipherRates& peer);
+
+} // namespace crypto
+} // namespace netcopy
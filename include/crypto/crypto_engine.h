@@ -4,6 +4,7 @@
 #include "crypto/xor_cipher.h"
 #include "crypto/aes_ctr.h"
 #include "crypto/aes_256_gcm_gpu.h"
+#include "crypto/random.h"
 #include <memory>
 #include <vector>
 #include <cstdint>
@@ -36,10 +37,7 @@ public:
 
 private:
     std::unique_ptr<ChaCha20Poly1305> cipher_;
-    ChaCha20Poly1305::Nonce current_nonce_;
-    uint64_t nonce_counter_;
-    
-    void increment_nonce();
+    NonceSequence<ChaCha20Poly1305::NONCE_SIZE> nonces_;
 };
 
 // XOR cipher implementation
@@ -99,10 +97,7 @@ public:
 private:
     std::unique_ptr<Aes256GcmGpu> cipher_;
     std::string secret_key_;
-    Aes256GcmGpu::IV current_iv_;
-    uint64_t iv_counter_;
-    
-    void increment_iv();
+    NonceSequence<Aes256GcmGpu::IV_SIZE> ivs_;
 };
 
 // Factory function
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace netcopy {
+namespace crypto {
+
+// Merkle tree over fixed-size leaves of a file, built incrementally while
+// chunks are written.
+//
+// Leaves that receive their bytes in order are hashed on the fly, whichever
+// stream delivers them. Leaves that see out-of-order or repeated writes are
+// marked deferred and re-read by finish(), so parallel and resumed uploads
+// still avoid a full second pass over the file.
+//
+// Like FileManager::compute_file_hash it uses xxHash64: the transport already
+// authenticates every frame, this only has to catch corrupted writes. Leaves
+// and inner nodes hash with different seeds; an odd node at the end of a
+// level is carried up unchanged.
+class MerkleTree {
+public:
+    static constexpr uint64_t kDefaultLeafSize = 4ull * 1024 * 1024;
+    static constexpr uint64_t kMinLeafSize = 64ull * 1024;
+    static constexpr uint64_t kMaxLeafSize = 64ull * 1024 * 1024;
+    static constexpr size_t kHashSize = 8;
+
+    using Hash = std::array<uint8_t, kHashSize>;
+    // Reads up to `length` bytes at `offset`, returns the count read
+    using ReadAt = std::function<size_t(uint64_t offset, uint8_t* out, size_t length)>;
+
+    MerkleTree(uint64_t data_size, uint64_t leaf_size = kDefaultLeafSize);
+
+    uint64_t data_size() const { return data_size_; }
+    uint64_t leaf_size() const { return leaf_size_; }
+    uint64_t leaf_count() const { return leaf_count_; }
+
+    // Records bytes written at `offset`. Safe to call from several threads.
+    void update(uint64_t offset, const uint8_t* data, size_t size);
+
+    // Records a hole of `length` zero bytes at `offset`. Leaves the hole
+    // covers entirely take a cached all-zero hash instead of being hashed.
+    void update_zeros(uint64_t offset, uint64_t length);
+
+    // Marks bytes written without passing through update() so finish()
+    // re-reads the leaves they touch
+    void invalidate(uint64_t offset, uint64_t length);
+
+    // Hashes every leaf update() could not complete. Returns false if the
+    // reader came up short.
+    bool finish(const ReadAt& read_at);
+
+    // Number of leaves finish() would have to read
+    uint64_t pending_leaves() const;
+
+    // Empty until every leaf is hashed
+    std::vector<uint8_t> root();
+
+    // Levels including the leaves (level 0) and the root
+    uint32_t depth();
+    uint64_t level_width(uint32_t level);
+
+    // Node hashes at `level`; out-of-range indices yield empty entries
+    std::vector<std::vector<uint8_t>> nodes(uint32_t level, const std::vector<uint64_t>& indices);
+
+    // (offset, length) of a leaf's bytes
+    std::pair<uint64_t, uint64_t> leaf_range(uint64_t leaf) const;
+
+    static Hash hash_node(const Hash& left, const Hash& right);
+
+private:
+    enum class LeafState : uint8_t { Empty, Partial, Done, Deferred };
+
+    struct PartialLeaf;
+
+    void feed_leaf(uint64_t leaf, uint64_t offset, const uint8_t* data, size_t size);
+    void build_levels_locked();
+    Hash zero_leaf_hash(uint64_t size);
+
+    uint64_t data_size_;
+    uint64_t leaf_size_;
+    uint64_t leaf_count_;
+
+    mutable std::mutex mutex_;
+    std::vector<LeafState> states_;
+    std::vector<Hash> leaf_hashes_;
+    std::unordered_map<uint64_t, std::shared_ptr<PartialLeaf>> partial_;
+    std::vector<std::vector<Hash>> levels_;
+    bool levels_dirty_ = true;
+    bool zero_leaf_hash_ready_ = false;
+    Hash zero_leaf_hash_{};
+};
+
+} // namespace crypto
+} // namespace netcopy
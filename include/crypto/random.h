@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace netcopy {
+namespace crypto {
+
+// Entropy straight from the OS (getrandom, getentropy or BCryptGenRandom).
+// A system call per use: meant for seeding, not for the message path.
+void os_random(uint8_t* out, size_t length);
+
+// Cryptographically secure random bytes from a per-thread ChaCha20
+// generator with fast key erasure: every refill replaces the key with
+// keystream, so earlier output cannot be reconstructed from the state.
+// Seeded from os_random, reseeded every few megabytes and in a child after
+// fork(). No lock and no system call between reseeds.
+void secure_random(uint8_t* out, size_t length);
+
+template <size_t N>
+std::array<uint8_t, N> secure_random_array() {
+    std::array<uint8_t, N> bytes;
+    secure_random(bytes.data(), bytes.size());
+    return bytes;
+}
+
+// Nonces for an AEAD key: a random 96-bit starting point whose low 64 bits
+// count up per message. Peers that share a key (both directions of a
+// session) start at independent random points, so their nonces do not
+// meet, and no nonce repeats for one sequence. Safe to share between
+// threads.
+template <size_t N>
+class NonceSequence {
+    static_assert(N >= 12, "nonce too short for a 64-bit counter");
+
+public:
+    NonceSequence() : base_(secure_random_array<N>()) {
+        uint64_t start = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            start |= static_cast<uint64_t>(base_[N - 8 + i]) << (8 * i);
+        }
+        counter_.store(start, std::memory_order_relaxed);
+    }
+
+    std::array<uint8_t, N> next() {
+        const uint64_t value = counter_.fetch_add(1, std::memory_order_relaxed);
+        std::array<uint8_t, N> nonce = base_;
+        for (size_t i = 0; i < 8; ++i) {
+            nonce[N - 8 + i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+        return nonce;
+    }
+
+private:
+    const std::array<uint8_t, N> base_;
+    std::atomic<uint64_t> counter_{0};
+};
+
+} // namespace crypto
+} // namespace netcopy
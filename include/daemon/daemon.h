@@ -1,5 +1,6 @@
 #pragma once
 
+#include <csignal>
 #include <string>
 
 namespace netcopy {
@@ -21,6 +22,11 @@ public:
     
     // Signal handling
     static void setup_signal_handlers();
+    // Only SIGHUP, for processes that keep the default termination behaviour
+    static void setup_reload_handler();
+    // True once after each SIGHUP; polled by the server's main loop, since
+    // reloading is not safe inside a signal handler
+    static bool take_reload_request();
     
     // Get current process ID
     static int get_pid();
@@ -28,6 +34,7 @@ public:
 private:
     static void signal_handler(int signal);
     static std::string current_pid_file_;
+    static volatile std::sig_atomic_t reload_requested_;
 };
 
 } // namespace daemon
@@ -6,6 +6,7 @@
 #include <filesystem>
 #include <cstdint>
 #include <functional>
+#include <utility>
 
 namespace netcopy {
 namespace file {
@@ -68,6 +69,24 @@ public:
     static uint64_t get_partial_file_size(const std::string& path);
     static bool is_transfer_complete(const std::string& path, uint64_t expected_size);
     
+    // Sparse file support: true if the file has holes worth skipping
+    static bool is_sparse(const std::string& path);
+    
+    // Server-local block reuse
+    enum class CopyMethod {
+        Reflink,   // extents shared, no data moved (FICLONERANGE)
+        Kernel,    // copied inside the kernel (copy_file_range)
+        Buffered   // read and written through user space
+    };
+    // Copies `length` bytes of `source` at `source_offset` into `target` at
+    // `target_offset`, using the cheapest method the filesystem allows.
+    // Throws FileException on failure or if the source is too short.
+    static CopyMethod copy_range(const std::string& source, uint64_t source_offset,
+                                 const std::string& target, uint64_t target_offset,
+                                 uint64_t length);
+    // xxHash64 of a byte range, matching compute_block_hashes for a block
+    static std::vector<uint8_t> hash_range(const std::string& path, uint64_t offset, uint64_t length);
+    
     // Synchronization support
     enum class ConflictResolution {
         OVERWRITE,
@@ -105,6 +124,10 @@ private:
 
 class FileStream {
 public:
+    // Holes shorter than this are sent as data; a descriptor per filesystem
+    // block would cost more than the zeros
+    static constexpr uint64_t kMinHoleSize = 64 * 1024;
+
     FileStream();
     ~FileStream();
     
@@ -122,11 +145,24 @@ public:
     size_t read(uint64_t offset, uint8_t* buffer, size_t size);
     void write(uint64_t offset, const uint8_t* data, size_t size);
     
+    // (offset, length) ranges of [start, end) that hold data, from
+    // SEEK_DATA/SEEK_HOLE or FSCTL_QUERY_ALLOCATED_RANGES. Without
+    // filesystem support the whole range is reported as data.
+    std::vector<std::pair<uint64_t, uint64_t>> data_extents(uint64_t start, uint64_t end);
+    
+    // Makes [offset, offset + length) read as zeros, extending the file if
+    // needed. Existing bytes are deallocated where the filesystem can punch
+    // holes and overwritten with zeros otherwise.
+    void punch_hole(uint64_t offset, uint64_t length);
+    
     void close();
     bool is_open() const;
     std::string get_path() const { return path_; }
 
 private:
+    uint64_t current_size();
+    void write_zeros(uint64_t offset, uint64_t length);
+
 #ifdef _WIN32
     void* file_handle_;
 #else
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace netcopy {
+namespace file {
+
+// (offset, length) pairs, sorted and non-overlapping
+using ByteRanges = std::vector<std::pair<uint64_t, uint64_t>>;
+
+// Receiver-side record of which byte ranges of a destination file have been
+// written and acknowledged, kept in a small sidecar next to the file. It is
+// keyed by the file the bytes are written to: the staging file, not the
+// destination, while an upload is staged under durable_writes.
+//
+// Unlike the partial file size, the journal stays correct when the
+// destination was preallocated or filled by several parallel streams, so a
+// resumed transfer can send exactly the missing ranges. All connections that
+// write the same destination share one instance.
+class ResumeJournal {
+public:
+    static constexpr const char* kSuffix = ".netcopy-journal";
+
+    static std::string sidecar_path(const std::string& file_path);
+
+    // Returns the shared journal for `file_path`, creating it if needed.
+    // Persisted ranges are reused only when the sidecar was written for the
+    // same source size and modification time and the destination exists.
+    static std::shared_ptr<ResumeJournal> open(const std::string& file_path,
+                                               uint64_t file_size,
+                                               uint64_t last_modified);
+
+    // Like open(), but returns nullptr when there is no usable journal
+    static std::shared_ptr<ResumeJournal> load(const std::string& file_path,
+                                               uint64_t file_size,
+                                               uint64_t last_modified);
+
+    // Deletes the sidecar and stops any live instance from writing it again.
+    // Called when the destination is truncated or the transfer completes.
+    static void discard(const std::string& file_path);
+
+    void add_range(uint64_t offset, uint64_t length);
+    ByteRanges completed() const;
+    const std::string& file_path() const { return file_path_; }
+    uint64_t contiguous_prefix() const;
+
+    // Writes the sidecar if ranges changed. Without `force`, writes are
+    // spaced at least kPersistInterval apart; a lagging journal only costs
+    // some retransmission on resume.
+    void persist(bool force = false);
+
+    ResumeJournal(std::string file_path, uint64_t file_size, uint64_t last_modified);
+
+private:
+    static constexpr std::chrono::milliseconds kPersistInterval{1000};
+
+    bool read_sidecar();
+    bool matches(uint64_t file_size, uint64_t last_modified) const;
+
+    std::string file_path_;
+    uint64_t file_size_;
+    uint64_t last_modified_;
+
+    mutable std::mutex mutex_;
+    std::map<uint64_t, uint64_t> ranges_; // start -> end (exclusive)
+    bool dirty_ = false;
+    bool discarded_ = false;
+    std::chrono::steady_clock::time_point last_persist_{};
+};
+
+} // namespace file
+} // namespace netcopy
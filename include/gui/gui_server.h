@@ -8,6 +8,9 @@
 #include <memory>
 #include <condition_variable>
 #include "client/client.h"
+#include "client/connection_pool.h"
+#include "gui/listing_cache.h"
+#include "gui/transfer_scheduler.h"
 #include "network/event_loop.h"
 #include <asio.hpp>
 
@@ -17,19 +20,6 @@
 namespace netcopy {
 namespace gui {
 
-struct FileProgress {
-    std::string path;
-    uint64_t bytes_transferred = 0;
-    uint64_t total_bytes = 0;
-    std::string status = "pending"; // "pending", "transferring", "paused", "skipped", "completed", "failed", "exists_exact", "exists_partial"
-    std::string rate_string = "0 B/s";
-    uint64_t last_bytes = 0;
-    std::chrono::steady_clock::time_point last_time = std::chrono::steady_clock::now();
-    std::string decision = "none"; // "none", "start", "overwrite", "resume", "re-transfer"
-    bool is_directory = false;
-    bool popped = false;
-};
-
 struct ActiveTransfer {
     std::string id;
     std::string direction; // "upload" or "download"
@@ -41,15 +31,13 @@ struct ActiveTransfer {
     std::atomic<uint64_t> total_bytes{0};
     std::string current_file;
     std::string error_message;
-    std::vector<FileProgress> files;
+    TransferScheduler scheduler;
     std::mutex mutex;
     std::shared_ptr<client::Client> client_inst;
     std::thread thread;
     std::string session_id;
     std::string start_time;
     std::vector<std::string> session_ids;
-    std::condition_variable cv_task;
-    std::mutex task_mutex;
     std::atomic<bool> cancelled{false};
 };
 
@@ -101,6 +89,13 @@ private:
     std::string get_query_param(const std::string& query, const std::string& param);
     std::string get_json_value(const std::string& json, const std::string& key);
     std::vector<std::string> get_json_array(const std::string& json, const std::string& key);
+    // Profile of the connected server; the caller holds client_mutex_
+    client::ConnectionProfile remote_profile_locked(uint32_t parallel_streams = 0) const;
+    // Listing of a remote directory from the cache, revalidated or loaded
+    // from the server when needed
+    ListingCache::Listing remote_listing(const client::ConnectionProfile& profile,
+                                         const std::vector<std::string>& allowed_paths,
+                                         const std::string& path);
 
     uint16_t port_;
     std::atomic<bool> running_;
@@ -109,7 +104,8 @@ private:
 
     // Connection state
     std::mutex client_mutex_;
-    std::shared_ptr<client::Client> active_client_;
+    client::ConnectionPool pool_;
+    ListingCache listing_cache_;
     config::ClientConfig active_client_config_;
     crypto::SecurityLevel active_security_level_;
     bool remote_connected_;
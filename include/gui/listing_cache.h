@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace netcopy {
+namespace gui {
+
+// Remote directory listings the GUI has shown, with the server's version of
+// each. A listing validated in the last few seconds is served as is; an
+// older one is revalidated with a conditional request, which carries no
+// entries while the directory is unchanged. A background thread loads the
+// subdirectories of the folder being viewed before the user opens them.
+class ListingCache {
+public:
+    struct Listing {
+        uint64_t version = 0;
+        std::string files_json; // "files" array as sent to the browser
+        std::vector<std::string> subdirectories;
+    };
+
+    // Loads the listing of a path into the cache; runs on the prefetch thread
+    using Fetcher = std::function<void(const std::string& path)>;
+
+    ListingCache();
+    ~ListingCache();
+
+    ListingCache(const ListingCache&) = delete;
+    ListingCache& operator=(const ListingCache&) = delete;
+
+    void set_fetcher(Fetcher fetcher);
+
+    // Copies the cached listing of path; `fresh` is false when it must be
+    // revalidated before it is shown
+    bool lookup(const std::string& path, Listing& listing, bool& fresh);
+
+    // Changes counter: a listing fetched while it moved may predate a change,
+    // so store() and confirm() with an older value keep it unvalidated
+    uint64_t epoch() const;
+    void store(const std::string& path, Listing listing, uint64_t epoch);
+    // The server confirmed the cached version is still current
+    void confirm(const std::string& path, uint64_t epoch);
+
+    // Something at changed_path was written: the listings of it and of every
+    // directory above it are revalidated before they are shown again
+    void invalidate(const std::string& changed_path);
+    void clear();
+
+    // Replaces the queue of directories to load in the background
+    void prefetch(const std::vector<std::string>& paths);
+
+private:
+    struct Entry {
+        Listing listing;
+        std::chrono::steady_clock::time_point validated{};
+        std::chrono::steady_clock::time_point last_used{};
+    };
+
+    static std::string key(const std::string& path);
+    bool is_fresh(const Entry& entry, std::chrono::steady_clock::time_point now) const;
+    void evict_locked();
+    void prefetch_loop();
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::unordered_map<std::string, Entry> entries_;
+    size_t cached_bytes_ = 0;
+    uint64_t epoch_ = 0;
+    std::deque<std::string> queue_;
+    Fetcher fetcher_;
+    bool stopping_ = false;
+    std::thread prefetcher_;
+};
+
+} // namespace gui
+} // namespace netcopy
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace netcopy {
+namespace gui {
+
+enum class FileState : uint8_t {
+    Pending,
+    Transferring,
+    Paused,
+    Skipped,
+    Completed,
+    Failed,
+    ExistsExact,   // destination already has the whole file; waits for a decision
+    ExistsPartial  // destination has a prefix; waits for a decision
+};
+
+constexpr size_t kFileStateCount = 8;
+
+// Name used in the web API
+const char* file_state_name(FileState state);
+
+struct FileProgress {
+    std::string path;
+    uint64_t bytes_transferred = 0;
+    uint64_t total_bytes = 0;
+    FileState state = FileState::Pending;
+    std::string rate_string = "0 B/s";
+    uint64_t last_bytes = 0;
+    std::chrono::steady_clock::time_point last_time = std::chrono::steady_clock::now();
+    std::string decision = "none"; // "none", "start", "overwrite", "resume", "re-transfer", "delta_sync"
+    bool is_directory = false;
+    bool popped = false;
+};
+
+// Work queue of one GUI transfer. Files waiting with a decision sit in a
+// ready queue, per-state counts and byte totals are kept up to date on
+// every change, and workers sleep on a condition variable that state changes
+// signal. Picking the next file and answering progress queries therefore
+// never scan the file list.
+class TransferScheduler {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    struct Counters {
+        size_t files = 0;
+        size_t by_state[kFileStateCount] = {};
+        size_t ready = 0;
+        uint64_t bytes_transferred = 0;
+        uint64_t total_bytes = 0;
+
+        size_t count(FileState state) const { return by_state[static_cast<size_t>(state)]; }
+    };
+
+    // Task files are handed out to workers; other files (reported only by
+    // progress callbacks) are tracked for display
+    size_t add(FileProgress file, bool task = true);
+
+    // Index of the file with this path, ignoring the separator and, on
+    // Windows, case. Tasks are added under the source path, which is the
+    // spelling the client reports progress with, so a lookup never scans.
+    size_t find(const std::string& path) const;
+
+    // Takes the next ready task and marks it transferring. Blocks until one
+    // is ready; npos once every task has finished, after stop(), or when
+    // should_stop() (checked on every wake-up and at least once a second)
+    // returns true.
+    size_t acquire(std::string& decision, const std::function<bool()>& should_stop);
+
+    // Sleeps for up to `timeout`, returning early on stop()
+    void wait_for(std::chrono::milliseconds timeout);
+    void stop();
+
+    // Runs fn on the file under the scheduler lock, then updates the
+    // counters and the ready queue and wakes waiting workers
+    void update(size_t index, const std::function<void(FileProgress&)>& fn);
+    void update_all(const std::function<void(FileProgress&)>& fn);
+    // As update() for the file with this path; a file not found is added as
+    // a non-task entry first
+    void update_or_add(const std::string& path, const std::function<void(FileProgress&)>& fn);
+
+    void for_each(const std::function<void(const FileProgress&)>& fn) const;
+    Counters counters() const;
+
+private:
+    static bool is_finished(FileState state);
+    bool is_ready(size_t index) const;
+    size_t find_locked(const std::string& path) const;
+    size_t add_locked(FileProgress file, bool task);
+    // True when the change can matter to a waiting worker
+    bool update_locked(size_t index, const std::function<void(FileProgress&)>& fn);
+    void count(size_t index, int direction);
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<FileProgress> files_;
+    std::vector<bool> tasks_;
+    std::vector<bool> queued_;
+    std::unordered_map<std::string, size_t> by_path_;
+    std::deque<size_t> ready_;
+    Counters counters_;
+    size_t unfinished_tasks_ = 0;
+    bool stopped_ = false;
+};
+
+} // namespace gui
+} // namespace netcopy
@@ -52,13 +52,18 @@ public:
     AsyncSocket(const AsyncSocket&) = delete;
     AsyncSocket& operator=(const AsyncSocket&) = delete;
 
-    void connect(const std::string& host, uint16_t port, std::function<void(ErrorCode)> handler);
+    // With a local address, the connection leaves through the interface
+    // that owns it
+    void connect(const std::string& host, uint16_t port, std::function<void(ErrorCode)> handler,
+                 const std::string& local_address = "");
     void disconnect();
 
     // TLS support
     void enable_tls(asio::ssl::context& ctx);
     void async_handshake(asio::ssl::stream_base::handshake_type type, std::function<void(ErrorCode)> handler);
     bool is_tls() const { return ssl_stream_ != nullptr; }
+    // TLS exporter of the session; empty without TLS (see network/socket.h)
+    std::vector<uint8_t> export_keying_material(const std::string& label, size_t length);
 
     // Async I/O operations
     void async_read(void* buffer, size_t length, std::function<void(ErrorCode, size_t)> handler);
@@ -16,6 +16,9 @@ public:
     explicit EventLoop(size_t num_threads = 0);
     ~EventLoop();
 
+    // Pins the worker threads to one CPU; call before start()
+    void set_cpu(int cpu) { cpu_ = cpu; }
+
     // Start the event loop processing (spawns worker threads)
     void start();
 
@@ -34,6 +37,7 @@ private:
     std::vector<std::thread> workers_;
     size_t num_threads_;
     bool running_;
+    int cpu_ = -1;
 };
 
 } // namespace network
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace netcopy {
+namespace network {
+
+// Characteristics of an emulated WAN path. All delays are applied per
+// direction as half of the round-trip time, so a 150 ms profile yields a
+// 150 ms request/ACK round trip on loopback.
+struct LinkProfile {
+    uint32_t rtt_ms = 0;
+    uint32_t jitter_ms = 0;          // Uniform +/- jitter added to each segment
+    uint64_t bandwidth_bps = 0;      // Bits per second per direction, 0 = unlimited
+    double loss_rate = 0.0;          // 0.0 - 1.0, probability a segment needs a retransmit
+    double reorder_rate = 0.0;       // 0.0 - 1.0, probability a segment is held back
+    uint32_t reorder_delay_ms = 0;   // Hold-back for reordered segments (0 = rtt / 4)
+    uint64_t queue_bytes = 0;        // Bottleneck buffer, 0 = 2x bandwidth-delay product
+    uint64_t seed = 1;               // RNG seed, identical seeds give identical schedules
+
+    bool is_passthrough() const;
+    std::string to_string() const;
+
+    // Parses "rtt=150ms,jitter=5ms,rate=100mbit,loss=0.5%,reorder=1%,seed=7".
+    // Throws ConfigException on malformed input.
+    static LinkProfile parse(const std::string& spec);
+};
+
+// In-process TCP relay that shapes traffic between a loopback listener and a
+// target endpoint. Each accepted connection gets two shaping pipes (one per
+// direction) that model serialization delay, propagation delay, jitter,
+// retransmission delay for lost segments and head-of-line blocking for
+// reordered segments. Bytes are always delivered intact and in order, as TCP
+// would do over a real lossy path.
+class LinkEmulator {
+public:
+    LinkEmulator(const std::string& target_host, uint16_t target_port, const LinkProfile& profile);
+    ~LinkEmulator();
+
+    LinkEmulator(const LinkEmulator&) = delete;
+    LinkEmulator& operator=(const LinkEmulator&) = delete;
+
+    // Binds 127.0.0.1 on `listen_port` (0 = ephemeral) and starts accepting.
+    void start(uint16_t listen_port = 0);
+    void stop();
+
+    uint16_t listen_port() const { return listen_port_; }
+    const LinkProfile& profile() const { return profile_; }
+
+    uint64_t bytes_forwarded() const { return bytes_forwarded_.load(); }
+    uint64_t segments_lost() const { return segments_lost_.load(); }
+    uint64_t segments_reordered() const { return segments_reordered_.load(); }
+
+    // Connect-time redirection used by Socket/AsyncSocket when built with
+    // NETCOPY_WITH_LINK_EMULATION. If the NETCOPY_LINK_EMULATION environment
+    // variable holds a profile, host/port are rewritten to a process-wide
+    // emulator in front of the original target. Returns true if redirected.
+    static bool redirect_if_enabled(std::string& host, uint16_t& port);
+
+private:
+    struct Connection;
+    class Pipe;
+
+    void accept_loop();
+    void reap_finished(bool all);
+
+    std::string target_host_;
+    uint16_t target_port_;
+    LinkProfile profile_;
+    uint16_t listen_port_ = 0;
+
+    asio::io_context io_context_;
+    std::unique_ptr<asio::ip::tcp::acceptor> acceptor_;
+    std::thread accept_thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> connection_counter_{0};
+
+    std::mutex connections_mutex_;
+    std::vector<std::unique_ptr<Connection>> connections_;
+
+    std::atomic<uint64_t> bytes_forwarded_{0};
+    std::atomic<uint64_t> segments_lost_{0};
+    std::atomic<uint64_t> segments_reordered_{0};
+};
+
+} // namespace network
+} // namespace netcopy
@@ -27,6 +27,7 @@
 
 #include <string>
 #include <cstdint>
+#include <vector>
 #include <wolfssl/openssl/ssl.h>
 #include <wolfssl/openssl/err.h>
 
@@ -51,6 +52,11 @@
 namespace netcopy {
 namespace network {
 
+// TLS exporter (RFC 5705, RFC 8446 section 7.5) of an established session.
+// Empty when there is no session or wolfSSL was built without
+// HAVE_KEYING_MATERIAL.
+std::vector<uint8_t> tls_export_keying_material(SSL* ssl, const std::string& label, size_t length);
+
 class Socket {
 public:
     Socket();
@@ -81,6 +87,9 @@ public:
     void enable_tls_server(const std::string& cert_file, const std::string& key_file, const std::string& dh_file = "");
     void perform_tls_handshake();
     bool is_tls() const { return ssl_ != nullptr; }
+    std::vector<uint8_t> export_keying_material(const std::string& label, size_t length) const {
+        return tls_export_keying_material(ssl_, label, length);
+    }
 
     // Data operations
     size_t send(const void* data, size_t length);
@@ -4,7 +4,9 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <utility>
 #include "crypto/chacha20_poly1305.h"
+#include "crypto/cipher_benchmark.h"
 
 namespace netcopy {
 namespace protocol {
@@ -35,7 +37,12 @@ enum class MessageType : uint32_t {
     BLOCK_HASHES_REQUEST = 23,
     BLOCK_HASHES_RESPONSE = 24,
     TRANSFER_STATUS_REQUEST = 25,
-    TRANSFER_STATUS_RESPONSE = 26
+    TRANSFER_STATUS_RESPONSE = 26,
+    MERKLE_NODES_REQUEST = 27,
+    MERKLE_NODES_RESPONSE = 28,
+    BLOCK_COPY_REQUEST = 29,
+    BLOCK_COPY_RESPONSE = 30,
+    ADMISSION_UPDATE = 31
 };
 
 struct MessageHeader {
@@ -81,6 +88,15 @@ public:
     // Auth fields (appended last for backward compatibility)
     std::string username;       // empty = anonymous
     uint8_t auth_method_id;     // 0=none, 1=password, 2=mlkem
+    // The client handles AdmissionUpdate messages arriving before a reply
+    bool accepts_admission_updates = false;
+    // Security level "auto": the server picks the cipher from both sides'
+    // measured rates; security_level is the fallback for older servers
+    bool auto_security_level = false;
+    crypto::CipherRates cipher_rates;
+    // Offer to skip payload encryption under TLS: the client's proof for
+    // this TLS session (common::tls_binding_proof); empty = no offer
+    std::vector<uint8_t> tls_binding;
     
     std::vector<uint8_t> serialize_payload() const override;
     void deserialize_payload(const std::vector<uint8_t>& data) override;
@@ -97,6 +113,10 @@ public:
     uint64_t max_chunk_size;  // Maximum chunk size server can handle
     uint32_t accepted_parallel_streams;
     bool auto_create_directories_allowed;
+    crypto::CipherRates cipher_rates;
+    // The server's proof when it accepted tls_binding; payloads are then
+    // protected by TLS alone. Empty = the usual encrypted session.
+    std::vector<uint8_t> tls_binding;
     
     std::vector<uint8_t> serialize_payload() const override;
     void deserialize_payload(const std::vector<uint8_t>& data) override;
@@ -120,6 +140,12 @@ public:
     uint64_t file_size = 0;
     uint64_t last_modified = 0;
     
+    // Leaf size the client wants a Merkle tree built with (0 = none)
+    uint64_t merkle_leaf_size = 0;
+    
+    // The source has holes the client would rather send as descriptors
+    bool sparse = false;
+    
     std::vector<uint8_t> serialize_payload() const override;
     void deserialize_payload(const std::vector<uint8_t>& data) override;
 };
@@ -134,6 +160,20 @@ public:
     uint64_t resume_offset;
     std::string session_id;
     
+    // Set on resume when the receiver keeps a range journal for the file;
+    // completed_ranges then lists (offset, length) of data already written
+    bool has_range_journal = false;
+    std::vector<std::pair<uint64_t, uint64_t>> completed_ranges;
+    
+    // Non-zero when the server builds a Merkle tree of the upload
+    uint64_t merkle_leaf_size = 0;
+    
+    // The server accepts hole chunks for this upload
+    bool sparse = false;
+    
+    // The server accepts BlockCopyRequest for this upload
+    bool block_copy = false;
+    
     std::vector<uint8_t> serialize_payload() const override;
     void deserialize_payload(const std::vector<uint8_t>& data) override;
 };
@@ -149,6 +189,9 @@ public:
         std::vector<uint8_t> data;
         bool is_last_chunk;
         bool compressed;
+        // No payload: [offset, offset + uncompressed_size) is a hole of zeros.
+        // Only sent when the receiver agreed to a sparse transfer.
+        bool hole = false;
         
         // Serialization helper for individual chunk
         std::vector<uint8_t> serialize_payload() const;
@@ -164,6 +207,7 @@ public:
     std::vector<uint8_t> data;
     bool is_last_chunk;
     bool compressed;
+    bool hole = false;
     
     std::vector<uint8_t> serialize_payload() const override;
     void deserialize_payload(const std::vector<uint8_t>& data) override;
@@ -276,6 +320,11 @@ struct RemoteFileInfo {
     std::string symlink_target;
 };
 
+struct BlockHashInfo {
+    uint64_t offset;
+    std::vector<uint8_t> hash;
+};
+
 class DownloadRequest : public Message {
 public:
     DownloadRequest();
@@ -283,6 +332,15 @@ public:
     std::string remote_path;
     uint64_t resume_offset = 0;
     
+    // The client can decompress chunks (older clients cannot)
+    bool accept_compression = false;
+    // Download delta mode: signatures of the client's existing copy. The
+    // server sends only blocks whose hash differs.
+    uint64_t delta_block_size = 0;
+    std::vector<BlockHashInfo> local_blocks;
+    // The client can recreate holes from hole chunks
+    bool accept_sparse = false;
+    
     std::vector<uint8_t> serialize_payload() const override;
     void deserialize_payload(const std::vector<uint8_t>& data) override;
 };
@@ -303,6 +361,11 @@ public:
     std::string session_id;
     uint64_t last_modified = 0;
     
+    // Only changed ranges follow; the client keeps its other bytes
+    bool delta_applied = false;
+    // Holes of the source follow as hole chunks
+    bool sparse = false;
+    
     std::vector<uint8_t> serialize_payload() const override;
     void deserialize_payload(const std::vector<uint8_t>& data) override;
 };
@@ -313,6 +376,9 @@ public:
     
     std::string remote_path;
     bool recursive;
+    // Version of a listing the client already holds (0: none). While it
+    // still matches, the response carries no entries.
+    uint64_t known_version = 0;
     
     std::vector<uint8_t> serialize_payload() const override;
     void deserialize_payload(const std::vector<uint8_t>& data) override;
@@ -325,6 +391,11 @@ public:
     bool success;
     std::string error_message;
     std::vector<RemoteFileInfo> entries;
+    // Digest of the listing's names, sizes, times and metadata; 0 from
+    // servers that do not compute it
+    uint64_t version = 0;
+    // The client's known_version is current; entries is empty
+    bool not_modified = false;
     
     std::vector<uint8_t> serialize_payload() const override;
     void deserialize_payload(const std::vector<uint8_t>& data) override;
@@ -344,6 +415,8 @@ public:
     
     std::string file_path;
     std::vector<uint8_t> expected_hash;
+    // Compared instead of expected_hash when set
+    std::vector<uint8_t> merkle_root;
     
     std::vector<uint8_t> serialize_payload() const override;
     void deserialize_payload(const std::vector<uint8_t>& data) override;
@@ -356,6 +429,10 @@ public:
     bool success;
     std::string error_message;
     std::vector<uint8_t> actual_hash;
+    std::vector<uint8_t> merkle_root;
+    // The upload was flushed and renamed into place before this answer
+    // (server durable_writes)
+    bool durable = false;
     
     std::vector<uint8_t> serialize_payload() const override;
     void deserialize_payload(const std::vector<uint8_t>& data) override;
@@ -372,11 +449,6 @@ public:
     void deserialize_payload(const std::vector<uint8_t>& data) override;
 };
 
-struct BlockHashInfo {
-    uint64_t offset;
-    std::vector<uint8_t> hash;
-};
-
 class BlockHashesResponse : public Message {
 public:
     BlockHashesResponse();
@@ -416,6 +488,81 @@ public:
     void deserialize_payload(const std::vector<uint8_t>& data) override;
 };
 
+// Fetches node hashes of the server's Merkle tree for the current upload,
+// used to narrow a root mismatch down to the leaves that differ
+class MerkleNodesRequest : public Message {
+public:
+    MerkleNodesRequest();
+    
+    std::string file_path;
+    uint32_t level = 0;             // 0 = leaves
+    std::vector<uint64_t> indices;
+    
+    std::vector<uint8_t> serialize_payload() const override;
+    void deserialize_payload(const std::vector<uint8_t>& data) override;
+};
+
+class MerkleNodesResponse : public Message {
+public:
+    MerkleNodesResponse();
+    
+    bool success = false;
+    std::string error_message;
+    std::vector<std::vector<uint8_t>> hashes; // parallel to the request's indices
+    
+    std::vector<uint8_t> serialize_payload() const override;
+    void deserialize_payload(const std::vector<uint8_t>& data) override;
+};
+
+struct BlockCopyRange {
+    uint64_t source_offset = 0;
+    uint64_t target_offset = 0;
+    uint64_t length = 0;
+    std::vector<uint8_t> hash; // xxHash64 of the bytes, as in BlockHashesResponse
+};
+
+// Fills ranges of the upload in progress from a file already on the server
+// instead of sending the bytes. The server checks each source range against
+// its hash before copying.
+class BlockCopyRequest : public Message {
+public:
+    BlockCopyRequest();
+    
+    std::string source_path;
+    std::vector<BlockCopyRange> ranges;
+    
+    std::vector<uint8_t> serialize_payload() const override;
+    void deserialize_payload(const std::vector<uint8_t>& data) override;
+};
+
+class BlockCopyResponse : public Message {
+public:
+    BlockCopyResponse();
+    
+    bool success = false;
+    std::string error_message;
+    std::vector<uint8_t> copied; // 1 per range copied; the rest must be sent
+    uint64_t bytes_copied = 0;
+    
+    std::vector<uint8_t> serialize_payload() const override;
+    void deserialize_payload(const std::vector<uint8_t>& data) override;
+};
+
+// Sent by the server ahead of a reply when its load changed the grant made
+// at handshake. The client uses no more streams, no larger chunks and, when
+// set, no larger upload window.
+class AdmissionUpdate : public Message {
+public:
+    AdmissionUpdate();
+    
+    uint32_t max_parallel_streams = 1;
+    uint64_t max_chunk_size = 0;
+    uint64_t inflight_window_bytes = 0; // 0 = no restriction
+    
+    std::vector<uint8_t> serialize_payload() const override;
+    void deserialize_payload(const std::vector<uint8_t>& data) override;
+};
+
 } // namespace protocol
 } // namespace netcopy
 
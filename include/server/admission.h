@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace netcopy {
+namespace server {
+
+// Server-wide budget of parallel streams. Every connection counts as one
+// stream of the client address it comes from; each client is granted a fair
+// share of the budget, which shrinks while the CPU is saturated or disk I/O
+// queues up. Chunk sizes are scaled down once more streams are active than
+// the budget allows, so in-flight data stays bounded under contention.
+class AdmissionController {
+public:
+    struct Grant {
+        uint32_t streams = 1;
+        size_t max_chunk_size = 0;
+    };
+
+    static AdmissionController& instance();
+
+    // 0 sizes the budget from the CPU count
+    void configure(int max_active_streams);
+
+    void add_stream(const std::string& client);
+    void remove_stream(const std::string& client);
+
+    // Grant for a client asking for `requested` streams and chunks of up to
+    // `max_chunk_size` bytes. Calling it again later yields the current one.
+    Grant grant(const std::string& client, uint32_t requested, size_t max_chunk_size);
+
+    uint32_t budget();
+    uint32_t active_streams() const;
+
+    // Brackets one disk read or write so the queue depth is known
+    class DiskOperation {
+    public:
+        DiskOperation();
+        ~DiskOperation();
+        DiskOperation(const DiskOperation&) = delete;
+        DiskOperation& operator=(const DiskOperation&) = delete;
+    };
+
+private:
+    static constexpr uint32_t kMaxStreamsPerClient = 8;
+    static constexpr size_t kMinGrantedChunkSize = 64 * 1024;
+
+    AdmissionController() = default;
+
+    // System-wide CPU busy fraction, resampled at most once a second
+    double cpu_utilization();
+    void update_metrics_locked();
+
+    mutable std::mutex mutex_;
+    uint32_t configured_budget_ = 0;
+    uint32_t active_streams_ = 0;
+    std::map<std::string, uint32_t> streams_by_client_;
+
+    std::atomic<uint32_t> disk_operations_{0};
+    // Moving average of the queue depth seen by new operations, x256
+    std::atomic<uint32_t> disk_queue_average_{0};
+
+    std::chrono::steady_clock::time_point cpu_sampled_at_{};
+    uint64_t cpu_busy_ticks_ = 0;
+    uint64_t cpu_total_ticks_ = 0;
+    double cpu_utilization_ = 0.0;
+};
+
+} // namespace server
+} // namespace netcopy
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "file/file_manager.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace netcopy {
+namespace server {
+
+// Server-wide cache of recently downloaded file content, for many clients
+// fetching the same file. Files are identified by path, modification time
+// and size, so a changed file is never served from the cache. It holds
+// aligned blocks of file data (with their compressed form once a client
+// asked for compression) under an LRU byte budget, plus each file's SHA3
+// hash and delta block hashes. A block that several connections want at
+// once is read from disk a single time.
+//
+// Only hot files are cached: ones downloaded at least twice within a few
+// minutes, so a one-off download of a large file does not evict them.
+class ChunkCache {
+public:
+    // Cached blocks start at multiples of this; download chunks are cut at
+    // block boundaries so each is a slice of one block
+    static constexpr uint64_t kBlockSize = 4ull * 1024 * 1024;
+
+    struct FileKey {
+        std::string path;
+        uint64_t modified = 0; // file clock ticks, finer than FileManager's seconds
+        uint64_t size = 0;
+
+        // Empty path when the file cannot be stat'ed
+        static FileKey of(const std::string& path, uint64_t size);
+        std::string id() const;
+    };
+
+    struct Block {
+        std::vector<uint8_t> data;
+        // Compressed form of the whole block; empty when it did not shrink
+        // or was never asked for
+        std::vector<uint8_t> compressed;
+        bool compression_tried = false;
+    };
+    using BlockPtr = std::shared_ptr<const Block>;
+    using ReadFn = std::function<size_t(uint64_t offset, uint8_t* out, size_t length)>;
+
+    static ChunkCache& instance();
+
+    // 0 disables the cache
+    void configure(uint64_t capacity_bytes);
+    bool enabled() const;
+
+    // Counts a download of the file; true when it is hot enough to cache
+    bool note_download(const FileKey& key);
+
+    // Block `index` of the file, read with `read` on a miss. With
+    // `compress` the compressed form is computed too (once per block).
+    // Never returns nullptr; read errors propagate as exceptions.
+    BlockPtr block(const FileKey& key, uint64_t index, bool compress, const ReadFn& read);
+
+    bool file_hash(const FileKey& key, std::vector<uint8_t>& hash);
+    void store_file_hash(const FileKey& key, const std::vector<uint8_t>& hash);
+    bool block_hashes(const FileKey& key, uint64_t block_size, std::vector<file::FileManager::BlockHash>& hashes);
+    void store_block_hashes(const FileKey& key, uint64_t block_size,
+                            const std::vector<file::FileManager::BlockHash>& hashes);
+
+private:
+    struct Entry {
+        BlockPtr block;
+        uint64_t bytes = 0;
+        std::list<std::string>::iterator lru;
+    };
+    struct FileInfo {
+        std::vector<std::chrono::steady_clock::time_point> downloads;
+        std::vector<uint8_t> hash;
+        std::map<uint64_t, std::vector<file::FileManager::BlockHash>> block_hashes;
+        std::chrono::steady_clock::time_point used_at{};
+    };
+
+    ChunkCache() = default;
+
+    BlockPtr load(const FileKey& key, uint64_t index, bool compress, const ReadFn& read, BlockPtr uncompressed);
+    void insert_locked(const std::string& id, BlockPtr block);
+    void evict_locked();
+    FileInfo& file_locked(const FileKey& key);
+
+    mutable std::mutex mutex_;
+    uint64_t capacity_ = 0;
+    uint64_t used_ = 0;
+    std::map<std::string, Entry> blocks_;
+    std::list<std::string> lru_; // most recently used first
+    // Single-flight: block id -> the read everyone interested waits for
+    std::map<std::string, std::shared_future<BlockPtr>> loading_;
+    std::map<std::string, FileInfo> files_;
+};
+
+} // namespace server
+} // namespace netcopy
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace netcopy {
+namespace server {
+
+// Server-wide group commit for [performance] durable_writes. Uploads are
+// written to a staging file next to the destination; once complete they
+// are queued here, and a single committer thread flushes everything queued
+// with as few sync calls as it can (one syncfs per file system for a large
+// batch, otherwise fdatasync after writeback was already started), then
+// renames each staging file over its destination and syncs the directories
+// once. A crash leaves either the old file or the complete new one, and
+// many small files share the cost of a flush instead of paying one each.
+class DurableCommitter {
+public:
+    enum class State {
+        None,     // nothing pending for that destination
+        Durable,  // renamed into place and flushed
+        Failed
+    };
+
+    static DurableCommitter& instance();
+
+    // window: how long the committer lets a batch fill before flushing it
+    void configure(bool enabled, std::chrono::milliseconds window);
+    void stop();
+    bool enabled() const;
+
+    // Staging file for a destination: ".<name>.ncpart" in the same directory,
+    // so the final rename never crosses file systems
+    static std::string stage_path(const std::string& destination);
+
+    // Records that an upload to destination is being written to its staging
+    // file, so the other streams of the upload write there as well
+    void begin_stage(const std::string& destination);
+    // Staging file an upload to destination currently writes to, or "" when
+    // it is written in place
+    std::string active_stage(const std::string& destination) const;
+    // Forgets an upload that ended without submitting; its staging file is
+    // kept for a resume
+    void abandon_stage(const std::string& destination);
+
+    // Queues a complete staging file to replace destination; returns at once
+    void submit(const std::string& destination);
+    // Waits until the last submission for destination is committed; None
+    // when nothing was submitted for it
+    State wait(const std::string& destination, std::string* error = nullptr);
+
+private:
+    struct Entry {
+        std::string stage;
+        std::string destination;
+        uint64_t ticket = 0;
+    };
+    struct Outcome {
+        uint64_t ticket = 0;
+        bool done = false;
+        bool failed = false;
+        std::string error;
+    };
+
+    DurableCommitter() = default;
+    ~DurableCommitter();
+
+    void run();
+    void commit_batch(std::deque<Entry>& batch);
+
+    mutable std::mutex mutex_;
+    std::condition_variable queued_;
+    std::condition_variable committed_;
+    std::deque<Entry> queue_;
+    // Destination -> staging file of uploads not yet submitted
+    std::map<std::string, std::string> stages_;
+    // Destination -> state of its last submission, dropped once waited for
+    std::map<std::string, Outcome> outcomes_;
+    uint64_t next_ticket_ = 0;
+    bool enabled_ = false;
+    bool stopping_ = false;
+    std::chrono::milliseconds window_{0};
+    std::thread thread_;
+};
+
+} // namespace server
+} // namespace netcopy
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "config/config_parser.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace netcopy {
+namespace server {
+
+// The server configuration that new and running connections work from.
+// A reload (SIGHUP, e.g. sent by `net_copy_admin tune`) publishes a new
+// immutable snapshot; connections compare generations at chunk boundaries
+// and copy the tunable fields of a newer one, so in-flight transfers pick
+// up the change without reconnecting. Only the [performance] section and
+// the transfer tuning keys of [protocol.internal] change live; everything
+// else keeps its start-up value until a restart.
+class LiveConfig {
+public:
+    static LiveConfig& instance();
+
+    void publish(const config::ServerConfig& config);
+    // nullptr before the first publish
+    std::shared_ptr<const config::ServerConfig> snapshot(uint64_t* generation = nullptr) const;
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+    // Copies the fields a reload may change from `from` into `to`
+    static void copy_tunables(const config::ServerConfig& from, config::ServerConfig& to);
+    // Settings that differ between the two but only apply after a restart
+    static std::vector<std::string> restart_only_changes(const config::ServerConfig& running,
+                                                         const config::ServerConfig& loaded);
+
+private:
+    LiveConfig() = default;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<const config::ServerConfig> current_;
+    std::atomic<uint64_t> generation_{0};
+};
+
+} // namespace server
+} // namespace netcopy
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace netcopy {
+namespace server {
+
+// Server-wide accountant for the large transient buffers of all
+// connections: received frames, decrypted and decompressed payloads and
+// download batches. A connection that cannot reserve its next frame stops
+// reading, so TCP pushes back on the client instead of the server growing
+// until it is killed.
+class MemoryBudget {
+public:
+    // Allocations below this never wait; ACKs and control messages must get
+    // through even when the budget is exhausted, or downloads that hold
+    // batch buffers could never be acknowledged.
+    static constexpr size_t kSmallAllocation = 64 * 1024;
+
+    static MemoryBudget& instance();
+
+    // 0 sizes the budget from physical memory
+    void configure(uint64_t limit_bytes);
+
+    uint64_t limit() const;
+    uint64_t reserved() const;
+    // Fraction of the budget reserved, 0 when unlimited
+    double pressure() const;
+
+    // In-flight window to advise clients at the current pressure; 0 means
+    // no restriction
+    uint64_t advised_window(uint64_t configured_window) const;
+
+    // Holds `bytes` of the budget until destroyed or resized. Waits while
+    // the budget is exhausted, but never longer than kMaxWait: past that
+    // the reservation is granted anyway so a stuck peer cannot wedge the
+    // server.
+    class Reservation {
+    public:
+        Reservation() = default;
+        explicit Reservation(uint64_t bytes);
+        ~Reservation();
+        Reservation(Reservation&& other) noexcept;
+        Reservation& operator=(Reservation&& other) noexcept;
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+
+        // Shrinking never waits
+        void resize(uint64_t bytes);
+        void release();
+        uint64_t bytes() const { return bytes_; }
+
+    private:
+        uint64_t bytes_ = 0;
+    };
+
+private:
+    MemoryBudget() = default;
+
+    void acquire(uint64_t bytes);
+    void give_back(uint64_t bytes);
+
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+    uint64_t limit_ = 0;
+    uint64_t reserved_ = 0;
+};
+
+} // namespace server
+} // namespace netcopy
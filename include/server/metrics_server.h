@@ -0,0 +1,41 @@
+#pragma once
+
+#include "network/event_loop.h"
+#include <asio.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace netcopy {
+namespace server {
+
+// Minimal HTTP exporter serving common::MetricsRegistry on GET /metrics and,
+// while chunk tracing is on, the current Chrome trace on GET /trace.
+// Runs on its own single-threaded event loop so scrapes never compete with
+// the transfer acceptor.
+class MetricsServer {
+public:
+    MetricsServer(const std::string& listen_address, uint16_t port);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    void start();
+    void stop();
+    uint16_t port() const { return port_; }
+
+private:
+    void do_accept();
+    void handle(std::shared_ptr<asio::ip::tcp::socket> socket);
+
+    std::string listen_address_;
+    uint16_t port_;
+    std::atomic<bool> running_{false};
+    std::unique_ptr<network::EventLoop> event_loop_;
+    std::unique_ptr<asio::ip::tcp::acceptor> acceptor_;
+};
+
+} // namespace server
+} // namespace netcopy
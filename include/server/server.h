@@ -4,9 +4,11 @@
 #include "crypto/chacha20_poly1305.h"
 #include "crypto/crypto_engine.h"
 #include "crypto/sha3.h"
+#include "crypto/merkle_tree.h"
 #include "config/config_parser.h"
 #include "protocol/message.h"
 #include "file/file_manager.h"
+#include "file/resume_journal.h"
 #include "auth/user_db.h"
 #include <memory>
 #include <string>
@@ -14,9 +16,13 @@
 #include <atomic>
 #include <vector>
 #include <mutex>
+#include <chrono>
 #include "network/event_loop.h"
 #include "auth/auth_engine.h"
 #include "network/ssh_server.h"
+#include "server/metrics_server.h"
+#include "server/memory_budget.h"
+#include "common/metrics.h"
 #include <asio.hpp>
 
 namespace netcopy {
@@ -42,6 +48,11 @@ private:
     uint32_t sequence_number_;
     std::string client_address_;
     std::string current_file_path_;  // Track the current file being transferred
+    // Staging file the data goes to under durable_writes; empty when the
+    // upload is written in place
+    std::string current_stage_path_;
+    // This connection started the staged upload and submits or abandons it
+    bool current_stage_owned_ = false;
     bool handshake_completed_;  // Track if handshake is done
     bool transport_encryption_active_;
     bool current_auto_create_;
@@ -55,9 +66,16 @@ private:
     uint64_t current_expected_file_size_ = 0;
     uint64_t current_expected_last_modified_ = 0;
     bool current_preallocated_ = false;
+    // The client sends holes as hole chunks; preallocation would fill them
+    bool current_sparse_ = false;
+    // Shared with other connections writing the same destination
+    std::shared_ptr<file::ResumeJournal> current_journal_;
     std::unique_ptr<crypto::Sha3Hasher> current_upload_hasher_;
     uint64_t current_upload_hash_next_offset_ = 0;
     bool current_upload_hash_valid_ = false;
+    // Replaces the linear hasher when the client asked for a Merkle tree;
+    // shared with the other streams of the same upload
+    std::shared_ptr<crypto::MerkleTree> current_upload_tree_;
     std::vector<uint8_t> last_received_file_hash_;
     std::string last_received_file_hash_path_;
     bool last_received_file_hash_valid_ = false;
@@ -81,6 +99,22 @@ private:
     int auth_failure_count_ = 0;
     static constexpr int MAX_AUTH_FAILURES = 5;
     std::shared_ptr<ServerTransferSession> current_session_;
+    // Per-user byte counters, bound once the peer is authenticated
+    common::MetricCounter* bytes_received_metric_ = nullptr;
+    common::MetricCounter* bytes_sent_metric_ = nullptr;
+    // Admission: this connection counts as one stream of admission_client_
+    std::string admission_client_;
+    bool admission_registered_ = false;
+    bool accepts_admission_updates_ = false;
+    uint32_t requested_streams_ = 1;
+    uint32_t granted_streams_ = 1;
+    size_t granted_chunk_size_ = 0;
+    uint64_t granted_window_bytes_ = 0;
+    // Budget held by the last received frame
+    MemoryBudget::Reservation frame_reservation_;
+    std::chrono::steady_clock::time_point admission_checked_at_{};
+    // LiveConfig generation config_'s tunable fields were last copied from
+    uint64_t tuning_generation_ = 0;
     
     // Protocol handling
     void perform_handshake();
@@ -91,6 +125,15 @@ private:
     void handle_file_verify_request(const protocol::FileVerifyRequest& request);
     void handle_block_hashes_request(const protocol::BlockHashesRequest& request);
     void handle_transfer_status_request(const protocol::TransferStatusRequest& request);
+    void handle_merkle_nodes_request(const protocol::MerkleNodesRequest& request);
+    void handle_block_copy_request(const protocol::BlockCopyRequest& request);
+    // Tells the client when its grant changed, at most once a second
+    void send_admission_update_if_changed();
+    // Picks up reloaded tuning; true when config_ changed. Called at chunk
+    // and batch boundaries.
+    bool refresh_tuning();
+    bool verify_merkle_root(const std::string& resolved, const protocol::FileVerifyRequest& request,
+                            protocol::FileVerifyResponse& response);
     
     // Message handling
     void send_message(const protocol::Message& message);
@@ -103,6 +146,10 @@ private:
     // File operations
     bool is_path_allowed(const std::string& path);
     std::string resolve_path(const std::string& path);
+    // Where the data of the current upload is written
+    const std::string& write_path() const;
+    std::string select_stage_path(const std::string& resolved_path, const protocol::FileRequest& request);
+    void abandon_stage();
     
     // Utility functions
     uint32_t get_next_sequence_number();
@@ -125,6 +172,13 @@ public:
     void stop();
     bool is_running() const;
     
+    // Chrome trace file rewritten after every connection while tracing is on
+    void set_trace_output(const std::string& path);
+    
+    // Re-reads the configuration file and applies its [performance]
+    // settings to new and running connections (SIGHUP)
+    void reload_config();
+    
     // Daemon operations
     void run_as_daemon();
     
@@ -133,14 +187,22 @@ public:
     void run_relay_server(const std::string& listen_address);
 
 private:
-    std::unique_ptr<network::EventLoop> event_loop_;
-    std::unique_ptr<asio::ip::tcp::acceptor> acceptor_;
+    // A listening socket with its own event loop. With [performance]
+    // accept_shards above 1 there is one per shard, all bound to the port
+    // with SO_REUSEPORT; the kernel spreads connections across them.
+    struct AcceptShard {
+        std::unique_ptr<network::EventLoop> event_loop;
+        std::unique_ptr<asio::ip::tcp::acceptor> acceptor;
+        int cpu = -1; // core the shard and its connections run on, -1 when unpinned
+    };
+    std::vector<AcceptShard> accept_shards_;
     config::ServerConfig config_;
     std::shared_ptr<crypto::ChaCha20Poly1305> crypto_;
     std::atomic<bool> running_;
     auth::UserDb user_db_;
     std::unique_ptr<auth::AuthEngine> auth_engine_;
     std::unique_ptr<network::SshServer> ssh_server_;
+    std::unique_ptr<MetricsServer> metrics_server_;
     
     struct WorkerThread {
         std::thread thread;
@@ -148,9 +210,17 @@ private:
     };
     std::vector<WorkerThread> worker_threads_;
     std::mutex worker_threads_mutex_;
+    std::string trace_output_;
+    // Absolute path given to load_config and the settings it held before
+    // command line overrides, to tell what a reload changed
+    std::string config_file_;
+    config::ServerConfig file_config_;
+    std::mutex trace_output_mutex_;
     
-    void do_accept();
+    void open_accept_shards(const asio::ip::tcp::endpoint& endpoint);
+    void do_accept(AcceptShard& shard);
     void handle_client(network::Socket client_socket);
+    void flush_trace();
     void cleanup_threads(bool force_join_all = false);
 };
 
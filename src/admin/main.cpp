@@ -7,8 +7,11 @@
 #include "crypto/aes_ctr.h"
 #include "client/client.h"
 #include "common/utils.h"
+#include "config/config_parser.h"
 #include "exceptions.h"
 #include <iomanip>
+#include <fstream>
+#include <filesystem>
 
 #include <iostream>
 #include <string>
@@ -16,6 +19,9 @@
 #include <map>
 #include <vector>
 #include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
 #include <algorithm>
 
 #ifdef _WIN32
@@ -23,6 +29,8 @@
 #else
 #  include <termios.h>
 #  include <unistd.h>
+#  include <signal.h>
+#  include <sys/types.h>
 #endif
 
 // ============================================================
@@ -508,6 +516,165 @@ static void cmd_ls(const std::map<std::string, std::string>& args) {
     }
 }
 
+// ============================================================
+// tune: live server settings
+// ============================================================
+
+static std::string trim_copy(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+// Section of a "[name]" line, "" for any other line
+static std::string section_of(const std::string& line) {
+    std::string t = trim_copy(line);
+    if (t.size() > 2 && t.front() == '[' && t.back() == ']') return trim_copy(t.substr(1, t.size() - 2));
+    return "";
+}
+
+static bool is_key_line(const std::string& line, const std::string& key) {
+    std::string t = trim_copy(line);
+    if (t.compare(0, key.size(), key) != 0) return false;
+    return trim_copy(t.substr(key.size())).compare(0, 1, "=") == 0;
+}
+
+// Sets key in the config text, keeping comments and order. The transfer
+// settings are read from [protocol.internal] first, so a key already there
+// is changed there; otherwise it goes to [performance].
+static void set_config_line(std::vector<std::string>& lines, const std::string& key, const std::string& value) {
+    const std::string entry = key + " = " + value;
+    for (const char* preferred : {"protocol.internal", "performance"}) {
+        std::string current;
+        for (auto& line : lines) {
+            std::string s = section_of(line);
+            if (!s.empty()) { current = s; continue; }
+            if (current == preferred && is_key_line(line, key)) {
+                line = entry;
+                return;
+            }
+        }
+    }
+    // Not present: append to [performance], creating it if needed
+    std::string current;
+    size_t insert_at = lines.size();
+    bool found = false;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        std::string s = section_of(lines[i]);
+        if (!s.empty()) {
+            if (found) break;
+            current = s;
+            found = (current == "performance");
+            if (found) insert_at = i + 1;
+            continue;
+        }
+        if (found && !trim_copy(lines[i]).empty()) insert_at = i + 1;
+    }
+    if (!found) {
+        lines.push_back("");
+        lines.push_back("[performance]");
+        lines.push_back(entry);
+        return;
+    }
+    lines.insert(lines.begin() + static_cast<std::ptrdiff_t>(insert_at), entry);
+}
+
+static void cmd_tune(const std::map<std::string, std::string>& args) {
+    if (!args.count("config")) {
+        std::cerr << "Error: --config SERVER.CONF required\n";
+        return;
+    }
+    const std::string config_file = args.at("config");
+    const auto& reloadable = netcopy::config::ServerConfig::reloadable_keys();
+
+    std::map<std::string, std::string> settings;
+    for (const auto& arg : args) {
+        if (arg.first == "config" || arg.first == "pid-file" || arg.first == "pid") continue;
+        if (std::find(reloadable.begin(), reloadable.end(), arg.first) == reloadable.end()) {
+            std::cerr << "Error: " << arg.first << " cannot be changed on a running server. Live settings:\n";
+            for (const auto& key : reloadable) std::cerr << "  --" << key << "\n";
+            return;
+        }
+        settings[arg.first] = arg.second;
+    }
+    if (settings.empty()) {
+        std::cerr << "Error: no settings given (e.g. --batch_bytes 8388608)\n";
+        return;
+    }
+
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(std::filesystem::u8path(config_file));
+        if (!in) {
+            std::cerr << "Error: cannot read " << config_file << "\n";
+            return;
+        }
+        std::string line;
+        while (std::getline(in, line)) lines.push_back(line);
+    }
+    for (const auto& setting : settings) set_config_line(lines, setting.first, setting.second);
+
+    // Validate the edited file before it replaces the one the server reads
+    const std::string staged = config_file + ".tune";
+    {
+        std::ofstream out(std::filesystem::u8path(staged), std::ios::trunc);
+        for (const auto& line : lines) out << line << "\n";
+        if (!out) {
+            std::cerr << "Error: cannot write " << staged << "\n";
+            return;
+        }
+    }
+    auto issues = netcopy::config::ServerConfig::validate_file(staged);
+    if (!issues.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(std::filesystem::u8path(staged), ec);
+        std::cerr << "Error: invalid value:\n" << netcopy::config::ConfigParser::format_validation_issues(issues) << "\n";
+        return;
+    }
+    std::filesystem::rename(std::filesystem::u8path(staged), std::filesystem::u8path(config_file));
+    for (const auto& setting : settings) {
+        std::cout << "Set " << setting.first << " = " << setting.second << "\n";
+    }
+
+    std::string pid_text = args.count("pid") ? args.at("pid") : "";
+    if (pid_text.empty()) {
+        std::string pid_file = args.count("pid-file")
+            ? args.at("pid-file")
+            : netcopy::config::ServerConfig::load_from_file(config_file).pid_file;
+        std::ifstream pid_in(std::filesystem::u8path(pid_file));
+        std::getline(pid_in, pid_text);
+        pid_text = trim_copy(pid_text);
+    }
+#ifdef _WIN32
+    std::cout << "Saved to " << config_file << "; the server applies it when restarted (no SIGHUP on Windows)\n";
+#else
+    if (pid_text.empty()) {
+        std::cout << "Saved to " << config_file << ". No server PID found (use --pid or --pid-file); "
+                  << "apply with: kill -HUP <server pid>\n";
+        return;
+    }
+    // 0 and -1 would signal the whole process group or every process we may
+    // signal, so only accept a plain positive number
+    char* end = nullptr;
+    errno = 0;
+    const long value = std::strtol(pid_text.c_str(), &end, 10);
+    if (errno != 0 || end == pid_text.c_str() || *end != '\0' || value <= 0 ||
+        value > static_cast<long>(std::numeric_limits<pid_t>::max())) {
+        std::cerr << "Error: saved to " << config_file << " but '" << pid_text << "' is not a valid server PID; "
+                  << "apply with: kill -HUP <server pid>\n";
+        return;
+    }
+    const pid_t pid = static_cast<pid_t>(value);
+    if (kill(pid, SIGHUP) != 0) {
+        std::cerr << "Error: saved to " << config_file << " but signalling PID " << pid << " failed: "
+                  << std::strerror(errno) << "\n";
+        return;
+    }
+    std::cout << "Server (PID " << pid << ") is reloading; running transfers pick the values up at their next chunk\n";
+#endif
+}
+
 static void print_usage() {
     std::cout << R"(net_copy_admin - Administration tool for net_copy
 
@@ -550,6 +717,11 @@ Usage:
 
   net_copy_admin ls --host HOST --name NAME [--pass PASS] [--key KEY.pem] [--passphrase PASS] --remote PATH [--recursive]
       List remote files on the server
+
+  net_copy_admin tune --config SERVER.CONF [--pid PID | --pid-file FILE] --KEY VALUE [...]
+      Change [performance] settings (e.g. --inflight_window_bytes, --batch_bytes,
+      --max_active_streams) in SERVER.CONF and make the running server reload
+      them (SIGHUP). Transfers in progress keep going with the new values.
 )";
 }
 
@@ -599,6 +771,8 @@ int main(int argc, char* argv[]) {
             cmd_verify(args);
         } else if (cmd == "ls") {
             cmd_ls(args);
+        } else if (cmd == "tune") {
+            cmd_tune(args);
         } else {
             std::cerr << "Unknown command: " << cmd << "\n";
             print_usage();
@@ -0,0 +1,138 @@
+#include "bench/bench.h"
+#include "common/utils.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+namespace netcopy {
+namespace bench {
+
+double BenchResult::throughput_mib_s() const {
+    if (seconds <= 0.0 || bytes == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds;
+}
+
+double BenchResult::ops_per_second() const {
+    if (seconds <= 0.0 || iterations == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(iterations) / seconds;
+}
+
+void BenchReport::add(BenchResult result) {
+    results_.push_back(std::move(result));
+}
+
+std::string BenchReport::to_json(const BenchOptions& options) const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(6);
+    out << "{\n";
+    out << "  \"meta\": {\n";
+    out << "    \"version\": \"" << common::escape_json(common::get_version_string()) << "\",\n";
+    out << "    \"build\": \"" << common::escape_json(common::get_build_info()) << "\",\n";
+    out << "    \"timestamp\": " << static_cast<uint64_t>(std::time(nullptr)) << ",\n";
+    out << "    \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "    \"suite\": \"" << common::escape_json(options.suite) << "\",\n";
+    out << "    \"repetitions\": " << options.repetitions << ",\n";
+    out << "    \"buffer_size\": " << options.buffer_size << "\n";
+    out << "  },\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results_.size(); ++i) {
+        const auto& r = results_[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"suite\": \"" << common::escape_json(r.suite) << "\""
+            << ", \"name\": \"" << common::escape_json(r.name) << "\""
+            << ", \"ok\": " << (r.ok ? "true" : "false")
+            << ", \"iterations\": " << r.iterations
+            << ", \"bytes\": " << r.bytes
+            << ", \"seconds\": " << r.seconds
+            << ", \"mean_seconds\": " << r.mean_seconds
+            << ", \"mib_per_s\": " << r.throughput_mib_s()
+            << ", \"ops_per_s\": " << r.ops_per_second();
+        if (!r.ok) {
+            out << ", \"error\": \"" << common::escape_json(r.error) << "\"";
+        }
+        out << "}";
+    }
+    out << (results_.empty() ? "]\n" : "\n  ]\n");
+    out << "}\n";
+    return out.str();
+}
+
+std::string BenchReport::to_table() const {
+    size_t name_width = 8;
+    for (const auto& r : results_) {
+        name_width = (std::max)(name_width, r.name.size());
+    }
+
+    std::ostringstream out;
+    out << std::left << std::setw(static_cast<int>(name_width) + 2) << "name"
+        << std::right << std::setw(12) << "best (s)"
+        << std::setw(14) << "MiB/s"
+        << std::setw(14) << "ops/s" << "\n";
+    for (const auto& r : results_) {
+        out << std::left << std::setw(static_cast<int>(name_width) + 2) << r.name << std::right;
+        if (!r.ok) {
+            out << "  FAILED: " << r.error << "\n";
+            continue;
+        }
+        out << std::fixed << std::setprecision(4) << std::setw(12) << r.seconds
+            << std::setprecision(1) << std::setw(14) << r.throughput_mib_s()
+            << std::setw(14) << r.ops_per_second() << "\n";
+    }
+    return out.str();
+}
+
+BenchResult measure(const std::string& suite,
+                    const std::string& name,
+                    uint64_t iterations,
+                    uint64_t bytes,
+                    int repetitions,
+                    const std::function<void()>& body,
+                    bool warm_up,
+                    const std::function<void()>& setup) {
+    BenchResult result;
+    result.suite = suite;
+    result.name = name;
+    result.iterations = iterations;
+    result.bytes = bytes;
+
+    try {
+        if (warm_up) {
+            if (setup) setup();
+            body();
+        }
+
+        double best = (std::numeric_limits<double>::max)();
+        double total = 0.0;
+        int runs = repetitions > 0 ? repetitions : 1;
+        for (int i = 0; i < runs; ++i) {
+            if (setup) setup();
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto end = std::chrono::steady_clock::now();
+            double elapsed = std::chrono::duration<double>(end - start).count();
+            best = (std::min)(best, elapsed);
+            total += elapsed;
+        }
+        result.seconds = best;
+        result.mean_seconds = total / runs;
+    } catch (const std::exception& e) {
+        result.ok = false;
+        result.error = e.what();
+    }
+    return result;
+}
+
+bool matches_filter(const BenchOptions& options, const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+} // namespace bench
+} // namespace netcopy
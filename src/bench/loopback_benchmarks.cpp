@@ -0,0 +1,344 @@
+#include "bench/bench.h"
+#include "server/server.h"
+#include "client/client.h"
+#include "config/config_parser.h"
+#include "file/file_manager.h"
+#include "logging/logger.h"
+#include "network/link_emulator.h"
+#include "exceptions.h"
+#include <asio.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+namespace netcopy {
+namespace bench {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr const char* kSuite = "loopback";
+constexpr const char* kBenchKey = "0x000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+constexpr const char* kLoopbackAddress = "127.0.0.1";
+
+uint16_t pick_free_port() {
+    asio::io_context io;
+    asio::ip::tcp::acceptor acceptor(io, asio::ip::tcp::endpoint(asio::ip::make_address(kLoopbackAddress), 0));
+    return acceptor.local_endpoint().port();
+}
+
+void write_pattern_file(const fs::path& path, uint64_t size, uint64_t seed) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw FileException("Cannot create benchmark input: " + path.string());
+    }
+    std::mt19937_64 rng(seed);
+    std::vector<uint64_t> block(64 * 1024 / sizeof(uint64_t));
+    uint64_t remaining = size;
+    while (remaining > 0) {
+        for (auto& v : block) v = rng();
+        size_t n = static_cast<size_t>((std::min<uint64_t>)(remaining, block.size() * sizeof(uint64_t)));
+        out.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(n));
+        remaining -= n;
+    }
+}
+
+// Flips a few bytes every `stride` bytes so delta sync has real work to do
+// without degenerating into a full transfer.
+void mutate_file(const fs::path& path, uint64_t size, uint64_t stride) {
+    std::fstream io(path, std::ios::binary | std::ios::in | std::ios::out);
+    for (uint64_t off = stride / 2; off < size; off += stride) {
+        io.seekp(static_cast<std::streamoff>(off));
+        const char patch[8] = {'n', 'e', 't', 'c', 'o', 'p', 'y', '!'};
+        io.write(patch, sizeof(patch));
+    }
+}
+
+void remove_path(const fs::path& path) {
+    std::error_code ec;
+    fs::remove_all(path, ec);
+}
+
+// Runs a Server on a background thread bound to loopback for the lifetime of
+// the suite. Mirrors the handshake settings of a default server with the
+// bench key and anonymous access so no users file is needed.
+class LoopbackServer {
+public:
+    LoopbackServer(const fs::path& root, uint16_t port) : port_(port) {
+        auto config = config::ServerConfig::get_default();
+        config.listen_address = kLoopbackAddress;
+        config.listen_port = port_;
+        config.max_connections = 64;
+        config.internal.secret_key = kBenchKey;
+        config.internal.require_auth = true;
+        config.internal.allow_anonymous = true;
+        config.internal.users_file = (root / "bench_users.csv").string();
+        config.logging.enable = false;
+        config.console.enable = false;
+        config.allowed_paths = {root.string()};
+        config.auto_create_directories = true;
+        server_.set_config(config);
+
+        thread_ = std::thread([this]() {
+            try {
+                server_.start();
+            } catch (const std::exception& e) {
+                LOG_ERROR("Benchmark server failed: " + std::string(e.what()));
+            }
+        });
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!server_.is_running()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                stop();
+                throw NetworkException("Benchmark server did not start on port " + std::to_string(port_));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    ~LoopbackServer() { stop(); }
+
+    uint16_t port() const { return port_; }
+
+private:
+    void stop() {
+        server_.stop();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    uint16_t port_;
+    server::Server server_;
+    std::thread thread_;
+};
+
+std::unique_ptr<client::Client> make_client(uint16_t port, uint32_t streams) {
+    auto client = std::make_unique<client::Client>();
+    auto config = config::ClientConfig::get_default();
+    config.internal.secret_key = kBenchKey;
+    config.internal.auth_method = config::defaults::kAuthNone;
+    config.logging.enable = false;
+    config.console.enable = false;
+    client->set_config(config);
+    client->set_security_level(crypto::SecurityLevel::HIGH);
+    client->set_requested_parallel_streams(streams);
+    client->set_overwrite_callback([](const std::string&, uint64_t) {
+        return client::Client::OverwriteDecision::DELTA_SYNC;
+    });
+    client->connect(kLoopbackAddress, port);
+    return client;
+}
+
+void add(const BenchOptions& options, BenchReport& report, const std::string& name,
+         uint64_t iterations, uint64_t bytes,
+         const std::function<void()>& body, const std::function<void()>& setup) {
+    if (!matches_filter(options, name)) {
+        return;
+    }
+    // End-to-end runs are expensive; skip the warm-up call and rely on the
+    // repetitions for a stable best-of-N.
+    report.add(measure(kSuite, name, iterations, bytes, options.repetitions, body, false, setup));
+}
+
+fs::path make_work_root(const BenchOptions& options, const std::string& suite) {
+    return options.work_dir.empty()
+        ? fs::temp_directory_path() / ("net_copy_bench_" + suite + "_" + std::to_string(std::random_device{}()))
+        : fs::path(options.work_dir) / suite;
+}
+
+void cleanup_work_root(const BenchOptions& options, const fs::path& root) {
+    if (options.keep_files) {
+        return;
+    }
+    remove_path(root / "local");
+    remove_path(root / "remote");
+    if (options.work_dir.empty()) {
+        remove_path(root);
+    }
+}
+
+} // namespace
+
+void run_loopback_benchmarks(const BenchOptions& options, BenchReport& report) {
+    fs::path root = make_work_root(options, kSuite);
+    fs::path local = root / "local";
+    fs::path remote = root / "remote";
+    fs::create_directories(local);
+    fs::create_directories(remote);
+
+    uint16_t port = options.port != 0 ? options.port : pick_free_port();
+
+    try {
+        LoopbackServer server(remote, port);
+
+        const fs::path large_src = local / "large.bin";
+        const fs::path large_dst = remote / "large.bin";
+        const std::string parallel_name = "loopback.upload.parallel_streams_" + std::to_string(options.parallel_streams);
+        bool need_large = matches_filter(options, "loopback.upload.large_file") ||
+                          matches_filter(options, parallel_name) ||
+                          matches_filter(options, "loopback.download.large_file") ||
+                          matches_filter(options, "loopback.upload.delta_sync");
+        if (need_large) {
+            write_pattern_file(large_src, options.large_file_size, 1);
+        }
+
+        // 1. Single large file, one stream
+        add(options, report, "loopback.upload.large_file", 1, options.large_file_size,
+            [&]() {
+                auto client = make_client(server.port(), 1);
+                client->transfer_file(large_src.string(), large_dst.string());
+                client->disconnect();
+            },
+            [&]() { remove_path(large_dst); });
+
+        // 2. Same file split over parallel streams
+        add(options, report, parallel_name, 1, options.large_file_size,
+            [&]() {
+                auto client = make_client(server.port(), options.parallel_streams);
+                client->transfer_file(large_src.string(), large_dst.string());
+                client->disconnect();
+            },
+            [&]() { remove_path(large_dst); });
+
+        // 3. Delta sync against a basis that differs every 1 MB
+        const fs::path basis = local / "large.basis";
+        add(options, report, "loopback.upload.delta_sync", 1, options.large_file_size,
+            [&]() {
+                auto client = make_client(server.port(), 1);
+                client->transfer_file(large_src.string(), large_dst.string());
+                client->disconnect();
+            },
+            [&]() {
+                if (!fs::exists(basis)) {
+                    fs::copy_file(large_src, basis, fs::copy_options::overwrite_existing);
+                    mutate_file(basis, options.large_file_size, 1024 * 1024);
+                }
+                fs::copy_file(basis, large_dst, fs::copy_options::overwrite_existing);
+            });
+
+        // 4. Download of the large file
+        const fs::path download_dst = local / "large.download";
+        add(options, report, "loopback.download.large_file", 1, options.large_file_size,
+            [&]() {
+                auto client = make_client(server.port(), 1);
+                client->download_file(large_dst.string(), download_dst.string());
+                client->disconnect();
+            },
+            [&]() {
+                remove_path(download_dst);
+                if (!fs::exists(large_dst)) {
+                    fs::copy_file(large_src, large_dst);
+                }
+            });
+
+        // 5. Many small files through the directory scheduler
+        const std::string small_name = "loopback.upload.small_files_" + std::to_string(options.small_file_count);
+        const fs::path small_src = local / "small";
+        const fs::path small_dst = remote / "small";
+        if (matches_filter(options, small_name)) {
+            fs::create_directories(small_src);
+            for (uint32_t i = 0; i < options.small_file_count; ++i) {
+                // Fan out into sub-directories to keep directory sizes sane
+                fs::path dir = small_src / std::to_string(i / 1000);
+                if (i % 1000 == 0) fs::create_directories(dir);
+                write_pattern_file(dir / ("f" + std::to_string(i) + ".dat"), options.small_file_size, i + 2);
+            }
+        }
+        add(options, report, small_name, options.small_file_count,
+            static_cast<uint64_t>(options.small_file_count) * options.small_file_size,
+            [&]() {
+                auto client = make_client(server.port(), options.parallel_streams);
+                client->transfer_directory(small_src.string(), small_dst.string(), true);
+                client->disconnect();
+            },
+            [&]() { remove_path(small_dst); });
+    } catch (const std::exception& e) {
+        BenchResult failed;
+        failed.suite = kSuite;
+        failed.name = "loopback.setup";
+        failed.ok = false;
+        failed.error = e.what();
+        report.add(failed);
+    }
+
+    cleanup_work_root(options, root);
+}
+
+void run_wan_benchmarks(const BenchOptions& options, BenchReport& report) {
+    constexpr const char* kWanSuite = "wan";
+    fs::path root = make_work_root(options, kWanSuite);
+    fs::path local = root / "local";
+    fs::path remote = root / "remote";
+    fs::create_directories(local);
+    fs::create_directories(remote);
+
+    try {
+        LoopbackServer server(remote, options.port != 0 ? options.port : pick_free_port());
+        const fs::path src = local / "wan.bin";
+        const fs::path dst = remote / "wan.bin";
+        bool generated = false;
+
+        for (const auto& entry : options.link_profiles) {
+            auto colon = entry.find(':');
+            std::string label = colon == std::string::npos ? entry : entry.substr(0, colon);
+            network::LinkProfile profile = network::LinkProfile::parse(
+                colon == std::string::npos ? entry : entry.substr(colon + 1));
+
+            std::vector<uint32_t> stream_counts = {1};
+            if (options.parallel_streams > 1) {
+                stream_counts.push_back(options.parallel_streams);
+            }
+
+            for (uint32_t streams : stream_counts) {
+                std::string name = std::string(kWanSuite) + "." + label + ".upload.streams_" + std::to_string(streams);
+                if (!matches_filter(options, name)) {
+                    continue;
+                }
+                if (!generated) {
+                    write_pattern_file(src, options.wan_file_size, 3);
+                    generated = true;
+                }
+
+                // Fresh emulator per run so every repetition replays the same
+                // loss/jitter schedule from the profile seed.
+                std::unique_ptr<network::LinkEmulator> link;
+                auto result = measure(kWanSuite, name, 1, options.wan_file_size, options.repetitions,
+                    [&]() {
+                        auto client = make_client(link->listen_port(), streams);
+                        client->transfer_file(src.string(), dst.string());
+                        client->disconnect();
+                    },
+                    false,
+                    [&]() {
+                        remove_path(dst);
+                        if (link) link->stop();
+                        link = std::make_unique<network::LinkEmulator>(kLoopbackAddress, server.port(), profile);
+                        link->start();
+                    });
+                if (link) {
+                    LOG_INFO(name + ": lost=" + std::to_string(link->segments_lost()) +
+                             " reordered=" + std::to_string(link->segments_reordered()));
+                    link->stop();
+                }
+                report.add(result);
+            }
+        }
+    } catch (const std::exception& e) {
+        BenchResult failed;
+        failed.suite = kWanSuite;
+        failed.name = "wan.setup";
+        failed.ok = false;
+        failed.error = e.what();
+        report.add(failed);
+    }
+
+    cleanup_work_root(options, root);
+}
+
+} // namespace bench
+} // namespace netcopy
@@ -0,0 +1,166 @@
+#include "bench/bench.h"
+#include "common/utils.h"
+#include "logging/logger.h"
+#include "network/link_emulator.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void print_usage(const char* program_name) {
+    std::cout << "NetCopy Benchmark Suite" << std::endl;
+    std::cout << netcopy::common::get_version_string() << std::endl << std::endl;
+
+    std::cout << "Usage:" << std::endl;
+    std::cout << "  " << program_name << " [options]" << std::endl << std::endl;
+
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --suite NAME               micro, loopback, wan or all (default: all)" << std::endl;
+    std::cout << "  --filter TEXT              Only run benchmarks whose name contains TEXT" << std::endl;
+    std::cout << "  --repetitions N            Timed repetitions per benchmark (default: 3)" << std::endl;
+    std::cout << "  --buffer-size BYTES        Buffer size for micro benchmarks (default: 4194304)" << std::endl;
+    std::cout << "  --large-file-size BYTES    Size of the loopback large file (default: 536870912)" << std::endl;
+    std::cout << "  --small-files N            Number of files in the small-file scenario (default: 100000)" << std::endl;
+    std::cout << "  --small-file-size BYTES    Size of each small file (default: 4096)" << std::endl;
+    std::cout << "  --streams N                Parallel streams for the parallel scenario (default: 4)" << std::endl;
+    std::cout << "  --wan-file-size BYTES      File size for the emulated-link scenarios (default: 268435456)" << std::endl;
+    std::cout << "  --link LABEL:PROFILE       Emulated link for the wan suite, e.g. sat:rtt=600ms,rate=50mbit,loss=1%" << std::endl;
+    std::cout << "                             (repeatable; replaces the default 1 ms and 150 ms profiles)" << std::endl;
+    std::cout << "  --port PORT                Loopback server port (default: pick a free port)" << std::endl;
+    std::cout << "  --work-dir DIR             Directory for generated files (default: temp directory)" << std::endl;
+    std::cout << "  --keep-files               Do not delete generated files afterwards" << std::endl;
+    std::cout << "  -o, --output FILE          Write the JSON report to FILE instead of stdout" << std::endl;
+    std::cout << "  -v, --verbose              Show server/client log output" << std::endl;
+    std::cout << "  -h, --help                 Show this help message" << std::endl << std::endl;
+
+    std::cout << "The JSON report is stable across commits and intended for automated comparison." << std::endl;
+}
+
+uint64_t parse_number(const std::vector<std::string>& args, size_t& i, const std::string& flag) {
+    if (i + 1 >= args.size()) {
+        throw std::runtime_error("Missing value for " + flag);
+    }
+    try {
+        return std::stoull(args[++i]);
+    } catch (const std::exception&) {
+        throw std::runtime_error("Invalid numeric value for " + flag + ": " + args[i]);
+    }
+}
+
+std::string parse_string(const std::vector<std::string>& args, size_t& i, const std::string& flag) {
+    if (i + 1 >= args.size()) {
+        throw std::runtime_error("Missing value for " + flag);
+    }
+    return args[++i];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        auto args = netcopy::common::preprocess_arguments(argc, argv);
+        netcopy::bench::BenchOptions options;
+        bool verbose = false;
+        bool custom_links = false;
+
+        for (size_t i = 0; i < args.size(); ++i) {
+            const std::string& arg = args[i];
+            if (arg == "-h" || arg == "--help") {
+                print_usage(argv[0]);
+                return 0;
+            } else if (arg == "--suite") {
+                options.suite = parse_string(args, i, arg);
+                if (options.suite != "micro" && options.suite != "loopback" && options.suite != "wan" && options.suite != "all") {
+                    throw std::runtime_error("Invalid suite '" + options.suite + "'. Use 'micro', 'loopback', 'wan' or 'all'.");
+                }
+            } else if (arg == "--filter") {
+                options.filter = parse_string(args, i, arg);
+            } else if (arg == "--repetitions") {
+                options.repetitions = static_cast<int>(parse_number(args, i, arg));
+            } else if (arg == "--buffer-size") {
+                options.buffer_size = parse_number(args, i, arg);
+            } else if (arg == "--large-file-size") {
+                options.large_file_size = parse_number(args, i, arg);
+            } else if (arg == "--small-files") {
+                options.small_file_count = static_cast<uint32_t>(parse_number(args, i, arg));
+            } else if (arg == "--small-file-size") {
+                options.small_file_size = static_cast<uint32_t>(parse_number(args, i, arg));
+            } else if (arg == "--streams") {
+                options.parallel_streams = static_cast<uint32_t>(parse_number(args, i, arg));
+            } else if (arg == "--wan-file-size") {
+                options.wan_file_size = parse_number(args, i, arg);
+            } else if (arg == "--link") {
+                if (!custom_links) {
+                    options.link_profiles.clear();
+                    custom_links = true;
+                }
+                std::string link = parse_string(args, i, arg);
+                auto colon = link.find(':');
+                // Validate early so typos fail before any scenario runs
+                netcopy::network::LinkProfile::parse(colon == std::string::npos ? link : link.substr(colon + 1));
+                options.link_profiles.push_back(link);
+            } else if (arg == "--port") {
+                uint64_t port = parse_number(args, i, arg);
+                if (!netcopy::common::is_valid_port(static_cast<int>(port))) {
+                    throw std::runtime_error("Port number out of range (1-65535)");
+                }
+                options.port = static_cast<uint16_t>(port);
+            } else if (arg == "--work-dir") {
+                options.work_dir = parse_string(args, i, arg);
+            } else if (arg == "--keep-files") {
+                options.keep_files = true;
+            } else if (arg == "-o" || arg == "--output") {
+                options.output_file = parse_string(args, i, arg);
+            } else if (arg == "-v" || arg == "--verbose") {
+                verbose = true;
+            } else {
+                throw std::runtime_error("Unknown argument '" + arg + "'. Use -h for help.");
+            }
+        }
+
+        if (options.buffer_size < 4096) {
+            throw std::runtime_error("--buffer-size must be at least 4096 bytes");
+        }
+
+        auto& logger = netcopy::logging::Logger::instance();
+        logger.set_file_output("");
+        logger.set_console_output(verbose);
+        logger.set_level(verbose ? netcopy::logging::LogLevel::DEBUG : netcopy::logging::LogLevel::LOG_ERROR);
+
+        netcopy::bench::BenchReport report;
+        if (options.suite == "micro" || options.suite == "all") {
+            netcopy::bench::run_micro_benchmarks(options, report);
+        }
+        if (options.suite == "loopback" || options.suite == "all") {
+            netcopy::bench::run_loopback_benchmarks(options, report);
+        }
+        if (options.suite == "wan" || options.suite == "all") {
+            netcopy::bench::run_wan_benchmarks(options, report);
+        }
+
+        std::string json = report.to_json(options);
+        if (options.output_file.empty()) {
+            std::cout << json;
+        } else {
+            std::ofstream out(options.output_file, std::ios::trunc);
+            if (!out) {
+                throw std::runtime_error("Cannot open output file: " + options.output_file);
+            }
+            out << json;
+            std::cerr << report.to_table();
+        }
+
+        for (const auto& result : report.results()) {
+            if (!result.ok) {
+                return 1;
+            }
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
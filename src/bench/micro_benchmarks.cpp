@@ -0,0 +1,249 @@
+#include "bench/bench.h"
+#include "protocol/message.h"
+#include "crypto/crypto_engine.h"
+#include "crypto/sha3.h"
+#include "crypto/xxhash64.h"
+#include "common/compression.h"
+#include "common/fast_mem.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#include <malloc.h>
+#endif
+
+namespace netcopy {
+namespace bench {
+
+namespace {
+
+constexpr const char* kSuite = "micro";
+constexpr const char* kBenchKey = "0x000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+
+// Half random, half repetitive text so LZ4 sees a realistic mix instead of
+// either incompressible noise or a trivially compressible zero page.
+std::vector<uint8_t> make_payload(size_t size) {
+    std::vector<uint8_t> data(size);
+    std::mt19937_64 rng(0x6e6574636f7079ull);
+    size_t half = size / 2;
+    for (size_t i = 0; i < half; i += sizeof(uint64_t)) {
+        uint64_t v = rng();
+        std::memcpy(data.data() + i, &v, (std::min)(sizeof(v), half - i));
+    }
+    static const char kText[] = "netcopy benchmark payload line with some repeated words\n";
+    for (size_t i = half; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(kText[(i - half) % (sizeof(kText) - 1)]);
+    }
+    return data;
+}
+
+// Prevents the optimiser from discarding results that are otherwise unused.
+volatile uint64_t g_sink = 0;
+
+void sink(const std::vector<uint8_t>& v) {
+    g_sink = g_sink + v.size() + (v.empty() ? 0 : v[0]);
+}
+
+void add(const BenchOptions& options, BenchReport& report, const std::string& name,
+         uint64_t iterations, uint64_t bytes, const std::function<void()>& body) {
+    if (!matches_filter(options, name)) {
+        return;
+    }
+    report.add(measure(kSuite, name, iterations, bytes, options.repetitions, body));
+}
+
+void bench_codec(const BenchOptions& options, BenchReport& report, const std::vector<uint8_t>& payload) {
+    constexpr uint32_t kRounds = 16;
+    constexpr size_t kChunks = 4;
+    const size_t chunk_size = payload.size() / kChunks;
+
+    protocol::FileData message;
+    for (size_t i = 0; i < kChunks; ++i) {
+        protocol::FileData::Chunk chunk;
+        chunk.offset = i * chunk_size;
+        chunk.uncompressed_size = chunk_size;
+        chunk.data.assign(payload.begin() + i * chunk_size, payload.begin() + (i + 1) * chunk_size);
+        chunk.is_last_chunk = (i + 1 == kChunks);
+        chunk.compressed = false;
+        message.chunks.push_back(std::move(chunk));
+    }
+    const uint64_t total = static_cast<uint64_t>(chunk_size) * kChunks * kRounds;
+
+    add(options, report, "codec.file_data.serialize", kRounds, total, [&]() {
+        for (uint32_t i = 0; i < kRounds; ++i) {
+            sink(message.serialize());
+        }
+    });
+
+    auto wire = message.serialize();
+    add(options, report, "codec.file_data.deserialize", kRounds, total, [&]() {
+        for (uint32_t i = 0; i < kRounds; ++i) {
+            auto decoded = protocol::Message::deserialize(wire);
+            g_sink = g_sink + static_cast<uint64_t>(decoded->get_type());
+        }
+    });
+}
+
+void bench_ciphers(const BenchOptions& options, BenchReport& report, const std::vector<uint8_t>& payload) {
+    struct CipherCase {
+        crypto::SecurityLevel level;
+        const char* name;
+    };
+    const CipherCase cases[] = {
+        {crypto::SecurityLevel::HIGH, "chacha20_poly1305"},
+        {crypto::SecurityLevel::FAST, "xor"},
+        {crypto::SecurityLevel::AES, "aes_ctr"},
+        {crypto::SecurityLevel::AES_256_GCM, "aes_256_gcm"},
+    };
+    constexpr uint32_t kRounds = 8;
+    const uint64_t total = payload.size() * kRounds;
+
+    for (const auto& c : cases) {
+        std::string base = std::string("cipher.") + c.name;
+        std::unique_ptr<crypto::CryptoEngine> engine;
+        try {
+            engine = crypto::create_crypto_engine(c.level, kBenchKey);
+        } catch (const std::exception& e) {
+            BenchResult failed;
+            failed.suite = kSuite;
+            failed.name = base;
+            failed.ok = false;
+            failed.error = e.what();
+            if (matches_filter(options, base)) {
+                report.add(failed);
+            }
+            continue;
+        }
+
+        add(options, report, base + ".encrypt", kRounds, total, [&]() {
+            for (uint32_t i = 0; i < kRounds; ++i) {
+                sink(engine->encrypt(payload));
+            }
+        });
+
+        auto sealed = engine->encrypt(payload);
+        add(options, report, base + ".decrypt", kRounds, total, [&]() {
+            for (uint32_t i = 0; i < kRounds; ++i) {
+                sink(engine->decrypt(sealed));
+            }
+        });
+    }
+}
+
+void bench_hashes(const BenchOptions& options, BenchReport& report, const std::vector<uint8_t>& payload) {
+    constexpr uint32_t kRounds = 8;
+    const uint64_t total = payload.size() * kRounds;
+
+    add(options, report, "hash.sha3_256.streaming", kRounds, total, [&]() {
+        for (uint32_t i = 0; i < kRounds; ++i) {
+            crypto::Sha3Hasher hasher;
+            hasher.update(payload);
+            sink(hasher.finalize());
+        }
+    });
+
+    add(options, report, "hash.xxhash64.oneshot", kRounds, total, [&]() {
+        for (uint32_t i = 0; i < kRounds; ++i) {
+            g_sink = g_sink + crypto::xxhash64(payload.data(), payload.size());
+        }
+    });
+
+    add(options, report, "hash.xxhash64.streaming", kRounds, total, [&]() {
+        for (uint32_t i = 0; i < kRounds; ++i) {
+            crypto::XxHash64Hasher hasher;
+            // Feed in 64 KB pieces to match how FileManager hashes blocks
+            constexpr size_t kPiece = 64 * 1024;
+            for (size_t off = 0; off < payload.size(); off += kPiece) {
+                hasher.update(payload.data() + off, (std::min)(kPiece, payload.size() - off));
+            }
+            sink(hasher.finalize());
+        }
+    });
+}
+
+void bench_compression(const BenchOptions& options, BenchReport& report, const std::vector<uint8_t>& payload) {
+    constexpr uint32_t kRounds = 8;
+    const uint64_t total = payload.size() * kRounds;
+
+    add(options, report, "lz4.compress", kRounds, total, [&]() {
+        for (uint32_t i = 0; i < kRounds; ++i) {
+            sink(common::compress_buffer(payload));
+        }
+    });
+
+    auto compressed = common::compress_buffer(payload);
+    add(options, report, "lz4.decompress", kRounds, total, [&]() {
+        for (uint32_t i = 0; i < kRounds; ++i) {
+            sink(common::decompress_buffer(compressed, payload.size()));
+        }
+    });
+}
+
+void bench_memory(const BenchOptions& options, BenchReport& report, const std::vector<uint8_t>& payload) {
+    constexpr uint32_t kRounds = 32;
+    const uint64_t total = payload.size() * kRounds;
+    std::vector<uint8_t> dest(payload.size());
+
+    add(options, report, "memcpy.fast_memcpy", kRounds, total, [&]() {
+        for (uint32_t i = 0; i < kRounds; ++i) {
+            fast_mem::fast_memcpy(dest.data(), payload.data(), payload.size());
+        }
+        sink(dest);
+    });
+
+    add(options, report, "memcpy.std_memcpy", kRounds, total, [&]() {
+        for (uint32_t i = 0; i < kRounds; ++i) {
+            std::memcpy(dest.data(), payload.data(), payload.size());
+        }
+        sink(dest);
+    });
+
+    // Pool allocator round-trips are measured per operation (bytes = 0)
+    constexpr size_t kBlockSize = 256 * 1024;
+    constexpr size_t kBlocks = 16;
+    constexpr uint32_t kOps = 200000;
+    fast_mem::PoolAllocator pool(kBlockSize, kBlocks, 64);
+    add(options, report, "pool.allocate_release", kOps, 0, [&]() {
+        void* held[kBlocks];
+        for (uint32_t i = 0; i < kOps; i += kBlocks) {
+            for (size_t b = 0; b < kBlocks; ++b) {
+                held[b] = pool.allocate();
+            }
+            for (size_t b = 0; b < kBlocks; ++b) {
+                pool.deallocate(held[b]);
+            }
+        }
+    });
+
+    add(options, report, "pool.aligned_malloc_free", kOps, 0, [&]() {
+        for (uint32_t i = 0; i < kOps; ++i) {
+            void* ptr = nullptr;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+            ptr = _aligned_malloc(kBlockSize, 64);
+            _aligned_free(ptr);
+#else
+            if (posix_memalign(&ptr, 64, kBlockSize) == 0) {
+                free(ptr);
+            }
+#endif
+        }
+    });
+}
+
+} // namespace
+
+void run_micro_benchmarks(const BenchOptions& options, BenchReport& report) {
+    auto payload = make_payload(static_cast<size_t>(options.buffer_size));
+
+    bench_codec(options, report, payload);
+    bench_ciphers(options, report, payload);
+    bench_hashes(options, report, payload);
+    bench_compression(options, report, payload);
+    bench_memory(options, report, payload);
+}
+
+} // namespace bench
+} // namespace netcopy
@@ -0,0 +1,738 @@
+#include "client/agent.h"
+#include "common/utils.h"
+#include "exceptions.h"
+#include "file/file_manager.h"
+#include "logging/logger.h"
+#include <asio.hpp>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace netcopy {
+namespace client {
+
+namespace {
+
+// Splits "port/path" or "path" after the server's colon
+void parse_port_and_path(const std::string& after_colon, uint16_t port_override, RemoteLocation& location) {
+    if (after_colon.empty()) {
+        // Format: server: (uses default port and path)
+        return;
+    }
+    if (after_colon[0] == '/' || after_colon[0] == '\\' ||
+        (after_colon.length() > 1 && after_colon[1] == ':')) {
+        // Format: server:/path, server:\path or server:C:\path
+        location.path = after_colon;
+        return;
+    }
+    if (port_override != 0) {
+        // Port already specified via command line, treat as path
+        location.path = after_colon;
+        return;
+    }
+    // Look for the path separator to determine where the port ends
+    size_t slash_pos = after_colon.find_first_of("/\\");
+    std::string potential_port = (slash_pos != std::string::npos) ? after_colon.substr(0, slash_pos) : after_colon;
+    try {
+        int port_int = std::stoi(potential_port);
+        if (port_int >= 1 && port_int <= 65535) {
+            location.port = static_cast<uint16_t>(port_int);
+            if (slash_pos != std::string::npos) {
+                location.path = after_colon.substr(slash_pos);
+            }
+        } else {
+            // Not a valid port, treat as path
+            location.path = after_colon;
+        }
+    } catch (const std::exception&) {
+        // Not a number, treat as path
+        location.path = after_colon;
+    }
+}
+
+} // namespace
+
+RemoteLocation parse_remote_location(const std::string& spec, uint16_t port_override) {
+    RemoteLocation location;
+    location.port = port_override;
+
+    if (!spec.empty() && spec.front() == '[') {
+        size_t close_bracket = spec.find(']');
+        if (close_bracket == std::string::npos) {
+            throw std::runtime_error("Invalid bracketed IPv6 destination. Missing ']'");
+        }
+        location.host = spec.substr(1, close_bracket - 1);
+        std::string after_bracket = spec.substr(close_bracket + 1);
+        if (!after_bracket.empty() && after_bracket[0] == ':') {
+            parse_port_and_path(after_bracket.substr(1), port_override, location);
+        } else if (!after_bracket.empty()) {
+            // Format: [::1]/path
+            location.path = after_bracket;
+        }
+    } else {
+        size_t colon_pos = spec.find(':');
+        if (colon_pos == std::string::npos) {
+            // Format: server (no port, no path)
+            location.host = spec;
+        } else {
+            location.host = spec.substr(0, colon_pos);
+            std::string after_colon = spec.substr(colon_pos + 1);
+            // Reject "1245:D:/Work/": a port followed by a drive letter
+            size_t slash_pos = after_colon.find_first_of("/\\");
+            size_t inner_colon = after_colon.find(':');
+            bool path_first = !after_colon.empty() &&
+                              (after_colon[0] == '/' || after_colon[0] == '\\' ||
+                               (after_colon.length() > 1 && after_colon[1] == ':'));
+            if (!path_first && inner_colon != std::string::npos && inner_colon < slash_pos) {
+                throw std::runtime_error("Invalid remote format. Multiple colons detected.\n"
+                                         "Use: server:port/path  (e.g., 127.0.0.1:1245/D:/Work/)\n"
+                                         "Or:  server:path       (e.g., 127.0.0.1:D:/Work/)");
+            }
+            parse_port_and_path(after_colon, port_override, location);
+        }
+    }
+
+    if (location.port == 0) {
+        location.port = config::defaults::kDefaultTransferPort;
+    }
+
+    // Normalize the remote path: absolute paths (e.g. C:\) keep their
+    // drive, relative ones are rooted
+    if (!location.path.empty() && location.path != "/") {
+        bool absolute = common::is_absolute_path(location.path);
+        location.path = common::convert_to_unix_path(location.path);
+        if (!absolute && location.path[0] != '/') {
+            location.path = "/" + location.path;
+        }
+    }
+    return location;
+}
+
+void run_transfer_request(Client& client, const TransferRequest& request,
+                          const std::function<void(const std::string& text)>& message) {
+    const std::string& local_path = request.local_path;
+    const std::string& remote_path = request.remote_path;
+
+    if (request.operation == "download") {
+        bool is_dir = false;
+        try {
+            // Try listing the path to see if it is a directory
+            client.list_remote_directory(remote_path, false);
+            is_dir = true;
+        } catch (const std::exception&) {
+            // Assume it's a file or not found (download_file will handle file-not-found)
+            is_dir = false;
+        }
+
+        std::string remote_name = remote_path;
+        size_t last_slash = remote_path.find_last_of("/\\");
+        if (last_slash != std::string::npos) {
+            remote_name = remote_path.substr(last_slash + 1);
+        }
+        if (is_dir) {
+            if (!request.recursive) {
+                throw std::runtime_error("Cannot transfer directory without -R/--recursive flag. Use -R to transfer directories recursively.");
+            }
+            message("Downloading directory: " + remote_name);
+            client.download_directory(remote_path, local_path, request.recursive);
+            message("\nDirectory download completed: " + remote_name);
+        } else {
+            message("Downloading file: " + remote_name);
+            client.download_file(remote_path, local_path);
+            message("\nFile download completed: " + remote_name);
+        }
+    } else if (request.operation == "upload") {
+        if (file::FileManager::is_directory(local_path)) {
+            if (!request.recursive) {
+                throw std::runtime_error("Cannot transfer directory without -R/--recursive flag. Use -R to transfer directories recursively.");
+            }
+            std::string source_name = file::FileManager::get_filename(local_path);
+            message("Transferring directory: " + source_name);
+            client.transfer_directory(local_path, remote_path, request.recursive, request.resume);
+            message("\nDirectory transfer completed: " + source_name);
+        } else {
+            std::string filename = file::FileManager::get_filename(local_path);
+            message("Transferring file: " + filename);
+            client.transfer_file(local_path, remote_path, request.resume);
+            message("\nFile transfer completed: " + filename);
+        }
+    } else {
+        throw std::runtime_error("Unknown transfer operation: " + request.operation);
+    }
+}
+
+std::string default_agent_socket_path() {
+    const char* path = std::getenv("NETCOPY_AGENT_SOCKET");
+    if (path != nullptr && *path != '\0') {
+        return path;
+    }
+    return common::get_default_config_path("agent.sock");
+}
+
+#if defined(ASIO_HAS_LOCAL_SOCKETS) && !defined(_WIN32)
+
+namespace {
+
+using LocalSocket = asio::local::stream_protocol::socket;
+
+constexpr uint8_t kAgentProtocolVersion = 1;
+constexpr uint32_t kMaxFrameSize = 1024 * 1024;
+constexpr std::chrono::milliseconds kProgressInterval{100}; // per file; completion is always sent
+
+// Frames are a little-endian u32 length of what follows, a type byte and
+// the payload
+enum class FrameType : uint8_t {
+    REQUEST = 1,
+    STARTED = 2,  // u32 negotiated streams
+    PROGRESS = 3, // u64 bytes, u64 total, string file
+    PROMPT = 4,   // string remote path, u64 remote size
+    DECISION = 5, // u8 OverwriteDecision
+    MESSAGE = 6,  // string text
+    DONE = 7      // u8 success, string error
+};
+
+void put_u8(std::vector<uint8_t>& out, uint8_t value) {
+    out.push_back(value);
+}
+
+void put_u32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void put_u64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void put_string(std::vector<uint8_t>& out, const std::string& value) {
+    put_u32(out, static_cast<uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+class FrameReader {
+public:
+    explicit FrameReader(const std::vector<uint8_t>& data) : data_(data) {}
+
+    uint8_t u8() {
+        need(1);
+        return data_[offset_++];
+    }
+
+    uint32_t u32() {
+        need(4);
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(data_[offset_++]) << (8 * i);
+        }
+        return value;
+    }
+
+    uint64_t u64() {
+        need(8);
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(data_[offset_++]) << (8 * i);
+        }
+        return value;
+    }
+
+    std::string string() {
+        uint32_t size = u32();
+        need(size);
+        std::string value(data_.begin() + offset_, data_.begin() + offset_ + size);
+        offset_ += size;
+        return value;
+    }
+
+private:
+    void need(size_t bytes) const {
+        if (data_.size() - offset_ < bytes) {
+            throw ProtocolException("Truncated client agent frame");
+        }
+    }
+
+    const std::vector<uint8_t>& data_;
+    size_t offset_ = 0;
+};
+
+void send_frame(LocalSocket& socket, FrameType type, const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> frame;
+    frame.reserve(5 + payload.size());
+    put_u32(frame, static_cast<uint32_t>(payload.size() + 1));
+    put_u8(frame, static_cast<uint8_t>(type));
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    asio::write(socket, asio::buffer(frame));
+}
+
+// False when the peer closed the connection between frames
+bool read_frame(LocalSocket& socket, FrameType& type, std::vector<uint8_t>& payload) {
+    uint8_t header[4];
+    asio::error_code ec;
+    asio::read(socket, asio::buffer(header), ec);
+    if (ec == asio::error::eof) {
+        return false;
+    }
+    if (ec) {
+        throw NetworkException("Client agent connection failed: " + ec.message());
+    }
+    uint32_t size = 0;
+    for (int i = 0; i < 4; ++i) {
+        size |= static_cast<uint32_t>(header[i]) << (8 * i);
+    }
+    if (size == 0 || size > kMaxFrameSize) {
+        throw ProtocolException("Invalid client agent frame size: " + std::to_string(size));
+    }
+    std::vector<uint8_t> body(size);
+    asio::read(socket, asio::buffer(body));
+    type = static_cast<FrameType>(body[0]);
+    payload.assign(body.begin() + 1, body.end());
+    return true;
+}
+
+std::vector<uint8_t> encode_request(const TransferRequest& request) {
+    std::vector<uint8_t> out;
+    put_u8(out, kAgentProtocolVersion);
+    put_string(out, request.config_file);
+    put_u8(out, request.create_empty_directories ? 1 : 0);
+    put_u8(out, request.auto_create_directories ? 1 : 0);
+    put_string(out, request.secret_key);
+    put_string(out, request.password);
+    put_string(out, request.host);
+    put_u32(out, request.port);
+    put_u8(out, static_cast<uint8_t>(request.security_level));
+    put_u8(out, request.auto_security_level ? 1 : 0);
+    put_string(out, request.operation);
+    put_string(out, request.local_path);
+    put_string(out, request.remote_path);
+    put_u8(out, request.recursive ? 1 : 0);
+    put_u8(out, request.resume ? 1 : 0);
+    put_u8(out, request.force ? 1 : 0);
+    return out;
+}
+
+TransferRequest decode_request(const std::vector<uint8_t>& payload) {
+    FrameReader reader(payload);
+    uint8_t version = reader.u8();
+    if (version != kAgentProtocolVersion) {
+        throw ProtocolException("Unsupported client agent protocol version " + std::to_string(version) +
+                                "; restart the agent with this version of the client");
+    }
+    TransferRequest request;
+    request.config_file = reader.string();
+    request.create_empty_directories = reader.u8() != 0;
+    request.auto_create_directories = reader.u8() != 0;
+    request.secret_key = reader.string();
+    request.password = reader.string();
+    request.host = reader.string();
+    request.port = static_cast<uint16_t>(reader.u32());
+    request.security_level = static_cast<crypto::SecurityLevel>(reader.u8());
+    request.auto_security_level = reader.u8() != 0;
+    request.operation = reader.string();
+    request.local_path = reader.string();
+    request.remote_path = reader.string();
+    request.recursive = reader.u8() != 0;
+    request.resume = reader.u8() != 0;
+    request.force = reader.u8() != 0;
+    return request;
+}
+
+// The socket file is private to its owner already; on Linux the peer's uid
+// is checked as well, in case the file was created with wider permissions
+bool peer_is_owner(LocalSocket& socket) {
+#if defined(__linux__)
+    ucred credentials{};
+    socklen_t length = sizeof(credentials);
+    if (getsockopt(socket.native_handle(), SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0) {
+        return false;
+    }
+    return credentials.uid == geteuid();
+#else
+    (void)socket;
+    return true;
+#endif
+}
+
+} // namespace
+
+bool submit_to_agent(const std::string& socket_path, const TransferRequest& request, const AgentCallbacks& callbacks) {
+    asio::io_context io;
+    LocalSocket socket(io);
+    asio::error_code ec;
+    socket.connect(asio::local::stream_protocol::endpoint(socket_path), ec);
+    if (ec) {
+        LOG_DEBUG("No client agent at " + socket_path + ": " + ec.message());
+        return false;
+    }
+
+    send_frame(socket, FrameType::REQUEST, encode_request(request));
+
+    FrameType type;
+    std::vector<uint8_t> payload;
+    while (read_frame(socket, type, payload)) {
+        FrameReader reader(payload);
+        switch (type) {
+            case FrameType::STARTED: {
+                uint32_t streams = reader.u32();
+                if (callbacks.started) {
+                    callbacks.started(streams);
+                }
+                break;
+            }
+            case FrameType::PROGRESS: {
+                uint64_t bytes = reader.u64();
+                uint64_t total = reader.u64();
+                std::string file = reader.string();
+                if (callbacks.progress) {
+                    callbacks.progress(bytes, total, file);
+                }
+                break;
+            }
+            case FrameType::PROMPT: {
+                std::string remote_path = reader.string();
+                uint64_t remote_size = reader.u64();
+                auto decision = callbacks.overwrite ? callbacks.overwrite(remote_path, remote_size)
+                                                    : Client::OverwriteDecision::OVERWRITE;
+                std::vector<uint8_t> reply;
+                put_u8(reply, static_cast<uint8_t>(decision));
+                send_frame(socket, FrameType::DECISION, reply);
+                break;
+            }
+            case FrameType::MESSAGE: {
+                std::string text = reader.string();
+                if (callbacks.message) {
+                    callbacks.message(text);
+                }
+                break;
+            }
+            case FrameType::DONE: {
+                bool success = reader.u8() != 0;
+                std::string error = reader.string();
+                if (!success) {
+                    throw std::runtime_error(error);
+                }
+                return true;
+            }
+            default:
+                throw ProtocolException("Unexpected client agent frame type " +
+                                        std::to_string(static_cast<int>(type)));
+        }
+    }
+    throw NetworkException("Client agent closed the connection before the request finished");
+}
+
+struct ClientAgent::Session {
+    explicit Session(LocalSocket accepted) : socket(std::move(accepted)) {}
+
+    LocalSocket socket;
+    // Progress from transfer workers, prompts and messages share the socket
+    std::mutex write_mutex;
+    // Only one prompt waits for its decision at a time
+    std::mutex prompt_mutex;
+
+    void send(FrameType type, const std::vector<uint8_t>& payload) {
+        std::lock_guard<std::mutex> lock(write_mutex);
+        send_frame(socket, type, payload);
+    }
+};
+
+ClientAgent::ClientAgent(std::string socket_path, std::chrono::seconds idle_timeout)
+    : socket_path_(std::move(socket_path)), pool_(idle_timeout) {}
+
+ClientAgent::~ClientAgent() {
+    stop();
+}
+
+void ClientAgent::run() {
+    using Protocol = asio::local::stream_protocol;
+    const Protocol::endpoint endpoint(socket_path_);
+
+    asio::error_code ec;
+    {
+        // A socket file nobody answers on is left over from an agent that
+        // did not shut down cleanly
+        asio::io_context probe_io;
+        LocalSocket probe(probe_io);
+        probe.connect(endpoint, ec);
+        if (!ec) {
+            throw NetworkException("A client agent is already listening on " + socket_path_);
+        }
+    }
+    std::error_code fs_ec;
+    std::filesystem::remove(socket_path_, fs_ec);
+    auto parent = std::filesystem::path(socket_path_).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, fs_ec);
+    }
+
+    asio::io_context io;
+    Protocol::acceptor acceptor(io);
+    acceptor.open(endpoint.protocol());
+    // Created owner-only so no other user can connect between bind and chmod
+    mode_t previous_mask = umask(077);
+    acceptor.bind(endpoint, ec);
+    umask(previous_mask);
+    if (ec) {
+        throw NetworkException("Cannot bind client agent socket " + socket_path_ + ": " + ec.message());
+    }
+    chmod(socket_path_.c_str(), S_IRUSR | S_IWUSR);
+    acceptor.listen();
+
+    asio::signal_set signals(io, SIGINT, SIGTERM);
+    signals.async_wait([this](const asio::error_code& error, int) {
+        if (!error) {
+            LOG_INFO("Client agent shutting down");
+            stop();
+        }
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        if (stopping_) {
+            return;
+        }
+        stop_hook_ = [&io]() { io.stop(); };
+    }
+
+    std::function<void()> accept_next;
+    accept_next = [&]() {
+        acceptor.async_accept([&, this](const asio::error_code& error, LocalSocket socket) {
+            if (error) {
+                if (error != asio::error::operation_aborted && !stopping_) {
+                    LOG_WARNING("Client agent accept failed: " + error.message());
+                    accept_next();
+                }
+                return;
+            }
+            auto session = std::make_shared<Session>(std::move(socket));
+            {
+                std::lock_guard<std::mutex> lock(sessions_mutex_);
+                sessions_.insert(session.get());
+            }
+            std::thread([this, session]() { serve(session); }).detach();
+            accept_next();
+        });
+    };
+    accept_next();
+
+    LOG_INFO("Client agent listening on " + socket_path_);
+    io.run();
+
+    stop();
+    {
+        std::unique_lock<std::mutex> lock(sessions_mutex_);
+        stop_hook_ = nullptr;
+        sessions_done_.wait(lock, [this]() { return sessions_.empty(); });
+    }
+    acceptor.close(ec);
+    std::filesystem::remove(socket_path_, fs_ec);
+    pool_.clear();
+}
+
+void ClientAgent::stop() {
+    stopping_ = true;
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    for (Client* client : running_) {
+        client->request_cancel();
+    }
+    for (Session* session : sessions_) {
+        asio::error_code ec;
+        session->socket.shutdown(LocalSocket::shutdown_both, ec);
+    }
+    if (stop_hook_) {
+        stop_hook_();
+    }
+}
+
+void ClientAgent::serve(std::shared_ptr<Session> session) {
+    try {
+        FrameType type;
+        std::vector<uint8_t> payload;
+        if (!peer_is_owner(session->socket)) {
+            LOG_WARNING("Client agent rejected a connection from another user");
+        } else if (read_frame(session->socket, type, payload) && type == FrameType::REQUEST) {
+            std::string error;
+            try {
+                execute(*session, decode_request(payload));
+            } catch (const std::exception& e) {
+                error = e.what();
+                LOG_ERROR("Client agent request failed: " + error);
+            }
+            std::vector<uint8_t> done;
+            put_u8(done, error.empty() ? 1 : 0);
+            put_string(done, error);
+            session->send(FrameType::DONE, done);
+        }
+    } catch (const std::exception& e) {
+        LOG_DEBUG(std::string("Client agent session ended: ") + e.what());
+    }
+
+    asio::error_code ec;
+    session->socket.close(ec);
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    sessions_.erase(session.get());
+    sessions_done_.notify_all();
+}
+
+void ClientAgent::execute(Session& session, const TransferRequest& request) {
+    ConnectionProfile profile;
+    profile.host = request.host;
+    profile.port = request.port;
+    profile.security_level = request.security_level;
+    profile.auto_security_level = request.auto_security_level;
+    profile.config = config::ClientConfig::load_from_file(request.config_file);
+    profile.config.create_empty_directories = request.create_empty_directories;
+    profile.config.auto_create_directories = request.auto_create_directories;
+    if (!request.secret_key.empty()) {
+        profile.config.internal.secret_key = request.secret_key;
+    }
+    if (!request.password.empty()) {
+        profile.config.internal.password = request.password;
+    }
+
+    ConnectionPool::Lease lease = pool_.acquire_verified(profile);
+    Client& client = *lease;
+    if (lease.reused()) {
+        // The profile key leaves out options that do not affect the
+        // connection itself
+        client.set_config(profile.config);
+    }
+    LOG_INFO("Client agent running " + request.operation + " of " + request.local_path + " on " +
+             request.host + ":" + std::to_string(request.port) + (lease.reused() ? " (warm connection)" : ""));
+
+    std::vector<uint8_t> started;
+    put_u32(started, client.get_negotiated_parallel_streams());
+    session.send(FrameType::STARTED, started);
+
+    auto progress_mutex = std::make_shared<std::mutex>();
+    auto last_sent = std::make_shared<std::unordered_map<std::string, std::chrono::steady_clock::time_point>>();
+    client.set_progress_callback([&session, &client, progress_mutex, last_sent](
+                                     uint64_t bytes_transferred, uint64_t total_bytes, const std::string& current_file) {
+        const auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(*progress_mutex);
+            auto it = last_sent->find(current_file);
+            bool finished = bytes_transferred >= total_bytes;
+            if (!finished && it != last_sent->end() && now - it->second < kProgressInterval) {
+                return;
+            }
+            if (finished) {
+                last_sent->erase(current_file);
+            } else {
+                (*last_sent)[current_file] = now;
+            }
+        }
+        std::vector<uint8_t> payload;
+        put_u64(payload, bytes_transferred);
+        put_u64(payload, total_bytes);
+        put_string(payload, current_file);
+        try {
+            session.send(FrameType::PROGRESS, payload);
+        } catch (const std::exception&) {
+            // The CLI went away (Ctrl+C); nobody is waiting for the transfer
+            client.request_cancel();
+        }
+    });
+    client.set_overwrite_callback([&session, force = request.force](const std::string& remote_path, uint64_t remote_size) {
+        if (force) {
+            return Client::OverwriteDecision::OVERWRITE;
+        }
+        std::lock_guard<std::mutex> prompt_lock(session.prompt_mutex);
+        std::vector<uint8_t> payload;
+        put_string(payload, remote_path);
+        put_u64(payload, remote_size);
+        FrameType type;
+        std::vector<uint8_t> reply;
+        try {
+            session.send(FrameType::PROMPT, payload);
+            if (!read_frame(session.socket, type, reply) || type != FrameType::DECISION || reply.empty()) {
+                return Client::OverwriteDecision::CANCEL;
+            }
+        } catch (const std::exception&) {
+            return Client::OverwriteDecision::CANCEL;
+        }
+        return static_cast<Client::OverwriteDecision>(reply[0]);
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        running_.insert(&client);
+    }
+    if (stopping_) {
+        client.request_cancel();
+    }
+    auto detach_client = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(sessions_mutex_);
+            running_.erase(&client);
+        }
+        client.set_progress_callback(nullptr);
+        client.set_overwrite_callback(nullptr);
+    };
+
+    try {
+        run_transfer_request(client, request, [&session](const std::string& text) {
+            std::vector<uint8_t> payload;
+            put_string(payload, text);
+            session.send(FrameType::MESSAGE, payload);
+        });
+    } catch (const NetworkException&) {
+        detach_client();
+        lease.discard();
+        throw;
+    } catch (const ProtocolException&) {
+        detach_client();
+        lease.discard();
+        throw;
+    } catch (...) {
+        // Errors about the request itself leave the connection usable
+        detach_client();
+        if (client.cancel_requested_) {
+            lease.discard();
+        }
+        throw;
+    }
+    detach_client();
+    if (client.cancel_requested_) {
+        // A cancelled transfer leaves the connection in an unknown state
+        lease.discard();
+    }
+}
+
+#else
+
+bool submit_to_agent(const std::string& socket_path, const TransferRequest&, const AgentCallbacks&) {
+    LOG_DEBUG("Client agent is not supported on this platform; not using " + socket_path);
+    return false;
+}
+
+ClientAgent::ClientAgent(std::string socket_path, std::chrono::seconds idle_timeout)
+    : socket_path_(std::move(socket_path)), pool_(idle_timeout) {}
+
+ClientAgent::~ClientAgent() = default;
+
+void ClientAgent::run() {
+    throw NetworkException("The client agent needs Unix domain sockets, which this platform does not support");
+}
+
+void ClientAgent::stop() {
+    stopping_ = true;
+}
+
+#endif
+
+} // namespace client
+} // namespace netcopy
@@ -0,0 +1,532 @@
+#include "client/bulk_job.h"
+#include "common/utils.h"
+#include "exceptions.h"
+#include "file/file_manager.h"
+#include "logging/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace netcopy {
+namespace client {
+
+namespace {
+
+constexpr std::chrono::milliseconds kProgressInterval{250};
+// How far down the queue a worker looks for an entry on the server it is
+// already connected to before it takes the head and switches servers
+constexpr size_t kAffinityWindow = 64;
+// Scheduling weight of entries whose size is not known up front
+constexpr uint64_t kUnknownSize = (std::numeric_limits<uint64_t>::max)();
+
+std::vector<std::string> split_fields(const std::string& line) {
+    std::vector<std::string> fields;
+    const bool tabs = line.find('\t') != std::string::npos;
+    const char* separators = tabs ? "\t" : " \t";
+    size_t pos = 0;
+    while (pos < line.size()) {
+        size_t start = line.find_first_not_of(separators, pos);
+        if (start == std::string::npos) {
+            break;
+        }
+        size_t end = line.find_first_of(separators, start);
+        if (end == std::string::npos) {
+            end = line.size();
+        }
+        std::string field = line.substr(start, end - start);
+        if (tabs) {
+            // Spaces around tab-separated fields are padding, not part of a path
+            size_t first = field.find_first_not_of(' ');
+            size_t last = field.find_last_not_of(' ');
+            field = first == std::string::npos ? std::string() : field.substr(first, last - first + 1);
+        }
+        if (!field.empty()) {
+            fields.push_back(std::move(field));
+        }
+        pos = end;
+    }
+    return fields;
+}
+
+uint64_t estimated_size(const JobEntry& entry) {
+    if (entry.operation != "upload" || !file::FileManager::is_regular_file(entry.local_path)) {
+        // Directories and downloads: assume large, so they start early
+        return kUnknownSize;
+    }
+    try {
+        return file::FileManager::file_size(entry.local_path);
+    } catch (const std::exception&) {
+        return kUnknownSize;
+    }
+}
+
+} // namespace
+
+std::vector<JobEntry> load_job_manifest(const std::string& path, const JobDefaults& defaults) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open job file: " + path);
+    }
+
+    std::vector<JobEntry> entries;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+
+        auto fail = [&](const std::string& what) {
+            throw std::runtime_error("Job file " + path + " line " + std::to_string(line_number) + ": " + what);
+        };
+
+        std::vector<std::string> fields = split_fields(line);
+        if (fields.size() < 3) {
+            fail("expected <upload|download> <source> <destination> [options]");
+        }
+
+        JobEntry entry;
+        entry.line = line_number;
+        entry.operation = fields[0];
+        entry.recursive = defaults.recursive;
+        entry.resume = defaults.resume;
+        if (defaults.force) {
+            entry.existing = Client::OverwriteDecision::OVERWRITE;
+        }
+
+        std::string remote_spec;
+        if (entry.operation == "upload") {
+            entry.local_path = fields[1];
+            remote_spec = fields[2];
+        } else if (entry.operation == "download") {
+            remote_spec = fields[1];
+            entry.local_path = fields[2];
+        } else {
+            fail("unknown operation '" + entry.operation + "', expected upload or download");
+        }
+
+        for (size_t i = 3; i < fields.size(); ++i) {
+            const std::string& option = fields[i];
+            if (option == "recursive" || option == "-R") {
+                entry.recursive = true;
+            } else if (option == "resume") {
+                entry.resume = true;
+            } else if (option == "force" || option == "-f") {
+                entry.existing = Client::OverwriteDecision::OVERWRITE;
+            } else if (option == "delta") {
+                entry.existing = Client::OverwriteDecision::DELTA_SYNC;
+            } else {
+                fail("unknown option '" + option + "'");
+            }
+        }
+
+        try {
+            entry.remote = parse_remote_location(remote_spec, defaults.port_override);
+        } catch (const std::exception& e) {
+            fail(e.what());
+        }
+        if (entry.remote.host.empty()) {
+            fail("missing server address in '" + remote_spec + "'");
+        }
+        // The process keeps one working directory for the whole job
+        entry.local_path = std::filesystem::absolute(entry.local_path).string();
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+const char* job_status_name(JobStatus status) {
+    switch (status) {
+        case JobStatus::PENDING:
+            return "pending";
+        case JobStatus::OK:
+            return "ok";
+        case JobStatus::FAILED:
+            return "failed";
+        case JobStatus::CANCELLED:
+            return "cancelled";
+    }
+    return "unknown";
+}
+
+BulkJob::BulkJob(std::vector<JobEntry> entries, ConnectionProfile profile, size_t workers)
+    : entries_(std::move(entries)), results_(entries_.size()), profile_(std::move(profile)),
+      workers_((std::max)(size_t(1), workers)) {
+    profile_keys_.reserve(entries_.size());
+    std::vector<uint64_t> sizes;
+    sizes.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+        ConnectionProfile entry_profile = profile_;
+        entry_profile.host = entry.remote.host;
+        entry_profile.port = entry.remote.port;
+        profile_keys_.push_back(entry_profile.key());
+        sizes.push_back(estimated_size(entry));
+    }
+
+    // Largest first: the job ends when its longest entry does, so that one
+    // should not be the last to start. Ties keep manifest order.
+    queue_.resize(entries_.size());
+    for (size_t i = 0; i < queue_.size(); ++i) {
+        queue_[i] = i;
+    }
+    std::stable_sort(queue_.begin(), queue_.end(), [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+}
+
+void BulkJob::run(const std::function<void(const JobTotals& totals)>& progress) {
+    const auto started = std::chrono::steady_clock::now();
+    const size_t count = (std::max)(size_t(1), (std::min)(workers_, entries_.size()));
+    std::vector<std::thread> threads;
+    threads.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        threads.emplace_back([this]() { worker(); });
+    }
+
+    bool cancelled = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (finished_workers_ < threads.size()) {
+            workers_done_.wait_for(lock, kProgressInterval);
+            if (!cancelled && cancel_requested_.load(std::memory_order_relaxed)) {
+                cancelled = true;
+                cancel_running();
+            }
+            if (progress) {
+                lock.unlock();
+                progress(totals());
+                lock.lock();
+            }
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Entries nobody took before a cancel
+        for (auto& result : results_) {
+            if (result.status == JobStatus::PENDING) {
+                result.status = JobStatus::CANCELLED;
+            }
+        }
+        seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    }
+    pool_.clear();
+    if (progress) {
+        progress(totals());
+    }
+}
+
+void BulkJob::worker() {
+    // Kept from one entry to the next while they go to the same server
+    ConnectionPool::Lease lease;
+    std::string lease_key;
+    size_t index = 0;
+    while (take(lease_key, index)) {
+        run_entry(index, lease, lease_key);
+    }
+    lease = ConnectionPool::Lease();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++finished_workers_;
+    workers_done_.notify_all();
+}
+
+bool BulkJob::take(const std::string& preferred_key, size_t& index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_head_ >= queue_.size() || cancel_requested_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (!preferred_key.empty()) {
+        const size_t window_end = (std::min)(queue_.size(), queue_head_ + kAffinityWindow);
+        for (size_t i = queue_head_; i < window_end; ++i) {
+            if (profile_keys_[queue_[i]] == preferred_key) {
+                // Move it to the head; the entries it passes keep their order
+                std::rotate(queue_.begin() + queue_head_, queue_.begin() + i, queue_.begin() + i + 1);
+                break;
+            }
+        }
+    }
+    index = queue_[queue_head_++];
+    return true;
+}
+
+void BulkJob::run_entry(size_t index, ConnectionPool::Lease& lease, std::string& lease_key) {
+    const JobEntry& entry = entries_[index];
+    const std::string& key = profile_keys_[index];
+    const auto started = std::chrono::steady_clock::now();
+
+    JobResult result;
+    EntryProgress progress;
+    // What the next attempt runs; a retry may switch it to resume
+    JobEntry attempt = entry;
+    auto fail = [&](const std::exception& e) {
+        result.status = cancel_requested_.load(std::memory_order_relaxed) ? JobStatus::CANCELLED : JobStatus::FAILED;
+        result.error = e.what();
+    };
+    auto drop_connection = [&]() {
+        lease.discard();
+        lease_key.clear();
+    };
+
+    while (result.status == JobStatus::PENDING) {
+        ++result.attempts;
+        // Set while the connection was opened for this attempt, so a
+        // failure cannot be blamed on it having gone stale while idle
+        bool fresh = true;
+        // Every FileResponse carries a new session id, so a change shows the
+        // server accepted a request of this attempt
+        std::string session_before;
+        try {
+            if (!lease || lease_key != key) {
+                ConnectionProfile profile = profile_;
+                profile.host = entry.remote.host;
+                profile.port = entry.remote.port;
+                lease = ConnectionPool::Lease();
+                lease = pool_.acquire(profile);
+                lease_key = key;
+                fresh = !lease.reused();
+                if (fresh) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ++connections_opened_;
+                }
+            } else {
+                fresh = false;
+            }
+            session_before = lease->get_session_id();
+            transfer(*lease, attempt, progress);
+            result.status = lease->cancel_requested_ ? JobStatus::CANCELLED : JobStatus::OK;
+            if (lease->cancel_requested_) {
+                // A cancelled transfer leaves the connection in an unknown state
+                drop_connection();
+            }
+        } catch (const NetworkException& e) {
+            const bool answered = lease && lease->get_session_id() != session_before;
+            drop_connection();
+            // The server may have closed a connection that sat idle; one
+            // more try on a new connection, if that cannot lose data
+            if (!fresh && result.attempts == 1 && !cancel_requested_.load(std::memory_order_relaxed) &&
+                prepare_retry(attempt, progress, answered)) {
+                LOG_DEBUG("Job line " + std::to_string(entry.line) + ": retrying on a new connection" +
+                          (attempt.resume ? " with resume" : "") + " after: " + e.what());
+                continue;
+            }
+            fail(e);
+        } catch (const ProtocolException& e) {
+            drop_connection();
+            fail(e);
+        } catch (const std::exception& e) {
+            // Errors about the entry itself leave the connection usable
+            if (lease && lease->cancel_requested_) {
+                drop_connection();
+            }
+            fail(e);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(progress.mutex);
+        result.bytes = progress.bytes;
+        result.skipped_files = progress.skipped;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (result.status == JobStatus::FAILED) {
+        LOG_WARNING("Job line " + std::to_string(entry.line) + " (" + entry.operation + " " + entry.local_path +
+                    ") failed: " + result.error);
+    }
+    finish(index, std::move(result));
+}
+
+bool BulkJob::prepare_retry(JobEntry& attempt, EntryProgress& progress, bool request_answered) {
+    std::lock_guard<std::mutex> lock(progress.mutex);
+    if (!request_answered && progress.bytes == 0 && progress.decisions == 0) {
+        // The server never took the request: the destination is as before
+        return true;
+    }
+    // Past this point the destination may hold part of this entry, which a
+    // plain retry would see as an existing file and skip
+    if (attempt.operation != "upload" || file::FileManager::is_directory(attempt.local_path)) {
+        // Downloads do not resume, and resuming a directory would also
+        // resume into files that existed before and were never decided on
+        return false;
+    }
+    if (attempt.existing != Client::OverwriteDecision::DELTA_SYNC) {
+        // The journal (or partial size) of this attempt gives the missing
+        // ranges; resume also skips the overwrite prompt
+        attempt.resume = true;
+    }
+    // Delta sync compares the destination with the source, so it converges
+    // whatever the first attempt left behind
+    return true;
+}
+
+void BulkJob::transfer(Client& client, const JobEntry& entry, EntryProgress& progress) {
+    client.set_progress_callback([this, &progress](uint64_t bytes_transferred, uint64_t, const std::string& current_file) {
+        uint64_t added = 0;
+        {
+            std::lock_guard<std::mutex> lock(progress.mutex);
+            uint64_t& last = progress.last_bytes[current_file];
+            auto skip = progress.skipping.find(std::this_thread::get_id());
+            if (skip != progress.skipping.end() && skip->second) {
+                skip->second = false;
+                last = bytes_transferred;
+                return;
+            }
+            if (bytes_transferred > last) {
+                added = bytes_transferred - last;
+                last = bytes_transferred;
+                progress.bytes += added;
+            }
+        }
+        if (added > 0) {
+            bytes_.fetch_add(added, std::memory_order_relaxed);
+        }
+    });
+    client.set_overwrite_callback([&progress, existing = entry.existing](const std::string&, uint64_t) {
+        std::lock_guard<std::mutex> lock(progress.mutex);
+        ++progress.decisions;
+        if (existing == Client::OverwriteDecision::SKIP) {
+            progress.skipping[std::this_thread::get_id()] = true;
+            ++progress.skipped;
+        }
+        return existing;
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_.insert(&client);
+    }
+    if (cancel_requested_.load(std::memory_order_relaxed)) {
+        client.request_cancel();
+    }
+    auto detach_client = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_.erase(&client);
+        }
+        client.set_progress_callback(nullptr);
+        client.set_overwrite_callback(nullptr);
+    };
+
+    TransferRequest request;
+    request.operation = entry.operation;
+    request.local_path = entry.local_path;
+    request.remote_path = entry.remote.path;
+    request.host = entry.remote.host;
+    request.port = entry.remote.port;
+    request.recursive = entry.recursive;
+    request.resume = entry.resume;
+    request.force = entry.existing == Client::OverwriteDecision::OVERWRITE;
+
+    try {
+        run_transfer_request(client, request, [](const std::string& text) {
+            size_t start = text.find_first_not_of('\n');
+            if (start != std::string::npos) {
+                LOG_DEBUG(text.substr(start));
+            }
+        });
+    } catch (...) {
+        detach_client();
+        throw;
+    }
+    detach_client();
+}
+
+void BulkJob::finish(size_t index, JobResult result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_[index] = std::move(result);
+}
+
+void BulkJob::cancel_running() {
+    // Called with mutex_ held
+    for (Client* client : running_) {
+        client->request_cancel();
+    }
+}
+
+JobTotals BulkJob::totals() const {
+    JobTotals totals;
+    std::lock_guard<std::mutex> lock(mutex_);
+    totals.entries = entries_.size();
+    for (const auto& result : results_) {
+        switch (result.status) {
+            case JobStatus::OK:
+                ++totals.succeeded;
+                break;
+            case JobStatus::FAILED:
+                ++totals.failed;
+                break;
+            case JobStatus::CANCELLED:
+                ++totals.cancelled;
+                break;
+            case JobStatus::PENDING:
+                break;
+        }
+    }
+    totals.running = running_.size();
+    totals.bytes = bytes_.load(std::memory_order_relaxed);
+    totals.connections_opened = connections_opened_;
+    return totals;
+}
+
+std::string BulkJob::report_json(const std::string& manifest_path) const {
+    const JobTotals summary = totals();
+    uint64_t bytes = 0;
+    for (const auto& result : results_) {
+        bytes += result.bytes;
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(6);
+    out << "{\n";
+    out << "  \"manifest\": \"" << common::escape_json(manifest_path) << "\",\n";
+    out << "  \"version\": \"" << common::escape_json(common::get_version_string()) << "\",\n";
+    out << "  \"workers\": " << workers_ << ",\n";
+    out << "  \"entries\": " << summary.entries << ",\n";
+    out << "  \"succeeded\": " << summary.succeeded << ",\n";
+    out << "  \"failed\": " << summary.failed << ",\n";
+    out << "  \"cancelled\": " << summary.cancelled << ",\n";
+    out << "  \"bytes\": " << bytes << ",\n";
+    out << "  \"seconds\": " << seconds_ << ",\n";
+    out << "  \"connections_opened\": " << summary.connections_opened << ",\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        const auto& e = entries_[i];
+        const auto& r = results_[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"line\": " << e.line
+            << ", \"operation\": \"" << common::escape_json(e.operation) << "\""
+            << ", \"local\": \"" << common::escape_json(e.local_path) << "\""
+            << ", \"host\": \"" << common::escape_json(e.remote.host) << "\""
+            << ", \"port\": " << e.remote.port
+            << ", \"remote\": \"" << common::escape_json(e.remote.path) << "\""
+            << ", \"status\": \"" << job_status_name(r.status) << "\""
+            << ", \"bytes\": " << r.bytes
+            << ", \"skipped_files\": " << r.skipped_files
+            << ", \"attempts\": " << r.attempts
+            << ", \"seconds\": " << r.seconds;
+        if (!r.error.empty()) {
+            out << ", \"error\": \"" << common::escape_json(r.error) << "\"";
+        }
+        out << "}";
+    }
+    out << (entries_.empty() ? "]\n" : "\n  ]\n");
+    out << "}\n";
+    return out.str();
+}
+
+} // namespace client
+} // namespace netcopy
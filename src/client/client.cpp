@@ -2,12 +2,14 @@
 #include "common/fast_mem.h"
 #include "common/compression.h"
 #include "common/utils.h"
+#include "common/trace.h"
 #include "exceptions.h"
 #include "file/file_manager.h"
 #include "logging/logger.h"
 #include "crypto/sha3.h"
 #include "crypto/mlkem.h"
 #include "crypto/key_manager.h"
+#include "crypto/cipher_benchmark.h"
 #include "protocol/message.h"
 #include "network/windows_experimental.h"
 #ifdef _WIN32
@@ -16,8 +18,11 @@
 #include <arpa/inet.h>
 #endif
 #include <algorithm>
+#include <cstring>
 #include <exception>
 #include <mutex>
+#include <set>
+#include <unordered_map>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -33,7 +38,7 @@ size_t execute_io_sync(Func&& async_op) {
     auto future = promise->get_future();
     async_op([promise](const asio::error_code& ec, size_t bytes) {
         if (ec) {
-            promise->set_exception(std::make_exception_ptr(std::runtime_error(ec.message())));
+            promise->set_exception(std::make_exception_ptr(NetworkException(ec.message())));
         } else {
             promise->set_value(bytes);
         }
@@ -65,6 +70,138 @@ size_t normalized_batch_chunks(int configured) {
     value = (std::max)(1, (std::min)(value, config::defaults::kMaxBatchChunks));
     return static_cast<size_t>(value);
 }
+
+using ByteRanges = std::vector<std::pair<uint64_t, uint64_t>>;
+
+// Complement of the receiver's completed (offset, length) ranges in [0, total_size)
+ByteRanges missing_ranges(ByteRanges completed, uint64_t total_size) {
+    std::sort(completed.begin(), completed.end());
+    ByteRanges missing;
+    uint64_t cursor = 0;
+    for (const auto& range : completed) {
+        uint64_t start = (std::min)(range.first, total_size);
+        uint64_t end = (std::min)(range.first + range.second, total_size);
+        if (start > cursor) {
+            missing.emplace_back(cursor, start - cursor);
+        }
+        cursor = (std::max)(cursor, end);
+    }
+    if (cursor < total_size) {
+        missing.emplace_back(cursor, total_size - cursor);
+    }
+    return missing;
+}
+
+// Splits the ranges into `streams` lists carrying roughly equal byte counts,
+// cutting ranges where a share boundary falls inside one. Shares are rounded
+// up to a multiple of `align` so cuts land on Merkle leaf boundaries.
+std::vector<ByteRanges> partition_ranges(const ByteRanges& ranges, uint32_t streams, uint64_t align = 1) {
+    uint64_t total = 0;
+    for (const auto& range : ranges) {
+        total += range.second;
+    }
+    streams = (std::max)(1u, streams);
+    align = (std::max)(uint64_t(1), align);
+    const uint64_t share = ((total + streams - 1) / streams + align - 1) / align * align;
+
+    std::vector<ByteRanges> plan(streams);
+    size_t stream = 0;
+    uint64_t filled = 0;
+    for (const auto& range : ranges) {
+        uint64_t offset = range.first;
+        uint64_t remaining = range.second;
+        while (remaining > 0) {
+            if (filled >= share && stream + 1 < plan.size()) {
+                ++stream;
+                filled = 0;
+            }
+            uint64_t take = (stream + 1 < plan.size()) ? (std::min)(remaining, share - filled) : remaining;
+            plan[stream].emplace_back(offset, take);
+            offset += take;
+            remaining -= take;
+            filled += take;
+        }
+    }
+    return plan;
+}
+
+// Directory uploads below this size go to the small-file lane
+constexpr uint64_t kSmallFileLaneSize = 1024 * 1024;
+// Directory uploads from this size on are split into pieces idle workers can take
+constexpr uint64_t kSharedUploadMinSize = 256ull * 1024 * 1024;
+constexpr uint64_t kSharedPieceSize = 64ull * 1024 * 1024;
+
+// Cuts the ranges into pieces of at most `piece` bytes, rounded up to a
+// multiple of `align`
+std::deque<std::pair<uint64_t, uint64_t>> split_ranges(const ByteRanges& ranges, uint64_t piece, uint64_t align) {
+    align = (std::max)(uint64_t(1), align);
+    piece = ((std::max)(piece, align) + align - 1) / align * align;
+    std::deque<std::pair<uint64_t, uint64_t>> pieces;
+    for (const auto& range : ranges) {
+        for (uint64_t done = 0; done < range.second;) {
+            uint64_t take = (std::min)(piece, range.second - done);
+            pieces.emplace_back(range.first + done, take);
+            done += take;
+        }
+    }
+    return pieces;
+}
+}
+
+bool Client::SharedUpload::take(Piece& piece, bool wait) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (wait) {
+        changed.wait(lock, [&]() { return !pieces.empty() || in_flight == 0; });
+    }
+    if (pieces.empty() || (closed && !wait)) {
+        return false;
+    }
+    piece = pieces.front();
+    pieces.pop_front();
+    ++in_flight;
+    return true;
+}
+
+void Client::SharedUpload::finish(const Piece& piece, bool sent) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!sent) {
+        pieces.push_front(piece);
+    }
+    --in_flight;
+    changed.notify_all();
+}
+
+std::function<void(uint64_t)> Client::SharedUpload::piece_progress(Piece& piece) {
+    auto repeated = std::make_shared<uint64_t>(piece.counted);
+    return [this, &piece, repeated](uint64_t delta) {
+        uint64_t again = (std::min)(delta, *repeated);
+        *repeated -= again;
+        piece.counted += delta - again;
+        if (delta > again) {
+            progress(delta - again);
+        }
+    };
+}
+
+bool Client::SharedUpload::join() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closed || pieces.empty()) {
+        return false;
+    }
+    ++helpers;
+    return true;
+}
+
+void Client::SharedUpload::leave() {
+    std::lock_guard<std::mutex> lock(mutex);
+    --helpers;
+    changed.notify_all();
+}
+
+void Client::SharedUpload::close() {
+    std::unique_lock<std::mutex> lock(mutex);
+    closed = true;
+    changed.wait(lock, [&]() { return helpers == 0; });
 }
 
 Client::Client()
@@ -128,6 +265,38 @@ const config::ClientConfig& Client::get_config() const {
 }
 
 void Client::connect(const std::string& server_address, uint16_t port) {
+    // Stream clients share the paths of the client that opened them
+    if (!parent_client_ && (!path_selector_ || !path_selector_->serves(server_address, port))) {
+        path_selector_ = PathSelector::from_config(config_, server_address, port);
+    }
+    if (!path_selector_) {
+        open_connection(server_address, port, "");
+        return;
+    }
+
+    std::exception_ptr last_error;
+    for (size_t attempt = 0; attempt < path_selector_->size(); ++attempt) {
+        size_t index = path_selector_->acquire();
+        const TransferPath& path = path_selector_->path(index);
+        try {
+            open_connection(path.host, path.port, path.local_address);
+        } catch (const std::exception& e) {
+            LOG_WARNING("Connecting over path " + path.name() + " failed: " + e.what());
+            path_selector_->release(index);
+            path_selector_->mark_failed(index);
+            last_error = std::current_exception();
+            continue;
+        }
+        path_index_ = index;
+        // Reconnects go through path selection again
+        server_address_ = server_address;
+        server_port_ = port;
+        return;
+    }
+    std::rethrow_exception(last_error);
+}
+
+void Client::open_connection(const std::string& host, uint16_t port, const std::string& local_address) {
     try {
         event_loop_ = std::make_shared<network::EventLoop>(2);
         event_loop_->start();
@@ -136,9 +305,9 @@ void Client::connect(const std::string& server_address, uint16_t port) {
         
         auto connect_promise = std::make_shared<std::promise<asio::error_code>>();
         auto connect_future = connect_promise->get_future();
-        async_socket_->connect(server_address, port, [connect_promise](const asio::error_code& ec) {
+        async_socket_->connect(host, port, [connect_promise](const asio::error_code& ec) {
             connect_promise->set_value(ec);
-        });
+        }, local_address);
         
         asio::error_code ec = connect_future.get();
         if (ec) {
@@ -179,7 +348,7 @@ void Client::connect(const std::string& server_address, uint16_t port) {
             }
         }
 
-        server_address_ = server_address;
+        server_address_ = host;
         server_port_ = port;
         perform_handshake();
 
@@ -310,6 +479,24 @@ void Client::disconnect() {
     }
     event_loop_.reset();
     connected_ = false;
+    if (path_selector_ && path_index_ != PathSelector::kNoPath) {
+        path_selector_->release(path_index_);
+        path_index_ = PathSelector::kNoPath;
+    }
+}
+
+bool Client::fail_over(const std::string& reason) {
+    if (!path_selector_ || path_selector_->size() < 2 || path_index_ == PathSelector::kNoPath || cancel_requested_) {
+        return false;
+    }
+    LOG_WARNING("Connection over path " + path_selector_->path(path_index_).name() + " lost: " + reason);
+    path_selector_->mark_failed(path_index_);
+    if (!path_selector_->has_healthy_path()) {
+        return false;
+    }
+    disconnect();
+    connect(server_address_, server_port_);
+    return true;
 }
 
 bool Client::is_connected() const {
@@ -320,6 +507,10 @@ void Client::set_security_level(crypto::SecurityLevel level) {
     security_level_ = level;
 }
 
+void Client::set_auto_security_level(bool enabled) {
+    auto_security_level_ = enabled;
+}
+
 void Client::transfer_file(const std::string& local_path, const std::string& remote_path, bool resume) {
     if (!connected_) {
         throw NetworkException("Client is not connected");
@@ -358,6 +549,7 @@ void Client::transfer_directory(const std::string& local_path,
         struct FileTransferTask {
             std::string local_path;
             std::string remote_path;
+            uint64_t size = 0;
         };
         std::vector<FileTransferTask> file_tasks;
         
@@ -400,7 +592,7 @@ void Client::transfer_directory(const std::string& local_path,
                     create_empty_directory(destination);
                 }
             } else {
-                file_tasks.push_back({entry.path, destination});
+                file_tasks.push_back({entry.path, destination, entry.size});
                 files_to_report.push_back({entry.path, entry.size});
                 total_bytes += entry.size;
                 files_transferred++;
@@ -416,6 +608,11 @@ void Client::transfer_directory(const std::string& local_path,
             return;
         }
         
+        // Largest first, so no big file is left to finish alone at the end
+        std::stable_sort(file_tasks.begin(), file_tasks.end(), [](const FileTransferTask& a, const FileTransferTask& b) {
+            return a.size > b.size;
+        });
+
         uint32_t max_threads = negotiated_parallel_streams_ == 0 ? 1 : negotiated_parallel_streams_;
         if (max_threads <= 1 || file_tasks.size() <= 1) {
             // Sequential transfer
@@ -432,9 +629,17 @@ void Client::transfer_directory(const std::string& local_path,
             return;
         }
         
-        // Concurrent transfer over multiple socket connections
+        // Concurrent transfer over multiple socket connections. Small files
+        // get a lane of their own so they keep moving while the large ones
+        // are sent; each lane helps the other once its own queue is empty.
+        auto first_small = std::find_if(file_tasks.begin(), file_tasks.end(), [](const FileTransferTask& task) {
+            return task.size < kSmallFileLaneSize;
+        });
+        const std::vector<FileTransferTask> large_tasks(file_tasks.begin(), first_small);
+        const std::vector<FileTransferTask> small_tasks(first_small, file_tasks.end());
         std::mutex queue_mutex;
-        size_t next_task_idx = 0;
+        size_t next_large_idx = 0;
+        size_t next_small_idx = 0;
         std::exception_ptr first_error;
         std::mutex error_mutex;
         
@@ -447,6 +652,24 @@ void Client::transfer_directory(const std::string& local_path,
         };
         
         uint32_t num_threads = (std::min)(max_threads, static_cast<uint32_t>(file_tasks.size()));
+        const bool small_lane = num_threads > 1 && !large_tasks.empty() && !small_tasks.empty();
+
+        auto next_task = [&](bool prefer_small) -> const FileTransferTask* {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (first_error) {
+                return nullptr;
+            }
+            if (prefer_small && next_small_idx < small_tasks.size()) {
+                return &small_tasks[next_small_idx++];
+            }
+            if (next_large_idx < large_tasks.size()) {
+                return &large_tasks[next_large_idx++];
+            }
+            if (next_small_idx < small_tasks.size()) {
+                return &small_tasks[next_small_idx++];
+            }
+            return nullptr;
+        };
         std::mutex progress_callback_mutex;
         auto safe_progress_callback = [&](uint64_t bytes_transferred, uint64_t total_bytes, const std::string& current_file) {
             if (progress_callback_) {
@@ -455,16 +678,17 @@ void Client::transfer_directory(const std::string& local_path,
             }
         };
         
-        auto worker_body = [&]() {
+        auto worker_body = [&](uint32_t worker_index) {
             try {
                 Client stream_client;
                 stream_client.set_config(config_);
-                stream_client.set_security_level(security_level_);
+                stream_client.set_security_level(negotiated_security_level_);
                 stream_client.set_requested_parallel_streams(1); // Enforce single thread/connection per file transfer
                 stream_client.bandwidth_limiter_ = bandwidth_limiter_;
                 stream_client.set_progress_callback(safe_progress_callback); // Propagate progress callback safely
                 stream_client.set_overwrite_callback(overwrite_callback_);
                 stream_client.parent_client_ = this;
+                stream_client.path_selector_ = path_selector_;
                 
                 {
                     std::lock_guard<std::mutex> lock(workers_mutex_);
@@ -493,23 +717,53 @@ void Client::transfer_directory(const std::string& local_path,
                     if (cancel_requested_ || stream_client.cancel_requested_) {
                         break;
                     }
-                    size_t idx;
-                    {
-                        std::lock_guard<std::mutex> lock(queue_mutex);
-                        if (next_task_idx >= file_tasks.size() || first_error) {
+                    // The server shrank this client's grant: retire surplus workers
+                    uint32_t admitted = admitted_streams_.load();
+                    if (admitted != 0 && worker_index > 0 && worker_index >= admitted) {
+                        LOG_INFO("Closing upload connection " + std::to_string(worker_index) + " at the server's request");
+                        break;
+                    }
+                    const FileTransferTask* task = next_task(small_lane && worker_index == 0);
+                    if (!task) {
+                        // Out of files: lend this connection to a large file still being sent
+                        bool helped = false;
+                        try {
+                            helped = stream_client.help_shared_upload();
+                        } catch (const std::exception& e) {
+                            // Pieces that were not sent went back to the owner's queue
+                            LOG_WARNING("Stopped helping with a shared upload: " + std::string(e.what()));
+                            if (!dynamic_cast<const NetworkException*>(&e) || !stream_client.fail_over(e.what())) {
+                                stream_client.disconnect();
+                                stream_client.connect(server_address_, server_port_);
+                            }
+                            helped = true;
+                        }
+                        if (!helped) {
                             break;
                         }
-                        idx = next_task_idx++;
+                        continue;
                     }
                     
-                    const auto& task = file_tasks[idx];
-                    try {
-                        stream_client.transfer_single_file(task.local_path, task.remote_path, resume);
-                    } catch (const FileSkippedException& e) {
-                        LOG_INFO("File skipped: " + task.local_path);
-                        stream_client.disconnect();
-                        stream_client.connect(server_address_, server_port_);
+                    stream_client.share_ranges_ = num_threads > 1 && task->size >= kSharedUploadMinSize;
+                    bool failed_over = false;
+                    while (true) {
+                        try {
+                            // After a failover the server keeps what arrived over the lost path
+                            stream_client.transfer_single_file(task->local_path, task->remote_path, resume || failed_over);
+                        } catch (const FileSkippedException& e) {
+                            LOG_INFO("File skipped: " + task->local_path);
+                            stream_client.disconnect();
+                            stream_client.connect(server_address_, server_port_);
+                        } catch (const NetworkException& e) {
+                            if (!stream_client.fail_over(e.what())) {
+                                throw;
+                            }
+                            failed_over = true;
+                            continue;
+                        }
+                        break;
                     }
+                    stream_client.share_ranges_ = false;
                 }
             } catch (...) {
                 record_error(std::current_exception());
@@ -520,7 +774,7 @@ void Client::transfer_directory(const std::string& local_path,
         workers.reserve(num_threads);
         try {
             for (uint32_t i = 0; i < num_threads; ++i) {
-                workers.emplace_back(worker_body);
+                workers.emplace_back(worker_body, i);
             }
         } catch (...) {
             for (auto& worker : workers) {
@@ -634,11 +888,27 @@ void Client::perform_handshake() {
     request.max_chunk_size = chunk_size_manager_.get_max_chunk_size();
     request.file_size = 0;
     request.requested_parallel_streams = requested_parallel_streams_;
+    request.accepts_admission_updates = true;
+    request.auto_security_level = auto_security_level_;
+    if (auto_security_level_ && !config_.internal.secret_key.empty()) {
+        request.cipher_rates = crypto::local_cipher_rates();
+    }
     // Set auth fields
     request.username = config_.internal.username;
     if (config_.internal.auth_method == "password")      request.auth_method_id = 1;
     else if (config_.internal.auth_method == "mlkem")    request.auth_method_id = 2;
     else                                         request.auth_method_id = 0;
+    // Under TLS, offer to bind the shared key to this TLS session instead of
+    // encrypting payloads twice (never for ML-KEM, whose inner layer is
+    // what makes the session post-quantum)
+    std::vector<uint8_t> tls_exporter;
+    if (config_.tls.channel_binding && !config_.internal.secret_key.empty() && request.auth_method_id != 2 &&
+        async_socket_ && async_socket_->is_tls()) {
+        tls_exporter = async_socket_->export_keying_material(common::kTlsBindingLabel, common::kTlsBindingExporterSize);
+        if (!tls_exporter.empty()) {
+            request.tls_binding = common::tls_binding_proof(config_.internal.secret_key, tls_exporter, true);
+        }
+    }
 
     send_message(request);
 
@@ -649,7 +919,15 @@ void Client::perform_handshake() {
     }
 
     negotiated_security_level_ = response->accepted_security_level;
-    if (negotiated_security_level_ != security_level_) {
+    // "auto" accepts either authenticated cipher, but never a downgrade
+    bool auto_choice = auto_security_level_ &&
+        (negotiated_security_level_ == crypto::SecurityLevel::HIGH ||
+         negotiated_security_level_ == crypto::SecurityLevel::AES_256_GCM);
+    if (auto_choice && response->cipher_rates.known()) {
+        LOG_DEBUG("Server cipher rates: ChaCha20-Poly1305 " + std::to_string(response->cipher_rates.chacha20_poly1305) +
+                  " MB/s, AES-256-GCM " + std::to_string(response->cipher_rates.aes_256_gcm) + " MB/s");
+    }
+    if (negotiated_security_level_ != security_level_ && !auto_choice) {
         std::string req_name = (security_level_ == crypto::SecurityLevel::HIGH) ? "HIGH" :
                                (security_level_ == crypto::SecurityLevel::FAST) ? "FAST" :
                                (security_level_ == crypto::SecurityLevel::AES) ? "AES" : "AES_256_GCM";
@@ -669,17 +947,29 @@ void Client::perform_handshake() {
         if (config_.internal.secret_key.empty()) {
             throw CryptoException("Server requires authentication but no secret key is configured");
         }
-        crypto_engine_ = crypto::create_crypto_engine(negotiated_security_level_, config_.internal.secret_key);
-        
-        // Derive dynamic session key with nonces
-        auto derived = common::derive_session_key(
-            config_.internal.secret_key,
-            {},
-            response->server_nonce,
-            request.client_nonce);
-        std::string hex_derived = common::to_hex_string(derived);
-        crypto_engine_ = crypto::create_crypto_engine(negotiated_security_level_, "0x" + hex_derived);
-        LOG_DEBUG("Derived dynamic session key with nonces");
+        if (!response->tls_binding.empty()) {
+            // A server that accepts binding must prove it holds the key for
+            // this very TLS session, or a relay could strip the inner layer
+            if (tls_exporter.empty() ||
+                !common::tls_binding_matches(common::tls_binding_proof(config_.internal.secret_key, tls_exporter, false),
+                                             response->tls_binding)) {
+                throw AuthException("TLS channel binding failed: server does not hold the shared key for this session");
+            }
+            crypto_engine_.reset();
+            LOG_INFO("TLS channel binding accepted; payloads are protected by TLS only");
+        } else {
+            crypto_engine_ = crypto::create_crypto_engine(negotiated_security_level_, config_.internal.secret_key);
+            
+            // Derive dynamic session key with nonces
+            auto derived = common::derive_session_key(
+                config_.internal.secret_key,
+                {},
+                response->server_nonce,
+                request.client_nonce);
+            std::string hex_derived = common::to_hex_string(derived);
+            crypto_engine_ = crypto::create_crypto_engine(negotiated_security_level_, "0x" + hex_derived);
+            LOG_DEBUG("Derived dynamic session key with nonces");
+        }
     }
 
     // User authentication phase
@@ -756,6 +1046,7 @@ void Client::send_message(const protocol::Message& message) {
 
     auto data = message.serialize();
     if (crypto_engine_) {
+        common::TraceScope trace(common::TraceStage::Encrypt);
         data = encrypt_message(data);
     }
     if (data.size() > config::defaults::kMaxFrameSize) {
@@ -763,6 +1054,7 @@ void Client::send_message(const protocol::Message& message) {
     }
 
     uint32_t length = htonl(static_cast<uint32_t>(data.size()));
+    common::TraceScope trace(common::TraceStage::Send);
     execute_io_sync([&](auto&& handler) {
         std::vector<asio::const_buffer> buffers;
         buffers.reserve(2);
@@ -772,6 +1064,9 @@ void Client::send_message(const protocol::Message& message) {
         }
         async_socket_->async_write(buffers, std::move(handler));
     });
+    if (path_selector_) {
+        path_selector_->record(path_index_, sizeof(length) + data.size());
+    }
 }
 
 std::unique_ptr<protocol::Message> Client::receive_message() {
@@ -802,11 +1097,31 @@ std::unique_ptr<protocol::Message> Client::receive_message() {
         total_received += received;
     }
 
+    if (path_selector_) {
+        path_selector_->record(path_index_, sizeof(length_net) + data.size());
+    }
     if (crypto_engine_) {
         data = decrypt_message(data);
     }
 
-    return protocol::Message::deserialize(data);
+    auto message = protocol::Message::deserialize(data);
+    if (auto update = dynamic_cast<protocol::AdmissionUpdate*>(message.get())) {
+        // Precedes the reply the caller is waiting for
+        apply_admission_update(*update);
+        return receive_message();
+    }
+    return message;
+}
+
+void Client::apply_admission_update(const protocol::AdmissionUpdate& update) {
+    Client* root = parent_client_ ? parent_client_ : this;
+    root->admitted_streams_ = (std::max)(1u, update.max_parallel_streams);
+    if (update.max_chunk_size > 0) {
+        admitted_chunk_size_ = static_cast<size_t>(update.max_chunk_size);
+    }
+    admitted_window_bytes_ = update.inflight_window_bytes;
+    LOG_DEBUG("Server admission changed: " + std::to_string(update.max_parallel_streams) + " streams, " +
+              std::to_string(update.max_chunk_size) + " byte chunks");
 }
 
 std::vector<uint8_t> Client::encrypt_message(const std::vector<uint8_t>& data) {
@@ -825,15 +1140,18 @@ std::vector<uint8_t> Client::decrypt_message(const std::vector<uint8_t>& data) {
 
 void Client::transfer_single_file(const std::string& local_path, const std::string& remote_path, bool resume) {
     cancel_requested_ = false;
+    upload_tree_.reset();
     bool is_sym = file::FileManager::is_symlink(local_path);
     uint64_t total_size = is_sym ? 0 : file::FileManager::file_size(local_path);
 
     uint64_t resume_offset = 0;
     uint64_t remote_file_size = 0;
+    std::optional<ByteRanges> journal_ranges;
     // Probe the destination without arming truncation. Delta sync needs the
     // existing remote file as its basis, and overwrite mode re-arms truncation
     // after the overwrite decision is known.
-    send_file_request(local_path, remote_path, resume, false, resume_offset, &remote_file_size);
+    send_file_request(local_path, remote_path, resume, false, resume_offset, &remote_file_size,
+                      resume ? &journal_ranges : nullptr);
     if (resume_offset > total_size) {
         throw FileException("Resume offset is larger than source file");
     }
@@ -911,6 +1229,46 @@ void Client::transfer_single_file(const std::string& local_path, const std::stri
             diffs.push_back({local_hashes[i].offset, (std::min)(block_size, total_size - local_hashes[i].offset)});
         }
         
+        // 4b. Blocks that moved within the file are copied on the server
+        bool blocks_copied = false;
+        if (negotiated_block_copy_ && !diffs.empty() && !remote_blocks.empty()) {
+            // Only full-size remote blocks can stand in for a local block
+            std::unordered_map<uint64_t, uint64_t> remote_by_hash;
+            for (const auto& block : remote_blocks) {
+                if (block.hash.size() == 8 && block.offset + block_size <= remote_file_size) {
+                    uint64_t key = 0;
+                    std::memcpy(&key, block.hash.data(), sizeof(key));
+                    remote_by_hash.emplace(key, block.offset);
+                }
+            }
+            std::vector<protocol::BlockCopyRange> moves;
+            for (const auto& diff : diffs) {
+                const auto& local = local_hashes[diff.offset / block_size];
+                if (diff.size != block_size || local.hash.size() != 8) {
+                    continue;
+                }
+                uint64_t key = 0;
+                std::memcpy(&key, local.hash.data(), sizeof(key));
+                auto it = remote_by_hash.find(key);
+                if (it != remote_by_hash.end()) {
+                    moves.push_back({it->second, diff.offset, diff.size, local.hash});
+                }
+            }
+            if (!moves.empty()) {
+                auto copied = request_block_copy(remote_path, moves);
+                if (!copied.empty()) {
+                    blocks_copied = true;
+                    std::set<uint64_t> copied_offsets;
+                    for (const auto& range : copied) {
+                        copied_offsets.insert(range.first);
+                    }
+                    diffs.erase(std::remove_if(diffs.begin(), diffs.end(), [&](const BlockRange& diff) {
+                        return copied_offsets.count(diff.offset) != 0;
+                    }), diffs.end());
+                }
+            }
+        }
+        
         // 5. Merge contiguous differing blocks to optimize transfers
         std::vector<BlockRange> merged_diffs;
         for (const auto& diff : diffs) {
@@ -990,7 +1348,7 @@ void Client::transfer_single_file(const std::string& local_path, const std::stri
         }
         
         // E2E Integrity verification
-        if (total_size > 0 && !merged_diffs.empty()) {
+        if (total_size > 0 && (!merged_diffs.empty() || blocks_copied)) {
             LOG_INFO("Performing E2E integrity check for: " + local_path);
             auto local_hash = local_full_hash.empty()
                 ? file::FileManager::compute_file_hash(local_path, should_cancel)
@@ -1012,7 +1370,8 @@ void Client::transfer_single_file(const std::string& local_path, const std::stri
                 throw FileException("Integrity verification failed for " + local_path + ": " + verify_resp->error_message);
             }
             
-            LOG_INFO("E2E Integrity verification succeeded for: " + local_path);
+            LOG_INFO("E2E Integrity verification succeeded for: " + local_path +
+                     (verify_resp->durable ? " (committed to stable storage)" : ""));
         }
         
         return; // Done with delta sync!
@@ -1027,7 +1386,51 @@ void Client::transfer_single_file(const std::string& local_path, const std::stri
     bandwidth_monitor_.reset();
     chunk_size_manager_.reset();
 
-    uint32_t stream_count = resume ? 1 : choose_parallel_stream_count(total_size - resume_offset);
+    // Ranges still to send. The receiver's range journal lists exactly what
+    // was written, which stays true with preallocation and parallel streams;
+    // without one, resume after the contiguous prefix.
+    ByteRanges pending;
+    if (journal_ranges) {
+        pending = missing_ranges(*journal_ranges, total_size);
+    } else if (total_size > resume_offset) {
+        pending.emplace_back(resume_offset, total_size - resume_offset);
+    }
+
+    // A file of the same size uploaded earlier in this session may hold the
+    // same bytes; the server copies whatever blocks still match
+    bool blocks_copied = false;
+    if (negotiated_block_copy_ && !is_sym && !journal_ranges && resume_offset == 0 &&
+        total_size >= config::defaults::kMinBlockCopyFileSize) {
+        const std::string source = find_upload_of_size(total_size, remote_path);
+        if (!source.empty()) {
+            const uint64_t block_size = file::FileManager::compute_optimal_block_size(total_size);
+            auto local_hashes = file::FileManager::compute_block_hashes(local_path, block_size, [&]() {
+                return cancel_requested_.load();
+            });
+            std::vector<protocol::BlockCopyRange> ranges;
+            ranges.reserve(local_hashes.size());
+            for (const auto& block : local_hashes) {
+                uint64_t length = (std::min)(block_size, total_size - block.offset);
+                ranges.push_back({block.offset, block.offset, length, block.hash});
+            }
+            auto copied = request_block_copy(source, ranges);
+            if (!copied.empty()) {
+                blocks_copied = true;
+                pending = missing_ranges(copied, total_size);
+                uint64_t reused = 0;
+                for (const auto& range : copied) {
+                    reused += range.second;
+                }
+                LOG_INFO("Reused " + std::to_string(reused) + " bytes of " + source + " for " + remote_path);
+            }
+        }
+    }
+    uint64_t pending_bytes = 0;
+    for (const auto& range : pending) {
+        pending_bytes += range.second;
+    }
+
+    uint32_t stream_count = choose_parallel_stream_count(pending_bytes);
     
     // Initialize BufferPool for memory reuse across all streams
     buffer_pool_ = std::make_shared<BufferPool>(negotiated_max_chunk_size_, stream_count * 4);
@@ -1042,18 +1445,29 @@ void Client::transfer_single_file(const std::string& local_path, const std::stri
             config_.internal.chunk_size_decrease_factor,
             0.3);
     };
-    if (stream_count <= 1 || total_size == resume_offset) {
+    if (!journal_ranges && !blocks_copied && !(share_ranges_ && pending_bytes > 0) &&
+        (stream_count <= 1 || total_size == resume_offset)) {
         send_file_data(local_path, resume_offset, total_size);
         if (total_size == resume_offset && progress_callback_) {
             progress_callback_(total_size, total_size, local_path);
         }
+        remember_upload(remote_path, total_size);
         return;
     }
 
-    uint64_t total_to_transfer = total_size - resume_offset;
-    uint64_t partition_size = (total_to_transfer + stream_count - 1) / stream_count;
+    // Both ends hash the streams' chunks into a Merkle tree as they pass, so
+    // verification does not have to re-read the whole file
+    if (negotiated_merkle_leaf_size_ > 0 && total_size > 0) {
+        upload_tree_ = std::make_shared<crypto::MerkleTree>(total_size, negotiated_merkle_leaf_size_);
+    }
+    const std::vector<ByteRanges> plan = partition_ranges(pending, stream_count,
+                                                          upload_tree_ ? upload_tree_->leaf_size() : 1);
+    if (journal_ranges) {
+        LOG_INFO("Resuming " + local_path + ": " + std::to_string(pending_bytes) + " bytes missing in " +
+                 std::to_string(pending.size()) + " ranges, " + std::to_string(stream_count) + " streams");
+    }
 
-    std::atomic<uint64_t> transferred(resume_offset);
+    std::atomic<uint64_t> transferred(total_size - pending_bytes);
     std::exception_ptr first_error;
     std::mutex error_mutex;
     std::mutex progress_mutex;
@@ -1074,15 +1488,52 @@ void Client::transfer_single_file(const std::string& local_path, const std::stri
         }
     };
 
+    // The main connection's share goes into a piece queue that idle
+    // directory workers can draw from as well
+    std::shared_ptr<SharedUpload> shared;
+    Client* root = parent_client_ ? parent_client_ : this;
+    if (share_ranges_) {
+        shared = std::make_shared<SharedUpload>();
+        shared->local_path = local_path;
+        shared->remote_path = remote_path;
+        shared->total_size = total_size;
+        shared->tree = upload_tree_;
+        shared->progress = progress_callback_lambda;
+        for (const auto& range : split_ranges(plan[0], kSharedPieceSize, upload_tree_ ? upload_tree_->leaf_size() : 1)) {
+            shared->pieces.push_back({range.first, range.second, 0});
+        }
+        std::lock_guard<std::mutex> lock(root->shared_uploads_mutex_);
+        root->shared_uploads_.push_back(shared);
+    }
+    struct SharedUploadGuard {
+        Client* root;
+        std::shared_ptr<SharedUpload> upload;
+        void release() {
+            if (!upload) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(root->shared_uploads_mutex_);
+                auto& list = root->shared_uploads_;
+                list.erase(std::remove(list.begin(), list.end(), upload), list.end());
+            }
+            upload->close();
+            upload.reset();
+        }
+        ~SharedUploadGuard() { release(); }
+    } shared_guard{root, shared};
+
     auto worker_body = [&](uint32_t stream_index) {
         try {
             Client stream_client;
             stream_client.set_config(config_);
-            stream_client.set_security_level(security_level_);
+            stream_client.set_security_level(negotiated_security_level_);
             stream_client.set_requested_parallel_streams(1);
             stream_client.set_buffer_pool(buffer_pool_); // Propagate buffer pool
+            stream_client.set_upload_tree(upload_tree_);
             stream_client.bandwidth_limiter_ = bandwidth_limiter_;
             stream_client.parent_client_ = this;
+            stream_client.path_selector_ = path_selector_;
             
             {
                 std::lock_guard<std::mutex> lock(workers_mutex_);
@@ -1111,17 +1562,42 @@ void Client::transfer_single_file(const std::string& local_path, const std::stri
             uint64_t worker_resume_offset = 0;
             stream_client.send_file_request(local_path, remote_path, false, false, worker_resume_offset);
 
-            uint64_t start = resume_offset + stream_index * partition_size;
-            if (start < total_size) {
-                uint64_t end = (std::min)(start + partition_size, total_size);
-                stream_client.send_file_range(local_path,
-                                               start,
-                                               end,
-                                               total_size,
-                                               worker_chunk_manager,
-                                               transfer_monitor,
-                                               progress_callback_lambda,
-                                               false);
+            for (const auto& range : plan[stream_index]) {
+                if (cancel_requested_) {
+                    break;
+                }
+                // A range cut off by a failed path is sent again from its
+                // start over another one; bytes already counted once are
+                // not counted again
+                uint64_t counted = 0;
+                while (true) {
+                    uint64_t repeated = counted;
+                    auto range_progress = [&](uint64_t delta) {
+                        uint64_t again = (std::min)(delta, repeated);
+                        repeated -= again;
+                        counted += delta - again;
+                        if (delta > again) {
+                            progress_callback_lambda(delta - again);
+                        }
+                    };
+                    try {
+                        stream_client.send_file_range(local_path,
+                                                       range.first,
+                                                       range.first + range.second,
+                                                       total_size,
+                                                       worker_chunk_manager,
+                                                       transfer_monitor,
+                                                       range_progress,
+                                                       false);
+                    } catch (const NetworkException& e) {
+                        if (cancel_requested_ || !stream_client.fail_over(e.what())) {
+                            throw;
+                        }
+                        stream_client.send_file_request(local_path, remote_path, false, false, worker_resume_offset);
+                        continue;
+                    }
+                    break;
+                }
             }
         } catch (...) {
             record_error(std::current_exception());
@@ -1145,21 +1621,38 @@ void Client::transfer_single_file(const std::string& local_path, const std::stri
 
     try {
         common::ChunkSizeManager main_chunk_manager = make_chunk_manager();
-        uint64_t start = resume_offset;
-        if (start < total_size) {
-            uint64_t end = (std::min)(start + partition_size, total_size);
-            send_file_range(local_path,
-                            start,
-                            end,
-                            total_size,
-                            main_chunk_manager,
-                            transfer_monitor,
-                            progress_callback_lambda,
-                            false);
+        if (shared) {
+            SharedUpload::Piece piece;
+            while (!cancel_requested_ && shared->take(piece, true)) {
+                try {
+                    send_file_range(local_path, piece.offset, piece.offset + piece.length, total_size,
+                                    main_chunk_manager, shared->monitor, shared->piece_progress(piece), false);
+                } catch (...) {
+                    shared->finish(piece, false);
+                    throw;
+                }
+                shared->finish(piece, true);
+            }
+        } else {
+            for (const auto& range : plan[0]) {
+                if (cancel_requested_) {
+                    break;
+                }
+                send_file_range(local_path,
+                                range.first,
+                                range.first + range.second,
+                                total_size,
+                                main_chunk_manager,
+                                transfer_monitor,
+                                progress_callback_lambda,
+                                false);
+            }
         }
     } catch (...) {
         record_error(std::current_exception());
     }
+    // Helpers report through this frame's progress counter
+    shared_guard.release();
 
     for (auto& worker : workers) {
         if (worker.joinable()) {
@@ -1194,7 +1687,10 @@ void Client::transfer_single_file(const std::string& local_path, const std::stri
     }
     
     // E2E Integrity check
-    if (total_size > 0) {
+    if (total_size > 0 && upload_tree_) {
+        verify_upload_tree(local_path, remote_path, total_size);
+        upload_tree_.reset();
+    } else if (total_size > 0) {
         LOG_INFO("Performing E2E integrity check for: " + local_path);
         auto local_hash = file::FileManager::compute_file_hash(local_path, [&]() {
             return cancel_requested_.load();
@@ -1216,8 +1712,239 @@ void Client::transfer_single_file(const std::string& local_path, const std::stri
             throw FileException("Integrity verification failed for " + local_path + ": " + verify_resp->error_message);
         }
         
-        LOG_INFO("E2E Integrity verification succeeded for: " + local_path);
+        LOG_INFO("E2E Integrity verification succeeded for: " + local_path +
+                 (verify_resp->durable ? " (committed to stable storage)" : ""));
+    }
+    remember_upload(remote_path, total_size);
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> Client::request_block_copy(const std::string& source_path,
+                                                                      const std::vector<protocol::BlockCopyRange>& ranges) {
+    constexpr size_t kMaxRangesPerRequest = 16384;
+    std::vector<std::pair<uint64_t, uint64_t>> copied;
+    uint64_t bytes_copied = 0;
+    for (size_t start = 0; start < ranges.size(); start += kMaxRangesPerRequest) {
+        protocol::BlockCopyRequest request;
+        request.source_path = source_path;
+        request.ranges.assign(ranges.begin() + start,
+                              ranges.begin() + (std::min)(ranges.size(), start + kMaxRangesPerRequest));
+        send_message(request);
+
+        auto response_msg = receive_message();
+        auto response = dynamic_cast<protocol::BlockCopyResponse*>(response_msg.get());
+        if (!response) {
+            throw ProtocolException("Expected BlockCopyResponse");
+        }
+        if (!response->success) {
+            // Not fatal: the ranges are simply sent instead
+            LOG_WARNING("Server-side block copy from " + source_path + " failed: " + response->error_message);
+            break;
+        }
+        for (size_t i = 0; i < request.ranges.size() && i < response->copied.size(); ++i) {
+            if (response->copied[i]) {
+                copied.emplace_back(request.ranges[i].target_offset, request.ranges[i].length);
+            }
+        }
+        bytes_copied += response->bytes_copied;
+    }
+    if (bytes_copied > 0) {
+        LOG_DEBUG("Server copied " + std::to_string(bytes_copied) + " bytes from " + source_path);
+    }
+    return copied;
+}
+
+bool Client::help_shared_upload() {
+    Client* root = parent_client_ ? parent_client_ : this;
+    std::shared_ptr<SharedUpload> upload;
+    {
+        std::lock_guard<std::mutex> lock(root->shared_uploads_mutex_);
+        for (const auto& candidate : root->shared_uploads_) {
+            if (candidate->join()) {
+                upload = candidate;
+                break;
+            }
+        }
+    }
+    if (!upload) {
+        return false;
+    }
+    struct Leave {
+        SharedUpload& upload;
+        ~Leave() { upload.leave(); }
+    } leave{*upload};
+
+    uint64_t resume_offset = 0;
+    upload_tree_ = upload->tree;
+    send_file_request(upload->local_path, upload->remote_path, false, false, resume_offset);
+    common::ChunkSizeManager chunk_manager(config_.internal.initial_chunk_size,
+                                           config_.internal.min_chunk_size,
+                                           negotiated_max_chunk_size_,
+                                           config_.internal.chunk_size_increase_factor,
+                                           config_.internal.chunk_size_decrease_factor,
+                                           0.3);
+    SharedUpload::Piece piece;
+    while (!cancel_requested_ && upload->take(piece, false)) {
+        try {
+            send_file_range(upload->local_path, piece.offset, piece.offset + piece.length, upload->total_size,
+                            chunk_manager, upload->monitor, upload->piece_progress(piece), false);
+        } catch (...) {
+            upload->finish(piece, false);
+            upload_tree_.reset();
+            throw;
+        }
+        upload->finish(piece, true);
+    }
+    upload_tree_.reset();
+    return true;
+}
+
+void Client::remember_upload(const std::string& remote_path, uint64_t size) {
+    if (!negotiated_block_copy_ || size < config::defaults::kMinBlockCopyFileSize) {
+        return;
+    }
+    Client* root = parent_client_ ? parent_client_ : this;
+    std::lock_guard<std::mutex> lock(root->uploaded_files_mutex_);
+    root->uploaded_files_[size] = remote_path;
+}
+
+std::string Client::find_upload_of_size(uint64_t size, const std::string& exclude_path) {
+    Client* root = parent_client_ ? parent_client_ : this;
+    std::lock_guard<std::mutex> lock(root->uploaded_files_mutex_);
+    auto it = root->uploaded_files_.find(size);
+    if (it == root->uploaded_files_.end() || it->second == exclude_path) {
+        return {};
     }
+    return it->second;
+}
+
+void Client::verify_upload_tree(const std::string& local_path, const std::string& remote_path, uint64_t total_size) {
+    constexpr int kMaxRepairRounds = 2;
+    LOG_INFO("Performing Merkle E2E integrity check for: " + local_path);
+
+    // Leaves split between streams, or skipped on resume, are hashed here
+    uint64_t pending = upload_tree_->pending_leaves();
+    if (pending > 0) {
+        file::FileStream reader;
+        if (!reader.open_read(local_path, file::FileAccessPattern::Sequential)) {
+            throw FileException("Failed to open file for hashing: " + local_path);
+        }
+        bool complete = upload_tree_->finish([&](uint64_t offset, uint8_t* out, size_t length) -> size_t {
+            return cancel_requested_ ? 0 : reader.read(offset, out, length);
+        });
+        if (!complete) {
+            throw FileException(cancel_requested_ ? "Hashing cancelled" : "Source file shrank during transfer: " + local_path);
+        }
+    }
+    const std::vector<uint8_t> root = upload_tree_->root();
+
+    for (int round = 0;; ++round) {
+        protocol::FileVerifyRequest verify_req;
+        verify_req.file_path = remote_path;
+        verify_req.merkle_root = root;
+        send_message(verify_req);
+
+        auto verify_resp_msg = receive_message();
+        auto verify_resp = dynamic_cast<protocol::FileVerifyResponse*>(verify_resp_msg.get());
+        if (!verify_resp) {
+            throw ProtocolException("Expected FileVerifyResponse");
+        }
+        if (verify_resp->success) {
+            LOG_INFO("E2E Integrity verification succeeded for: " + local_path +
+                     (verify_resp->durable ? " (committed to stable storage)" : ""));
+            return;
+        }
+        // No root means the server could not hash the file at all
+        if (verify_resp->merkle_root.empty() || round == kMaxRepairRounds) {
+            throw FileException("Integrity verification failed for " + local_path + ": " + verify_resp->error_message);
+        }
+
+        std::vector<uint64_t> leaves = find_mismatched_leaves(remote_path);
+        if (leaves.empty()) {
+            throw FileException("Integrity verification failed for " + local_path + ": Merkle roots differ but no leaf does");
+        }
+        LOG_WARNING("Merkle root mismatch for " + local_path + ", resending " + std::to_string(leaves.size()) + " of " +
+                    std::to_string(upload_tree_->leaf_count()) + " leaves");
+
+        // Resend only the damaged leaves, merging neighbours into one range
+        ByteRanges repairs;
+        for (uint64_t leaf : leaves) {
+            auto range = upload_tree_->leaf_range(leaf);
+            if (!repairs.empty() && repairs.back().first + repairs.back().second == range.first) {
+                repairs.back().second += range.second;
+            } else {
+                repairs.push_back(range);
+            }
+        }
+        common::ChunkSizeManager repair_chunk_manager(
+            config_.internal.initial_chunk_size,
+            config_.internal.min_chunk_size,
+            negotiated_max_chunk_size_,
+            config_.internal.chunk_size_increase_factor,
+            config_.internal.chunk_size_decrease_factor,
+            0.3);
+        common::BandwidthMonitor repair_monitor;
+        for (const auto& range : repairs) {
+            send_file_range(local_path, range.first, range.first + range.second, total_size,
+                            repair_chunk_manager, repair_monitor, [](uint64_t) {}, false);
+        }
+
+        // Finalize again so the server re-applies size and timestamps
+        protocol::FileData final_msg;
+        final_msg.offset = total_size;
+        final_msg.uncompressed_size = 0;
+        final_msg.is_last_chunk = true;
+        final_msg.compressed = false;
+        send_message(final_msg);
+        auto ack_msg = receive_message();
+        auto ack = dynamic_cast<protocol::FileAck*>(ack_msg.get());
+        if (!ack || !ack->success) {
+            throw FileException("Transfer finalization failed: " + (ack ? ack->error_message : "No acknowledgment"));
+        }
+    }
+}
+
+std::vector<uint64_t> Client::find_mismatched_leaves(const std::string& remote_path) {
+    // Walk down from the root, only expanding nodes whose hashes differ
+    uint32_t level = upload_tree_->depth() - 1;
+    std::vector<uint64_t> mismatched{0};
+    while (level > 0 && !mismatched.empty()) {
+        --level;
+        const uint64_t width = upload_tree_->level_width(level);
+        std::vector<uint64_t> children;
+        children.reserve(mismatched.size() * 2);
+        for (uint64_t parent : mismatched) {
+            for (uint64_t child = parent * 2; child < parent * 2 + 2 && child < width; ++child) {
+                children.push_back(child);
+            }
+        }
+
+        protocol::MerkleNodesRequest nodes_req;
+        nodes_req.file_path = remote_path;
+        nodes_req.level = level;
+        nodes_req.indices = children;
+        send_message(nodes_req);
+
+        auto nodes_resp_msg = receive_message();
+        auto nodes_resp = dynamic_cast<protocol::MerkleNodesResponse*>(nodes_resp_msg.get());
+        if (!nodes_resp) {
+            throw ProtocolException("Expected MerkleNodesResponse");
+        }
+        if (!nodes_resp->success) {
+            throw FileException("Failed to get remote Merkle nodes: " + nodes_resp->error_message);
+        }
+        if (nodes_resp->hashes.size() != children.size()) {
+            throw ProtocolException("MerkleNodesResponse does not match the request");
+        }
+
+        auto local = upload_tree_->nodes(level, children);
+        mismatched.clear();
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (local[i] != nodes_resp->hashes[i]) {
+                mismatched.push_back(children[i]);
+            }
+        }
+    }
+    return mismatched;
 }
 
 void Client::send_file_request(const std::string& local_path,
@@ -1225,7 +1952,8 @@ void Client::send_file_request(const std::string& local_path,
                                bool resume,
                                bool truncate_destination,
                                uint64_t& resume_offset,
-                               uint64_t* remote_file_size) {
+                               uint64_t* remote_file_size,
+                               std::optional<std::vector<std::pair<uint64_t, uint64_t>>>* completed_ranges) {
     protocol::FileRequest request;
     request.source_path = common::convert_to_unix_path(local_path);
     request.destination_path = common::convert_to_unix_path(remote_path);
@@ -1241,6 +1969,16 @@ void Client::send_file_request(const std::string& local_path,
         request.symlink_target = file::FileManager::read_symlink(local_path);
     }
     request.file_size = request.is_symlink ? 0 : file::FileManager::file_size(local_path);
+    // The tree only pays off when the file may be split over streams; a
+    // single stream is verified with the hash the server keeps in passing.
+    // Helpers of a split upload already hold the owner's tree and must ask
+    // for it too, or the server would drop it.
+    const bool may_split = upload_tree_ || share_ranges_ || choose_parallel_stream_count(request.file_size) > 1;
+    if (config_.internal.streaming_verification && request.file_size > 0 && may_split) {
+        request.merkle_leaf_size = upload_tree_ ? upload_tree_->leaf_size() : crypto::MerkleTree::kDefaultLeafSize;
+    }
+    request.sparse = config_.internal.sparse_files && !request.is_symlink && request.file_size > 0 &&
+                     file::FileManager::is_sparse(local_path);
     
     send_message(request);
 
@@ -1259,9 +1997,19 @@ void Client::send_file_request(const std::string& local_path,
     }
 
     resume_offset = resume ? response->resume_offset : 0;
+    negotiated_merkle_leaf_size_ = response->merkle_leaf_size;
+    negotiated_sparse_ = request.sparse && response->sparse;
+    negotiated_block_copy_ = config_.internal.block_copy && response->block_copy;
     if (remote_file_size) {
         *remote_file_size = response->file_size;
     }
+    if (completed_ranges) {
+        if (resume && response->has_range_journal) {
+            *completed_ranges = response->completed_ranges;
+        } else {
+            completed_ranges->reset();
+        }
+    }
 }
 
 void Client::send_file_data(const std::string& file_path, uint64_t resume_offset, uint64_t total_size) {
@@ -1284,9 +2032,13 @@ void Client::send_file_data(const std::string& file_path, uint64_t resume_offset
         return;
     }
 
+    // Count acknowledged deltas rather than monitored bytes: holes of a
+    // sparse file are acknowledged without passing through the monitor
+    uint64_t acknowledged = resume_offset;
     send_file_range(file_path, resume_offset, total_size, total_size, chunk_size_manager_, bandwidth_monitor_, [&](uint64_t delta) {
+        acknowledged += delta;
         if (progress_callback_) {
-            progress_callback_(resume_offset + bandwidth_monitor_.get_total_bytes(), total_size, file_path);
+            progress_callback_(acknowledged, total_size, file_path);
         }
     }, true);
 }
@@ -1315,7 +2067,16 @@ void Client::send_file_range(const std::string& file_path,
     std::atomic<uint64_t> last_acknowledged_offset(start_offset);
     std::atomic<uint64_t> in_flight_bytes(0);
     
-    std::map<uint64_t, size_t> in_flight_chunks;
+    // Unacknowledged chunks by offset. Holes advance the acknowledged offset
+    // but take no room in the window.
+    struct InFlightChunk {
+        uint64_t length;
+        bool hole;
+    };
+    std::map<uint64_t, InFlightChunk> in_flight_chunks;
+    // Send timestamps of sampled chunks, for the tracer's ACK stage
+    std::map<uint64_t, std::chrono::steady_clock::time_point> traced_send_times;
+    auto& tracer = common::ChunkTracer::instance();
     
     // Flow-control window: keep up to 64 MB in flight to allow pipelining.
     // The chunk size is capped to at most half this value so the wait
@@ -1361,17 +2122,28 @@ void Client::send_file_range(const std::string& file_path,
                     
                     std::lock_guard<std::mutex> lock(ack_mutex);
                     auto it = in_flight_chunks.begin();
-                    while (it != in_flight_chunks.end() && it->first + it->second <= bytes_received) {
+                    while (it != in_flight_chunks.end() && it->first + it->second.length <= bytes_received) {
                         uint64_t chunk_offset = it->first;
-                        size_t chunk_size = it->second;
+                        uint64_t chunk_size = it->second.length;
+                        
+                        if (!traced_send_times.empty()) {
+                            auto sent = traced_send_times.find(chunk_offset);
+                            if (sent != traced_send_times.end()) {
+                                tracer.record(common::TraceStage::Ack, chunk_offset, chunk_size,
+                                              sent->second, std::chrono::steady_clock::now());
+                                traced_send_times.erase(sent);
+                            }
+                        }
                         
-                        shared_bandwidth_monitor.record_bytes(chunk_size);
-                        shared_chunk_manager.update_chunk_size(shared_bandwidth_monitor, true, chunk_size);
+                        if (!it->second.hole) {
+                            shared_bandwidth_monitor.record_bytes(chunk_size);
+                            shared_chunk_manager.update_chunk_size(shared_bandwidth_monitor, true, chunk_size);
+                            in_flight_bytes.fetch_sub(chunk_size);
+                        }
                         
                         progress_delta += chunk_size;
                         
                         last_acknowledged_offset = chunk_offset + chunk_size;
-                        in_flight_bytes.fetch_sub(chunk_size);
                         
                         it = in_flight_chunks.erase(it);
                     }
@@ -1406,6 +2178,15 @@ void Client::send_file_range(const std::string& file_path,
                     throw FileException("Failed to open source file for reading: " + file_path);
                 }
                 
+                // Holes of a sparse source are skipped, not read. A stream
+                // hash needs every byte, so it keeps the plain path.
+                std::vector<std::pair<uint64_t, uint64_t>> extents;
+                const bool skip_holes = negotiated_sparse_ && !stream_hasher;
+                if (skip_holes) {
+                    extents = file_stream.data_extents(start_offset, end_offset);
+                }
+                size_t extent_index = 0;
+                
                 uint64_t current_read_offset = start_offset;
                 while (current_read_offset < end_offset && !cancel_requested_ && !ack_thread_failed.load()) {
                     while (is_file_paused(file_path) && !is_file_skipped(file_path) && !cancel_requested_ && !ack_thread_failed.load()) {
@@ -1414,16 +2195,41 @@ void Client::send_file_range(const std::string& file_path,
                     if (is_file_skipped(file_path)) {
                         throw FileSkippedException("File skip requested by client: " + file_path);
                     }
+                    uint64_t data_end = end_offset;
+                    if (skip_holes) {
+                        while (extent_index < extents.size() &&
+                               extents[extent_index].first + extents[extent_index].second <= current_read_offset) {
+                            ++extent_index;
+                        }
+                        uint64_t hole_end = extent_index < extents.size() ? extents[extent_index].first : end_offset;
+                        if (current_read_offset < hole_end) {
+                            ReadAheadChunk hole;
+                            hole.offset = current_read_offset;
+                            hole.hole_length = hole_end - current_read_offset;
+                            hole.is_last = is_final_range && hole_end >= end_offset;
+                            read_queue.push(std::move(hole));
+                            current_read_offset = hole_end;
+                            continue;
+                        }
+                        data_end = extents[extent_index].first + extents[extent_index].second;
+                    }
                     size_t chunk_size = shared_chunk_manager.get_optimal_chunk_size(shared_bandwidth_monitor);
                     // Cap chunk size so it always fits inside the flow-control window;
                     // without this cap the window condition can never become true → deadlock.
                     chunk_size = (std::min)(chunk_size, max_chunk_for_window);
-                    chunk_size = static_cast<size_t>((std::min)(static_cast<uint64_t>(chunk_size), end_offset - current_read_offset));
+                    if (size_t admitted = admitted_chunk_size_.load()) {
+                        chunk_size = (std::min)(chunk_size, admitted);
+                    }
+                    chunk_size = static_cast<size_t>((std::min)(static_cast<uint64_t>(chunk_size), data_end - current_read_offset));
                     
                     auto buffer = buffer_pool_->acquire();
                     buffer->resize(chunk_size);
                     
-                    size_t bytes_read = file_stream.read(current_read_offset, buffer->data(), chunk_size);
+                    size_t bytes_read = 0;
+                    {
+                        common::TraceScope trace(common::TraceStage::Read, current_read_offset, chunk_size);
+                        bytes_read = file_stream.read(current_read_offset, buffer->data(), chunk_size);
+                    }
                     if (bytes_read == 0) {
                         buffer_pool_->release(std::move(buffer));
                         throw FileException("Unexpected end of source file during read-ahead");
@@ -1483,9 +2289,13 @@ void Client::send_file_range(const std::string& file_path,
                 throw FileException("ACK thread failed: " + ack_thread_error);
             }
 
+            // Window bytes of a chunk; holes carry none
+            auto payload_bytes = [](const ReadAheadChunk& chunk) -> uint64_t {
+                return chunk.data ? chunk.data->size() : 0;
+            };
             std::vector<ReadAheadChunk> batch;
             batch.push_back(std::move(current_chunk));
-            uint64_t batch_uncompressed_bytes = batch.front().data->size();
+            uint64_t batch_uncompressed_bytes = payload_bytes(batch.front());
             bool batch_has_last = batch.front().is_last;
 
             while (batch.size() < max_batch_chunks &&
@@ -1495,7 +2305,7 @@ void Client::send_file_range(const std::string& file_path,
                 if (!read_queue.try_pop(next_chunk)) {
                     break;
                 }
-                batch_uncompressed_bytes += next_chunk.data->size();
+                batch_uncompressed_bytes += payload_bytes(next_chunk);
                 batch_has_last = next_chunk.is_last;
                 batch.push_back(std::move(next_chunk));
             }
@@ -1503,7 +2313,13 @@ void Client::send_file_range(const std::string& file_path,
             // Flow Control: block if in-flight bytes exceed window
             std::unique_lock<std::mutex> lock(ack_mutex);
             ack_cv.wait(lock, [&]() {
-                return in_flight_bytes.load() + batch_uncompressed_bytes <= max_window_bytes.load() ||
+                uint64_t window = max_window_bytes.load();
+                if (uint64_t admitted = admitted_window_bytes_.load()) {
+                    window = (std::min)(window, admitted);
+                }
+                // A window smaller than one batch still lets a batch through alone
+                return in_flight_bytes.load() == 0 ||
+                       in_flight_bytes.load() + batch_uncompressed_bytes <= window ||
                        cancel_requested_ || 
                        ack_thread_failed.load();
             });
@@ -1520,15 +2336,42 @@ void Client::send_file_range(const std::string& file_path,
             size_t throttled_bytes = 0;
 
             auto append_payload = [&](ReadAheadChunk& chunk, protocol::FileData::Chunk* out_chunk) {
+                if (chunk.hole_length > 0) {
+                    if (upload_tree_) {
+                        upload_tree_->update_zeros(chunk.offset, chunk.hole_length);
+                    }
+                    if (out_chunk) {
+                        out_chunk->offset = chunk.offset;
+                        out_chunk->uncompressed_size = chunk.hole_length;
+                        out_chunk->compressed = false;
+                        out_chunk->hole = true;
+                        out_chunk->is_last_chunk = chunk.is_last;
+                    } else {
+                        data_msg.offset = chunk.offset;
+                        data_msg.uncompressed_size = chunk.hole_length;
+                        data_msg.compressed = false;
+                        data_msg.hole = true;
+                        data_msg.is_last_chunk = chunk.is_last;
+                    }
+                    in_flight_chunks[chunk.offset] = {chunk.hole_length, true};
+                    batch_last_end = chunk.offset + chunk.hole_length;
+                    return;
+                }
                 const size_t original_size = chunk.data->size();
                 std::vector<uint8_t> payload;
                 bool compressed_payload = false;
 
                 if (stream_hasher && original_size > 0) {
+                    common::TraceScope trace(common::TraceStage::Hash, chunk.offset, original_size);
                     stream_hasher->update(chunk.data->data(), original_size);
                 }
+                if (upload_tree_ && original_size > 0) {
+                    common::TraceScope trace(common::TraceStage::Hash, chunk.offset, original_size);
+                    upload_tree_->update(chunk.offset, chunk.data->data(), original_size);
+                }
 
                 if (compress) {
+                    common::TraceScope trace(common::TraceStage::Compress, chunk.offset, original_size);
                     auto compressed_data = common::compress_buffer(chunk.data->data(), original_size);
                     if (compressed_data.size() < original_size &&
                         compressed_data.size() <= negotiated_max_chunk_size_) {
@@ -1556,8 +2399,11 @@ void Client::send_file_range(const std::string& file_path,
                     data_msg.is_last_chunk = chunk.is_last;
                 }
 
-                in_flight_chunks[chunk.offset] = original_size;
+                in_flight_chunks[chunk.offset] = {original_size, false};
                 in_flight_bytes.fetch_add(original_size);
+                if (tracer.enabled() && tracer.should_sample(chunk.offset)) {
+                    traced_send_times[chunk.offset] = std::chrono::steady_clock::now();
+                }
                 batch_last_end = chunk.offset + original_size;
                 throttled_bytes += original_size;
                 buffer_pool_->release(std::move(chunk.data));
@@ -1576,7 +2422,11 @@ void Client::send_file_range(const std::string& file_path,
             
             lock.unlock(); // Release lock before sending message
             
-            send_message(data_msg);
+            {
+                // Encrypt/send are message-level; attribute them to the batch's first chunk
+                common::TraceChunkContext trace_chunk(batch.front().offset, throttled_bytes);
+                send_message(data_msg);
+            }
             bytes_sent = batch_last_end;
             
             if (bandwidth_limiter_) {
@@ -1587,7 +2437,7 @@ void Client::send_file_range(const std::string& file_path,
         // Wait for all in-flight packets to be acknowledged
         std::unique_lock<std::mutex> lock(ack_mutex);
         ack_cv.wait(lock, [&]() {
-            return in_flight_bytes.load() == 0 || ack_thread_failed.load() || cancel_requested_.load();
+            return in_flight_chunks.empty() || ack_thread_failed.load() || cancel_requested_.load();
         });
 
         if (cancel_requested_) {
@@ -1644,6 +2494,10 @@ uint32_t Client::choose_parallel_stream_count(uint64_t transfer_size) const {
     }
 
     uint32_t streams = negotiated_parallel_streams_ == 0 ? 1 : negotiated_parallel_streams_;
+    const Client* root = parent_client_ ? parent_client_ : this;
+    if (uint32_t admitted = root->admitted_streams_.load()) {
+        streams = (std::min)(streams, admitted);
+    }
     if (transfer_size < 1024ull * 1024ull * 1024ull) {
         streams = (std::min)(streams, 2u);
     }
@@ -1771,6 +2625,26 @@ void Client::download_file(const std::string& remote_path, const std::string& lo
             bytes_received = std::filesystem::file_size(std::filesystem::u8path(local_path));
         }
         request.resume_offset = bytes_received;
+        request.accept_compression = true;
+        request.accept_sparse = config_.internal.sparse_files;
+
+        // Download delta: offer signatures of the existing local copy so the
+        // server only sends blocks that changed
+        if (!resume && config_.internal.download_delta_sync &&
+            file::FileManager::exists(local_path) && file::FileManager::is_regular_file(local_path) &&
+            !file::FileManager::is_symlink(local_path)) {
+            uint64_t local_size = file::FileManager::file_size(local_path);
+            if (local_size > 0) {
+                request.delta_block_size = file::FileManager::compute_optimal_block_size(local_size);
+                auto local_hashes = file::FileManager::compute_block_hashes(local_path, request.delta_block_size, [&]() {
+                    return cancel_requested_.load();
+                });
+                request.local_blocks.reserve(local_hashes.size());
+                for (auto& block : local_hashes) {
+                    request.local_blocks.push_back({block.offset, std::move(block.hash)});
+                }
+            }
+        }
 
         send_message(request);
 
@@ -1841,17 +2715,21 @@ void Client::download_file(const std::string& remote_path, const std::string& lo
             throw FileSkippedException("File skip requested by client");
         }
 
-        // Open local file
+        // Open local file; a delta download patches the existing copy in place
+        const bool delta = response->delta_applied;
         file::FileStream fs;
         file::FileAccessPattern write_pattern = config_.internal.cache_hints
             ? file::FileAccessPattern::Sequential
             : file::FileAccessPattern::Normal;
-        if (!fs.open_write(local_path, !resume, true, write_pattern)) {
+        if (!fs.open_write(local_path, !resume && !delta, true, write_pattern)) {
             throw FileException("Failed to open local file for writing: " + local_path);
         }
 
         total_bytes = response->file_size;
-        if (config_.internal.preallocate_files && !resume && total_bytes > 0) {
+        if (delta) {
+            LOG_INFO("Delta download of " + remote_path + ": receiving changed blocks only");
+        }
+        if (config_.internal.preallocate_files && !resume && !delta && !response->sparse && total_bytes > 0) {
             std::string prealloc_error;
             if (!file::FileManager::preallocate_file(local_path, total_bytes, true, false, &prealloc_error)) {
                 LOG_WARNING("Download preallocation skipped: " + prealloc_error);
@@ -1859,7 +2737,7 @@ void Client::download_file(const std::string& remote_path, const std::string& lo
         }
 
         crypto::Sha3Hasher download_hasher;
-        bool streaming_hash_valid = config_.internal.streaming_verification && !resume;
+        bool streaming_hash_valid = config_.internal.streaming_verification && !resume && !delta && !response->sparse;
 
         while (bytes_received < total_bytes) {
             while (is_file_paused(remote_path) && !is_file_skipped(remote_path) && !cancel_requested_) {
@@ -1883,15 +2761,16 @@ void Client::download_file(const std::string& remote_path, const std::string& lo
                 const std::vector<uint8_t>& data;
                 bool is_last_chunk;
                 bool compressed;
+                bool hole;
             };
 
             std::vector<TempChunk> chunks_to_process;
             if (!file_data->chunks.empty()) {
                 for (const auto& chunk : file_data->chunks) {
-                    chunks_to_process.push_back({chunk.offset, chunk.uncompressed_size, chunk.data, chunk.is_last_chunk, chunk.compressed});
+                    chunks_to_process.push_back({chunk.offset, chunk.uncompressed_size, chunk.data, chunk.is_last_chunk, chunk.compressed, chunk.hole});
                 }
             } else {
-                chunks_to_process.push_back({file_data->offset, file_data->uncompressed_size, file_data->data, file_data->is_last_chunk, file_data->compressed});
+                chunks_to_process.push_back({file_data->offset, file_data->uncompressed_size, file_data->data, file_data->is_last_chunk, file_data->compressed, file_data->hole});
             }
 
             bool saw_last_chunk = false;
@@ -1901,6 +2780,7 @@ void Client::download_file(const std::string& remote_path, const std::string& lo
                     const uint8_t* payload_ptr = nullptr;
                     size_t payload_size = 0;
                     if (chunk.compressed) {
+                        common::TraceScope trace(common::TraceStage::Decompress, chunk.offset, chunk.uncompressed_size);
                         decompressed_payload = common::decompress_buffer(chunk.data, static_cast<size_t>(chunk.uncompressed_size));
                         payload_ptr = decompressed_payload.data();
                         payload_size = decompressed_payload.size();
@@ -1909,15 +2789,27 @@ void Client::download_file(const std::string& remote_path, const std::string& lo
                         payload_size = chunk.data.size();
                     }
 
+                    if (chunk.hole) {
+                        common::TraceScope trace(common::TraceStage::Write, chunk.offset, chunk.uncompressed_size);
+                        fs.punch_hole(chunk.offset, chunk.uncompressed_size);
+                        bytes_received = (std::max)(bytes_received, chunk.offset + chunk.uncompressed_size);
+                        saw_last_chunk = saw_last_chunk || chunk.is_last_chunk;
+                        continue;
+                    }
+
                     if (streaming_hash_valid && payload_size > 0) {
                         if (chunk.offset == bytes_received) {
+                            common::TraceScope trace(common::TraceStage::Hash, chunk.offset, payload_size);
                             download_hasher.update(payload_ptr, payload_size);
                         } else {
                             streaming_hash_valid = false;
                         }
                     }
 
-                    fs.write(chunk.offset, payload_ptr, payload_size);
+                    {
+                        common::TraceScope trace(common::TraceStage::Write, chunk.offset, payload_size);
+                        fs.write(chunk.offset, payload_ptr, payload_size);
+                    }
                     uint64_t end_offset = chunk.offset + payload_size;
                     if (end_offset > bytes_received) {
                         bytes_received = end_offset;
@@ -1950,6 +2842,13 @@ void Client::download_file(const std::string& remote_path, const std::string& lo
             }
         }
         fs.close();
+        if (delta && file::FileManager::file_size(local_path) > total_bytes) {
+            std::error_code ec;
+            std::filesystem::resize_file(std::filesystem::u8path(local_path), total_bytes, ec);
+            if (ec) {
+                throw FileException("Failed to truncate " + local_path + ": " + ec.message());
+            }
+        }
         if (response->permissions != 0) {
             file::FileManager::set_permissions(local_path, response->permissions);
         }
@@ -1987,6 +2886,14 @@ void Client::download_file(const std::string& remote_path, const std::string& lo
 }
 
 std::vector<protocol::RemoteFileInfo> Client::list_remote_directory(const std::string& remote_path, bool recursive) {
+    std::vector<protocol::RemoteFileInfo> entries;
+    uint64_t version = 0;
+    list_remote_directory_if_changed(remote_path, recursive, entries, version);
+    return entries;
+}
+
+bool Client::list_remote_directory_if_changed(const std::string& remote_path, bool recursive,
+                                              std::vector<protocol::RemoteFileInfo>& entries, uint64_t& version) {
     if (!async_socket_) {
         throw NetworkException("Socket is not connected");
     }
@@ -1994,6 +2901,7 @@ std::vector<protocol::RemoteFileInfo> Client::list_remote_directory(const std::s
     protocol::ListRequest request;
     request.remote_path = remote_path;
     request.recursive = recursive;
+    request.known_version = version;
     send_message(request);
 
     auto response_msg = receive_message();
@@ -2006,7 +2914,12 @@ std::vector<protocol::RemoteFileInfo> Client::list_remote_directory(const std::s
         throw FileException("Listing failed: " + response->error_message);
     }
 
-    return response->entries;
+    if (response->not_modified && version != 0) {
+        return false;
+    }
+    entries = std::move(response->entries);
+    version = response->version;
+    return true;
 }
 
 void Client::download_directory(const std::string& remote_path, const std::string& local_path, bool recursive, bool resume) {
@@ -0,0 +1,362 @@
+#include "client/connection_pool.h"
+#include "common/bandwidth_limiter.h"
+#include "logging/logger.h"
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
+namespace netcopy {
+namespace client {
+
+namespace {
+
+constexpr std::chrono::seconds kKeepAliveInterval{15};
+constexpr std::chrono::seconds kRetryDelay{10};         // after a failed warm-up
+constexpr std::chrono::seconds kMaintenanceTick{5};
+constexpr size_t kMaxIdlePerProfile = 8;
+
+} // namespace
+
+std::string ConnectionProfile::key() const {
+    const auto& internal = config.internal;
+    // Credentials only enter the key as a hash
+    std::string secrets = internal.password + '\0' + internal.private_key_file + '\0' +
+                          internal.private_key_passphrase + '\0' + internal.secret_key;
+    std::ostringstream key;
+    key << host << ":" << port << "|" << internal.username << "|" << internal.auth_method << "|"
+        << static_cast<int>(security_level) << (auto_security_level ? "a" : "") << "|" << parallel_streams << "|"
+        << std::hash<std::string>{}(secrets);
+    return key.str();
+}
+
+ConnectionPool::Lease::Lease(ConnectionPool* pool, std::string key, uint64_t generation,
+                             std::unique_ptr<Client> client, bool reused)
+    : pool_(pool), key_(std::move(key)), generation_(generation), client_(std::move(client)), reused_(reused) {}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), key_(std::move(other.key_)), generation_(other.generation_),
+      client_(std::move(other.client_)), reused_(other.reused_) {
+    other.pool_ = nullptr;
+}
+
+ConnectionPool::Lease& ConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        key_ = std::move(other.key_);
+        generation_ = other.generation_;
+        client_ = std::move(other.client_);
+        reused_ = other.reused_;
+        other.pool_ = nullptr;
+    }
+    return *this;
+}
+
+ConnectionPool::Lease::~Lease() {
+    release();
+}
+
+void ConnectionPool::Lease::discard() {
+    if (client_) {
+        try {
+            client_->disconnect();
+        } catch (...) {}
+    }
+    release();
+}
+
+void ConnectionPool::Lease::release() {
+    if (pool_ && client_) {
+        pool_->give_back(key_, generation_, std::move(client_));
+    }
+    pool_ = nullptr;
+    client_.reset();
+}
+
+ConnectionPool::ConnectionPool(std::chrono::seconds idle_timeout) : idle_timeout_(idle_timeout) {
+    maintainer_ = std::thread([this]() { maintain(); });
+}
+
+ConnectionPool::~ConnectionPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (maintainer_.joinable()) {
+        maintainer_.join();
+    }
+    clear();
+}
+
+std::unique_ptr<Client> ConnectionPool::open(const ConnectionProfile& profile) {
+    auto client = std::make_unique<Client>();
+    client->set_config(profile.config);
+    client->set_security_level(profile.security_level);
+    client->set_auto_security_level(profile.auto_security_level);
+    if (profile.parallel_streams != 0) {
+        client->set_requested_parallel_streams(profile.parallel_streams);
+    }
+    client->connect(profile.host, profile.port);
+    return client;
+}
+
+void ConnectionPool::close(std::vector<std::unique_ptr<Client>>& clients) {
+    for (auto& client : clients) {
+        if (client) {
+            try {
+                client->disconnect();
+            } catch (...) {}
+        }
+    }
+    clients.clear();
+}
+
+bool ConnectionPool::is_alive(Client& client) {
+    if (!client.is_connected()) {
+        return false;
+    }
+    try {
+        // An empty session id is answered without touching any session
+        client.query_transfer_status("");
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+ConnectionPool::Lease ConnectionPool::acquire(const ConnectionProfile& profile) {
+    const std::string key = profile.key();
+    std::vector<std::unique_ptr<Client>> stale;
+    std::unique_ptr<Client> client;
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot& slot = slots_[key];
+        slot.profile = profile;
+        // Most recently used first: it is the least likely to have gone stale
+        while (!client && !slot.idle.empty()) {
+            auto idle = std::move(slot.idle.back());
+            slot.idle.pop_back();
+            if (idle.client->is_connected()) {
+                client = std::move(idle.client);
+            } else {
+                stale.push_back(std::move(idle.client));
+            }
+        }
+        ++slot.busy;
+        generation = generation_;
+    }
+    close(stale);
+    if (client) {
+        return Lease(this, key, generation, std::move(client), true);
+    }
+
+    try {
+        client = open(profile);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = slots_.find(key);
+        if (it != slots_.end() && generation == generation_) {
+            --it->second.busy;
+        }
+        throw;
+    }
+    return Lease(this, key, generation, std::move(client), false);
+}
+
+ConnectionPool::Lease ConnectionPool::acquire_fresh(const ConnectionProfile& profile) {
+    const std::string key = profile.key();
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot& slot = slots_[key];
+        slot.profile = profile;
+        ++slot.busy;
+        generation = generation_;
+    }
+    try {
+        return Lease(this, key, generation, open(profile), false);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = slots_.find(key);
+        if (it != slots_.end() && generation == generation_) {
+            --it->second.busy;
+        }
+        throw;
+    }
+}
+
+ConnectionPool::Lease ConnectionPool::acquire_verified(const ConnectionProfile& profile) {
+    Lease lease = acquire(profile);
+    if (lease.reused() && !is_alive(*lease)) {
+        lease.discard();
+        lease = acquire_fresh(profile);
+    }
+    return lease;
+}
+
+void ConnectionPool::give_back(const std::string& key, uint64_t generation, std::unique_ptr<Client> client) {
+    // A cancelled connection may have a reply in flight; never reuse it
+    const bool reusable = client->is_connected() && !client->cancel_requested_;
+    if (reusable) {
+        client->set_progress_callback(nullptr);
+        client->set_overwrite_callback(nullptr);
+        client->set_file_list_callback(nullptr);
+        client->set_parent_client(nullptr);
+    }
+
+    std::vector<std::unique_ptr<Client>> stale;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = slots_.find(key);
+        const bool current = it != slots_.end() && generation == generation_;
+        if (current) {
+            --it->second.busy;
+        }
+        if (reusable && current && it->second.idle.size() < kMaxIdlePerProfile) {
+            // Workers share their transfer's limiter; give the connection its own again
+            client->bandwidth_limiter_ = std::make_shared<common::BandwidthLimiter>();
+            client->bandwidth_limiter_->set_limit_percent(it->second.profile.config.max_bandwidth_percent);
+            it->second.idle.push_back({std::move(client), std::chrono::steady_clock::now()});
+        } else {
+            stale.push_back(std::move(client));
+        }
+    }
+    close(stale);
+}
+
+void ConnectionPool::keep_warm(const ConnectionProfile& profile, size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot& slot = slots_[profile.key()];
+        slot.profile = profile;
+        slot.warm = count;
+        slot.retry_after = {};
+    }
+    wake_.notify_all();
+}
+
+void ConnectionPool::clear() {
+    std::vector<std::unique_ptr<Client>> stale;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+        for (auto& entry : slots_) {
+            for (auto& idle : entry.second.idle) {
+                stale.push_back(std::move(idle.client));
+            }
+        }
+        slots_.clear();
+    }
+    close(stale);
+}
+
+void ConnectionPool::maintain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        const auto now = std::chrono::steady_clock::now();
+        const uint64_t generation = generation_;
+        std::vector<std::unique_ptr<Client>> stale;
+
+        // Top up one profile below its warm count per pass, so stop() and
+        // clear() are never held up by more than one handshake
+        auto below = slots_.end();
+        for (auto it = slots_.begin(); it != slots_.end(); ++it) {
+            const Slot& slot = it->second;
+            if (slot.idle.size() + slot.busy < slot.warm && now >= slot.retry_after) {
+                below = it;
+                break;
+            }
+        }
+        if (below != slots_.end()) {
+            const std::string key = below->first;
+            const ConnectionProfile profile = below->second.profile;
+            ++below->second.busy;
+            lock.unlock();
+            std::unique_ptr<Client> client;
+            try {
+                client = open(profile);
+            } catch (const std::exception& e) {
+                LOG_DEBUG("Connection pool: cannot open a connection to " + profile.host + ": " + e.what());
+            }
+            lock.lock();
+            auto it = slots_.find(key);
+            if (it != slots_.end() && generation == generation_) {
+                --it->second.busy;
+                if (client) {
+                    it->second.idle.push_back({std::move(client), std::chrono::steady_clock::now()});
+                } else {
+                    it->second.retry_after = std::chrono::steady_clock::now() + kRetryDelay;
+                }
+            }
+            if (client) {
+                stale.push_back(std::move(client));
+                lock.unlock();
+                close(stale);
+                lock.lock();
+            }
+            continue;
+        }
+
+        // Keep-alive: probe connections that have been idle for a while and
+        // close those of profiles nobody asked to keep warm
+        std::vector<std::pair<std::string, IdleConnection>> probes;
+        for (auto& entry : slots_) {
+            Slot& slot = entry.second;
+            for (auto it = slot.idle.begin(); it != slot.idle.end();) {
+                const auto idle_for = now - it->since;
+                const auto unprobed_for = now - (std::max)(it->since, it->last_probe);
+                if (slot.warm == 0 && idle_for >= idle_timeout_) {
+                    stale.push_back(std::move(it->client));
+                    it = slot.idle.erase(it);
+                } else if (unprobed_for >= kKeepAliveInterval) {
+                    probes.emplace_back(entry.first, std::move(*it));
+                    ++slot.busy;
+                    it = slot.idle.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        if (!probes.empty() || !stale.empty()) {
+            lock.unlock();
+            close(stale);
+            for (auto& probe : probes) {
+                if (!is_alive(*probe.second.client)) {
+                    LOG_DEBUG("Connection pool: dropping a dead idle connection");
+                    stale.push_back(std::move(probe.second.client));
+                }
+            }
+            close(stale);
+            lock.lock();
+            for (auto& probe : probes) {
+                auto it = slots_.find(probe.first);
+                if (it == slots_.end() || generation != generation_) {
+                    if (probe.second.client) {
+                        stale.push_back(std::move(probe.second.client));
+                    }
+                    continue;
+                }
+                --it->second.busy;
+                if (probe.second.client) {
+                    // Keeps its idle time, so idle_timeout still applies
+                    probe.second.last_probe = std::chrono::steady_clock::now();
+                    it->second.idle.push_back(std::move(probe.second));
+                }
+            }
+            if (!stale.empty()) {
+                lock.unlock();
+                close(stale);
+                lock.lock();
+            }
+            continue;
+        }
+
+        wake_.wait_for(lock, kMaintenanceTick);
+    }
+}
+
+} // namespace client
+} // namespace netcopy
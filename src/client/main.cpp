@@ -1,4 +1,6 @@
 #include "client/client.h"
+#include "client/agent.h"
+#include "client/bulk_job.h"
 #include "common/utils.h"
 #include "logging/logger.h"
 #include "file/file_manager.h"
@@ -7,6 +9,7 @@
 #include "crypto/sha3.h"
 #include "crypto/aes_256_gcm_gpu.h"
 #include "common/bandwidth_monitor.h"
+#include "common/trace.h"
 #include <iostream>
 #include <string>
 #include <iomanip>
@@ -18,7 +21,11 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <csignal>
+#include <cstdlib>
 #include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -29,10 +36,15 @@
 
 namespace {
 netcopy::client::Client* g_active_client = nullptr;
+netcopy::client::BulkJob* g_active_job = nullptr;
 
 #ifdef _WIN32
 BOOL WINAPI console_ctrl_handler(DWORD ctrl_type) {
     if (ctrl_type == CTRL_C_EVENT || ctrl_type == CTRL_BREAK_EVENT) {
+        if (g_active_job != nullptr) {
+            g_active_job->request_cancel();
+            return TRUE;
+        }
         if (g_active_client != nullptr) {
             g_active_client->request_cancel();
             return TRUE;
@@ -43,6 +55,9 @@ BOOL WINAPI console_ctrl_handler(DWORD ctrl_type) {
 #else
 void signal_handler(int sig) {
     if (sig == SIGINT || sig == SIGTERM) {
+        if (g_active_job != nullptr) {
+            g_active_job->request_cancel();
+        }
         if (g_active_client != nullptr) {
             g_active_client->request_cancel();
         }
@@ -86,6 +101,62 @@ const std::vector<uint8_t> kStoredPasswordSalt = {
 };
 
 constexpr int kStoredPasswordPbkdf2Iterations = 100000;
+
+// Writes the chunk trace when client_main unwinds, so failed transfers are
+// traced too
+class TraceDumper {
+public:
+    explicit TraceDumper(std::string path) : path_(std::move(path)) {}
+    ~TraceDumper() {
+        if (path_.empty()) {
+            return;
+        }
+        if (netcopy::common::ChunkTracer::instance().write_chrome_trace(path_)) {
+            std::cout << "Trace written to " << path_ << std::endl;
+        } else {
+            std::cerr << "Failed to write trace file: " << path_ << std::endl;
+        }
+    }
+
+private:
+    std::string path_;
+};
+
+// Whether progress can be redrawn in place with ANSI escapes
+bool enable_ansi_console() {
+#ifdef _WIN32
+    HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (hOut != INVALID_HANDLE_VALUE) {
+        DWORD dwMode = 0;
+        if (GetConsoleMode(hOut, &dwMode)) {
+            dwMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
+            if (SetConsoleMode(hOut, dwMode)) {
+                return true;
+            }
+        }
+    }
+    return false;
+#else
+    return isatty(fileno(stdout)) != 0;
+#endif
+}
+
+std::string format_size(uint64_t bytes) {
+    const char* units[] = {"B", "KB", "MB", "GB", "TB"};
+    int unit = 0;
+    double size = static_cast<double>(bytes);
+    while (size >= 1024 && unit < 4) {
+        size /= 1024;
+        unit++;
+    }
+    char buffer[32];
+    if (unit == 0) {
+        snprintf(buffer, sizeof(buffer), "%.0f %s", size, units[unit]);
+    } else {
+        snprintf(buffer, sizeof(buffer), "%.1f %s", size, units[unit]);
+    }
+    return std::string(buffer);
+}
 }
 
 struct CommandLineArgs {
@@ -104,9 +175,19 @@ struct CommandLineArgs {
     bool auto_create_directories = netcopy::config::defaults::kAutoCreateDirectories;
     bool auto_create_specified = false;
     netcopy::crypto::SecurityLevel security_level = netcopy::crypto::SecurityLevel::HIGH;
+    bool auto_security = false;
     bool force = false;
     bool version = false;
     std::string status_session_id;
+    std::string trace_file;
+    uint32_t trace_sample = 1;
+    bool agent = false;
+    bool use_agent = false;
+    std::string agent_socket;
+    uint32_t agent_idle_seconds = 600;
+    std::string job_file;
+    std::string report_file;
+    uint32_t job_workers = 0; // 0: one per CPU core, at most 8
 };
 
 void print_usage(const char* program_name) {
@@ -125,10 +206,19 @@ void print_usage(const char* program_name) {
     std::cout << "  --auto-create              Automatically create non-existent directories (default)" << std::endl;
     std::cout << "  --no-auto-create           Disable automatic directory creation" << std::endl;
     std::cout << "  --no-empty-dirs            Don't create empty directories" << std::endl;
-    std::cout << "  -s, --security LEVEL       Security level: high (default), fast, aes, or AES-256-GCM" << std::endl;
+    std::cout << "  -s, --security LEVEL       Security level: high (default), fast, aes, AES-256-GCM, or auto" << std::endl;
     std::cout << "  -g, --get, --download      Download/pull file/directory from server" << std::endl;
     std::cout << "  -f, --force                Force replacing existing files/folders without prompting" << std::endl;
     std::cout << "  -v, --verbose              Enable verbose logging" << std::endl;
+    std::cout << "  --trace FILE               Write a per-chunk stage trace (Chrome trace JSON)" << std::endl;
+    std::cout << "  --trace-sample N           Trace one chunk in N (default: 1, every chunk)" << std::endl;
+    std::cout << "  --agent                    Run the client agent, which keeps connections warm for --use-agent" << std::endl;
+    std::cout << "  --use-agent                Run through the client agent when one is running (or NETCOPY_USE_AGENT=1)" << std::endl;
+    std::cout << "  --agent-socket PATH        Client agent socket (default: NETCOPY_AGENT_SOCKET or agent.sock in the config directory)" << std::endl;
+    std::cout << "  --agent-idle SECONDS       Close agent connections idle this long (default: 600)" << std::endl;
+    std::cout << "  --jobs FILE                Run every transfer listed in FILE over shared connections" << std::endl;
+    std::cout << "  --job-workers N            Transfers run at once with --jobs (default: CPU cores, at most 8)" << std::endl;
+    std::cout << "  --report FILE              Write a JSON result report for --jobs (- for stdout)" << std::endl;
     std::cout << "  -h, --help                 Show this help message" << std::endl << std::endl;
     
     std::cout << "Destination formats (Source formats if downloading):" << std::endl;
@@ -146,6 +236,14 @@ void print_usage(const char* program_name) {
     std::cout << "  " << program_name << " large_file.zip 192.168.1.100:/downloads/ --resume" << std::endl;
     std::cout << "  " << program_name << " --get 192.168.1.100:/remote/file.txt ./local_file.txt" << std::endl;
     std::cout << "  " << program_name << " --get -R 192.168.1.100:/remote/dir ./local_dir" << std::endl;
+    std::cout << "  " << program_name << " --agent &" << std::endl;
+    std::cout << "  " << program_name << " --use-agent file.txt 192.168.1.100:/remote/path/" << std::endl;
+    std::cout << "  " << program_name << " --jobs transfers.txt --report result.json" << std::endl << std::endl;
+
+    std::cout << "Job file lines (tab-separated, or space-separated when a line has no tab):" << std::endl;
+    std::cout << "  upload   <local path> <destination> [recursive] [resume] [force|delta]" << std::endl;
+    std::cout << "  download <source> <local path> [recursive] [resume] [force|delta]" << std::endl;
+    std::cout << "  Files that already exist are skipped unless force or delta is given." << std::endl;
 }
 
 CommandLineArgs parse_arguments(const std::vector<std::string>& arg_list) {
@@ -214,8 +312,11 @@ CommandLineArgs parse_arguments(const std::vector<std::string>& arg_list) {
                     args.security_level = netcopy::crypto::SecurityLevel::AES;
                 } else if (level == "AES-256-GCM") {
                     args.security_level = netcopy::crypto::SecurityLevel::AES_256_GCM;
+                } else if (level == "auto") {
+                    args.security_level = netcopy::crypto::SecurityLevel::HIGH;
+                    args.auto_security = true;
                 } else {
-                    throw std::runtime_error("Invalid security level '" + level + "'. Use 'high', 'fast', 'aes', or 'AES-256-GCM'.");
+                    throw std::runtime_error("Invalid security level '" + level + "'. Use 'high', 'fast', 'aes', 'AES-256-GCM', or 'auto'.");
                 }
             } else {
                 throw std::runtime_error("Missing security level argument");
@@ -238,12 +339,93 @@ CommandLineArgs parse_arguments(const std::vector<std::string>& arg_list) {
             }
         } else if (arg == "-g" || arg == "--get" || arg == "--download") {
             args.download = true;
+        } else if (arg == "--trace") {
+            if (i + 1 < arg_list.size()) {
+                args.trace_file = arg_list[++i];
+            } else {
+                throw std::runtime_error("Missing file argument for --trace");
+            }
+        } else if (arg == "--trace-sample") {
+            if (i + 1 < arg_list.size()) {
+                try {
+                    int sample = std::stoi(arg_list[++i]);
+                    if (sample < 1) {
+                        throw std::runtime_error("must be at least 1");
+                    }
+                    args.trace_sample = static_cast<uint32_t>(sample);
+                } catch (const std::exception& e) {
+                    throw std::runtime_error("Error parsing --trace-sample argument '" + arg_list[i] + "': " + e.what());
+                }
+            } else {
+                throw std::runtime_error("Missing value for --trace-sample");
+            }
+        } else if (arg == "--agent") {
+            args.agent = true;
+        } else if (arg == "--use-agent") {
+            args.use_agent = true;
+        } else if (arg == "--agent-socket") {
+            if (i + 1 < arg_list.size()) {
+                args.agent_socket = arg_list[++i];
+            } else {
+                throw std::runtime_error("Missing path argument for --agent-socket");
+            }
+        } else if (arg == "--agent-idle") {
+            if (i + 1 < arg_list.size()) {
+                try {
+                    int seconds = std::stoi(arg_list[++i]);
+                    if (seconds < 1) {
+                        throw std::runtime_error("must be at least 1");
+                    }
+                    args.agent_idle_seconds = static_cast<uint32_t>(seconds);
+                } catch (const std::exception& e) {
+                    throw std::runtime_error("Error parsing --agent-idle argument '" + arg_list[i] + "': " + e.what());
+                }
+            } else {
+                throw std::runtime_error("Missing value for --agent-idle");
+            }
+        } else if (arg == "--jobs") {
+            if (i + 1 < arg_list.size()) {
+                args.job_file = arg_list[++i];
+            } else {
+                throw std::runtime_error("Missing file argument for --jobs");
+            }
+        } else if (arg == "--job-workers") {
+            if (i + 1 < arg_list.size()) {
+                try {
+                    int workers = std::stoi(arg_list[++i]);
+                    if (workers < 1 || workers > 256) {
+                        throw std::runtime_error("must be between 1 and 256");
+                    }
+                    args.job_workers = static_cast<uint32_t>(workers);
+                } catch (const std::exception& e) {
+                    throw std::runtime_error("Error parsing --job-workers argument '" + arg_list[i] + "': " + e.what());
+                }
+            } else {
+                throw std::runtime_error("Missing value for --job-workers");
+            }
+        } else if (arg == "--report") {
+            if (i + 1 < arg_list.size()) {
+                args.report_file = arg_list[++i];
+            } else {
+                throw std::runtime_error("Missing file argument for --report");
+            }
         } else {
             positional_args.push_back(arg);
         }
     }
     
-    if (!args.status_session_id.empty()) {
+    if (!args.report_file.empty() && args.job_file.empty() && !args.help && !args.version) {
+        throw std::runtime_error("--report is only used with --jobs. Use -h for help.");
+    }
+    if (args.agent) {
+        if (!positional_args.empty()) {
+            throw std::runtime_error("--agent takes no source or destination arguments. Use -h for help.");
+        }
+    } else if (!args.job_file.empty()) {
+        if (!positional_args.empty()) {
+            throw std::runtime_error("--jobs takes no source or destination arguments; they come from the job file. Use -h for help.");
+        }
+    } else if (!args.status_session_id.empty()) {
         if (positional_args.size() == 1) {
             args.destination_path = positional_args[0];
         } else if (positional_args.empty()) {
@@ -267,6 +449,107 @@ CommandLineArgs parse_arguments(const std::vector<std::string>& arg_list) {
     return args;
 }
 
+// --jobs: runs every transfer of a job file in this process over shared
+// connections, then prints a summary and writes the JSON report
+int run_job_file(const CommandLineArgs& args, const netcopy::config::ClientConfig& config) {
+    netcopy::client::JobDefaults defaults;
+    defaults.port_override = args.server_port;
+    defaults.recursive = args.recursive;
+    defaults.resume = args.resume;
+    defaults.force = args.force;
+    auto entries = netcopy::client::load_job_manifest(args.job_file, defaults);
+
+    netcopy::client::ConnectionProfile profile;
+    profile.config = config;
+    profile.security_level = args.security_level;
+    profile.auto_security_level = args.auto_security;
+    if (args.security_level == netcopy::crypto::SecurityLevel::FAST) {
+        LOG_WARNING("'fast' mode uses XOR cipher which provides NO real security. Use only on trusted local networks.");
+    }
+
+    const unsigned cores = std::thread::hardware_concurrency();
+    const size_t workers = args.job_workers != 0 ? args.job_workers : (std::max)(1u, (std::min)(8u, cores == 0 ? 1u : cores));
+    netcopy::client::BulkJob job(std::move(entries), profile, workers);
+
+    // The report owns stdout when it is written there
+    const bool report_to_stdout = args.report_file == "-";
+    std::ostream& console = report_to_stdout ? std::cerr : std::cout;
+    const bool use_ansi = !report_to_stdout && enable_ansi_console();
+    console << "Running " << job.entries().size() << " transfers from " << args.job_file << " with up to "
+            << workers << " at once" << std::endl;
+
+    g_active_job = &job;
+#ifdef _WIN32
+    SetConsoleCtrlHandler(console_ctrl_handler, TRUE);
+#else
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+#endif
+
+    netcopy::common::BandwidthMonitor bandwidth_monitor;
+    uint64_t recorded_bytes = 0;
+    auto last_line = std::chrono::steady_clock::now();
+    job.run([&](const netcopy::client::JobTotals& totals) {
+        if (totals.bytes > recorded_bytes) {
+            bandwidth_monitor.record_bytes(totals.bytes - recorded_bytes);
+            recorded_bytes = totals.bytes;
+        }
+        std::ostringstream line;
+        line << "Jobs: " << (totals.succeeded + totals.failed + totals.cancelled) << "/" << totals.entries << " done";
+        if (totals.failed > 0) {
+            line << ", " << totals.failed << " failed";
+        }
+        line << ", " << totals.running << " running, " << format_size(totals.bytes) << " at "
+             << bandwidth_monitor.get_rate_string();
+        if (use_ansi) {
+            console << "\r\033[K" << line.str() << std::flush;
+        } else {
+            // Redirected output: an occasional line instead of a redraw
+            const auto now = std::chrono::steady_clock::now();
+            if (now - last_line >= std::chrono::seconds(5)) {
+                console << line.str() << std::endl;
+                last_line = now;
+            }
+        }
+    });
+    if (use_ansi) {
+        console << std::endl;
+    }
+
+#ifdef _WIN32
+    SetConsoleCtrlHandler(console_ctrl_handler, FALSE);
+#endif
+    g_active_job = nullptr;
+
+    const auto totals = job.totals();
+    const auto& results = job.results();
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].status == netcopy::client::JobStatus::FAILED) {
+            const auto& entry = job.entries()[i];
+            console << "Failed (line " << entry.line << "): " << entry.operation << " " << entry.local_path << ": "
+                    << results[i].error << std::endl;
+        }
+    }
+    console << "Completed " << totals.succeeded << " of " << totals.entries << " transfers";
+    if (totals.failed > 0 || totals.cancelled > 0) {
+        console << " (" << totals.failed << " failed, " << totals.cancelled << " cancelled)";
+    }
+    console << ", " << format_size(totals.bytes) << " over " << totals.connections_opened << " connections" << std::endl;
+
+    if (report_to_stdout) {
+        std::cout << job.report_json(args.job_file) << std::flush;
+    } else if (!args.report_file.empty()) {
+        std::ofstream report(args.report_file, std::ios::binary | std::ios::trunc);
+        report << job.report_json(args.job_file);
+        if (!report) {
+            std::cerr << "Failed to write report file: " << args.report_file << std::endl;
+            return 1;
+        }
+        console << "Report written to " << args.report_file << std::endl;
+    }
+    return (totals.failed == 0 && totals.cancelled == 0) ? 0 : 1;
+}
+
 int client_main(int argc, char* argv[]) {
     try {
         auto arg_list = netcopy::common::preprocess_arguments(argc, argv);
@@ -282,6 +565,28 @@ int client_main(int argc, char* argv[]) {
             return 0;
         }
         
+        if (args.agent_socket.empty()) {
+            args.agent_socket = netcopy::client::default_agent_socket_path();
+        }
+        if (const char* use_agent = std::getenv("NETCOPY_USE_AGENT")) {
+            args.use_agent = args.use_agent || std::string(use_agent) == "1";
+        }
+        
+        if (args.agent) {
+            // Requests carry their own configuration; the agent only logs
+            auto& logger = netcopy::logging::Logger::instance();
+            logger.set_console_output(true);
+            logger.set_console_level(netcopy::logging::Logger::string_to_level(args.verbose ? args.console_level : "INFO"));
+            netcopy::client::ClientAgent agent(args.agent_socket, std::chrono::seconds(args.agent_idle_seconds));
+            agent.run();
+            return 0;
+        }
+        
+        if (!args.trace_file.empty()) {
+            netcopy::common::ChunkTracer::instance().enable("client", args.trace_sample);
+        }
+        TraceDumper trace_dumper(args.trace_file);
+        
         netcopy::client::Client client;
         
         // Load configuration
@@ -423,124 +728,18 @@ int client_main(int argc, char* argv[]) {
             LOG_INFO("Client configuration loaded from: " + config_path_used);
         }
 
-        // Parse destination (or source if downloading) - support multiple formats:
-        // 1. server_address:port/path  (e.g., 127.0.0.1:1245/path)
-        // 2. server_address:path       (e.g., 127.0.0.1:/path, uses port from config/command line)
-        // 3. server_address            (e.g., 127.0.0.1, uses port from config/command line and default path)
-        
-        std::string server_address;
-        uint16_t server_port = args.server_port; // Use command line port if provided
-        std::string remote_path = "/"; // Default path
-        
+        if (!args.job_file.empty()) {
+            return run_job_file(args, config);
+        }
+
+        // Parse destination (or source if downloading); see parse_remote_location
+        // for the accepted forms
         std::string path_to_parse = args.download ? args.source_path : args.destination_path;
         std::string local_path = args.download ? args.destination_path : args.source_path;
-        
-        if (!path_to_parse.empty() && path_to_parse.front() == '[') {
-            size_t close_bracket = path_to_parse.find(']');
-            if (close_bracket == std::string::npos) {
-                std::cerr << "Error: Invalid bracketed IPv6 destination. Missing ']'" << std::endl;
-                return 1;
-            }
-            server_address = path_to_parse.substr(1, close_bracket - 1);
-            std::string after_bracket = path_to_parse.substr(close_bracket + 1);
-            if (after_bracket.empty()) {
-                // Format: [::1] (uses default port and path)
-            } else if (after_bracket[0] == ':') {
-                std::string after_colon = after_bracket.substr(1);
-                if (after_colon.empty()) {
-                    // Format: [::1]:
-                    // Use default port and path
-                } else if (after_colon[0] == '/' || after_colon[0] == '\\' || 
-                           (after_colon.length() > 1 && after_colon[1] == ':')) {
-                    // Format: [::1]:/path or [::1]:D:/path
-                    remote_path = after_colon;
-                } else {
-                    size_t slash_pos = after_colon.find_first_of("/\\");
-                    std::string potential_port = (slash_pos != std::string::npos) ? 
-                        after_colon.substr(0, slash_pos) : after_colon;
-                    
-                    if (server_port == 0) {
-                        try {
-                            int port_int = std::stoi(potential_port);
-                            if (port_int >= 1 && port_int <= 65535) {
-                                server_port = static_cast<uint16_t>(port_int);
-                                if (slash_pos != std::string::npos) {
-                                    remote_path = after_colon.substr(slash_pos);
-                                }
-                            } else {
-                                remote_path = after_colon;
-                            }
-                        } catch (const std::exception&) {
-                            remote_path = after_colon;
-                        }
-                    } else {
-                        remote_path = after_colon;
-                    }
-                }
-            } else {
-                // Format: [::1]/path
-                remote_path = after_bracket;
-            }
-        } else {
-            size_t colon_pos = path_to_parse.find(":");
-            if (colon_pos == std::string::npos) {
-                // Format: server_address (no port, no path)
-                server_address = path_to_parse;
-            } else {
-                server_address = path_to_parse.substr(0, colon_pos);
-                std::string after_colon = path_to_parse.substr(colon_pos + 1);
-                
-                if (after_colon.empty()) {
-                    // Format: server_address: (empty after colon)
-                    // Use default port and path
-                } else if (after_colon[0] == '/' || after_colon[0] == '\\' || 
-                          (after_colon.length() > 1 && after_colon[1] == ':')) {
-                    // Format: server_address:/path or server_address:\path or server_address:C:\path
-                    remote_path = after_colon;
-                } else {
-                    // Check if it's a port number or path
-                    // Look for path separator to determine where port ends
-                    size_t slash_pos = after_colon.find_first_of("/\\");
-                    size_t colon_pos_inner = after_colon.find(':');
-                    
-                    // Handle cases like "1245:D:/Work/" (invalid format)
-                    if (colon_pos_inner != std::string::npos && colon_pos_inner < slash_pos) {
-                        std::cerr << "Error: Invalid remote format. Multiple colons detected." << std::endl;
-                        std::cerr << "Use: server:port/path  (e.g., 127.0.0.1:1245/D:/Work/)" << std::endl;
-                        std::cerr << "Or:  server:path       (e.g., 127.0.0.1:D:/Work/)" << std::endl;
-                        return 1;
-                    }
-                    
-                    std::string potential_port = (slash_pos != std::string::npos) ? 
-                        after_colon.substr(0, slash_pos) : after_colon;
-                    
-                    // Try to parse as port number
-                    if (server_port == 0) { // Only parse port if not provided via command line
-                        try {
-                            int port_int = std::stoi(potential_port);
-                            if (port_int >= 1 && port_int <= 65535) {
-                                server_port = static_cast<uint16_t>(port_int);
-                                if (slash_pos != std::string::npos) {
-                                    remote_path = after_colon.substr(slash_pos);
-                                }
-                            } else {
-                                // Not a valid port, treat as path
-                                remote_path = after_colon;
-                            }
-                        } catch (const std::exception&) {
-                            // Not a number, treat as path
-                            remote_path = after_colon;
-                        }
-                    } else {
-                        // Port already specified via command line, treat as path
-                        remote_path = after_colon;
-                    }
-                }
-            }
-        }
+        auto location = netcopy::client::parse_remote_location(path_to_parse, args.server_port);
         
         // Validate server address
-        if (server_address.empty()) {
+        if (location.host.empty()) {
             std::cerr << "Error: Missing server address" << std::endl;
             std::cerr << "Usage: " << argv[0] << " [options] <source> <destination>" << std::endl;
             std::cerr << "Destination formats (Source formats if downloading):" << std::endl;
@@ -549,26 +748,9 @@ int client_main(int argc, char* argv[]) {
             std::cerr << "  server_address            (e.g., 127.0.0.1, uses default port and path)" << std::endl;
             return 1;
         }
-        
-        // Set default port if not specified
-        if (server_port == 0) {
-            server_port = netcopy::config::defaults::kDefaultTransferPort;
-        }
-        
-        // Normalize remote path based on detected format
-        if (!remote_path.empty() && remote_path != "/") {
-            // Detect if this is a Windows absolute path (e.g., C:\, D:\)
-            if (netcopy::common::is_absolute_path(remote_path)) {
-                // Keep absolute paths as-is but convert to Unix style for network transmission
-                remote_path = netcopy::common::convert_to_unix_path(remote_path);
-            } else {
-                // For relative paths, ensure they start with /
-                remote_path = netcopy::common::convert_to_unix_path(remote_path);
-                if (remote_path[0] != '/') {
-                    remote_path = "/" + remote_path;
-                }
-            }
-        }
+        const std::string server_address = location.host;
+        const uint16_t server_port = location.port;
+        const std::string remote_path = location.path;
         
         // Debug output for path handling
         if (args.verbose) {
@@ -577,94 +759,12 @@ int client_main(int argc, char* argv[]) {
             LOG_INFO("Remote path (native format): " + netcopy::common::convert_to_native_path(remote_path));
         }
 
-        // Set security level before connecting
-        client.set_security_level(args.security_level);
-        if (args.verbose) {
-            std::string level_name;
-            switch (args.security_level) {
-                case netcopy::crypto::SecurityLevel::HIGH:
-                    level_name = "HIGH (ChaCha20-Poly1305)";
-                    break;
-                case netcopy::crypto::SecurityLevel::FAST:
-                    level_name = "FAST (XOR cipher)";
-                    break;
-                case netcopy::crypto::SecurityLevel::AES:
-                    level_name = "AES (AES-CTR with hardware acceleration)";
-                    // Show detailed AES acceleration information
-                    LOG_INFO(netcopy::crypto::AesCtr::get_detailed_acceleration_info());
-                    break;
-                case netcopy::crypto::SecurityLevel::AES_256_GCM:
-                    level_name = "AES-256-GCM (GPU accelerated)";
-                    // Show detailed GPU acceleration information
-                    LOG_INFO(netcopy::crypto::Aes256GcmGpu::get_detailed_gpu_info());
-                    break;
-            }
-            LOG_INFO("Security level: " + level_name);
-            LOG_INFO("Connecting to " + server_address + ":" + std::to_string(server_port));
-        }
-        if (args.security_level == netcopy::crypto::SecurityLevel::FAST) {
-            LOG_WARNING("'fast' mode uses XOR cipher which provides NO real security. Use only on trusted local networks.");
-        }
-
-        client.connect(server_address, server_port);
-        if (args.verbose) {
-            LOG_INFO("Connected successfully");
-        }
-
-#ifdef _WIN32
-        g_active_client = &client;
-        SetConsoleCtrlHandler(console_ctrl_handler, TRUE);
-#else
-        g_active_client = &client;
-        std::signal(SIGINT, signal_handler);
-        std::signal(SIGTERM, signal_handler);
-#endif
-
-        if (!args.status_session_id.empty()) {
-            std::cout << "Querying session status for: " << args.status_session_id << std::endl;
-            auto status_resp = client.query_transfer_status(args.status_session_id);
-            if (status_resp.success) {
-                std::cout << "======================================" << std::endl;
-                std::cout << "Session ID:        " << args.status_session_id << std::endl;
-                std::cout << "Status:            " << status_resp.status_string << std::endl;
-                std::cout << "Bytes Transferred: " << status_resp.bytes_transferred << std::endl;
-                std::cout << "Total Bytes:       " << status_resp.total_bytes << std::endl;
-                std::cout << "Active:            " << (status_resp.active ? "Yes" : "No") << std::endl;
-                std::cout << "--------------------------------------" << std::endl;
-                std::cout << "Audit Logs:" << std::endl;
-                std::cout << status_resp.logs;
-                std::cout << "======================================" << std::endl;
-            } else {
-                std::cerr << "Query failed: " << status_resp.error_message << std::endl;
-            }
-            
-#ifdef _WIN32
-            SetConsoleCtrlHandler(console_ctrl_handler, FALSE);
-            g_active_client = nullptr;
-#endif
-            return 0;
-        }
-
-        bool use_ansi = false;
-#ifdef _WIN32
-        HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
-        if (hOut != INVALID_HANDLE_VALUE) {
-            DWORD dwMode = 0;
-            if (GetConsoleMode(hOut, &dwMode)) {
-                dwMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
-                if (SetConsoleMode(hOut, dwMode)) {
-                    use_ansi = true;
-                }
-            }
-        }
-#else
-        use_ansi = (isatty(fileno(stdout)) != 0);
-#endif
+        bool use_ansi = enable_ansi_console();
 
         // Create overwrite state
         auto overwrite_state = std::make_shared<OverwriteState>();
         
-        client.set_overwrite_callback(static_cast<netcopy::client::Client::OverwriteCallback>([overwrite_state, args](const std::string& remote_path, uint64_t remote_size) {
+        netcopy::client::Client::OverwriteCallback overwrite_callback = [overwrite_state, args](const std::string& remote_path, uint64_t remote_size) {
             if (args.force) {
                 return netcopy::client::Client::OverwriteDecision::OVERWRITE;
             }
@@ -711,14 +811,16 @@ int client_main(int argc, char* argv[]) {
                     return netcopy::client::Client::OverwriteDecision::CANCEL;
                 }
             }
-        }));
+        };
 
         // Create bandwidth monitor
         auto bandwidth_monitor = std::make_shared<netcopy::common::BandwidthMonitor>();
         
         auto state = std::make_shared<ProgressState>();
+        // Known once connected, directly or through the agent
+        auto parallel_streams = std::make_shared<std::atomic<uint32_t>>(1);
         
-        client.set_progress_callback(static_cast<netcopy::client::Client::ProgressCallback>([bandwidth_monitor, state, use_ansi, args, &client, overwrite_state](uint64_t bytes_transferred, uint64_t total_bytes, const std::string& current_file) {
+        netcopy::client::Client::ProgressCallback progress_callback = [bandwidth_monitor, state, use_ansi, args, parallel_streams, overwrite_state](uint64_t bytes_transferred, uint64_t total_bytes, const std::string& current_file) {
             // Prepare output under the state lock, but defer console I/O
             // to outside the lock so shared-mutex contention does not
             // serialize all parallel transfer workers.
@@ -751,23 +853,6 @@ int client_main(int argc, char* argv[]) {
             std::string filename = netcopy::file::FileManager::get_filename(current_file);
             double progress = static_cast<double>(bytes_transferred) / total_bytes * 100.0;
 
-            auto format_size = [](uint64_t bytes) -> std::string {
-                const char* units[] = {"B", "KB", "MB", "GB", "TB"};
-                int unit = 0;
-                double size = static_cast<double>(bytes);
-                while (size >= 1024 && unit < 4) {
-                    size /= 1024;
-                    unit++;
-                }
-                char buffer[32];
-                if (unit == 0) {
-                    snprintf(buffer, sizeof(buffer), "%.0f %s", size, units[unit]);
-                } else {
-                    snprintf(buffer, sizeof(buffer), "%.1f %s", size, units[unit]);
-                }
-                return std::string(buffer);
-            };
-
             std::string rate_str = bandwidth_monitor->get_rate_string();
             std::ostringstream line;
             line << filename << ": " << std::fixed << std::setprecision(1) << progress << "% "
@@ -775,7 +860,7 @@ int client_main(int argc, char* argv[]) {
                  << "at " << rate_str;
             output = line.str();
 
-            bool is_concurrent = args.recursive && !args.download && (client.get_negotiated_parallel_streams() > 1);
+            bool is_concurrent = args.recursive && !args.download && (parallel_streams->load() > 1);
 
             if (use_ansi) {
                 if (is_concurrent) {
@@ -858,58 +943,127 @@ int client_main(int argc, char* argv[]) {
                     std::cout << "\r\033[K" << output << std::flush;
                 }
             }
-        }));
+        };
+
+        netcopy::client::TransferRequest request;
+        request.operation = args.download ? "download" : "upload";
+        request.local_path = local_path;
+        request.remote_path = remote_path;
+        request.recursive = args.recursive;
+        request.resume = args.resume;
+        request.force = args.force;
+        auto print_message = [](const std::string& text) { std::cout << text << std::endl; };
+
+        if (args.use_agent && args.status_session_id.empty()) {
+            // The agent runs elsewhere: it gets absolute paths and the
+            // settings and credentials resolved above
+            request.config_file = std::filesystem::absolute(config_path_used).string();
+            request.local_path = std::filesystem::absolute(local_path).string();
+            request.create_empty_directories = config.create_empty_directories;
+            request.auto_create_directories = config.auto_create_directories;
+            request.secret_key = config.internal.secret_key;
+            request.password = config.internal.password;
+            request.host = server_address;
+            request.port = server_port;
+            request.security_level = args.security_level;
+            request.auto_security_level = args.auto_security;
 
-        if (args.download) {
-            bool is_dir = false;
-            try {
-                // Try listing the path to see if it is a directory
-                client.list_remote_directory(remote_path, false);
-                is_dir = true;
-            } catch (const std::exception&) {
-                // Assume it's a file or not found (download_file will handle file-not-found)
-                is_dir = false;
+            netcopy::client::AgentCallbacks callbacks;
+            callbacks.started = [parallel_streams](uint32_t streams) { parallel_streams->store(streams); };
+            callbacks.progress = progress_callback;
+            callbacks.overwrite = overwrite_callback;
+            callbacks.message = print_message;
+            if (netcopy::client::submit_to_agent(args.agent_socket, request, callbacks)) {
+                return 0;
             }
+            if (args.verbose) {
+                LOG_INFO("No client agent on " + args.agent_socket + ", connecting directly");
+            }
+        }
 
-            if (is_dir) {
-                if (!args.recursive) {
-                    throw std::runtime_error("Cannot transfer directory without -R/--recursive flag. Use -R to transfer directories recursively.");
-                }
-                std::string remote_name = remote_path;
-                size_t last_slash = remote_path.find_last_of("/\\");
-                if (last_slash != std::string::npos) {
-                    remote_name = remote_path.substr(last_slash + 1);
-                }
-                std::cout << "Downloading directory: " << remote_name << std::endl;
-                client.download_directory(remote_path, local_path, args.recursive);
-                std::cout << std::endl << "Directory download completed: " << remote_name << std::endl;
-            } else {
-                std::string filename = remote_path;
-                size_t last_slash = remote_path.find_last_of("/\\");
-                if (last_slash != std::string::npos) {
-                    filename = remote_path.substr(last_slash + 1);
-                }
-                std::cout << "Downloading file: " << filename << std::endl;
-                client.download_file(remote_path, local_path);
-                std::cout << std::endl << "File download completed: " << filename << std::endl;
+        client.set_overwrite_callback(overwrite_callback);
+        client.set_progress_callback(progress_callback);
+
+        // Set security level before connecting
+        client.set_security_level(args.security_level);
+        client.set_auto_security_level(args.auto_security);
+        if (args.verbose && args.auto_security) {
+            LOG_INFO("Security level: AUTO (fastest authenticated cipher on both ends)");
+            LOG_INFO("Connecting to " + server_address + ":" + std::to_string(server_port));
+        } else if (args.verbose) {
+            std::string level_name;
+            switch (args.security_level) {
+                case netcopy::crypto::SecurityLevel::HIGH:
+                    level_name = "HIGH (ChaCha20-Poly1305)";
+                    break;
+                case netcopy::crypto::SecurityLevel::FAST:
+                    level_name = "FAST (XOR cipher)";
+                    break;
+                case netcopy::crypto::SecurityLevel::AES:
+                    level_name = "AES (AES-CTR with hardware acceleration)";
+                    // Show detailed AES acceleration information
+                    LOG_INFO(netcopy::crypto::AesCtr::get_detailed_acceleration_info());
+                    break;
+                case netcopy::crypto::SecurityLevel::AES_256_GCM:
+                    level_name = "AES-256-GCM (GPU accelerated)";
+                    // Show detailed GPU acceleration information
+                    LOG_INFO(netcopy::crypto::Aes256GcmGpu::get_detailed_gpu_info());
+                    break;
             }
-        } else {
-            if (netcopy::file::FileManager::is_directory(local_path)) {
-                if (!args.recursive) {
-                    throw std::runtime_error("Cannot transfer directory without -R/--recursive flag. Use -R to transfer directories recursively.");
-                }
-                std::string source_name = netcopy::file::FileManager::get_filename(local_path);
-                std::cout << "Transferring directory: " << source_name << std::endl;
-                client.transfer_directory(local_path, remote_path, args.recursive, args.resume);
-                std::cout << std::endl << "Directory transfer completed: " << source_name << std::endl;
+            LOG_INFO("Security level: " + level_name);
+            LOG_INFO("Connecting to " + server_address + ":" + std::to_string(server_port));
+        }
+        if (args.security_level == netcopy::crypto::SecurityLevel::FAST) {
+            LOG_WARNING("'fast' mode uses XOR cipher which provides NO real security. Use only on trusted local networks.");
+        }
+
+        client.connect(server_address, server_port);
+        if (args.verbose) {
+            LOG_INFO("Connected successfully");
+            if (args.auto_security) {
+                LOG_INFO(std::string("Negotiated cipher: ") +
+                         (client.get_negotiated_security_level() == netcopy::crypto::SecurityLevel::AES_256_GCM
+                              ? "AES-256-GCM" : "ChaCha20-Poly1305"));
+            }
+        }
+
+#ifdef _WIN32
+        g_active_client = &client;
+        SetConsoleCtrlHandler(console_ctrl_handler, TRUE);
+#else
+        g_active_client = &client;
+        std::signal(SIGINT, signal_handler);
+        std::signal(SIGTERM, signal_handler);
+#endif
+
+        if (!args.status_session_id.empty()) {
+            std::cout << "Querying session status for: " << args.status_session_id << std::endl;
+            auto status_resp = client.query_transfer_status(args.status_session_id);
+            if (status_resp.success) {
+                std::cout << "======================================" << std::endl;
+                std::cout << "Session ID:        " << args.status_session_id << std::endl;
+                std::cout << "Status:            " << status_resp.status_string << std::endl;
+                std::cout << "Bytes Transferred: " << status_resp.bytes_transferred << std::endl;
+                std::cout << "Total Bytes:       " << status_resp.total_bytes << std::endl;
+                std::cout << "Active:            " << (status_resp.active ? "Yes" : "No") << std::endl;
+                std::cout << "--------------------------------------" << std::endl;
+                std::cout << "Audit Logs:" << std::endl;
+                std::cout << status_resp.logs;
+                std::cout << "======================================" << std::endl;
             } else {
-                std::string filename = netcopy::file::FileManager::get_filename(local_path);
-                std::cout << "Transferring file: " << filename << std::endl;
-                client.transfer_file(local_path, remote_path, args.resume);
-                std::cout << std::endl << "File transfer completed: " << filename << std::endl;
+                std::cerr << "Query failed: " << status_resp.error_message << std::endl;
             }
+            
+#ifdef _WIN32
+            SetConsoleCtrlHandler(console_ctrl_handler, FALSE);
+            g_active_client = nullptr;
+#endif
+            return 0;
         }
 
+        parallel_streams->store(client.get_negotiated_parallel_streams());
+        netcopy::client::run_transfer_request(client, request, print_message);
+
 #ifdef _WIN32
         SetConsoleCtrlHandler(console_ctrl_handler, FALSE);
         g_active_client = nullptr;
@@ -0,0 +1,202 @@
+#include "client/multipath.h"
+#include "exceptions.h"
+#include "logging/logger.h"
+#include <algorithm>
+
+namespace netcopy {
+namespace client {
+
+namespace {
+
+constexpr std::chrono::seconds kSampleInterval{1};
+constexpr std::chrono::seconds kFailedPathRetry{30};
+constexpr double kRateSmoothing = 0.3; // weight of the newest sample
+
+// "host", "host:port", "[v6]" or "[v6]:port"; a bare IPv6 address has no port
+void parse_server_address(const std::string& entry, uint16_t default_port, std::string& host, uint16_t& port) {
+    host = entry;
+    port = default_port;
+    std::string port_text;
+    if (!entry.empty() && entry.front() == '[') {
+        size_t close = entry.find(']');
+        if (close == std::string::npos) {
+            throw ConfigException("Invalid server address '" + entry + "': missing ']'");
+        }
+        host = entry.substr(1, close - 1);
+        if (close + 1 < entry.size()) {
+            if (entry[close + 1] != ':') {
+                throw ConfigException("Invalid server address '" + entry + "'");
+            }
+            port_text = entry.substr(close + 2);
+        }
+    } else if (std::count(entry.begin(), entry.end(), ':') == 1) {
+        size_t colon = entry.find(':');
+        host = entry.substr(0, colon);
+        port_text = entry.substr(colon + 1);
+    }
+    if (!port_text.empty()) {
+        int value = 0;
+        try {
+            value = std::stoi(port_text);
+        } catch (const std::exception&) {
+            value = 0;
+        }
+        if (value < 1 || value > 65535) {
+            throw ConfigException("Invalid port in server address '" + entry + "'");
+        }
+        port = static_cast<uint16_t>(value);
+    }
+}
+
+} // namespace
+
+std::string TransferPath::name() const {
+    std::string text = (host.find(':') != std::string::npos ? "[" + host + "]" : host) + ":" + std::to_string(port);
+    return local_address.empty() ? text : local_address + " -> " + text;
+}
+
+PathSelector::PathSelector(std::vector<TransferPath> paths) : paths_(std::move(paths)), states_(paths_.size()) {}
+
+std::shared_ptr<PathSelector> PathSelector::from_config(const config::ClientConfig& config,
+                                                        const std::string& host, uint16_t port) {
+    if (config.server_addresses.empty() && config.local_addresses.empty()) {
+        return nullptr;
+    }
+    std::vector<std::pair<std::string, uint16_t>> remotes{{host, port}};
+    for (const auto& entry : config.server_addresses) {
+        std::pair<std::string, uint16_t> remote;
+        parse_server_address(entry, port, remote.first, remote.second);
+        if (std::find(remotes.begin(), remotes.end(), remote) == remotes.end()) {
+            remotes.push_back(remote);
+        }
+    }
+    std::vector<std::string> locals = config.local_addresses;
+    if (locals.empty()) {
+        locals.push_back("");
+    }
+
+    // Remote and local addresses are paired in order, the shorter list
+    // wrapping around: two server ports and two NICs make two paths
+    std::vector<TransferPath> paths;
+    const size_t count = (std::max)(remotes.size(), locals.size());
+    for (size_t i = 0; i < count; ++i) {
+        TransferPath path;
+        path.host = remotes[i % remotes.size()].first;
+        path.port = remotes[i % remotes.size()].second;
+        path.local_address = locals[i % locals.size()];
+        paths.push_back(std::move(path));
+    }
+    return std::make_shared<PathSelector>(std::move(paths));
+}
+
+bool PathSelector::serves(const std::string& host, uint16_t port) const {
+    return paths_.front().host == host && paths_.front().port == port;
+}
+
+size_t PathSelector::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = std::chrono::steady_clock::now();
+    sample_locked(now);
+
+    // Unmeasured paths count as average ones, so each gets streams to be
+    // measured with
+    double measured_total = 0;
+    size_t measured = 0;
+    for (const auto& state : states_) {
+        if (state.stream_rate > 0) {
+            measured_total += state.stream_rate;
+            ++measured;
+        }
+    }
+    const double unmeasured_rate = measured > 0 ? measured_total / static_cast<double>(measured) : 1.0;
+
+    size_t best = kNoPath;
+    double best_load = 0;
+    for (size_t i = 0; i < states_.size(); ++i) {
+        const auto& state = states_[i];
+        if (state.down_until > now) {
+            continue;
+        }
+        double rate = state.stream_rate > 0 ? state.stream_rate : unmeasured_rate;
+        double load = static_cast<double>(state.streams + 1) / rate;
+        if (best == kNoPath || load < best_load) {
+            best = i;
+            best_load = load;
+        }
+    }
+    if (best == kNoPath) {
+        // Every path failed recently; try the one that failed first
+        best = static_cast<size_t>(std::min_element(states_.begin(), states_.end(),
+                                                    [](const PathState& a, const PathState& b) {
+                                                        return a.down_until < b.down_until;
+                                                    }) - states_.begin());
+    }
+    ++states_[best].streams;
+    LOG_DEBUG("Connection over path " + paths_[best].name());
+    return best;
+}
+
+void PathSelector::release(size_t index) {
+    if (index >= states_.size()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    sample_locked(std::chrono::steady_clock::now());
+    if (states_[index].streams > 0) {
+        --states_[index].streams;
+    }
+}
+
+void PathSelector::record(size_t index, uint64_t bytes) {
+    if (index < states_.size()) {
+        states_[index].bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+void PathSelector::mark_failed(size_t index) {
+    if (index >= states_.size()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& state = states_[index];
+    state.down_until = std::chrono::steady_clock::now() + kFailedPathRetry;
+    // Measured again from scratch once it is back
+    state.stream_rate = 0;
+    LOG_WARNING("Path " + paths_[index].name() + " failed; not using it for " +
+                std::to_string(kFailedPathRetry.count()) + " seconds");
+}
+
+bool PathSelector::has_healthy_path() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = std::chrono::steady_clock::now();
+    return std::any_of(states_.begin(), states_.end(), [now](const PathState& state) {
+        return state.down_until <= now;
+    });
+}
+
+void PathSelector::sample_locked(std::chrono::steady_clock::time_point now) {
+    for (auto& state : states_) {
+        uint64_t bytes = state.bytes.load(std::memory_order_relaxed);
+        if (state.sampled_at == std::chrono::steady_clock::time_point{}) {
+            state.sampled_at = now;
+            state.sampled_bytes = bytes;
+            continue;
+        }
+        auto elapsed = std::chrono::duration<double>(now - state.sampled_at).count();
+        if (elapsed < std::chrono::duration<double>(kSampleInterval).count()) {
+            continue;
+        }
+        uint64_t delta = bytes - state.sampled_bytes;
+        if (state.streams > 0 && delta > 0) {
+            double rate = static_cast<double>(delta) / elapsed / static_cast<double>(state.streams);
+            state.stream_rate = state.stream_rate > 0
+                ? (1.0 - kRateSmoothing) * state.stream_rate + kRateSmoothing * rate
+                : rate;
+        }
+        state.sampled_at = now;
+        state.sampled_bytes = bytes;
+    }
+}
+
+} // namespace client
+} // namespace netcopy
@@ -0,0 +1,195 @@
+#include "common/metrics.h"
+#include "exceptions.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+namespace netcopy {
+namespace common {
+
+namespace {
+
+std::atomic<size_t> g_next_shard{0};
+
+std::string format_value(double value) {
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%.9g", value);
+    return buf;
+}
+
+std::string with_labels(const std::string& name, const std::string& labels, const std::string& extra = "") {
+    if (labels.empty() && extra.empty()) {
+        return name;
+    }
+    std::string out = name + "{" + labels;
+    if (!labels.empty() && !extra.empty()) {
+        out += ",";
+    }
+    out += extra + "}";
+    return out;
+}
+
+} // namespace
+
+size_t metric_shard_index() {
+    thread_local size_t index = g_next_shard.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+    return index;
+}
+
+uint64_t MetricCounter::value() const {
+    uint64_t total = 0;
+    for (const auto& slot : slots_) {
+        total += slot.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+MetricHistogram::MetricHistogram(std::vector<double> upper_bounds)
+    : upper_bounds_(std::move(upper_bounds)) {
+    std::sort(upper_bounds_.begin(), upper_bounds_.end());
+    upper_bounds_.erase(std::unique(upper_bounds_.begin(), upper_bounds_.end()), upper_bounds_.end());
+    for (auto& slot : slots_) {
+        slot.buckets.reset(new std::atomic<uint64_t>[upper_bounds_.size() + 1]);
+        for (size_t i = 0; i <= upper_bounds_.size(); ++i) {
+            slot.buckets[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void MetricHistogram::observe(double value) {
+    size_t bucket = static_cast<size_t>(
+        std::lower_bound(upper_bounds_.begin(), upper_bounds_.end(), value) - upper_bounds_.begin());
+    Slot& slot = slots_[metric_shard_index()];
+    slot.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    slot.count.fetch_add(1, std::memory_order_relaxed);
+    if (value > 0) {
+        slot.sum_micros.fetch_add(static_cast<uint64_t>(value * 1e6 + 0.5), std::memory_order_relaxed);
+    }
+}
+
+std::vector<uint64_t> MetricHistogram::bucket_counts() const {
+    std::vector<uint64_t> counts(upper_bounds_.size() + 1, 0);
+    for (const auto& slot : slots_) {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            counts[i] += slot.buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    return counts;
+}
+
+uint64_t MetricHistogram::count() const {
+    uint64_t total = 0;
+    for (const auto& slot : slots_) {
+        total += slot.count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+double MetricHistogram::sum() const {
+    uint64_t micros = 0;
+    for (const auto& slot : slots_) {
+        micros += slot.sum_micros.load(std::memory_order_relaxed);
+    }
+    return static_cast<double>(micros) / 1e6;
+}
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name, const std::string& help, Kind kind) {
+    auto it = families_.find(name);
+    if (it == families_.end()) {
+        it = families_.emplace(name, Family{}).first;
+        it->second.kind = kind;
+        it->second.help = help;
+    } else if (it->second.kind != kind) {
+        throw ConfigException("Metric '" + name + "' registered with conflicting types");
+    }
+    return it->second;
+}
+
+MetricCounter& MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = family(name, help, Kind::Counter).counters[labels];
+    if (!entry) {
+        entry = std::make_unique<MetricCounter>();
+    }
+    return *entry;
+}
+
+MetricGauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = family(name, help, Kind::Gauge).gauges[labels];
+    if (!entry) {
+        entry = std::make_unique<MetricGauge>();
+    }
+    return *entry;
+}
+
+MetricHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                            const std::vector<double>& upper_bounds, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = family(name, help, Kind::Histogram).histograms[labels];
+    if (!entry) {
+        entry = std::make_unique<MetricHistogram>(upper_bounds);
+    }
+    return *entry;
+}
+
+std::vector<double> MetricsRegistry::latency_buckets() {
+    return {0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+            0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+}
+
+std::string MetricsRegistry::render() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    for (const auto& [name, fam] : families_) {
+        out << "# HELP " << name << " " << fam.help << "\n";
+        const char* type = fam.kind == Kind::Counter ? "counter"
+                         : fam.kind == Kind::Gauge ? "gauge" : "histogram";
+        out << "# TYPE " << name << " " << type << "\n";
+
+        for (const auto& [labels, counter] : fam.counters) {
+            out << with_labels(name, labels) << " " << counter->value() << "\n";
+        }
+        for (const auto& [labels, gauge] : fam.gauges) {
+            out << with_labels(name, labels) << " " << gauge->value() << "\n";
+        }
+        for (const auto& [labels, histogram] : fam.histograms) {
+            auto counts = histogram->bucket_counts();
+            const auto& bounds = histogram->upper_bounds();
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < counts.size(); ++i) {
+                cumulative += counts[i];
+                std::string le = i < bounds.size() ? format_value(bounds[i]) : "+Inf";
+                out << with_labels(name + "_bucket", labels, "le=\"" + le + "\"") << " " << cumulative << "\n";
+            }
+            out << with_labels(name + "_sum", labels) << " " << format_value(histogram->sum()) << "\n";
+            // Derive the count from the buckets so a scrape is self-consistent
+            out << with_labels(name + "_count", labels) << " " << cumulative << "\n";
+        }
+    }
+    return out.str();
+}
+
+std::string metric_label(const std::string& key, const std::string& value) {
+    std::string out = key + "=\"";
+    for (char c : value) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '"') out += "\\\"";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    out += "\"";
+    return out;
+}
+
+} // namespace common
+} // namespace netcopy
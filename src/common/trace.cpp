@@ -0,0 +1,217 @@
+#include "common/trace.h"
+#include "common/utils.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace netcopy {
+namespace common {
+
+namespace {
+
+struct ThreadChunk {
+    bool set = false;
+    uint64_t offset = 0;
+    uint64_t bytes = 0;
+};
+
+thread_local ThreadChunk t_chunk;
+
+uint64_t to_ns(std::chrono::steady_clock::time_point tp) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count());
+}
+
+// Chrome trace timestamps are microseconds with fractional precision
+std::string ns_to_us(uint64_t ns) {
+    std::string s = std::to_string(ns / 1000);
+    uint64_t frac = ns % 1000;
+    if (frac != 0) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), ".%03u", static_cast<unsigned>(frac));
+        s += buf;
+    }
+    return s;
+}
+
+} // namespace
+
+const char* trace_stage_name(TraceStage stage) {
+    switch (stage) {
+        case TraceStage::Read: return "read";
+        case TraceStage::Hash: return "hash";
+        case TraceStage::Compress: return "compress";
+        case TraceStage::Encrypt: return "encrypt";
+        case TraceStage::Send: return "send";
+        case TraceStage::Receive: return "receive";
+        case TraceStage::Decrypt: return "decrypt";
+        case TraceStage::Decompress: return "decompress";
+        case TraceStage::Write: return "write";
+        case TraceStage::Ack: return "ack";
+    }
+    return "unknown";
+}
+
+ChunkTracer& ChunkTracer::instance() {
+    static ChunkTracer tracer;
+    return tracer;
+}
+
+void ChunkTracer::enable(const std::string& role, uint32_t sample_every, size_t events_per_thread) {
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        role_ = role;
+        events_per_thread_ = events_per_thread == 0 ? 1 : events_per_thread;
+    }
+    sample_every_.store(sample_every == 0 ? 1 : sample_every, std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+bool ChunkTracer::should_sample(uint64_t offset) const {
+    uint32_t every = sample_every_.load(std::memory_order_relaxed);
+    if (every <= 1) {
+        return true;
+    }
+    // splitmix64 finalizer: spreads regularly spaced chunk offsets evenly
+    uint64_t z = offset + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    return z % every == 0;
+}
+
+ChunkTracer::ThreadSlot::~ThreadSlot() {
+    if (buffer) {
+        ChunkTracer::instance().release(buffer);
+    }
+}
+
+ChunkTracer::ThreadBuffer* ChunkTracer::thread_buffer() {
+    thread_local ThreadSlot slot;
+    if (slot.buffer) {
+        return slot.buffer;
+    }
+    // Every buffer is taken and none has been released: drop without locking
+    if (buffers_full_.load(std::memory_order_relaxed) &&
+        released_count_.load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    if (!released_.empty()) {
+        slot.buffer = released_.back();
+        released_.pop_back();
+        released_count_.store(released_.size(), std::memory_order_relaxed);
+        return slot.buffer;
+    }
+    if (buffers_.size() >= kMaxThreadBuffers) {
+        return nullptr;
+    }
+    auto owned = std::make_unique<ThreadBuffer>();
+    owned->tid = static_cast<uint32_t>(buffers_.size() + 1);
+    owned->capacity = events_per_thread_;
+    owned->events.reset(new Event[owned->capacity]);
+    slot.buffer = owned.get();
+    buffers_.push_back(std::move(owned));
+    buffers_full_.store(buffers_.size() >= kMaxThreadBuffers, std::memory_order_relaxed);
+    return slot.buffer;
+}
+
+void ChunkTracer::release(ThreadBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    // A full buffer would only make its next owner drop everything
+    if (buffer->size.load(std::memory_order_relaxed) < buffer->capacity) {
+        released_.push_back(buffer);
+        released_count_.store(released_.size(), std::memory_order_relaxed);
+    }
+}
+
+void ChunkTracer::record(TraceStage stage, uint64_t offset, uint64_t bytes,
+                         std::chrono::steady_clock::time_point start,
+                         std::chrono::steady_clock::time_point end) {
+    ThreadBuffer* buffer = thread_buffer();
+    if (!buffer) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    size_t index = buffer->size.load(std::memory_order_relaxed);
+    if (index >= buffer->capacity) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t start_ns = to_ns(start);
+    uint64_t end_ns = to_ns(end);
+    buffer->events[index] = Event{start_ns, end_ns > start_ns ? end_ns - start_ns : 0, offset, bytes, stage};
+    buffer->size.store(index + 1, std::memory_order_release);
+}
+
+void ChunkTracer::set_thread_chunk(uint64_t offset, uint64_t bytes) {
+    t_chunk.set = true;
+    t_chunk.offset = offset;
+    t_chunk.bytes = bytes;
+}
+
+void ChunkTracer::clear_thread_chunk() {
+    t_chunk.set = false;
+}
+
+bool ChunkTracer::thread_chunk(uint64_t& offset, uint64_t& bytes) {
+    if (!t_chunk.set) {
+        return false;
+    }
+    offset = t_chunk.offset;
+    bytes = t_chunk.bytes;
+    return true;
+}
+
+std::string ChunkTracer::to_chrome_json() const {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    // Separate pids keep client and server tracks apart when files are merged
+    const int pid = role_ == "server" ? 2 : 1;
+    const std::string role = escape_json(role_);
+
+    std::ostringstream out;
+    out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"role\":\"" << role
+        << "\",\"sample_every\":" << sample_every_.load(std::memory_order_relaxed)
+        << ",\"dropped_events\":" << dropped_.load(std::memory_order_relaxed) << "},";
+    out << "\"traceEvents\":[";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+        << ",\"tid\":0,\"args\":{\"name\":\"" << role << "\"}}";
+
+    for (const auto& buffer : buffers_) {
+        size_t count = buffer->size.load(std::memory_order_acquire);
+        if (count == 0) {
+            continue;
+        }
+        out << ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":\"" << role << "-" << buffer->tid << "\"}}";
+        for (size_t i = 0; i < count; ++i) {
+            const Event& e = buffer->events[i];
+            out << ",{\"name\":\"" << trace_stage_name(e.stage) << "\",\"cat\":\"" << role
+                << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+                << ",\"ts\":" << ns_to_us(e.start_ns) << ",\"dur\":" << ns_to_us(e.duration_ns)
+                << ",\"args\":{\"offset\":" << e.offset << ",\"bytes\":" << e.bytes << "}}";
+        }
+    }
+    out << "]}\n";
+    return out.str();
+}
+
+bool ChunkTracer::write_chrome_trace(const std::string& path) const {
+    std::string json = to_chrome_json();
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file << json;
+        if (!file) {
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+} // namespace common
+} // namespace netcopy
@@ -1,9 +1,9 @@
 #include "common/utils.h"
 #include "network/socket.h"
 #include "crypto/sha3.h"
+#include "crypto/random.h"
 #include <sstream>
 #include <iomanip>
-#include <random>
 #include <iostream>
 #include <filesystem>
 #include <thread>
@@ -24,6 +24,8 @@
 #include <arpa/inet.h>
 #include <termios.h>
 #include <sys/sysinfo.h>
+#include <pthread.h>
+#include <sched.h>
 #endif
 
 namespace netcopy {
@@ -161,16 +163,26 @@ void sleep_milliseconds(int ms) {
     std::this_thread::sleep_for(std::chrono::milliseconds(ms));
 }
 
+bool pin_current_thread_to_cpu(unsigned cpu) {
+#ifdef _WIN32
+    if (cpu >= sizeof(DWORD_PTR) * 8) {
+        return false;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
 std::vector<uint8_t> generate_random_bytes(size_t length) {
     std::vector<uint8_t> bytes(length);
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<uint16_t> dis(0, 255);
-    
-    for (auto& byte : bytes) {
-        byte = static_cast<uint8_t>(dis(gen));
-    }
-    
+    crypto::secure_random(bytes.data(), bytes.size());
     return bytes;
 }
 
@@ -350,6 +362,25 @@ std::vector<uint8_t> derive_session_key(
     return crypto::sha3_256(material);
 }
 
+std::vector<uint8_t> tls_binding_proof(const std::string& base_key_hex,
+                                       const std::vector<uint8_t>& exporter,
+                                       bool client_side) {
+    auto binding_key = derive_session_key(base_key_hex, exporter, {}, {});
+    const std::string role = client_side ? "netcopy client binding" : "netcopy server binding";
+    return crypto::hmac_sha3_256(binding_key, std::vector<uint8_t>(role.begin(), role.end()));
+}
+
+bool tls_binding_matches(const std::vector<uint8_t>& expected, const std::vector<uint8_t>& received) {
+    if (expected.empty() || expected.size() != received.size()) {
+        return false;
+    }
+    uint8_t diff = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        diff |= expected[i] ^ received[i];
+    }
+    return diff == 0;
+}
+
 std::vector<std::string> preprocess_arguments(int argc, char* argv[]) {
     std::vector<std::string> args;
     for (int i = 1; i < argc; ++i) {
@@ -160,6 +160,9 @@ std::vector<ConfigRule> server_rules() {
         {"protocol.internal", "cache_hints", ValueKind::Bool},
         {"protocol.internal", "streaming_verification", ValueKind::Bool},
         {"protocol.internal", "tcp_info_window", ValueKind::Bool},
+        {"protocol.internal", "resume_journal", ValueKind::Bool},
+        {"protocol.internal", "sparse_files", ValueKind::Bool},
+        {"protocol.internal", "block_copy", ValueKind::Bool},
         {"protocol.tls", "enable", ValueKind::Bool},
         {"protocol.tls", "tls_server_cert_file", ValueKind::String},
         {"protocol.tls", "tls_server_key_file", ValueKind::String},
@@ -167,6 +170,7 @@ std::vector<ConfigRule> server_rules() {
         {"protocol.tls", "tls_client_cert_validation", ValueKind::Bool},
         {"protocol.tls", "tls_client_chain_validation", ValueKind::Bool},
         {"protocol.tls", "tls_trusted_chain_file", ValueKind::String},
+        {"protocol.tls", "channel_binding", ValueKind::Bool},
         {"protocol.ssh", "enable", ValueKind::Bool},
         {"protocol.ssh", "port", ValueKind::IntRange, kMinPort, kMaxPort},
         {"protocol.sftp", "enable", ValueKind::Bool},
@@ -177,8 +181,18 @@ std::vector<ConfigRule> server_rules() {
         {"logging", "audit_file", ValueKind::String},
         {"console_output", "enable", ValueKind::Bool},
         {"console_output", "level", ValueKind::Option, 0, 0, log_level_options()},
+        {"metrics", "enable", ValueKind::Bool},
+        {"metrics", "listen_address", ValueKind::String},
+        {"metrics", "port", ValueKind::IntRange, kMinPort, kMaxPort},
         {"performance", "max_file_size", ValueKind::UInt64},
         {"performance", "max_bandwidth_percent", ValueKind::IntRange, 0, kMaxPercent},
+        {"performance", "max_active_streams", ValueKind::IntRange, 0, kMaxConnectionsLimit},
+        {"performance", "memory_budget_bytes", ValueKind::UInt64},
+        {"performance", "chunk_cache_bytes", ValueKind::UInt64},
+        {"performance", "durable_writes", ValueKind::Bool},
+        {"performance", "durable_commit_window_ms", ValueKind::IntRange, 0, 1000},
+        {"performance", "accept_shards", ValueKind::IntRange, 0, 1024},
+        {"performance", "pin_accept_shards", ValueKind::Bool},
         {"performance", "inflight_window_bytes", ValueKind::UInt64},
         {"performance", "batch_bytes", ValueKind::UInt64},
         {"performance", "batch_chunks", ValueKind::IntRange, 1, kMaxBatchChunks},
@@ -187,6 +201,9 @@ std::vector<ConfigRule> server_rules() {
         {"performance", "cache_hints", ValueKind::Bool},
         {"performance", "streaming_verification", ValueKind::Bool},
         {"performance", "tcp_info_window", ValueKind::Bool},
+        {"performance", "resume_journal", ValueKind::Bool},
+        {"performance", "sparse_files", ValueKind::Bool},
+        {"performance", "block_copy", ValueKind::Bool},
         {"integration", "webhook_url", ValueKind::String},
         {"daemon", "run_as_daemon", ValueKind::Bool},
         {"daemon", "pid_file", ValueKind::String},
@@ -207,6 +224,8 @@ std::vector<ConfigRule> client_rules() {
         {"connection", "keep_alive", ValueKind::Bool},
         {"network", "udp", ValueKind::Bool},
         {"network", "socket_buffer_size", ValueKind::IntRange, 0, kMaxSocketBufferSize},
+        {"network", "server_addresses", ValueKind::String},
+        {"network", "local_addresses", ValueKind::String},
         {"protocol", "default_protocol", ValueKind::Option, 0, 0, {kProtocolInternal, kProtocolSsh, kProtocolSftp}},
         {"protocol.internal", "enable", ValueKind::Bool},
         {"protocol.internal", "secret_key", ValueKind::String},
@@ -229,6 +248,9 @@ std::vector<ConfigRule> client_rules() {
         {"protocol.internal", "cache_hints", ValueKind::Bool},
         {"protocol.internal", "streaming_verification", ValueKind::Bool},
         {"protocol.internal", "tcp_info_window", ValueKind::Bool},
+        {"protocol.internal", "download_delta_sync", ValueKind::Bool},
+        {"protocol.internal", "sparse_files", ValueKind::Bool},
+        {"protocol.internal", "block_copy", ValueKind::Bool},
         {"protocol.tls", "enable", ValueKind::Bool},
         {"protocol.tls", "tls_mutual_authentication", ValueKind::Bool},
         {"protocol.tls", "tls_client_cert_file", ValueKind::String},
@@ -236,6 +258,7 @@ std::vector<ConfigRule> client_rules() {
         {"protocol.tls", "tls_server_cert_validation", ValueKind::Bool},
         {"protocol.tls", "tls_server_chain_validation", ValueKind::Bool},
         {"protocol.tls", "tls_trusted_chain_file", ValueKind::String},
+        {"protocol.tls", "channel_binding", ValueKind::Bool},
         {"protocol.ssh", "enable", ValueKind::Bool},
         {"protocol.ssh", "username", ValueKind::String},
         {"protocol.ssh", "private_key_file", ValueKind::String},
@@ -250,6 +273,9 @@ std::vector<ConfigRule> client_rules() {
         {"performance", "cache_hints", ValueKind::Bool},
         {"performance", "streaming_verification", ValueKind::Bool},
         {"performance", "tcp_info_window", ValueKind::Bool},
+        {"performance", "download_delta_sync", ValueKind::Bool},
+        {"performance", "sparse_files", ValueKind::Bool},
+        {"performance", "block_copy", ValueKind::Bool},
         {"logging", "enable", ValueKind::Bool},
         {"logging", "log_level", ValueKind::Option, 0, 0, log_level_options()},
         {"logging", "log_file", ValueKind::String},
@@ -708,6 +734,9 @@ ServerConfig ServerConfig::load_from_file(const std::string& filename) {
     config.internal.cache_hints = get_bool_prefer(parser, "protocol.internal", "cache_hints", "performance", "cache_hints", config.internal.cache_hints);
     config.internal.streaming_verification = get_bool_prefer(parser, "protocol.internal", "streaming_verification", "performance", "streaming_verification", config.internal.streaming_verification);
     config.internal.tcp_info_window = get_bool_prefer(parser, "protocol.internal", "tcp_info_window", "performance", "tcp_info_window", config.internal.tcp_info_window);
+    config.internal.resume_journal = get_bool_prefer(parser, "protocol.internal", "resume_journal", "performance", "resume_journal", config.internal.resume_journal);
+    config.internal.sparse_files = get_bool_prefer(parser, "protocol.internal", "sparse_files", "performance", "sparse_files", config.internal.sparse_files);
+    config.internal.block_copy = get_bool_prefer(parser, "protocol.internal", "block_copy", "performance", "block_copy", config.internal.block_copy);
     
     // Protocol TLS
     config.tls.enable = parser.get_bool("protocol.tls", "enable", config.tls.enable);
@@ -717,6 +746,7 @@ ServerConfig ServerConfig::load_from_file(const std::string& filename) {
     config.tls.client_cert_validation = parser.get_bool("protocol.tls", "tls_client_cert_validation", config.tls.client_cert_validation);
     config.tls.client_chain_validation = parser.get_bool("protocol.tls", "tls_client_chain_validation", config.tls.client_chain_validation);
     config.tls.trusted_chain_file = parser.get_string("protocol.tls", "tls_trusted_chain_file", config.tls.trusted_chain_file);
+    config.tls.channel_binding = parser.get_bool("protocol.tls", "channel_binding", config.tls.channel_binding);
     
     // Protocol SSH
     config.ssh.enable = parser.get_bool("protocol.ssh", "enable", config.ssh.enable);
@@ -736,8 +766,20 @@ ServerConfig ServerConfig::load_from_file(const std::string& filename) {
     config.console.enable = parser.get_bool("console_output", "enable", config.console.enable);
     config.console.level = parser.get_string("console_output", "level", config.console.level);
     
+    // Metrics
+    config.metrics.enable = parser.get_bool("metrics", "enable", config.metrics.enable);
+    config.metrics.listen_address = parser.get_string("metrics", "listen_address", config.metrics.listen_address);
+    config.metrics.port = static_cast<uint16_t>(parser.get_int("metrics", "port", config.metrics.port));
+    
     config.max_file_size = parser.get_uint64("performance", "max_file_size", config.max_file_size);
     config.max_bandwidth_percent = parser.get_int("performance", "max_bandwidth_percent", config.max_bandwidth_percent);
+    config.max_active_streams = parser.get_int("performance", "max_active_streams", config.max_active_streams);
+    config.memory_budget_bytes = parser.get_uint64("performance", "memory_budget_bytes", config.memory_budget_bytes);
+    config.chunk_cache_bytes = parser.get_uint64("performance", "chunk_cache_bytes", config.chunk_cache_bytes);
+    config.durable_writes = parser.get_bool("performance", "durable_writes", config.durable_writes);
+    config.durable_commit_window_ms = parser.get_int("performance", "durable_commit_window_ms", config.durable_commit_window_ms);
+    config.accept_shards = parser.get_int("performance", "accept_shards", config.accept_shards);
+    config.pin_accept_shards = parser.get_bool("performance", "pin_accept_shards", config.pin_accept_shards);
     
     config.webhook_url = parser.get_string("integration", "webhook_url", config.webhook_url);
     
@@ -798,6 +840,9 @@ ServerConfig ServerConfig::get_default() {
     config.internal.cache_hints = kDefaultCacheHints;
     config.internal.streaming_verification = kDefaultStreamingVerification;
     config.internal.tcp_info_window = kDefaultTcpInfoWindow;
+    config.internal.resume_journal = kServerResumeJournal;
+    config.internal.sparse_files = kDefaultSparseFiles;
+    config.internal.block_copy = kDefaultBlockCopy;
 
     config.tls.enable = kServerTlsEnabled;
     config.tls.server_cert_file = "";
@@ -806,6 +851,7 @@ ServerConfig ServerConfig::get_default() {
     config.tls.client_cert_validation = kServerTlsClientCertValidation;
     config.tls.client_chain_validation = kServerTlsClientChainValidation;
     config.tls.trusted_chain_file = "";
+    config.tls.channel_binding = kDefaultTlsChannelBinding;
     
     config.ssh.enable = kServerSshEnabled;
     config.ssh.port = kServerSshPort;
@@ -821,8 +867,19 @@ ServerConfig ServerConfig::get_default() {
     config.console.enable = kServerConsoleEnabled;
     config.console.level = kLogLevelInfo;
     
+    config.metrics.enable = kServerMetricsEnabled;
+    config.metrics.listen_address = kServerMetricsListenAddress;
+    config.metrics.port = kServerMetricsPort;
+    
     config.max_file_size = kUnlimitedFileSize;
     config.max_bandwidth_percent = kDefaultMaxBandwidthPercent;
+    config.max_active_streams = kServerMaxActiveStreams;
+    config.memory_budget_bytes = kServerMemoryBudgetBytes;
+    config.chunk_cache_bytes = kServerChunkCacheBytes;
+    config.durable_writes = kServerDurableWrites;
+    config.durable_commit_window_ms = kServerDurableCommitWindowMs;
+    config.accept_shards = kServerAcceptShards;
+    config.pin_accept_shards = kServerPinAcceptShards;
     config.webhook_url = "";
     config.run_as_daemon = kServerRunAsDaemon;
     config.pid_file = kServerPidFile;
@@ -861,7 +918,10 @@ void ServerConfig::create_default_file(const std::string& filename) {
     stream << "trusted_skip_zero_fill = " << bool_string(config.internal.trusted_skip_zero_fill) << "\n";
     stream << "cache_hints = " << bool_string(config.internal.cache_hints) << "\n";
     stream << "streaming_verification = " << bool_string(config.internal.streaming_verification) << "\n";
-    stream << "tcp_info_window = " << bool_string(config.internal.tcp_info_window) << "\n\n";
+    stream << "tcp_info_window = " << bool_string(config.internal.tcp_info_window) << "\n";
+    stream << "resume_journal = " << bool_string(config.internal.resume_journal) << "\n";
+    stream << "sparse_files = " << bool_string(config.internal.sparse_files) << "\n";
+    stream << "block_copy = " << bool_string(config.internal.block_copy) << "\n\n";
     stream << "[protocol.tls]\n";
     stream << "enable = " << bool_string(config.tls.enable) << "\n";
     stream << "tls_server_cert_file = " << config.tls.server_cert_file << "\n";
@@ -869,7 +929,8 @@ void ServerConfig::create_default_file(const std::string& filename) {
     stream << "tls_dh_file = " << config.tls.dh_file << "\n";
     stream << "tls_client_cert_validation = " << bool_string(config.tls.client_cert_validation) << "\n";
     stream << "tls_client_chain_validation = " << bool_string(config.tls.client_chain_validation) << "\n";
-    stream << "tls_trusted_chain_file = " << config.tls.trusted_chain_file << "\n\n";
+    stream << "tls_trusted_chain_file = " << config.tls.trusted_chain_file << "\n";
+    stream << "channel_binding = " << bool_string(config.tls.channel_binding) << "\n\n";
     stream << "[protocol.ssh]\n";
     stream << "enable = " << bool_string(config.ssh.enable) << "\n";
     stream << "port = " << config.ssh.port << "\n\n";
@@ -884,9 +945,20 @@ void ServerConfig::create_default_file(const std::string& filename) {
     stream << "[console_output]\n";
     stream << "enable = " << bool_string(config.console.enable) << "\n";
     stream << "level = " << config.console.level << "\n\n";
+    stream << "[metrics]\n";
+    stream << "enable = " << bool_string(config.metrics.enable) << "\n";
+    stream << "listen_address = " << config.metrics.listen_address << "\n";
+    stream << "port = " << config.metrics.port << "\n\n";
     stream << "[performance]\n";
     stream << "max_file_size = " << config.max_file_size << "\n";
-    stream << "max_bandwidth_percent = " << config.max_bandwidth_percent << "\n\n";
+    stream << "max_bandwidth_percent = " << config.max_bandwidth_percent << "\n";
+    stream << "max_active_streams = " << config.max_active_streams << "\n";
+    stream << "memory_budget_bytes = " << config.memory_budget_bytes << "\n";
+    stream << "chunk_cache_bytes = " << config.chunk_cache_bytes << "\n";
+    stream << "durable_writes = " << bool_string(config.durable_writes) << "\n";
+    stream << "durable_commit_window_ms = " << config.durable_commit_window_ms << "\n";
+    stream << "accept_shards = " << config.accept_shards << "\n";
+    stream << "pin_accept_shards = " << bool_string(config.pin_accept_shards) << "\n\n";
     stream << "[integration]\n";
     stream << "webhook_url = " << config.webhook_url << "\n\n";
     stream << "[daemon]\n";
@@ -909,6 +981,16 @@ std::vector<ConfigValidationIssue> ServerConfig::validate_file(const std::string
     return validate_file_with_rules(filename, server_rules());
 }
 
+const std::vector<std::string>& ServerConfig::reloadable_keys() {
+    static const std::vector<std::string> keys = {
+        "max_file_size", "max_active_streams", "memory_budget_bytes", "chunk_cache_bytes",
+        "durable_writes", "durable_commit_window_ms", "inflight_window_bytes", "batch_bytes",
+        "batch_chunks", "preallocate_files", "trusted_skip_zero_fill", "cache_hints",
+        "streaming_verification", "tcp_info_window", "resume_journal", "sparse_files", "block_copy",
+    };
+    return keys;
+}
+
 // ClientConfig implementation
 ClientConfig ClientConfig::load_from_file(const std::string& filename) {
     auto issues = validate_file(filename);
@@ -925,6 +1007,8 @@ ClientConfig ClientConfig::load_from_file(const std::string& filename) {
     config.keep_alive = parser.get_bool("connection", "keep_alive", config.keep_alive);
     config.udp = parser.get_bool("network", "udp", config.udp);
     config.socket_buffer_size = parser.get_int("network", "socket_buffer_size", config.socket_buffer_size);
+    config.server_addresses = parser.get_string_list("network", "server_addresses", config.server_addresses);
+    config.local_addresses = parser.get_string_list("network", "local_addresses", config.local_addresses);
     
     config.default_protocol = parser.get_string("protocol", "default_protocol", config.default_protocol);
     
@@ -957,6 +1041,9 @@ ClientConfig ClientConfig::load_from_file(const std::string& filename) {
     config.internal.cache_hints = get_bool_prefer(parser, "protocol.internal", "cache_hints", "performance", "cache_hints", config.internal.cache_hints);
     config.internal.streaming_verification = get_bool_prefer(parser, "protocol.internal", "streaming_verification", "performance", "streaming_verification", config.internal.streaming_verification);
     config.internal.tcp_info_window = get_bool_prefer(parser, "protocol.internal", "tcp_info_window", "performance", "tcp_info_window", config.internal.tcp_info_window);
+    config.internal.download_delta_sync = get_bool_prefer(parser, "protocol.internal", "download_delta_sync", "performance", "download_delta_sync", config.internal.download_delta_sync);
+    config.internal.sparse_files = get_bool_prefer(parser, "protocol.internal", "sparse_files", "performance", "sparse_files", config.internal.sparse_files);
+    config.internal.block_copy = get_bool_prefer(parser, "protocol.internal", "block_copy", "performance", "block_copy", config.internal.block_copy);
     
     // Protocol TLS
     config.tls.enable = parser.get_bool("protocol.tls", "enable", config.tls.enable);
@@ -966,6 +1053,7 @@ ClientConfig ClientConfig::load_from_file(const std::string& filename) {
     config.tls.server_cert_validation = parser.get_bool("protocol.tls", "tls_server_cert_validation", config.tls.server_cert_validation);
     config.tls.server_chain_validation = parser.get_bool("protocol.tls", "tls_server_chain_validation", config.tls.server_chain_validation);
     config.tls.trusted_chain_file = parser.get_string("protocol.tls", "tls_trusted_chain_file", config.tls.trusted_chain_file);
+    config.tls.channel_binding = parser.get_bool("protocol.tls", "channel_binding", config.tls.channel_binding);
     
     // Protocol SSH
     config.ssh.enable = parser.get_bool("protocol.ssh", "enable", config.ssh.enable);
@@ -1053,6 +1141,9 @@ ClientConfig ClientConfig::get_default() {
     config.internal.cache_hints = kDefaultCacheHints;
     config.internal.streaming_verification = kDefaultStreamingVerification;
     config.internal.tcp_info_window = kDefaultTcpInfoWindow;
+    config.internal.download_delta_sync = kClientDownloadDeltaSync;
+    config.internal.sparse_files = kDefaultSparseFiles;
+    config.internal.block_copy = kDefaultBlockCopy;
 
     config.tls.enable = kClientTlsEnabled;
     config.tls.mutual_authentication = kClientTlsMutualAuthentication;
@@ -1061,6 +1152,7 @@ ClientConfig ClientConfig::get_default() {
     config.tls.server_cert_validation = kClientTlsServerCertValidation;
     config.tls.server_chain_validation = kClientTlsServerChainValidation;
     config.tls.trusted_chain_file = "";
+    config.tls.channel_binding = kDefaultTlsChannelBinding;
     
     config.ssh.enable = kClientSshEnabled;
     config.ssh.username = "";
@@ -1106,7 +1198,9 @@ void ClientConfig::create_default_file(const std::string& filename) {
     stream << "keep_alive = " << bool_string(config.keep_alive) << "\n\n";
     stream << "[network]\n";
     stream << "udp = " << bool_string(config.udp) << "\n";
-    stream << "socket_buffer_size = " << config.socket_buffer_size << "\n\n";
+    stream << "socket_buffer_size = " << config.socket_buffer_size << "\n";
+    stream << "server_addresses = \n";
+    stream << "local_addresses = \n\n";
     stream << "[protocol]\n";
     stream << "default_protocol = " << config.default_protocol << "\n\n";
     stream << "[protocol.internal]\n";
@@ -1130,7 +1224,10 @@ void ClientConfig::create_default_file(const std::string& filename) {
     stream << "preallocate_files = " << bool_string(config.internal.preallocate_files) << "\n";
     stream << "cache_hints = " << bool_string(config.internal.cache_hints) << "\n";
     stream << "streaming_verification = " << bool_string(config.internal.streaming_verification) << "\n";
-    stream << "tcp_info_window = " << bool_string(config.internal.tcp_info_window) << "\n\n";
+    stream << "tcp_info_window = " << bool_string(config.internal.tcp_info_window) << "\n";
+    stream << "download_delta_sync = " << bool_string(config.internal.download_delta_sync) << "\n";
+    stream << "sparse_files = " << bool_string(config.internal.sparse_files) << "\n";
+    stream << "block_copy = " << bool_string(config.internal.block_copy) << "\n\n";
     stream << "[protocol.tls]\n";
     stream << "enable = " << bool_string(config.tls.enable) << "\n";
     stream << "tls_mutual_authentication = " << bool_string(config.tls.mutual_authentication) << "\n";
@@ -1138,7 +1235,8 @@ void ClientConfig::create_default_file(const std::string& filename) {
     stream << "tls_client_key_file = " << config.tls.client_key_file << "\n";
     stream << "tls_server_cert_validation = " << bool_string(config.tls.server_cert_validation) << "\n";
     stream << "tls_server_chain_validation = " << bool_string(config.tls.server_chain_validation) << "\n";
-    stream << "tls_trusted_chain_file = " << config.tls.trusted_chain_file << "\n\n";
+    stream << "tls_trusted_chain_file = " << config.tls.trusted_chain_file << "\n";
+    stream << "channel_binding = " << bool_string(config.tls.channel_binding) << "\n\n";
     stream << "[protocol.ssh]\n";
     stream << "enable = " << bool_string(config.ssh.enable) << "\n";
     stream << "username = " << config.ssh.username << "\n";
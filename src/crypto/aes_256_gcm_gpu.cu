@@ -1,6 +1,7 @@
 #include "crypto/aes_256_gcm_gpu.h"
 #include "crypto/aes_ctr.h"  // Fallback to CPU AES if GPU not available
 #include "common/utils.h"
+#include "crypto/random.h"
 #include <algorithm>
 #include <random>
 #include <chrono>
@@ -388,15 +389,13 @@ std::vector<uint8_t> Aes256GcmGpu::decrypt(const std::vector<uint8_t>& ciphertex
 
 Aes256GcmGpu::Key Aes256GcmGpu::generate_key() {
     Key key;
-    auto random_bytes = common::generate_random_bytes(KEY_SIZE);
-    std::copy(random_bytes.begin(), random_bytes.end(), key.begin());
+    secure_random(key.data(), key.size());
     return key;
 }
 
 Aes256GcmGpu::IV Aes256GcmGpu::generate_iv() {
     IV iv;
-    auto random_bytes = common::generate_random_bytes(IV_SIZE);
-    std::copy(random_bytes.begin(), random_bytes.end(), iv.begin());
+    secure_random(iv.data(), iv.size());
     return iv;
 }
 
@@ -1,5 +1,5 @@
 #include "crypto/aes_ctr.h"
-#include <random>
+#include "crypto/random.h"
 #include <chrono>
 #include <cstring>
 #include <algorithm>
@@ -109,31 +109,13 @@ void AesCtr::reset() {
 
 AesCtr::Key AesCtr::generate_key() {
     Key key;
-    
-    // Use high-resolution clock for better randomness
-    auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    std::mt19937_64 gen(seed);
-    std::uniform_int_distribution<uint16_t> dist(0, 255);
-    
-    for (auto& byte : key) {
-        byte = static_cast<uint8_t>(dist(gen));
-    }
-    
+    secure_random(key.data(), key.size());
     return key;
 }
 
 AesCtr::IV AesCtr::generate_iv() {
     IV iv;
-    
-    // Use high-resolution clock for better randomness
-    auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    std::mt19937_64 gen(seed);
-    std::uniform_int_distribution<uint16_t> dist(0, 255);
-    
-    for (auto& byte : iv) {
-        byte = static_cast<uint8_t>(dist(gen));
-    }
-    
+    secure_random(iv.data(), iv.size());
     return iv;
 }
 
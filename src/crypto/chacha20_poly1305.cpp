@@ -1,7 +1,7 @@
 #include "crypto/chacha20_poly1305.h"
 #include "exceptions.h"
 #include "common/fast_mem.h"
-#include <random>
+#include "crypto/random.h"
 #include <cstring>
 #include <algorithm>
 
@@ -320,29 +320,18 @@ std::vector<uint8_t> ChaCha20Poly1305::decrypt(const std::vector<uint8_t>& ciphe
 }
 
 ChaCha20Poly1305::Key ChaCha20Poly1305::generate_key() {
-    Key key;
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<uint16_t> dis(0, 255);
-    
-    for (auto& byte : key) {
-        byte = static_cast<uint8_t>(dis(gen));
-    }
-    
-    return key;
+    return secure_random_array<KEY_SIZE>();
 }
 
 ChaCha20Poly1305::Nonce ChaCha20Poly1305::generate_nonce() {
-    Nonce nonce;
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<uint16_t> dis(0, 255);
-    
-    for (auto& byte : nonce) {
-        byte = static_cast<uint8_t>(dis(gen));
-    }
-    
-    return nonce;
+    return secure_random_array<NONCE_SIZE>();
+}
+
+void ChaCha20Poly1305::keystream(const Key& key, const Nonce& nonce, uint32_t counter,
+                                 uint8_t* output, size_t length) {
+    std::memset(output, 0, length);
+    ChaCha20 chacha(key, nonce, counter);
+    chacha.encrypt(output, length);
 }
 
 ChaCha20Poly1305::Key ChaCha20Poly1305::derive_key(const std::string& password, 
@@ -0,0 +1,198 @@
+#include "crypto/cipher_benchmark.h"
+#include "crypto/crypto_engine.h"
+#include "common/utils.h"
+#include "logging/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+    #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+#endif
+
+namespace netcopy {
+namespace crypto {
+
+namespace {
+
+constexpr const char* kCacheFile = "cipher_rates.cache";
+constexpr const char* kBenchKey = "0x000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+constexpr size_t kBenchBufferSize = 1024 * 1024;
+constexpr std::chrono::milliseconds kBenchDuration{100};
+
+#if defined(_WIN32) && (defined(_M_X64) || defined(_M_IX86))
+bool read_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+    int info[4];
+    __cpuid(info, 0);
+    if (static_cast<uint32_t>(info[0]) < leaf && leaf < 0x80000000u) {
+        return false;
+    }
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) {
+        regs[i] = static_cast<uint32_t>(info[i]);
+    }
+    return true;
+}
+#define NETCOPY_HAS_CPUID 1
+#elif !defined(_WIN32) && (defined(__x86_64__) || defined(__i386__))
+bool read_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+    if (leaf < 0x80000000u && __get_cpuid_max(0, nullptr) < leaf) {
+        return false;
+    }
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+    return true;
+}
+#define NETCOPY_HAS_CPUID 1
+#endif
+
+// Encrypts and decrypts the buffer repeatedly; MB/s of data processed, 0
+// when the engine is unusable
+uint32_t measure_engine(SecurityLevel level, const std::vector<uint8_t>& buffer) {
+    try {
+        auto engine = create_crypto_engine(level, kBenchKey);
+        auto round = [&]() { return engine->decrypt(engine->encrypt(buffer)).size(); };
+        // Warm-up (tables, GPU context) doubling as a self-test: an engine
+        // that cannot round-trip on this build must never be negotiated
+        if (engine->decrypt(engine->encrypt(buffer)) != buffer) {
+            LOG_WARNING("Cipher benchmark: round trip mismatch");
+            return 0;
+        }
+
+        uint64_t processed = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::steady_clock::duration::zero();
+        do {
+            processed += 2 * round();
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed < kBenchDuration);
+
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        return static_cast<uint32_t>((std::max)(1.0, static_cast<double>(processed) / seconds / 1e6));
+    } catch (const std::exception& e) {
+        LOG_WARNING("Cipher benchmark failed: " + std::string(e.what()));
+        return 0;
+    }
+}
+
+std::string cache_path() {
+    return (std::filesystem::path(common::get_config_directory()) / kCacheFile).string();
+}
+
+bool load_cached_rates(const std::string& signature, CipherRates& rates) {
+    std::ifstream in(cache_path());
+    std::string line;
+    if (!std::getline(in, line) || line != signature) {
+        return false;
+    }
+    CipherRates loaded;
+    std::string name;
+    uint32_t value = 0;
+    while (in >> name >> value) {
+        if (name == "chacha20_poly1305") {
+            loaded.chacha20_poly1305 = value;
+        } else if (name == "aes_256_gcm") {
+            loaded.aes_256_gcm = value;
+        }
+    }
+    if (!loaded.known()) {
+        return false;
+    }
+    rates = loaded;
+    return true;
+}
+
+void store_cached_rates(const std::string& signature, const CipherRates& rates) {
+    std::error_code ec;
+    std::filesystem::create_directories(common::get_config_directory(), ec);
+    std::ofstream out(cache_path(), std::ios::trunc);
+    if (!out) {
+        LOG_DEBUG("Cannot write cipher benchmark cache " + cache_path());
+        return;
+    }
+    out << signature << "\n"
+        << "chacha20_poly1305 " << rates.chacha20_poly1305 << "\n"
+        << "aes_256_gcm " << rates.aes_256_gcm << "\n";
+}
+
+} // namespace
+
+std::string cpu_signature() {
+    std::ostringstream signature;
+    // A new build may have faster engines, so it measures again
+    signature << common::get_version_string();
+#ifdef NETCOPY_HAS_CPUID
+    uint32_t regs[4] = {0, 0, 0, 0};
+    char brand[49] = {};
+    if (read_cpuid(0x80000000u, 0, regs) && regs[0] >= 0x80000004u) {
+        for (uint32_t i = 0; i < 3; ++i) {
+            read_cpuid(0x80000002u + i, 0, regs);
+            std::memcpy(brand + i * 16, regs, 16);
+        }
+    }
+    signature << "|" << brand;
+    bool aes_ni = read_cpuid(1, 0, regs) && (regs[2] & (1u << 25)) != 0;
+    bool vaes = false;
+    bool avx512 = false;
+    if (read_cpuid(7, 0, regs)) {
+        vaes = (regs[2] & (1u << 9)) != 0;
+        avx512 = (regs[1] & (1u << 16)) != 0;
+    }
+    signature << "|aesni=" << aes_ni << "|vaes=" << vaes << "|avx512=" << avx512;
+#else
+    signature << "|generic";
+#endif
+    signature << "|threads=" << std::thread::hardware_concurrency();
+    return signature.str();
+}
+
+CipherRates measure_cipher_rates() {
+    std::vector<uint8_t> buffer(kBenchBufferSize);
+    std::mt19937 rng(0x6e6574u);
+    std::generate(buffer.begin(), buffer.end(), [&]() { return static_cast<uint8_t>(rng()); });
+
+    CipherRates rates;
+    rates.chacha20_poly1305 = measure_engine(SecurityLevel::HIGH, buffer);
+    rates.aes_256_gcm = measure_engine(SecurityLevel::AES_256_GCM, buffer);
+    return rates;
+}
+
+const CipherRates& local_cipher_rates() {
+    static const CipherRates rates = []() {
+        const std::string signature = cpu_signature();
+        CipherRates result;
+        if (load_cached_rates(signature, result)) {
+            LOG_DEBUG("Cipher rates from cache: ChaCha20-Poly1305 " + std::to_string(result.chacha20_poly1305) +
+                      " MB/s, AES-256-GCM " + std::to_string(result.aes_256_gcm) + " MB/s");
+            return result;
+        }
+        result = measure_cipher_rates();
+        LOG_INFO("Measured cipher rates: ChaCha20-Poly1305 " + std::to_string(result.chacha20_poly1305) +
+                 " MB/s, AES-256-GCM " + std::to_string(result.aes_256_gcm) + " MB/s");
+        if (result.known()) {
+            store_cached_rates(signature, result);
+        }
+        return result;
+    }();
+    return rates;
+}
+
+SecurityLevel choose_fastest_cipher(const CipherRates& local, const CipherRates& peer) {
+    if (!local.known() || !peer.known()) {
+        return SecurityLevel::HIGH;
+    }
+    uint32_t chacha = (std::min)(local.chacha20_poly1305, peer.chacha20_poly1305);
+    uint32_t gcm = (std::min)(local.aes_256_gcm, peer.aes_256_gcm);
+    return gcm > chacha ? SecurityLevel::AES_256_GCM : SecurityLevel::HIGH;
+}
+
+} // namespace crypto
+} // namespace netcopy
@@ -7,8 +7,7 @@ namespace netcopy {
 namespace crypto {
 
 // HighSecurityEngine implementation
-HighSecurityEngine::HighSecurityEngine(const std::string& password) 
-    : nonce_counter_(0) {
+HighSecurityEngine::HighSecurityEngine(const std::string& password) {
     // Convert hex string to key (like the legacy implementation)
     std::string hex_key = password;
     if (hex_key.length() > 2 && hex_key.substr(0, 2) == "0x") {
@@ -26,14 +25,12 @@ HighSecurityEngine::HighSecurityEngine(const std::string& password)
     }
     
     cipher_ = std::make_unique<ChaCha20Poly1305>(key);
-    
-    // Initialize nonce
-    current_nonce_.fill(0);
 }
 
 std::vector<uint8_t> HighSecurityEngine::encrypt(const std::vector<uint8_t>& data) {
-    // Use exactly the same logic as the legacy implementation
-    auto nonce = ChaCha20Poly1305::generate_nonce();
+    // Counter nonce: no randomness per message, and the receiver reads the
+    // nonce from the message as before
+    auto nonce = nonces_.next();
     auto encrypted = cipher_->encrypt(data, nonce);
     
     // Prepend nonce to encrypted data
@@ -72,16 +69,7 @@ std::vector<uint8_t> HighSecurityEngine::decrypt(const std::vector<uint8_t>& dat
 }
 
 void HighSecurityEngine::reset() {
-    nonce_counter_ = 0;
-    current_nonce_.fill(0);
-}
-
-void HighSecurityEngine::increment_nonce() {
-    ++nonce_counter_;
-    // Convert counter to bytes in little-endian format
-    for (size_t i = 0; i < sizeof(nonce_counter_) && i < current_nonce_.size(); ++i) {
-        current_nonce_[i] = static_cast<uint8_t>((nonce_counter_ >> (i * 8)) & 0xFF);
-    }
+    // The nonce sequence never rewinds: the key stays the same
 }
 
 // FastSecurityEngine implementation
@@ -148,7 +136,8 @@ AesSecurityEngine::AesSecurityEngine(const std::string& password)
 }
 
 std::vector<uint8_t> AesSecurityEngine::encrypt(const std::vector<uint8_t>& data) {
-    // Generate a random IV for CTR mode
+    // Random IV for CTR mode: each IV starts a 2^128 block counter, so
+    // sequential IVs would overlap the keystreams of consecutive messages
     auto iv = AesCtr::generate_iv();
     
     // Encrypt the data
@@ -206,7 +195,7 @@ bool AesSecurityEngine::is_using_hardware_acceleration() const {
 
 // GpuSecurityEngine implementation
 GpuSecurityEngine::GpuSecurityEngine(const std::string& password) 
-    : secret_key_(password), iv_counter_(0) {
+    : secret_key_(password) {
     // Parse hex key and create Aes256GcmGpu
     std::string hex_key = password;
     if (hex_key.length() > 2 && hex_key.substr(0, 2) == "0x") {
@@ -224,14 +213,11 @@ GpuSecurityEngine::GpuSecurityEngine(const std::string& password)
     }
     
     cipher_ = std::make_unique<Aes256GcmGpu>(key);
-    
-    // Initialize IV
-    current_iv_.fill(0);
 }
 
 std::vector<uint8_t> GpuSecurityEngine::encrypt(const std::vector<uint8_t>& data) {
-    // Generate a random IV for GCM mode
-    auto iv = Aes256GcmGpu::generate_iv();
+    // Counter IV: GCM needs uniqueness per key, not unpredictability
+    auto iv = ivs_.next();
     
     // Encrypt the data (returns ciphertext + authentication tag)
     auto result = cipher_->encrypt(data, iv);
@@ -282,16 +268,7 @@ std::vector<uint8_t> GpuSecurityEngine::decrypt(const std::vector<uint8_t>& data
 }
 
 void GpuSecurityEngine::reset() {
-    iv_counter_ = 0;
-    current_iv_.fill(0);
-}
-
-void GpuSecurityEngine::increment_iv() {
-    ++iv_counter_;
-    // Convert counter to bytes in little-endian format
-    for (size_t i = 0; i < sizeof(iv_counter_) && i < current_iv_.size(); ++i) {
-        current_iv_[i] = static_cast<uint8_t>((iv_counter_ >> (i * 8)) & 0xFF);
-    }
+    // The IV sequence never rewinds: the key stays the same
 }
 
 std::string GpuSecurityEngine::get_acceleration_info() const {
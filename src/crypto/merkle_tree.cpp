@@ -0,0 +1,304 @@
+#include "crypto/merkle_tree.h"
+#include "crypto/xxhash64.h"
+#include <algorithm>
+#include <cstring>
+
+namespace netcopy {
+namespace crypto {
+
+namespace {
+
+constexpr uint64_t kLeafSeed = 0;
+constexpr uint64_t kNodeSeed = 1;
+constexpr size_t kFinishReadSize = 1024 * 1024;
+
+MerkleTree::Hash to_hash(const std::vector<uint8_t>& digest) {
+    MerkleTree::Hash hash{};
+    std::memcpy(hash.data(), digest.data(), (std::min)(digest.size(), hash.size()));
+    return hash;
+}
+
+const std::vector<uint8_t>& zero_block() {
+    static const std::vector<uint8_t> zeros(kFinishReadSize, 0);
+    return zeros;
+}
+
+} // namespace
+
+// Hash state of a leaf that has so far been written in order
+struct MerkleTree::PartialLeaf {
+    std::mutex mutex;
+    XxHash64Hasher hasher{kLeafSeed};
+    uint64_t next_offset = 0;
+};
+
+MerkleTree::MerkleTree(uint64_t data_size, uint64_t leaf_size)
+    : data_size_(data_size),
+      leaf_size_(leaf_size == 0 ? kDefaultLeafSize : (std::max)(leaf_size, kMinLeafSize)) {
+    leaf_count_ = data_size_ == 0 ? 1 : (data_size_ + leaf_size_ - 1) / leaf_size_;
+    states_.assign(leaf_count_, LeafState::Empty);
+    leaf_hashes_.resize(leaf_count_);
+}
+
+std::pair<uint64_t, uint64_t> MerkleTree::leaf_range(uint64_t leaf) const {
+    uint64_t start = leaf * leaf_size_;
+    if (start >= data_size_) {
+        return {data_size_, 0};
+    }
+    return {start, (std::min)(leaf_size_, data_size_ - start)};
+}
+
+MerkleTree::Hash MerkleTree::hash_node(const Hash& left, const Hash& right) {
+    uint8_t pair[kHashSize * 2];
+    std::memcpy(pair, left.data(), kHashSize);
+    std::memcpy(pair + kHashSize, right.data(), kHashSize);
+    return to_hash(xxhash64_bytes(pair, sizeof(pair), kNodeSeed));
+}
+
+void MerkleTree::update(uint64_t offset, const uint8_t* data, size_t size) {
+    while (size > 0 && offset < data_size_) {
+        uint64_t leaf = offset / leaf_size_;
+        auto range = leaf_range(leaf);
+        size_t piece = static_cast<size_t>((std::min)(static_cast<uint64_t>(size),
+                                                      range.first + range.second - offset));
+        feed_leaf(leaf, offset, data, piece);
+        offset += piece;
+        data += piece;
+        size -= piece;
+    }
+}
+
+void MerkleTree::feed_leaf(uint64_t leaf, uint64_t offset, const uint8_t* data, size_t size) {
+    auto range = leaf_range(leaf);
+    const uint64_t leaf_end = range.first + range.second;
+
+    std::shared_ptr<PartialLeaf> partial;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (offset == range.first) {
+            // A write at the leaf start (first pass or retransmission) restarts it
+            partial = std::make_shared<PartialLeaf>();
+            partial->next_offset = range.first;
+            partial_[leaf] = partial;
+            states_[leaf] = LeafState::Partial;
+            levels_dirty_ = true;
+        } else {
+            auto it = partial_.find(leaf);
+            if (it != partial_.end()) {
+                partial = it->second;
+            } else {
+                // Out of order, or rewriting a hashed leaf: re-read in finish()
+                states_[leaf] = LeafState::Deferred;
+                levels_dirty_ = true;
+                return;
+            }
+        }
+    }
+
+    bool in_order = false;
+    bool complete = false;
+    Hash digest{};
+    {
+        std::lock_guard<std::mutex> partial_lock(partial->mutex);
+        if (partial->next_offset == offset) {
+            in_order = true;
+            partial->hasher.update(data, size);
+            partial->next_offset += size;
+            if (partial->next_offset == leaf_end) {
+                complete = true;
+                digest = to_hash(partial->hasher.finalize());
+            }
+        }
+    }
+
+    if (in_order && !complete) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = partial_.find(leaf);
+    // Another write restarted or deferred the leaf meanwhile
+    if (it == partial_.end() || it->second != partial) {
+        return;
+    }
+    partial_.erase(it);
+    if (complete) {
+        leaf_hashes_[leaf] = digest;
+        states_[leaf] = LeafState::Done;
+    } else {
+        states_[leaf] = LeafState::Deferred;
+    }
+    levels_dirty_ = true;
+}
+
+MerkleTree::Hash MerkleTree::zero_leaf_hash(uint64_t size) {
+    const bool full_leaf = size == leaf_size_;
+    if (full_leaf) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (zero_leaf_hash_ready_) {
+            return zero_leaf_hash_;
+        }
+    }
+    const auto& zeros = zero_block();
+    XxHash64Hasher hasher(kLeafSeed);
+    for (uint64_t done = 0; done < size;) {
+        size_t piece = static_cast<size_t>((std::min)(static_cast<uint64_t>(zeros.size()), size - done));
+        hasher.update(zeros.data(), piece);
+        done += piece;
+    }
+    Hash digest = to_hash(hasher.finalize());
+    if (full_leaf) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        zero_leaf_hash_ = digest;
+        zero_leaf_hash_ready_ = true;
+    }
+    return digest;
+}
+
+void MerkleTree::update_zeros(uint64_t offset, uint64_t length) {
+    const auto& zeros = zero_block();
+    const uint64_t end = (std::min)(data_size_, offset + length);
+    while (offset < end) {
+        uint64_t leaf = offset / leaf_size_;
+        auto range = leaf_range(leaf);
+        uint64_t piece = (std::min)(end, range.first + range.second) - offset;
+        if (offset == range.first && piece == range.second) {
+            Hash digest = zero_leaf_hash(range.second);
+            std::lock_guard<std::mutex> lock(mutex_);
+            partial_.erase(leaf);
+            leaf_hashes_[leaf] = digest;
+            states_[leaf] = LeafState::Done;
+            levels_dirty_ = true;
+        } else {
+            for (uint64_t done = 0; done < piece;) {
+                size_t part = static_cast<size_t>((std::min)(static_cast<uint64_t>(zeros.size()), piece - done));
+                feed_leaf(leaf, offset + done, zeros.data(), part);
+                done += part;
+            }
+        }
+        offset += piece;
+    }
+}
+
+void MerkleTree::invalidate(uint64_t offset, uint64_t length) {
+    if (length == 0 || offset >= data_size_) {
+        return;
+    }
+    const uint64_t first = offset / leaf_size_;
+    const uint64_t last = ((std::min)(data_size_, offset + length) - 1) / leaf_size_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint64_t leaf = first; leaf <= last; ++leaf) {
+        partial_.erase(leaf);
+        states_[leaf] = LeafState::Deferred;
+    }
+    levels_dirty_ = true;
+}
+
+uint64_t MerkleTree::pending_leaves() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<uint64_t>(std::count_if(states_.begin(), states_.end(),
+                                               [](LeafState s) { return s != LeafState::Done; }));
+}
+
+bool MerkleTree::finish(const ReadAt& read_at) {
+    std::vector<uint64_t> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint64_t leaf = 0; leaf < leaf_count_; ++leaf) {
+            if (states_[leaf] != LeafState::Done) {
+                pending.push_back(leaf);
+            }
+        }
+    }
+    if (pending.empty()) {
+        return true;
+    }
+
+    std::vector<uint8_t> buffer(static_cast<size_t>((std::min)(leaf_size_, static_cast<uint64_t>(kFinishReadSize))));
+    for (uint64_t leaf : pending) {
+        auto range = leaf_range(leaf);
+        XxHash64Hasher hasher(kLeafSeed);
+        uint64_t done = 0;
+        while (done < range.second) {
+            size_t want = static_cast<size_t>((std::min)(static_cast<uint64_t>(buffer.size()), range.second - done));
+            size_t got = read_at(range.first + done, buffer.data(), want);
+            if (got == 0) {
+                return false;
+            }
+            hasher.update(buffer.data(), got);
+            done += got;
+        }
+        Hash digest = to_hash(hasher.finalize());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        partial_.erase(leaf);
+        leaf_hashes_[leaf] = digest;
+        states_[leaf] = LeafState::Done;
+        levels_dirty_ = true;
+    }
+    return true;
+}
+
+void MerkleTree::build_levels_locked() {
+    if (!levels_dirty_) {
+        return;
+    }
+    levels_.clear();
+    levels_.push_back(leaf_hashes_);
+    while (levels_.back().size() > 1) {
+        const auto& below = levels_.back();
+        std::vector<Hash> above;
+        above.reserve((below.size() + 1) / 2);
+        for (size_t i = 0; i + 1 < below.size(); i += 2) {
+            above.push_back(hash_node(below[i], below[i + 1]));
+        }
+        if (below.size() % 2 != 0) {
+            above.push_back(below.back());
+        }
+        levels_.push_back(std::move(above));
+    }
+    levels_dirty_ = false;
+}
+
+std::vector<uint8_t> MerkleTree::root() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (LeafState state : states_) {
+        if (state != LeafState::Done) {
+            return {};
+        }
+    }
+    build_levels_locked();
+    const Hash& top = levels_.back().front();
+    return std::vector<uint8_t>(top.begin(), top.end());
+}
+
+uint32_t MerkleTree::depth() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    build_levels_locked();
+    return static_cast<uint32_t>(levels_.size());
+}
+
+uint64_t MerkleTree::level_width(uint32_t level) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    build_levels_locked();
+    return level < levels_.size() ? levels_[level].size() : 0;
+}
+
+std::vector<std::vector<uint8_t>> MerkleTree::nodes(uint32_t level, const std::vector<uint64_t>& indices) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    build_levels_locked();
+    std::vector<std::vector<uint8_t>> out;
+    out.reserve(indices.size());
+    for (uint64_t index : indices) {
+        if (level < levels_.size() && index < levels_[level].size()) {
+            const Hash& hash = levels_[level][index];
+            out.emplace_back(hash.begin(), hash.end());
+        } else {
+            out.emplace_back();
+        }
+    }
+    return out;
+}
+
+} // namespace crypto
+} // namespace netcopy
@@ -0,0 +1,200 @@
+#include "crypto/random.h"
+#include "crypto/chacha20_poly1305.h"
+#include "exceptions.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <bcrypt.h>
+#  pragma comment(lib, "bcrypt.lib")
+#else
+#  include <fcntl.h>
+#  include <pthread.h>
+#  include <unistd.h>
+#  if defined(__linux__) || defined(__APPLE__)
+#    include <sys/random.h>
+#  endif
+#endif
+
+namespace netcopy {
+namespace crypto {
+
+namespace {
+
+// Output between reseeds from the OS
+constexpr uint64_t kReseedBytes = 4ull * 1024 * 1024;
+// Keystream generated per refill: the next key plus this many output bytes
+constexpr size_t kBufferBytes = 768;
+
+// Wipes memory in a way the optimizer may not drop
+void secure_wipe(void* data, size_t length) {
+    volatile uint8_t* bytes = static_cast<volatile uint8_t*>(data);
+    while (length--) {
+        *bytes++ = 0;
+    }
+}
+
+#ifndef _WIN32
+bool read_dev_urandom(uint8_t* out, size_t length) {
+    int fd = ::open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    size_t filled = 0;
+    while (filled < length) {
+        ssize_t got = ::read(fd, out + filled, length - filled);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;
+        }
+        filled += static_cast<size_t>(got);
+    }
+    ::close(fd);
+    return filled == length;
+}
+
+// Bumped in every child after fork(), so a child never continues its
+// parent's stream
+std::atomic<uint64_t> g_fork_generation{0};
+
+void on_fork_child() {
+    g_fork_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+void register_fork_handler() {
+    static const bool registered = []() {
+        return pthread_atfork(nullptr, nullptr, on_fork_child) == 0;
+    }();
+    (void)registered;
+}
+#endif
+
+class ThreadDrbg {
+public:
+    ~ThreadDrbg() {
+        secure_wipe(key_.data(), key_.size());
+        secure_wipe(buffer_, sizeof(buffer_));
+    }
+
+    void fill(uint8_t* out, size_t length) {
+        if (needs_reseed()) {
+            reseed();
+        }
+        while (length > 0) {
+            if (available_ == 0) {
+                refill();
+            }
+            const size_t take = (std::min)(length, available_);
+            uint8_t* source = buffer_ + (sizeof(buffer_) - available_);
+            std::memcpy(out, source, take);
+            // Served bytes must not stay around to be read back later
+            secure_wipe(source, take);
+            available_ -= take;
+            out += take;
+            length -= take;
+            since_reseed_ += take;
+        }
+    }
+
+private:
+    bool needs_reseed() const {
+#ifndef _WIN32
+        if (fork_generation_ != g_fork_generation.load(std::memory_order_relaxed)) {
+            return true;
+        }
+#endif
+        return !seeded_ || since_reseed_ >= kReseedBytes;
+    }
+
+    void reseed() {
+#ifndef _WIN32
+        register_fork_handler();
+        fork_generation_ = g_fork_generation.load(std::memory_order_relaxed);
+#endif
+        os_random(key_.data(), key_.size());
+        secure_wipe(buffer_, sizeof(buffer_));
+        available_ = 0;
+        since_reseed_ = 0;
+        seeded_ = true;
+    }
+
+    // Fast key erasure: the first 32 keystream bytes become the next key,
+    // the rest is output. The nonce can stay fixed as every key is used once.
+    void refill() {
+        static const ChaCha20Poly1305::Nonce kNonce{};
+        uint8_t block[ChaCha20Poly1305::KEY_SIZE + kBufferBytes];
+        ChaCha20Poly1305::keystream(key_, kNonce, 0, block, sizeof(block));
+        std::memcpy(key_.data(), block, key_.size());
+        std::memcpy(buffer_, block + key_.size(), sizeof(buffer_));
+        secure_wipe(block, sizeof(block));
+        available_ = sizeof(buffer_);
+    }
+
+    ChaCha20Poly1305::Key key_{};
+    uint8_t buffer_[kBufferBytes] = {};
+    size_t available_ = 0;
+    uint64_t since_reseed_ = 0;
+    bool seeded_ = false;
+#ifndef _WIN32
+    uint64_t fork_generation_ = 0;
+#endif
+};
+
+} // namespace
+
+void os_random(uint8_t* out, size_t length) {
+    if (length == 0) {
+        return;
+    }
+#ifdef _WIN32
+    NTSTATUS status = BCryptGenRandom(
+        nullptr,
+        out,
+        static_cast<ULONG>(length),
+        BCRYPT_USE_SYSTEM_PREFERRED_RNG);
+    if (!BCRYPT_SUCCESS(status)) {
+        throw CryptoException("BCryptGenRandom failed with status " + std::to_string(status));
+    }
+#else
+    size_t filled = 0;
+#if defined(__linux__)
+    while (filled < length) {
+        ssize_t got = getrandom(out + filled, length - filled, 0);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Kernels without getrandom: fall back to the device
+            break;
+        }
+        filled += static_cast<size_t>(got);
+    }
+#elif defined(__APPLE__)
+    // getentropy serves at most 256 bytes per call
+    while (filled < length) {
+        const size_t step = (std::min)(length - filled, size_t(256));
+        if (getentropy(out + filled, step) != 0) {
+            break;
+        }
+        filled += step;
+    }
+#endif
+    if (filled < length && !read_dev_urandom(out + filled, length - filled)) {
+        throw CryptoException("Failed to read OS entropy: " + std::string(std::strerror(errno)));
+    }
+#endif
+}
+
+void secure_random(uint8_t* out, size_t length) {
+    static thread_local ThreadDrbg drbg;
+    drbg.fill(out, length);
+}
+
+} // namespace crypto
+} // namespace netcopy
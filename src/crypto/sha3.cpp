@@ -1,6 +1,7 @@
 // SHA3-256 (FIPS 202 Keccak-f[1600]), HMAC-SHA3-256, PBKDF2-HMAC-SHA3-256
 // Base64 encode/decode, hex encode/decode, cryptographically secure random bytes
 #include "crypto/sha3.h"
+#include "crypto/random.h"
 #include "exceptions.h"
 
 #include <algorithm>
@@ -9,14 +10,6 @@
 #include <iomanip>
 #include <stdexcept>
 
-#ifdef _WIN32
-#  include <windows.h>
-#  include <bcrypt.h>
-#  pragma comment(lib, "bcrypt.lib")
-#else
-#  include <fstream>
-#endif
-
 namespace netcopy {
 namespace crypto {
 
@@ -347,27 +340,7 @@ std::vector<uint8_t> base64_decode(const std::string& b64) {
 
 std::vector<uint8_t> random_bytes(size_t count) {
     std::vector<uint8_t> buf(count);
-    if (count == 0) return buf;
-
-#ifdef _WIN32
-    NTSTATUS status = BCryptGenRandom(
-        nullptr,
-        buf.data(),
-        static_cast<ULONG>(count),
-        BCRYPT_USE_SYSTEM_PREFERRED_RNG);
-    if (!BCRYPT_SUCCESS(status)) {
-        throw CryptoException("BCryptGenRandom failed with status " + std::to_string(status));
-    }
-#else
-    std::ifstream urandom("/dev/urandom", std::ios::binary);
-    if (!urandom) {
-        throw CryptoException("Failed to open /dev/urandom");
-    }
-    urandom.read(reinterpret_cast<char*>(buf.data()), static_cast<std::streamsize>(count));
-    if (!urandom) {
-        throw CryptoException("Failed to read from /dev/urandom");
-    }
-#endif
+    secure_random(buf.data(), buf.size());
     return buf;
 }
 
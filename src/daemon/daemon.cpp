@@ -33,6 +33,7 @@ namespace netcopy {
 namespace daemon {
 
 std::string Daemon::current_pid_file_;
+volatile std::sig_atomic_t Daemon::reload_requested_ = 0;
 
 
 void Daemon::daemonize() {
@@ -170,6 +171,20 @@ void Daemon::setup_signal_handlers() {
 #endif
 }
 
+void Daemon::setup_reload_handler() {
+#ifndef _WIN32
+    signal(SIGHUP, signal_handler);
+#endif
+}
+
+bool Daemon::take_reload_request() {
+    if (!reload_requested_) {
+        return false;
+    }
+    reload_requested_ = 0;
+    return true;
+}
+
 int Daemon::get_pid() {
 #ifdef _WIN32
     return GetCurrentProcessId();
@@ -189,8 +204,8 @@ void Daemon::signal_handler(int signal_num) {
             break;
 #ifndef _WIN32
         case SIGHUP:
-            LOG_INFO("Received SIGHUP, reloading configuration");
-            // TODO: Implement configuration reload
+            // Logged and carried out by whoever polls take_reload_request()
+            reload_requested_ = 1;
             break;
 #endif
         default:
@@ -11,9 +11,17 @@
 #ifdef _WIN32
 #define NOMINMAX
 #include <windows.h>
+#include <winioctl.h>
 #else
 #include <unistd.h>
 #include <fcntl.h>
+#include <cerrno>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <linux/falloc.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
 #endif
 
 namespace netcopy {
@@ -31,6 +39,35 @@ DWORD access_pattern_to_flags(FileAccessPattern access_pattern) {
     return flags;
 }
 #endif
+
+using Extents = std::vector<std::pair<uint64_t, uint64_t>>;
+
+// Folds holes shorter than FileStream::kMinHoleSize (including one at either
+// end of [start, end)) into the neighbouring data extents
+Extents merge_small_holes(const Extents& raw, uint64_t start, uint64_t end) {
+    Extents merged;
+    uint64_t covered = start;
+    for (const auto& extent : raw) {
+        uint64_t extent_start = extent.first;
+        uint64_t extent_end = extent.first + extent.second;
+        if (extent_start - covered < FileStream::kMinHoleSize) {
+            extent_start = merged.empty() ? start : merged.back().first;
+            if (!merged.empty()) {
+                merged.pop_back();
+            }
+        }
+        merged.emplace_back(extent_start, extent_end - extent_start);
+        covered = extent_end;
+    }
+    if (end - covered < FileStream::kMinHoleSize && end > covered) {
+        if (merged.empty()) {
+            merged.emplace_back(start, end - start);
+        } else {
+            merged.back().second = end - merged.back().first;
+        }
+    }
+    return merged;
+}
 }
 
 bool FileManager::exists(const std::string& path) {
@@ -313,6 +350,115 @@ bool FileManager::preallocate_file(const std::string& path, uint64_t size, bool
 #endif
 }
 
+bool FileManager::is_sparse(const std::string& path) {
+    uint64_t size = file_size(path);
+    if (size < FileStream::kMinHoleSize) {
+        return false;
+    }
+    FileStream stream;
+    if (!stream.open_read(path)) {
+        return false;
+    }
+    uint64_t data_bytes = 0;
+    for (const auto& extent : stream.data_extents(0, size)) {
+        data_bytes += extent.second;
+    }
+    return data_bytes < size;
+}
+
+FileManager::CopyMethod FileManager::copy_range(const std::string& source, uint64_t source_offset,
+                                                const std::string& target, uint64_t target_offset,
+                                                uint64_t length) {
+    uint64_t copied = 0;
+#ifdef __linux__
+    {
+        int src = ::open(source.c_str(), O_RDONLY);
+        if (src < 0) {
+            throw FileException("Failed to open block copy source: " + source);
+        }
+        int dst = ::open(target.c_str(), O_WRONLY | O_CREAT, 0644);
+        if (dst < 0) {
+            ::close(src);
+            throw FileException("Failed to open block copy target: " + target);
+        }
+        struct FdGuard {
+            int fd;
+            ~FdGuard() { ::close(fd); }
+        } src_guard{src}, dst_guard{dst};
+
+#ifdef FICLONERANGE
+        // Needs filesystem-block alignment except at the end of the source;
+        // any refusal just falls through to a real copy
+        struct file_clone_range clone {};
+        clone.src_fd = src;
+        clone.src_offset = source_offset;
+        clone.src_length = length;
+        clone.dest_offset = target_offset;
+        if (::ioctl(dst, FICLONERANGE, &clone) == 0) {
+            return CopyMethod::Reflink;
+        }
+#endif
+        loff_t in = static_cast<loff_t>(source_offset);
+        loff_t out = static_cast<loff_t>(target_offset);
+        while (copied < length) {
+            ssize_t n = ::copy_file_range(src, &in, dst, &out, static_cast<size_t>(length - copied), 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                break; // Unsupported here (e.g. across filesystems); finish buffered
+            }
+            if (n == 0) {
+                throw FileException("Block copy source is shorter than expected: " + source);
+            }
+            copied += static_cast<uint64_t>(n);
+        }
+        if (copied == length) {
+            return CopyMethod::Kernel;
+        }
+    }
+#endif
+    FileStream in;
+    FileStream out;
+    if (!in.open_read(source)) {
+        throw FileException("Failed to open block copy source: " + source);
+    }
+    if (!out.open_write(target, false, false)) {
+        throw FileException("Failed to open block copy target: " + target);
+    }
+    std::vector<uint8_t> buffer(static_cast<size_t>((std::min)(length - copied, static_cast<uint64_t>(DEFAULT_CHUNK_SIZE * 4))));
+    while (copied < length) {
+        size_t want = static_cast<size_t>((std::min)(static_cast<uint64_t>(buffer.size()), length - copied));
+        size_t got = in.read(source_offset + copied, buffer.data(), want);
+        if (got == 0) {
+            throw FileException("Block copy source is shorter than expected: " + source);
+        }
+        out.write(target_offset + copied, buffer.data(), got);
+        copied += got;
+    }
+    return CopyMethod::Buffered;
+}
+
+std::vector<uint8_t> FileManager::hash_range(const std::string& path, uint64_t offset, uint64_t length) {
+    FileStream file;
+    if (!file.open_read(path)) {
+        throw FileException("Failed to open file for hashing: " + path);
+    }
+    std::vector<uint8_t> buffer(static_cast<size_t>((std::min)(length, static_cast<uint64_t>(DEFAULT_CHUNK_SIZE * 4))));
+    crypto::XxHash64Hasher hasher;
+    uint64_t done = 0;
+    while (done < length) {
+        size_t want = static_cast<size_t>((std::min)(static_cast<uint64_t>(buffer.size()), length - done));
+        size_t got = file.read(offset + done, buffer.data(), want);
+        if (got == 0) {
+            break;
+        }
+        hasher.update(buffer.data(), got);
+        done += got;
+    }
+    return done == length ? hasher.finalize() : std::vector<uint8_t>{};
+}
+
 uint64_t FileManager::get_partial_file_size(const std::string& path) {
     if (!exists(path)) {
         return 0;
@@ -924,6 +1070,139 @@ void FileStream::write(uint64_t offset, const uint8_t* data, size_t size) {
 #endif
 }
 
+std::vector<std::pair<uint64_t, uint64_t>> FileStream::data_extents(uint64_t start, uint64_t end) {
+    Extents whole;
+    if (start < end) {
+        whole.emplace_back(start, end - start);
+    }
+    if (!is_open() || start >= end) {
+        return whole;
+    }
+
+    Extents raw;
+#ifdef _WIN32
+    HANDLE handle = static_cast<HANDLE>(file_handle_);
+    FILE_ALLOCATED_RANGE_BUFFER query{};
+    query.FileOffset.QuadPart = static_cast<LONGLONG>(start);
+    query.Length.QuadPart = static_cast<LONGLONG>(end - start);
+    FILE_ALLOCATED_RANGE_BUFFER ranges[64];
+    while (true) {
+        DWORD returned = 0;
+        BOOL ok = DeviceIoControl(handle, FSCTL_QUERY_ALLOCATED_RANGES,
+                                  &query, sizeof(query), ranges, sizeof(ranges), &returned, nullptr);
+        if (!ok && GetLastError() != ERROR_MORE_DATA) {
+            return whole;
+        }
+        DWORD count = returned / sizeof(ranges[0]);
+        for (DWORD i = 0; i < count; ++i) {
+            uint64_t range_start = (std::max)(start, static_cast<uint64_t>(ranges[i].FileOffset.QuadPart));
+            uint64_t range_end = (std::min)(end, static_cast<uint64_t>(ranges[i].FileOffset.QuadPart + ranges[i].Length.QuadPart));
+            if (range_start < range_end) {
+                raw.emplace_back(range_start, range_end - range_start);
+            }
+        }
+        if (ok || count == 0) {
+            break;
+        }
+        uint64_t next = static_cast<uint64_t>(ranges[count - 1].FileOffset.QuadPart + ranges[count - 1].Length.QuadPart);
+        if (next >= end) {
+            break;
+        }
+        query.FileOffset.QuadPart = static_cast<LONGLONG>(next);
+        query.Length.QuadPart = static_cast<LONGLONG>(end - next);
+    }
+#elif defined(SEEK_DATA) && defined(SEEK_HOLE)
+    off_t pos = static_cast<off_t>(start);
+    while (static_cast<uint64_t>(pos) < end) {
+        off_t data = lseek(fd_, pos, SEEK_DATA);
+        if (data < 0) {
+            if (errno == ENXIO) {
+                break; // Only a hole remains
+            }
+            return whole;
+        }
+        if (static_cast<uint64_t>(data) >= end) {
+            break;
+        }
+        off_t hole = lseek(fd_, data, SEEK_HOLE);
+        if (hole < 0) {
+            return whole;
+        }
+        uint64_t data_end = (std::min)(end, static_cast<uint64_t>(hole));
+        raw.emplace_back(static_cast<uint64_t>(data), data_end - static_cast<uint64_t>(data));
+        pos = hole;
+    }
+#else
+    return whole;
+#endif
+    return merge_small_holes(raw, start, end);
+}
+
+uint64_t FileStream::current_size() {
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(static_cast<HANDLE>(file_handle_), &size)) {
+        throw FileException("FileStream failed to query size: " + path_);
+    }
+    return static_cast<uint64_t>(size.QuadPart);
+#else
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        throw FileException("FileStream failed to query size: " + path_);
+    }
+    return static_cast<uint64_t>(st.st_size);
+#endif
+}
+
+void FileStream::write_zeros(uint64_t offset, uint64_t length) {
+    static const std::vector<uint8_t> zeros(1024 * 1024, 0);
+    while (length > 0) {
+        size_t piece = static_cast<size_t>((std::min)(length, static_cast<uint64_t>(zeros.size())));
+        write(offset, zeros.data(), piece);
+        offset += piece;
+        length -= piece;
+    }
+}
+
+void FileStream::punch_hole(uint64_t offset, uint64_t length) {
+    if (!is_open() || length == 0) return;
+    const uint64_t end = offset + length;
+#ifdef _WIN32
+    HANDLE handle = static_cast<HANDLE>(file_handle_);
+    DWORD returned = 0;
+    // Must precede any extension, or NTFS allocates the new range
+    const bool sparse = DeviceIoControl(handle, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &returned, nullptr) != 0;
+#endif
+    const uint64_t size = current_size();
+    if (size < end) {
+        // Extend with a write rather than a truncate: a parallel stream may
+        // grow the file meanwhile and must never be cut short
+        const uint8_t zero = 0;
+        write(end - 1, &zero, 1);
+    }
+    if (offset >= size) {
+        return;
+    }
+
+    const uint64_t zero_end = (std::min)(end, size);
+    bool deallocated = false;
+#ifdef _WIN32
+    if (sparse) {
+        FILE_ZERO_DATA_INFORMATION zero_info{};
+        zero_info.FileOffset.QuadPart = static_cast<LONGLONG>(offset);
+        zero_info.BeyondFinalZero.QuadPart = static_cast<LONGLONG>(zero_end);
+        deallocated = DeviceIoControl(handle, FSCTL_SET_ZERO_DATA,
+                                      &zero_info, sizeof(zero_info), nullptr, 0, &returned, nullptr) != 0;
+    }
+#elif defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+    deallocated = fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                            static_cast<off_t>(offset), static_cast<off_t>(zero_end - offset)) == 0;
+#endif
+    if (!deallocated) {
+        write_zeros(offset, zero_end - offset);
+    }
+}
+
 void FileStream::close() {
 #ifdef _WIN32
     if (file_handle_ != nullptr && file_handle_ != INVALID_HANDLE_VALUE) {
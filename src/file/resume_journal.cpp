@@ -0,0 +1,224 @@
+#include "file/resume_journal.h"
+#include "file/file_manager.h"
+#include "logging/logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+
+namespace netcopy {
+namespace file {
+
+namespace {
+
+constexpr const char* kJournalHeader = "netcopy-resume-journal 1";
+
+std::mutex registry_mutex;
+std::unordered_map<std::string, std::weak_ptr<ResumeJournal>> registry;
+
+std::string registry_key(const std::string& file_path) {
+    return FileManager::normalize_path(file_path);
+}
+
+} // namespace
+
+std::string ResumeJournal::sidecar_path(const std::string& file_path) {
+    return file_path + kSuffix;
+}
+
+ResumeJournal::ResumeJournal(std::string file_path, uint64_t file_size, uint64_t last_modified)
+    : file_path_(std::move(file_path)), file_size_(file_size), last_modified_(last_modified) {}
+
+bool ResumeJournal::matches(uint64_t file_size, uint64_t last_modified) const {
+    return file_size_ == file_size && last_modified_ == last_modified;
+}
+
+std::shared_ptr<ResumeJournal> ResumeJournal::open(const std::string& file_path,
+                                                   uint64_t file_size,
+                                                   uint64_t last_modified) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& slot = registry[registry_key(file_path)];
+    auto journal = slot.lock();
+    if (journal) {
+        std::lock_guard<std::mutex> journal_lock(journal->mutex_);
+        if (!journal->discarded_ && journal->matches(file_size, last_modified)) {
+            return journal;
+        }
+    }
+
+    journal = std::make_shared<ResumeJournal>(file_path, file_size, last_modified);
+    if (FileManager::exists(file_path)) {
+        journal->read_sidecar();
+    }
+    slot = journal;
+    return journal;
+}
+
+std::shared_ptr<ResumeJournal> ResumeJournal::load(const std::string& file_path,
+                                                   uint64_t file_size,
+                                                   uint64_t last_modified) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& slot = registry[registry_key(file_path)];
+    auto live = slot.lock();
+    if (live) {
+        std::lock_guard<std::mutex> journal_lock(live->mutex_);
+        if (!live->discarded_) {
+            // Another connection is writing this destination; only its
+            // in-memory ranges are current
+            return live->matches(file_size, last_modified) ? live : nullptr;
+        }
+    }
+    if (!FileManager::exists(file_path) || !FileManager::exists(sidecar_path(file_path))) {
+        return nullptr;
+    }
+
+    auto journal = std::make_shared<ResumeJournal>(file_path, file_size, last_modified);
+    if (!journal->read_sidecar() || journal->completed().empty()) {
+        return nullptr;
+    }
+    slot = journal;
+    return journal;
+}
+
+void ResumeJournal::discard(const std::string& file_path) {
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        auto it = registry.find(registry_key(file_path));
+        if (it != registry.end()) {
+            if (auto journal = it->second.lock()) {
+                std::lock_guard<std::mutex> journal_lock(journal->mutex_);
+                journal->discarded_ = true;
+                journal->ranges_.clear();
+                journal->dirty_ = false;
+            }
+            registry.erase(it);
+        }
+    }
+    std::remove(sidecar_path(file_path).c_str());
+}
+
+void ResumeJournal::add_range(uint64_t offset, uint64_t length) {
+    if (length == 0) {
+        return;
+    }
+    uint64_t start = offset;
+    uint64_t end = offset + length;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (discarded_) {
+        return;
+    }
+    // Merge with every range that overlaps or touches [start, end)
+    auto it = ranges_.upper_bound(start);
+    if (it != ranges_.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second >= start) {
+            start = prev->first;
+            end = (std::max)(end, prev->second);
+            it = ranges_.erase(prev);
+        }
+    }
+    while (it != ranges_.end() && it->first <= end) {
+        end = (std::max)(end, it->second);
+        it = ranges_.erase(it);
+    }
+    ranges_[start] = end;
+    dirty_ = true;
+}
+
+ByteRanges ResumeJournal::completed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ByteRanges out;
+    out.reserve(ranges_.size());
+    for (const auto& range : ranges_) {
+        out.emplace_back(range.first, range.second - range.first);
+    }
+    return out;
+}
+
+uint64_t ResumeJournal::contiguous_prefix() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ranges_.empty() || ranges_.begin()->first != 0) {
+        return 0;
+    }
+    return ranges_.begin()->second;
+}
+
+void ResumeJournal::persist(bool force) {
+    // Held across the write so a concurrent discard() cannot be undone
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dirty_ || discarded_) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - last_persist_ < kPersistInterval) {
+        return;
+    }
+
+    std::ostringstream out;
+    out << kJournalHeader << "\n";
+    out << "size " << file_size_ << "\n";
+    out << "mtime " << last_modified_ << "\n";
+    for (const auto& range : ranges_) {
+        out << range.first << " " << (range.second - range.first) << "\n";
+    }
+
+    const std::string path = sidecar_path(file_path_);
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        file << out.str();
+        if (!file) {
+            LOG_WARNING("Failed to write resume journal: " + tmp);
+            return;
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOG_WARNING("Failed to replace resume journal: " + path);
+        return;
+    }
+    dirty_ = false;
+    last_persist_ = now;
+}
+
+bool ResumeJournal::read_sidecar() {
+    std::ifstream file(sidecar_path(file_path_), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::string header;
+    std::getline(file, header);
+    if (header != kJournalHeader) {
+        return false;
+    }
+    std::string key;
+    uint64_t size = 0;
+    uint64_t mtime = 0;
+    if (!(file >> key >> size) || key != "size" || !(file >> key >> mtime) || key != "mtime") {
+        return false;
+    }
+    if (!matches(size, mtime)) {
+        LOG_DEBUG("Ignoring resume journal for a different source version: " + file_path_);
+        return false;
+    }
+
+    uint64_t destination_size = FileManager::file_size(file_path_);
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    while (file >> offset >> length) {
+        // Never trust a range the destination cannot hold
+        if (length == 0 || offset + length > file_size_ || offset + length > destination_size) {
+            continue;
+        }
+        add_range(offset, length);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    dirty_ = false;
+    return true;
+}
+
+} // namespace file
+} // namespace netcopy
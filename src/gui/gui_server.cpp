@@ -35,6 +35,9 @@ namespace netcopy {
 namespace gui {
 
 namespace {
+// Idle single-stream connections kept ready for transfer workers
+constexpr uint32_t kWarmTransferConnections = 4;
+
 std::string escape_json(const std::string& s) {
     std::string out;
     for (char c : s) {
@@ -56,13 +59,15 @@ std::string escape_json(const std::string& s) {
     return out;
 }
 
-std::string normalize_gui_path(const std::string& path) {
-    std::string norm = path;
-    std::replace(norm.begin(), norm.end(), '\\', '/');
-    for (auto& c : norm) {
-        c = std::tolower(static_cast<unsigned char>(c));
+// Per-state file counts kept by the scheduler, as a JSON object
+std::string file_counts_json(const TransferScheduler::Counters& counters) {
+    std::string json = "{\"files\":" + std::to_string(counters.files) + ",\"ready\":" + std::to_string(counters.ready);
+    for (size_t i = 0; i < kFileStateCount; ++i) {
+        json += ",\"";
+        json += file_state_name(static_cast<FileState>(i));
+        json += "\":" + std::to_string(counters.by_state[i]);
     }
-    return norm;
+    return json + "}";
 }
 
 std::string format_rate(double bytes_per_sec) {
@@ -83,6 +88,75 @@ std::string format_rate(double bytes_per_sec) {
         return buf;
     }
 }
+// "files" array of a remote listing as the browser expects it: a ".."
+// entry below filesystem and allowed roots, then the entries
+std::string remote_files_json(const std::string& path, const std::vector<protocol::RemoteFileInfo>& entries,
+                              const std::vector<std::string>& allowed_paths) {
+    std::string json = "[";
+
+    bool is_filesystem_root = (path == "/" || path == "\\" || (path.length() == 3 && path[1] == ':' && (path[2] == '\\' || path[2] == '/')));
+    
+    bool is_trusted_root = false;
+    std::string normalized_path = path;
+    std::replace(normalized_path.begin(), normalized_path.end(), '/', '\\');
+    if (!normalized_path.empty() && normalized_path.back() != '\\') {
+        normalized_path += '\\';
+    }
+    
+    for (const auto& allowed : allowed_paths) {
+        std::string normalized_allowed = allowed;
+        std::replace(normalized_allowed.begin(), normalized_allowed.end(), '/', '\\');
+        if (!normalized_allowed.empty() && normalized_allowed.back() != '\\') {
+            normalized_allowed += '\\';
+        }
+        if (normalized_path == normalized_allowed) {
+            is_trusted_root = true;
+            break;
+        }
+    }
+    
+    if (!is_filesystem_root && !is_trusted_root) {
+        json += "{";
+        json += "\"name\":\"..\",";
+        json += "\"path\":\"..\",";
+        json += "\"size\":0,";
+        json += "\"is_dir\":true,";
+        json += "\"last_modified\":0,";
+        json += "\"permissions\":0,";
+        json += "\"is_symlink\":false,";
+        json += "\"symlink_target\":\"\"";
+        json += "}";
+        if (!entries.empty()) {
+            json += ",";
+        }
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& e = entries[i];
+        std::string name = file::FileManager::get_filename(e.path);
+        
+        if (name.empty() || name == "\\" || name == "/") {
+            name = e.path;
+        }
+        
+        json += "{";
+        json += "\"name\":\"" + escape_json(name) + "\",";
+        json += "\"path\":\"" + escape_json(e.path) + "\",";
+        json += "\"size\":" + std::to_string(e.size) + ",";
+        json += "\"is_dir\":" + std::string(e.is_directory ? "true" : "false") + ",";
+        json += "\"last_modified\":" + std::to_string(e.last_modified) + ",";
+        json += "\"permissions\":" + std::to_string(e.permissions) + ",";
+        json += "\"is_symlink\":" + std::string(e.is_symlink ? "true" : "false") + ",";
+        json += "\"symlink_target\":\"" + escape_json(e.symlink_target) + "\"";
+        json += "}";
+        if (i + 1 < entries.size()) {
+            json += ",";
+        }
+    }
+    json += "]";
+    return json;
+}
+
 } // namespace
 
 GuiServer::GuiServer()
@@ -94,7 +168,21 @@ GuiServer::GuiServer()
       transfer_active_(false),
       transfer_bytes_(0),
       transfer_total_bytes_(0),
-      transfer_rate_(0.0) {}
+      transfer_rate_(0.0) {
+    listing_cache_.set_fetcher([this](const std::string& path) {
+        client::ConnectionProfile profile;
+        std::vector<std::string> allowed_paths;
+        {
+            std::lock_guard<std::mutex> lock(client_mutex_);
+            if (!remote_connected_) {
+                return;
+            }
+            profile = remote_profile_locked();
+            allowed_paths = remote_allowed_paths_;
+        }
+        remote_listing(profile, allowed_paths, path);
+    });
+}
 
 GuiServer::~GuiServer() {
     stop();
@@ -170,10 +258,8 @@ void GuiServer::stop() {
     }
 
     std::lock_guard<std::mutex> lock(client_mutex_);
-    if (active_client_) {
-        active_client_->disconnect();
-        active_client_.reset();
-    }
+    pool_.clear();
+    listing_cache_.clear();
     remote_connected_ = false;
 }
 
@@ -447,7 +533,10 @@ void GuiServer::handle_api_connect(std::shared_ptr<asio::ip::tcp::socket> client
     try {
         std::lock_guard<std::mutex> lock(client_mutex_);
 
-        active_client_ = std::make_shared<client::Client>();
+        // Connections and listings of the previous server are not reused
+        pool_.clear();
+        listing_cache_.clear();
+        remote_connected_ = false;
 
         config::ClientConfig conf = config::ClientConfig::get_default();
         conf.auto_create_directories = true;
@@ -466,8 +555,6 @@ void GuiServer::handle_api_connect(std::shared_ptr<asio::ip::tcp::socket> client
             conf.internal.auth_method = "none";
         }
 
-        active_client_->set_config(conf);
-
         crypto::SecurityLevel level = crypto::SecurityLevel::HIGH;
         if (security_level_str == "fast") {
             level = crypto::SecurityLevel::FAST;
@@ -477,15 +564,19 @@ void GuiServer::handle_api_connect(std::shared_ptr<asio::ip::tcp::socket> client
             level = crypto::SecurityLevel::AES_256_GCM;
         }
 
-        active_client_->set_security_level(level);
-        active_client_->connect(host, port);
-
         active_client_config_ = conf;
         active_security_level_ = level;
-
-        remote_connected_ = true;
         remote_host_ = host;
         remote_port_ = port;
+
+        // The first connection stays in the pool for browsing; transfer
+        // workers get single-stream connections opened in the background
+        client::ConnectionProfile profile = remote_profile_locked();
+        uint32_t streams = pool_.acquire(profile)->get_negotiated_parallel_streams();
+        pool_.keep_warm(profile, 1);
+        pool_.keep_warm(remote_profile_locked(1), (std::min)((std::max)(streams, 1u), kWarmTransferConnections));
+
+        remote_connected_ = true;
         remote_username_ = username;
 
         remote_allowed_paths_.clear();
@@ -548,7 +639,6 @@ void GuiServer::handle_api_connect(std::shared_ptr<asio::ip::tcp::socket> client
         send_response(client_socket, "200 OK", "application/json", body);
     } catch (const std::exception& e) {
         remote_connected_ = false;
-        active_client_.reset();
         send_error(client_socket, 500, std::string("Connection failed: ") + e.what());
     }
 }
@@ -559,80 +649,68 @@ void GuiServer::handle_api_remote_list(std::shared_ptr<asio::ip::tcp::socket> cl
         path = "/";
     }
 
-    std::lock_guard<std::mutex> lock(client_mutex_);
-    if (!remote_connected_ || !active_client_) {
-        send_error(client_socket, 400, "Not connected to remote server");
-        return;
+    client::ConnectionProfile profile;
+    std::vector<std::string> allowed_paths;
+    {
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        if (!remote_connected_) {
+            send_error(client_socket, 400, "Not connected to remote server");
+            return;
+        }
+        profile = remote_profile_locked();
+        allowed_paths = remote_allowed_paths_;
     }
 
     try {
-        auto entries = active_client_->list_remote_directory(path, false);
-        std::string body = "{\"status\":\"success\",\"path\":\"" + escape_json(path) + "\",\"files\":[";
+        auto listing = remote_listing(profile, allowed_paths, path);
+        std::string body = "{\"status\":\"success\",\"path\":\"" + escape_json(path) + "\",\"files\":" + listing.files_json + "}";
+        send_response(client_socket, "200 OK", "application/json", body);
+        // The user is likely to open one of these next
+        listing_cache_.prefetch(listing.subdirectories);
+    } catch (const std::exception& e) {
+        send_error(client_socket, 500, e.what());
+    }
+}
 
-        bool is_filesystem_root = (path == "/" || path == "\\" || (path.length() == 3 && path[1] == ':' && (path[2] == '\\' || path[2] == '/')));
-        
-        bool is_trusted_root = false;
-        std::string normalized_path = path;
-        std::replace(normalized_path.begin(), normalized_path.end(), '/', '\\');
-        if (!normalized_path.empty() && normalized_path.back() != '\\') {
-            normalized_path += '\\';
-        }
-        
-        for (const auto& allowed : remote_allowed_paths_) {
-            std::string normalized_allowed = allowed;
-            std::replace(normalized_allowed.begin(), normalized_allowed.end(), '/', '\\');
-            if (!normalized_allowed.empty() && normalized_allowed.back() != '\\') {
-                normalized_allowed += '\\';
-            }
-            if (normalized_path == normalized_allowed) {
-                is_trusted_root = true;
-                break;
-            }
-        }
-        
-        if (!is_filesystem_root && !is_trusted_root) {
-            body += "{";
-            body += "\"name\":\"..\",";
-            body += "\"path\":\"..\",";
-            body += "\"size\":0,";
-            body += "\"is_dir\":true,";
-            body += "\"last_modified\":0,";
-            body += "\"permissions\":0,";
-            body += "\"is_symlink\":false,";
-            body += "\"symlink_target\":\"\"";
-            body += "}";
-            if (!entries.empty()) {
-                body += ",";
-            }
-        }
+ListingCache::Listing GuiServer::remote_listing(const client::ConnectionProfile& profile,
+                                                const std::vector<std::string>& allowed_paths,
+                                                const std::string& path) {
+    ListingCache::Listing listing;
+    bool fresh = false;
+    const bool cached = listing_cache_.lookup(path, listing, fresh);
+    if (cached && fresh) {
+        return listing;
+    }
+
+    const uint64_t epoch = listing_cache_.epoch();
+    uint64_t version = cached ? listing.version : 0;
+    std::vector<protocol::RemoteFileInfo> entries;
+    // Runs on a pooled connection, so browsing neither waits for other
+    // requests nor pays for a handshake
+    bool changed = pool_.run(profile, [&](client::Client& client) {
+        return client.list_remote_directory_if_changed(path, false, entries, version);
+    });
+    if (!changed) {
+        listing_cache_.confirm(path, epoch);
+        return listing;
+    }
 
-        for (size_t i = 0; i < entries.size(); ++i) {
-            const auto& e = entries[i];
+    listing = ListingCache::Listing();
+    listing.version = version;
+    listing.files_json = remote_files_json(path, entries, allowed_paths);
+    for (const auto& e : entries) {
+        if (e.is_directory && !e.is_symlink) {
             std::string name = file::FileManager::get_filename(e.path);
-            
-            if (name.empty() || name == "\\" || name == "/") {
-                name = e.path;
-            }
-            
-            body += "{";
-            body += "\"name\":\"" + escape_json(name) + "\",";
-            body += "\"path\":\"" + escape_json(e.path) + "\",";
-            body += "\"size\":" + std::to_string(e.size) + ",";
-            body += "\"is_dir\":" + std::string(e.is_directory ? "true" : "false") + ",";
-            body += "\"last_modified\":" + std::to_string(e.last_modified) + ",";
-            body += "\"permissions\":" + std::to_string(e.permissions) + ",";
-            body += "\"is_symlink\":" + std::string(e.is_symlink ? "true" : "false") + ",";
-            body += "\"symlink_target\":\"" + escape_json(e.symlink_target) + "\"";
-            body += "}";
-            if (i + 1 < entries.size()) {
-                body += ",";
+            if (!name.empty() && name != "\\" && name != "/") {
+                listing.subdirectories.push_back(file::FileManager::join_path(path, name));
             }
         }
-        body += "]}";
-        send_response(client_socket, "200 OK", "application/json", body);
-    } catch (const std::exception& e) {
-        send_error(client_socket, 500, e.what());
     }
+    // Servers without listing versions cannot revalidate; never cache those
+    if (version != 0) {
+        listing_cache_.store(path, listing, epoch);
+    }
+    return listing;
 }
 
 void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> client_socket, const std::string& request_body) {
@@ -651,16 +729,14 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
         return;
     }
 
-    std::string host;
-    uint16_t port = 0;
+    client::ConnectionProfile profile;
     {
         std::lock_guard<std::mutex> lock(client_mutex_);
         if (!remote_connected_) {
             send_error(client_socket, 400, "Not connected to remote server");
             return;
         }
-        host = remote_host_;
-        port = remote_port_;
+        profile = remote_profile_locked();
     }
 
     static std::atomic<uint32_t> g_transfer_id_counter(0);
@@ -692,9 +768,12 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
         transfers_[transfer_id] = transfer;
     }
 
-    // Connect separate client instance
+    // The transfer's own client only coordinates the workers (pause and skip
+    // state, cancellation, bandwidth); the stream count it would negotiate
+    // comes from a pooled connection of the same profile
+    uint32_t negotiated_streams = 0;
     try {
-        transfer->client_inst->connect(host, port);
+        negotiated_streams = pool_.acquire(profile)->get_negotiated_parallel_streams();
     } catch (const std::exception& e) {
         transfer->active = false;
         transfer->error_message = std::string("Connection failed: ") + e.what();
@@ -764,10 +843,8 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
             }
         } else {
             // download
-            client::Client list_client;
-            list_client.set_config(active_client_config_);
-            list_client.set_security_level(active_security_level_);
-            list_client.connect(host, port);
+            auto list_lease = pool_.acquire(profile);
+            client::Client& list_client = *list_lease;
 
             std::filesystem::path p_remote_base = std::filesystem::u8path(remote_path).lexically_normal();
             std::string norm_remote_base = p_remote_base.u8string();
@@ -834,7 +911,6 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
                     tasks.push_back({full_remote, dest, size, false});
                 }
             }
-            list_client.disconnect();
         }
     } catch (const std::exception& e) {
         transfer->active = false;
@@ -854,10 +930,8 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
     std::map<std::string, uint64_t> remote_existing;
     if (direction == "upload") {
         try {
-            client::Client list_client;
-            list_client.set_config(active_client_config_);
-            list_client.set_security_level(active_security_level_);
-            list_client.connect(host, port);
+            auto list_lease = pool_.acquire(profile);
+            client::Client& list_client = *list_lease;
             auto existing = list_client.list_remote_directory(remote_path, true);
             for (const auto& f : existing) {
                 if (!f.is_directory) {
@@ -869,20 +943,17 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
                     remote_existing[path_norm] = f.size;
                 }
             }
-            list_client.disconnect();
         } catch (...) {}
     }
 
-    uint64_t total_transfer_bytes = 0;
     {
-        std::lock_guard<std::mutex> t_lock(transfer->mutex);
         for (const auto& task : tasks) {
             FileProgress fp;
             fp.path = task.source_path; // display source path
             fp.total_bytes = task.size;
             fp.bytes_transferred = 0;
             fp.is_directory = false;
-            fp.status = "pending";
+            fp.state = FileState::Pending;
             fp.decision = "none";
 
             bool exists = false;
@@ -909,27 +980,28 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
 
             if (exists) {
                 if (dest_size == task.size) {
-                    fp.status = "exists_exact";
+                    fp.state = FileState::ExistsExact;
                     fp.decision = "none";
                     fp.bytes_transferred = task.size;
                 } else if (dest_size < task.size) {
-                    fp.status = "exists_partial";
+                    fp.state = FileState::ExistsPartial;
                     fp.decision = "none";
                     fp.bytes_transferred = dest_size;
                 } else {
-                    fp.status = "exists_exact";
+                    fp.state = FileState::ExistsExact;
                     fp.decision = "none";
                     fp.bytes_transferred = task.size;
                 }
             } else {
-                fp.status = "pending";
+                fp.state = FileState::Pending;
                 fp.decision = "start"; // new files can start automatically
             }
 
-            transfer->files.push_back(fp);
-            total_transfer_bytes += fp.total_bytes;
+            // Task indices match scheduler indices: tasks are added first
+            transfer->scheduler.add(std::move(fp));
         }
-        transfer->total_bytes = total_transfer_bytes;
+        transfer->total_bytes = transfer->scheduler.counters().total_bytes;
+        std::lock_guard<std::mutex> t_lock(transfer->mutex);
         transfer->current_file = "Waiting for decision...";
     }
 
@@ -941,98 +1013,57 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
     auto tracker = std::make_shared<ProgressTracker>();
 
     auto progress_cb = [transfer, tracker](uint64_t bytes_transferred, uint64_t total_bytes, const std::string& current_file) {
-        std::lock_guard<std::mutex> lock(transfer->mutex);
-        
-        bool found = false;
-        for (auto& f : transfer->files) {
-            auto norm_match = [](const std::string& p1, const std::string& p2) {
-                std::string n1 = p1; std::string n2 = p2;
-                std::replace(n1.begin(), n1.end(), '\\', '/');
-                std::replace(n2.begin(), n2.end(), '\\', '/');
-                #ifdef _WIN32
-                std::transform(n1.begin(), n1.end(), n1.begin(), ::tolower);
-                std::transform(n2.begin(), n2.end(), n2.begin(), ::tolower);
-                #endif
-                if (n1.length() >= n2.length() && n1.compare(n1.length() - n2.length(), n2.length(), n2) == 0) return true;
-                if (n2.length() >= n1.length() && n2.compare(n2.length() - n1.length(), n1.length(), n1) == 0) return true;
-                return false;
-            };
-
-            if (norm_match(f.path, current_file)) {
-                auto now = std::chrono::steady_clock::now();
-                auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - f.last_time).count();
-                if (duration_ms >= 500) {
-                    double speed = static_cast<double>(bytes_transferred - f.last_bytes) / (static_cast<double>(duration_ms) / 1000.0);
+        bool paused = transfer->client_inst->is_file_paused(current_file);
+        bool skipped = transfer->client_inst->is_file_skipped(current_file);
+        transfer->scheduler.update_or_add(current_file, [&](FileProgress& f) {
+            auto now = std::chrono::steady_clock::now();
+            auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - f.last_time).count();
+            if (f.total_bytes == 0 && f.bytes_transferred == 0) {
+                // First report of a file only known from progress callbacks
+                f.total_bytes = total_bytes;
+            }
+            if (duration_ms >= 500) {
+                double speed = static_cast<double>(bytes_transferred - f.last_bytes) / (static_cast<double>(duration_ms) / 1000.0);
+                f.rate_string = format_rate(speed);
+                f.last_bytes = bytes_transferred;
+                f.last_time = now;
+            } else if (f.rate_string == "0 B/s" || f.rate_string.empty()) {
+                if (bytes_transferred > 0 && duration_ms > 0) {
+                    double speed = static_cast<double>(bytes_transferred) / (static_cast<double>(duration_ms) / 1000.0);
                     f.rate_string = format_rate(speed);
-                    f.last_bytes = bytes_transferred;
-                    f.last_time = now;
-                } else if (f.rate_string == "0 B/s" || f.rate_string.empty()) {
-                    if (bytes_transferred > 0 && duration_ms > 0) {
-                        double speed = static_cast<double>(bytes_transferred) / (static_cast<double>(duration_ms) / 1000.0);
-                        f.rate_string = format_rate(speed);
-                    }
-                }
-
-                f.bytes_transferred = bytes_transferred;
-                if (bytes_transferred >= total_bytes && total_bytes > 0) {
-                    f.status = "completed";
-                    f.rate_string = "0 B/s";
-                } else if (transfer->client_inst->is_file_paused(f.path)) {
-                    f.status = "paused";
-                    f.rate_string = "0 B/s";
-                } else if (transfer->client_inst->is_file_skipped(f.path)) {
-                    f.status = "skipped";
-                    f.rate_string = "0 B/s";
-                } else {
-                    f.status = "transferring";
                 }
-                found = true;
-                break;
             }
-        }
 
-        if (!found) {
-            FileProgress fp;
-            fp.path = current_file;
-            fp.total_bytes = total_bytes;
-            fp.bytes_transferred = bytes_transferred;
-            fp.last_bytes = bytes_transferred;
-            fp.last_time = std::chrono::steady_clock::now();
+            f.bytes_transferred = bytes_transferred;
             if (bytes_transferred >= total_bytes && total_bytes > 0) {
-                fp.status = "completed";
-                fp.rate_string = "0 B/s";
-            } else if (transfer->client_inst->is_file_paused(current_file)) {
-                fp.status = "paused";
-                fp.rate_string = "0 B/s";
-            } else if (transfer->client_inst->is_file_skipped(current_file)) {
-                fp.status = "skipped";
-                fp.rate_string = "0 B/s";
+                f.state = FileState::Completed;
+                f.rate_string = "0 B/s";
+            } else if (paused) {
+                f.state = FileState::Paused;
+                f.rate_string = "0 B/s";
+            } else if (skipped) {
+                f.state = FileState::Skipped;
+                f.rate_string = "0 B/s";
             } else {
-                fp.status = "transferring";
-                fp.rate_string = "0 B/s";
+                f.state = FileState::Transferring;
             }
-            transfer->files.push_back(fp);
-        }
+        });
 
-        uint64_t total_done = 0;
-        uint64_t total_size = 0;
-        for (const auto& f : transfer->files) {
-            total_done += f.bytes_transferred;
-            total_size += f.total_bytes;
-        }
-        transfer->bytes_transferred = total_done;
-        if (total_size > 0) {
-            transfer->total_bytes = total_size;
+        auto counters = transfer->scheduler.counters();
+        transfer->bytes_transferred = counters.bytes_transferred;
+        if (counters.total_bytes > 0) {
+            transfer->total_bytes = counters.total_bytes;
         } else {
             transfer->total_bytes = total_bytes;
         }
 
+        std::lock_guard<std::mutex> lock(transfer->mutex);
         transfer->current_file = file::FileManager::get_filename(current_file);
     };
 
     transfer->client_inst->set_progress_callback(progress_cb);
 
-    transfer->thread = std::thread([this, transfer, direction, local_path, remote_path, items, resume, host, port, progress_cb, force, tasks]() {
+    transfer->thread = std::thread([this, transfer, direction, local_path, remote_path, items, resume, profile, negotiated_streams, progress_cb, force, tasks]() {
         try {
             std::exception_ptr first_error;
             std::mutex error_mutex;
@@ -1042,9 +1073,10 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
                 if (!first_error) {
                     first_error = error;
                 }
+                transfer->scheduler.stop();
             };
 
-            uint32_t max_threads = transfer->client_inst->get_negotiated_parallel_streams();
+            uint32_t max_threads = negotiated_streams;
             if (max_threads == 0) max_threads = 4;
             
             bool single_large_file = (tasks.size() == 1 && tasks[0].size > 64 * 1024 * 1024);
@@ -1057,80 +1089,64 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
 
             std::vector<std::thread> worker_threads;
             for (uint32_t w = 0; w < num_workers; ++w) {
-                worker_threads.push_back(std::thread([this, transfer, direction, host, port, progress_cb, force, &first_error, &record_error, tasks, single_large_file, max_threads]() {
-                    try {
-                        client::Client stream_client;
-                        stream_client.set_config(active_client_config_);
-                        stream_client.set_security_level(active_security_level_);
-                        
-                        uint32_t streams = single_large_file ? max_threads : 1;
-                        stream_client.set_requested_parallel_streams(streams);
-                        
-                        stream_client.bandwidth_limiter_ = transfer->client_inst->bandwidth_limiter_;
-                        stream_client.set_progress_callback(progress_cb);
-                        
-                        // Overwrite callback is set dynamically per task below
+                worker_threads.push_back(std::thread([this, transfer, direction, profile, progress_cb, force, &first_error, &record_error, tasks, single_large_file, max_threads]() {
+                    client::ConnectionProfile worker_profile = profile;
+                    worker_profile.parallel_streams = single_large_file ? max_threads : 1;
+                    client::ConnectionPool::Lease stream_client;
+
+                    // Dead or skipped-out connections are closed; healthy
+                    // ones go back to the pool for the next transfer
+                    auto release_connection = [&](bool discard) {
+                        if (!stream_client) {
+                            return;
+                        }
+                        transfer->client_inst->unregister_worker(&*stream_client);
+                        if (discard) {
+                            stream_client.discard();
+                        } else {
+                            stream_client = client::ConnectionPool::Lease();
+                        }
+                    };
 
-                        stream_client.set_parent_client(transfer->client_inst.get());
-                        transfer->client_inst->register_worker(&stream_client);
+                    try {
+                        auto should_stop = [&]() {
+                            return transfer->client_inst->cancel_requested_ || (stream_client && stream_client->cancel_requested_) || transfer->cancelled || first_error;
+                        };
 
                         while (true) {
-                            if (transfer->client_inst->cancel_requested_ || stream_client.cancel_requested_ || transfer->cancelled || first_error) {
+                            if (should_stop()) {
                                 break;
                             }
                             
-                            if (!stream_client.is_connected()) {
+                            if (!stream_client || !stream_client->is_connected()) {
+                                release_connection(true);
                                 try {
-                                    stream_client.connect(host, port);
+                                    stream_client = pool_.acquire_verified(worker_profile);
                                 } catch (...) {
-                                    // Connection failed. Wait 2 seconds on cv_task and retry.
-                                    std::unique_lock<std::mutex> lock(transfer->task_mutex);
-                                    transfer->cv_task.wait_for(lock, std::chrono::seconds(2));
+                                    // Connection failed. Wait 2 seconds and retry.
+                                    transfer->scheduler.wait_for(std::chrono::seconds(2));
                                     continue;
                                 }
-                            }
-                            
-                            size_t task_idx = -1;
-                            std::string task_decision;
-                            
-                            {
-                                std::unique_lock<std::mutex> lock(transfer->task_mutex);
-                                while (true) {
-                                    if (transfer->client_inst->cancel_requested_ || stream_client.cancel_requested_ || transfer->cancelled || first_error) {
-                                        break;
-                                    }
 
-                                    bool all_completed_or_skipped = true;
-                                    for (size_t i = 0; i < tasks.size(); ++i) {
-                                        auto& f = transfer->files[i];
-                                        if (f.status != "completed" && f.status != "skipped" && f.status != "failed") {
-                                            all_completed_or_skipped = false;
-                                        }
-                                        if (f.decision != "none" && f.status != "transferring" && f.status != "paused" && f.status != "completed" && f.status != "skipped" && f.status != "failed") {
-                                            task_idx = i;
-                                            task_decision = f.decision;
-                                            f.status = "transferring";
-                                            f.popped = true;
-                                            break;
-                                        }
-                                    }
+                                stream_client->bandwidth_limiter_ = transfer->client_inst->bandwidth_limiter_;
+                                stream_client->set_progress_callback(progress_cb);
 
-                                    if (task_idx != -1 || all_completed_or_skipped) {
-                                        break;
-                                    }
+                                // Overwrite callback is set dynamically per task below
 
-                                    transfer->cv_task.wait_for(lock, std::chrono::milliseconds(500));
-                                }
+                                stream_client->set_parent_client(transfer->client_inst.get());
+                                transfer->client_inst->register_worker(&*stream_client);
                             }
-
-                            if (task_idx == -1) {
+                            
+                            std::string task_decision;
+                            size_t task_idx = transfer->scheduler.acquire(task_decision, should_stop);
+                            if (task_idx == TransferScheduler::npos) {
                                 break;
                             }
 
                             const auto& task = tasks[task_idx];
                             bool resume_file = (task_decision == "resume");
                             
-                            stream_client.set_overwrite_callback([task_decision](const std::string&, uint64_t) {
+                            stream_client->set_overwrite_callback([task_decision](const std::string&, uint64_t) {
                                 if (task_decision == "delta_sync") {
                                     return client::Client::OverwriteDecision::DELTA_SYNC;
                                 }
@@ -1139,38 +1155,42 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
 
                             try {
                                 if (direction == "upload") {
-                                    stream_client.transfer_file(task.source_path, task.dest_path, resume_file);
+                                    stream_client->transfer_file(task.source_path, task.dest_path, resume_file);
                                 } else {
                                     std::string dest_dir = file::FileManager::get_directory(task.dest_path);
                                     if (!dest_dir.empty()) {
                                         file::FileManager::create_directories(dest_dir);
                                     }
-                                    stream_client.download_file(task.source_path, task.dest_path, resume_file);
+                                    stream_client->download_file(task.source_path, task.dest_path, resume_file);
                                 }
 
-                                if (!stream_client.get_session_id().empty()) {
+                                if (!stream_client->get_session_id().empty()) {
                                     std::lock_guard<std::mutex> t_lock(transfer->mutex);
-                                    if (std::find(transfer->session_ids.begin(), transfer->session_ids.end(), stream_client.get_session_id()) == transfer->session_ids.end()) {
-                                        transfer->session_ids.push_back(stream_client.get_session_id());
+                                    if (std::find(transfer->session_ids.begin(), transfer->session_ids.end(), stream_client->get_session_id()) == transfer->session_ids.end()) {
+                                        transfer->session_ids.push_back(stream_client->get_session_id());
                                     }
                                     if (transfer->session_id.empty()) {
-                                        transfer->session_id = stream_client.get_session_id();
+                                        transfer->session_id = stream_client->get_session_id();
                                     }
                                 }
 
-                                {
-                                    std::lock_guard<std::mutex> t_lock(transfer->mutex);
-                                    transfer->files[task_idx].status = "completed";
-                                    transfer->files[task_idx].bytes_transferred = task.size;
-                                    transfer->files[task_idx].rate_string = "0 B/s";
-                                    transfer->files[task_idx].popped = false;
+                                transfer->scheduler.update(task_idx, [&](FileProgress& f) {
+                                    f.state = FileState::Completed;
+                                    f.bytes_transferred = task.size;
+                                    f.rate_string = "0 B/s";
+                                    f.popped = false;
+                                });
+                                if (direction == "upload") {
+                                    // Folders showing the new file list it on the next refresh
+                                    listing_cache_.invalidate(task.dest_path);
                                 }
                             } catch (const FileSkippedException&) {
-                                std::lock_guard<std::mutex> t_lock(transfer->mutex);
-                                transfer->files[task_idx].status = "skipped";
-                                transfer->files[task_idx].rate_string = "0 B/s";
-                                transfer->files[task_idx].popped = false;
-                                stream_client.disconnect();
+                                transfer->scheduler.update(task_idx, [](FileProgress& f) {
+                                    f.state = FileState::Skipped;
+                                    f.rate_string = "0 B/s";
+                                    f.popped = false;
+                                });
+                                release_connection(true);
                             } catch (...) {
                                 bool server_down = false;
                                 {
@@ -1180,30 +1200,28 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
                                     }
                                 }
                                 if (!server_down) {
-                                    if (!stream_client.is_connected()) {
+                                    if (!stream_client->is_connected()) {
                                         server_down = true;
                                     }
                                 }
 
                                 if (server_down) {
-                                    {
-                                        std::lock_guard<std::mutex> t_lock(transfer->mutex);
-                                        transfer->files[task_idx].status = "paused";
-                                        transfer->files[task_idx].decision = "resume";
-                                        transfer->files[task_idx].rate_string = "0 B/s";
-                                        transfer->files[task_idx].popped = false;
-                                    }
-                                    try { stream_client.disconnect(); } catch (...) {}
+                                    transfer->scheduler.update(task_idx, [](FileProgress& f) {
+                                        f.state = FileState::Paused;
+                                        f.decision = "resume";
+                                        f.rate_string = "0 B/s";
+                                        f.popped = false;
+                                    });
+                                    release_connection(true);
                                     LOG_INFO("Worker detected server disconnection, pausing file: " + task.source_path);
                                     record_error(std::current_exception());
                                     break;
                                 } else {
-                                    {
-                                        std::lock_guard<std::mutex> t_lock(transfer->mutex);
-                                        transfer->files[task_idx].status = "failed";
-                                        transfer->files[task_idx].rate_string = "0 B/s";
-                                        transfer->files[task_idx].popped = false;
-                                    }
+                                    transfer->scheduler.update(task_idx, [](FileProgress& f) {
+                                        f.state = FileState::Failed;
+                                        f.rate_string = "0 B/s";
+                                        f.popped = false;
+                                    });
                                     // Log the error but continue with the next file
                                     try {
                                         std::rethrow_exception(std::current_exception());
@@ -1215,8 +1233,9 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
                             }
                         }
 
-                        transfer->client_inst->unregister_worker(&stream_client);
+                        release_connection(false);
                     } catch (...) {
+                        release_connection(true);
                         record_error(std::current_exception());
                     }
                 }));
@@ -1231,27 +1250,26 @@ void GuiServer::handle_api_transfer(std::shared_ptr<asio::ip::tcp::socket> clien
             }
 
             // Mark completed
+            transfer->scheduler.update_all([](FileProgress& f) {
+                if (f.state == FileState::Transferring || f.state == FileState::Pending) {
+                    f.state = FileState::Completed;
+                    f.bytes_transferred = f.total_bytes;
+                }
+            });
             {
                 std::lock_guard<std::mutex> lock(transfer->mutex);
                 transfer->bytes_transferred = transfer->total_bytes.load();
                 transfer->current_file = "Completed";
-                for (auto& f : transfer->files) {
-                    if (f.status == "transferring" || f.status == "pending") {
-                        f.status = "completed";
-                        f.bytes_transferred = f.total_bytes;
-                    }
-                }
             }
             transfer->active = false;
         } catch (const std::exception& e) {
             transfer->error_message = e.what();
             transfer->active = false;
-            std::lock_guard<std::mutex> lock(transfer->mutex);
-            for (auto& f : transfer->files) {
-                if (f.status == "transferring" || f.status == "pending") {
-                    f.status = "paused";
+            transfer->scheduler.update_all([](FileProgress& f) {
+                if (f.state == FileState::Transferring || f.state == FileState::Pending) {
+                    f.state = FileState::Paused;
                 }
-            }
+            });
         }
         
         try {
@@ -1292,6 +1310,7 @@ void GuiServer::handle_api_transfers(std::shared_ptr<asio::ip::tcp::socket> clie
         body += "\"current_file\":\"" + escape_json(t->current_file) + "\",";
         body += "\"start_time\":\"" + escape_json(t->start_time) + "\",";
         body += "\"session_id\":\"" + escape_json(t->session_id) + "\",";
+        body += "\"counts\":" + file_counts_json(t->scheduler.counters()) + ",";
         body += "\"error\":\"" + escape_json(t->error_message) + "\"";
         body += "}";
         
@@ -1368,19 +1387,23 @@ void GuiServer::handle_api_transfer_status(std::shared_ptr<asio::ip::tcp::socket
     body += "\"percent\":" + std::to_string(percent) + ",";
     body += "\"current_file\":\"" + escape_json(t->current_file) + "\",";
     body += "\"error\":\"" + escape_json(t->error_message) + "\",";
+    body += "\"counts\":" + file_counts_json(t->scheduler.counters()) + ",";
     body += "\"files\":[";
-    for (size_t i = 0; i < t->files.size(); ++i) {
-        const auto& f = t->files[i];
-        
-        std::string file_status = f.status;
+    bool first_file = true;
+    t->scheduler.for_each([&](const FileProgress& f) {
+        std::string file_status = file_state_name(f.state);
         if (t->client_inst) {
             if (t->client_inst->is_file_skipped(f.path)) {
                 file_status = "skipped";
-            } else if (t->client_inst->is_file_paused(f.path) && file_status == "transferring") {
+            } else if (t->client_inst->is_file_paused(f.path) && f.state == FileState::Transferring) {
                 file_status = "paused";
             }
         }
 
+        if (!first_file) {
+            body += ",";
+        }
+        first_file = false;
         body += "{";
         body += "\"path\":\"" + escape_json(f.path) + "\",";
         body += "\"bytes_transferred\":" + std::to_string(f.bytes_transferred) + ",";
@@ -1389,10 +1412,7 @@ void GuiServer::handle_api_transfer_status(std::shared_ptr<asio::ip::tcp::socket
         body += "\"rate_string\":\"" + escape_json(f.rate_string) + "\",";
         body += "\"decision\":\"" + escape_json(f.decision) + "\"";
         body += "}";
-        if (i + 1 < t->files.size()) {
-            body += ",";
-        }
-    }
+    });
     body += "]}";
 
     send_response(client_socket, "200 OK", "application/json", body);
@@ -1402,9 +1422,6 @@ void GuiServer::handle_api_transfer_abort(std::shared_ptr<asio::ip::tcp::socket>
     std::string id = get_json_value(request_body, "id");
     if (id.empty()) {
         std::lock_guard<std::mutex> lock(client_mutex_);
-        if (active_client_) {
-            active_client_->request_cancel();
-        }
         transfer_active_ = false;
         transfer_error_ = "Transfer aborted by user";
         send_response(client_socket, "200 OK", "application/json", "{\"success\":true}");
@@ -1428,6 +1445,7 @@ void GuiServer::handle_api_transfer_abort(std::shared_ptr<asio::ip::tcp::socket>
     if (t->client_inst) {
         t->client_inst->request_cancel();
     }
+    t->scheduler.stop();
     t->active = false;
     t->error_message = "Transfer aborted by user";
     send_response(client_socket, "200 OK", "application/json", "{\"success\":true}");
@@ -1490,39 +1508,35 @@ void GuiServer::handle_api_transfer_file_control(std::shared_ptr<asio::ip::tcp::
         return;
     }
 
-    std::lock_guard<std::mutex> t_lock(t->mutex);
     bool found = false;
-    std::string path_norm = normalize_gui_path(path);
-    for (auto& f : t->files) {
-        if (normalize_gui_path(f.path) == path_norm) {
+    size_t index = t->scheduler.find(path);
+    if (index != TransferScheduler::npos) {
+        t->scheduler.update(index, [&](FileProgress& f) {
+            found = true;
             if (action == "pause") {
                 t->client_inst->pause_file(f.path);
-                f.status = "paused";
+                f.state = FileState::Paused;
             } else if (action == "resume" || action == "start" || action == "overwrite" || action == "re-transfer" || action == "delta_sync") {
-                if (f.status == "paused") {
+                if (f.state == FileState::Paused) {
                     t->client_inst->resume_file(f.path);
                     if (f.popped) {
-                        f.status = "transferring";
+                        f.state = FileState::Transferring;
                     } else {
                         f.decision = "resume";
-                        f.status = "pending";
+                        f.state = FileState::Pending;
                     }
-                    t->cv_task.notify_all();
                 } else {
                     f.decision = action;
-                    f.status = "pending";
+                    f.state = FileState::Pending;
                     if (action == "overwrite" || action == "re-transfer") {
                         f.bytes_transferred = 0;
                     }
-                    t->cv_task.notify_all();
                 }
             } else if (action == "skip") {
                 t->client_inst->skip_file(f.path);
-                f.status = "skipped";
+                f.state = FileState::Skipped;
             }
-            found = true;
-            break;
-        }
+        });
     }
 
     if (!found) {
@@ -1666,6 +1680,16 @@ std::vector<std::string> GuiServer::get_json_array(const std::string& json, cons
     return result;
 }
 
+client::ConnectionProfile GuiServer::remote_profile_locked(uint32_t parallel_streams) const {
+    client::ConnectionProfile profile;
+    profile.host = remote_host_;
+    profile.port = remote_port_;
+    profile.config = active_client_config_;
+    profile.security_level = active_security_level_;
+    profile.parallel_streams = parallel_streams;
+    return profile;
+}
+
 void GuiServer::handle_api_transfer_remove(std::shared_ptr<asio::ip::tcp::socket> client_socket, const std::string& request_body) {
     std::string id = get_json_value(request_body, "id");
     if (id.empty()) {
@@ -1683,7 +1707,7 @@ void GuiServer::handle_api_transfer_remove(std::shared_ptr<asio::ip::tcp::socket
             }
             t->cancelled = true;
             t->active = false;
-            t->cv_task.notify_all();
+            t->scheduler.stop();
         }
         if (t->thread.joinable()) {
             t->thread.detach();
@@ -1720,78 +1744,76 @@ void GuiServer::handle_api_transfer_control(std::shared_ptr<asio::ip::tcp::socke
         return;
     }
 
-    std::lock_guard<std::mutex> t_lock(t->mutex);
-    for (auto& f : t->files) {
+    t->scheduler.update_all([&](FileProgress& f) {
         if (action == "pause") {
             t->client_inst->pause_file(f.path);
-            if (f.status == "transferring" || f.status == "pending") {
-                f.status = "paused";
+            if (f.state == FileState::Transferring || f.state == FileState::Pending) {
+                f.state = FileState::Paused;
             }
         } else if (action == "resume" || action == "start_all") {
-            if (f.status == "paused") {
+            if (f.state == FileState::Paused) {
                 t->client_inst->resume_file(f.path);
                 if (f.popped) {
-                    f.status = "transferring";
+                    f.state = FileState::Transferring;
                 } else {
                     f.decision = "resume";
-                    f.status = "pending";
+                    f.state = FileState::Pending;
                 }
-            } else if (f.status == "exists_exact") {
+            } else if (f.state == FileState::ExistsExact) {
                 f.decision = "overwrite";
-                f.status = "pending";
+                f.state = FileState::Pending;
                 f.bytes_transferred = 0;
-            } else if (f.status == "exists_partial") {
+            } else if (f.state == FileState::ExistsPartial) {
                 f.decision = "resume";
-                f.status = "pending";
-            } else if (f.status == "pending" && f.decision == "none") {
+                f.state = FileState::Pending;
+            } else if (f.state == FileState::Pending && f.decision == "none") {
                 f.decision = "start";
-                f.status = "pending";
+                f.state = FileState::Pending;
             }
         } else if (action == "overwrite_all") {
-            if (f.status == "exists_exact" || f.status == "exists_partial") {
+            if (f.state == FileState::ExistsExact || f.state == FileState::ExistsPartial) {
                 f.decision = "overwrite";
-                f.status = "pending";
+                f.state = FileState::Pending;
                 f.bytes_transferred = 0;
-            } else if (f.status == "pending" && f.decision == "none") {
+            } else if (f.state == FileState::Pending && f.decision == "none") {
                 f.decision = "start";
-                f.status = "pending";
+                f.state = FileState::Pending;
             }
         } else if (action == "overwrite_resume_all") {
-            if (f.status == "exists_exact") {
+            if (f.state == FileState::ExistsExact) {
                 f.decision = "overwrite";
-                f.status = "pending";
+                f.state = FileState::Pending;
                 f.bytes_transferred = 0;
-            } else if (f.status == "exists_partial") {
+            } else if (f.state == FileState::ExistsPartial) {
                 f.decision = "resume";
-                f.status = "pending";
-            } else if (f.status == "pending" && f.decision == "none") {
+                f.state = FileState::Pending;
+            } else if (f.state == FileState::Pending && f.decision == "none") {
                 f.decision = "start";
-                f.status = "pending";
+                f.state = FileState::Pending;
             }
         } else if (action == "delta_sync_all") {
-            if (f.status == "exists_exact" || f.status == "exists_partial") {
+            if (f.state == FileState::ExistsExact || f.state == FileState::ExistsPartial) {
                 f.decision = "delta_sync";
-                f.status = "pending";
+                f.state = FileState::Pending;
                 f.bytes_transferred = 0;
-            } else if (f.status == "pending" && f.decision == "none") {
+            } else if (f.state == FileState::Pending && f.decision == "none") {
                 f.decision = "start";
-                f.status = "pending";
+                f.state = FileState::Pending;
             }
         } else if (action == "delta_sync_resume_all") {
-            if (f.status == "exists_exact") {
+            if (f.state == FileState::ExistsExact) {
                 f.decision = "delta_sync";
-                f.status = "pending";
+                f.state = FileState::Pending;
                 f.bytes_transferred = 0;
-            } else if (f.status == "exists_partial") {
+            } else if (f.state == FileState::ExistsPartial) {
                 f.decision = "resume";
-                f.status = "pending";
-            } else if (f.status == "pending" && f.decision == "none") {
+                f.state = FileState::Pending;
+            } else if (f.state == FileState::Pending && f.decision == "none") {
                 f.decision = "start";
-                f.status = "pending";
+                f.state = FileState::Pending;
             }
         }
-    }
-    t->cv_task.notify_all();
+    });
 
     send_response(client_socket, "200 OK", "application/json", "{\"success\":true}");
 }
@@ -1833,10 +1855,12 @@ void GuiServer::handle_api_transfer_server_session(std::shared_ptr<asio::ip::tcp
     }
 
     try {
-        client::Client temp_client;
-        temp_client.set_config(active_client_config_);
-        temp_client.set_security_level(active_security_level_);
-        temp_client.connect(remote_host_, remote_port_);
+        client::ConnectionProfile profile;
+        {
+            std::lock_guard<std::mutex> lock(client_mutex_);
+            profile = remote_profile_locked();
+        }
+        auto temp_client = pool_.acquire_verified(profile);
         
         uint64_t total_bytes_transferred = 0;
         uint64_t total_bytes_limit = 0;
@@ -1845,7 +1869,7 @@ void GuiServer::handle_api_transfer_server_session(std::shared_ptr<asio::ip::tcp
         std::string final_status = "completed";
 
         for (const auto& sess_id : session_ids) {
-            auto resp = temp_client.query_transfer_status(sess_id);
+            auto resp = temp_client->query_transfer_status(sess_id);
             if (resp.success) {
                 total_bytes_transferred += resp.bytes_transferred;
                 total_bytes_limit += resp.total_bytes;
@@ -1863,7 +1887,6 @@ void GuiServer::handle_api_transfer_server_session(std::shared_ptr<asio::ip::tcp
                 }
             }
         }
-        temp_client.disconnect();
 
         uint64_t local_transferred = 0;
         uint64_t local_total = 0;
@@ -1879,19 +1902,18 @@ void GuiServer::handle_api_transfer_server_session(std::shared_ptr<asio::ip::tcp
             direction = t->direction;
             source = t->source;
             destination = t->destination;
-            for (size_t i = 0; i < t->files.size(); ++i) {
-                const auto& f = t->files[i];
-                files_json += "{";
-                files_json += "\"path\":\"" + escape_json(f.path) + "\",";
-                files_json += "\"total_bytes\":" + std::to_string(f.total_bytes) + ",";
-                files_json += "\"bytes_transferred\":" + std::to_string(f.bytes_transferred) + ",";
-                files_json += "\"status\":\"" + escape_json(f.status) + "\"";
-                files_json += "}";
-                if (i + 1 < t->files.size()) {
-                    files_json += ",";
-                }
-            }
         }
+        t->scheduler.for_each([&](const FileProgress& f) {
+            if (files_json.size() > 1) {
+                files_json += ",";
+            }
+            files_json += "{";
+            files_json += "\"path\":\"" + escape_json(f.path) + "\",";
+            files_json += "\"total_bytes\":" + std::to_string(f.total_bytes) + ",";
+            files_json += "\"bytes_transferred\":" + std::to_string(f.bytes_transferred) + ",";
+            files_json += "\"status\":\"" + std::string(file_state_name(f.state)) + "\"";
+            files_json += "}";
+        });
         files_json += "]";
 
         std::string body = "{";
@@ -1917,23 +1939,19 @@ void GuiServer::handle_api_transfer_server_session(std::shared_ptr<asio::ip::tcp
 
 void GuiServer::handle_api_remote_check(std::shared_ptr<asio::ip::tcp::socket> client_socket) {
     bool connected = false;
-    std::string host;
-    uint16_t port = 0;
+    client::ConnectionProfile profile;
     
     {
         std::lock_guard<std::mutex> lock(client_mutex_);
         connected = remote_connected_;
-        host = remote_host_;
-        port = remote_port_;
+        profile = remote_profile_locked();
     }
 
     if (connected) {
         try {
-            client::Client check_client;
-            check_client.set_config(active_client_config_);
-            check_client.set_security_level(active_security_level_);
-            check_client.connect(host, port);
-            check_client.disconnect();
+            // A pooled connection that still answers proves the server is
+            // reachable without a new handshake
+            pool_.acquire_verified(profile);
         } catch (...) {
             connected = false;
         }
@@ -1942,7 +1960,8 @@ void GuiServer::handle_api_remote_check(std::shared_ptr<asio::ip::tcp::socket> c
     if (!connected) {
         std::lock_guard<std::mutex> lock(client_mutex_);
         remote_connected_ = false;
-        active_client_ = nullptr;
+        pool_.clear();
+        listing_cache_.clear();
     }
 
     std::string body = "{\"connected\":" + std::string(connected ? "true" : "false") + "}";
@@ -1953,12 +1972,8 @@ void GuiServer::handle_api_disconnect(std::shared_ptr<asio::ip::tcp::socket> cli
     {
         std::lock_guard<std::mutex> lock(client_mutex_);
         remote_connected_ = false;
-        if (active_client_) {
-            try {
-                active_client_->disconnect();
-            } catch (...) {}
-            active_client_ = nullptr;
-        }
+        pool_.clear();
+        listing_cache_.clear();
     }
     send_response(client_socket, "200 OK", "application/json", "{\"success\":true}");
 }
@@ -2003,12 +2018,19 @@ void GuiServer::handle_api_remote_create_dir(std::shared_ptr<asio::ip::tcp::sock
     full_path = common::convert_to_unix_path(full_path);
 
     try {
-        std::lock_guard<std::mutex> lock(client_mutex_);
-        if (!remote_connected_ || !active_client_) {
-            send_error(client_socket, 400, "Not connected to remote server");
-            return;
+        client::ConnectionProfile profile;
+        {
+            std::lock_guard<std::mutex> lock(client_mutex_);
+            if (!remote_connected_) {
+                send_error(client_socket, 400, "Not connected to remote server");
+                return;
+            }
+            profile = remote_profile_locked();
         }
-        active_client_->create_empty_directory(full_path);
+        pool_.run(profile, [&](client::Client& client) {
+            client.create_empty_directory(full_path);
+        });
+        listing_cache_.invalidate(full_path);
         send_response(client_socket, "200 OK", "application/json", "{\"success\":true}");
     } catch (const std::exception& e) {
         send_response(client_socket, "200 OK", "application/json", "{\"success\":false,\"error\":\"" + escape_json(e.what()) + "\"}");
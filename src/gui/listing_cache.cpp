@@ -0,0 +1,196 @@
+#include "gui/listing_cache.h"
+#include "logging/logger.h"
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace netcopy {
+namespace gui {
+
+namespace {
+
+constexpr std::chrono::seconds kFreshFor{5};
+constexpr size_t kMaxListings = 512;
+constexpr size_t kMaxCachedBytes = 64 * 1024 * 1024;
+constexpr size_t kMaxPrefetch = 16; // subdirectories loaded per folder viewed
+
+size_t listing_bytes(const ListingCache::Listing& listing) {
+    size_t bytes = listing.files_json.size();
+    for (const auto& dir : listing.subdirectories) {
+        bytes += dir.size();
+    }
+    return bytes;
+}
+
+} // namespace
+
+ListingCache::ListingCache() {
+    prefetcher_ = std::thread([this]() { prefetch_loop(); });
+}
+
+ListingCache::~ListingCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    wake_.notify_all();
+    if (prefetcher_.joinable()) {
+        prefetcher_.join();
+    }
+}
+
+std::string ListingCache::key(const std::string& path) {
+    // The browser builds paths with either separator and may add a
+    // trailing one; all spellings share an entry
+    std::string key;
+    key.reserve(path.size());
+    for (char c : path) {
+        if (c == '\\') {
+            c = '/';
+        }
+        if (c == '/' && !key.empty() && key.back() == '/') {
+            continue;
+        }
+        key += c;
+    }
+    while (key.size() > 1 && key.back() == '/' && !(key.size() == 3 && key[1] == ':')) {
+        key.pop_back();
+    }
+    return key;
+}
+
+bool ListingCache::is_fresh(const Entry& entry, std::chrono::steady_clock::time_point now) const {
+    return entry.validated != std::chrono::steady_clock::time_point{} && now - entry.validated < kFreshFor;
+}
+
+void ListingCache::set_fetcher(Fetcher fetcher) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fetcher_ = std::move(fetcher);
+}
+
+bool ListingCache::lookup(const std::string& path, Listing& listing, bool& fresh) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key(path));
+    if (it == entries_.end()) {
+        return false;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    it->second.last_used = now;
+    listing = it->second.listing;
+    fresh = is_fresh(it->second, now);
+    return true;
+}
+
+uint64_t ListingCache::epoch() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return epoch_;
+}
+
+void ListingCache::store(const std::string& path, Listing listing, uint64_t epoch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = entries_[key(path)];
+    cached_bytes_ -= listing_bytes(entry.listing);
+    cached_bytes_ += listing_bytes(listing);
+    entry.listing = std::move(listing);
+    const auto now = std::chrono::steady_clock::now();
+    entry.validated = epoch == epoch_ ? now : std::chrono::steady_clock::time_point{};
+    entry.last_used = now;
+    evict_locked();
+}
+
+void ListingCache::confirm(const std::string& path, uint64_t epoch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key(path));
+    if (it != entries_.end() && epoch == epoch_) {
+        it->second.validated = std::chrono::steady_clock::now();
+    }
+}
+
+void ListingCache::invalidate(const std::string& changed_path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++epoch_;
+    std::string dir = key(changed_path);
+    while (true) {
+        auto it = entries_.find(dir);
+        if (it != entries_.end()) {
+            it->second.validated = {};
+        }
+        size_t slash = dir.find_last_of('/');
+        if (slash == std::string::npos || dir.size() <= 1) {
+            break;
+        }
+        // "/a" -> "/", "C:/a" -> "C:/", "a/b" -> "a"
+        std::string parent = dir.substr(0, slash);
+        if (parent.empty() || (parent.size() == 2 && parent[1] == ':')) {
+            parent += '/';
+        }
+        if (parent == dir) {
+            break;
+        }
+        dir = std::move(parent);
+    }
+}
+
+void ListingCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++epoch_;
+    entries_.clear();
+    cached_bytes_ = 0;
+    queue_.clear();
+}
+
+void ListingCache::prefetch(const std::vector<std::string>& paths) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Only the folder being viewed matters; drop what is left of the last one
+        queue_.clear();
+        const auto now = std::chrono::steady_clock::now();
+        for (const auto& path : paths) {
+            if (queue_.size() >= kMaxPrefetch) {
+                break;
+            }
+            auto it = entries_.find(key(path));
+            if (it == entries_.end() || !is_fresh(it->second, now)) {
+                queue_.push_back(path);
+            }
+        }
+        if (queue_.empty()) {
+            return;
+        }
+    }
+    wake_.notify_all();
+}
+
+void ListingCache::evict_locked() {
+    while (entries_.size() > kMaxListings || (cached_bytes_ > kMaxCachedBytes && entries_.size() > 1)) {
+        auto oldest = std::min_element(entries_.begin(), entries_.end(), [](const auto& a, const auto& b) {
+            return a.second.last_used < b.second.last_used;
+        });
+        cached_bytes_ -= listing_bytes(oldest->second.listing);
+        entries_.erase(oldest);
+    }
+}
+
+void ListingCache::prefetch_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this]() { return stopping_ || (!queue_.empty() && fetcher_); });
+        if (stopping_) {
+            return;
+        }
+        std::string path = std::move(queue_.front());
+        queue_.pop_front();
+        Fetcher fetcher = fetcher_;
+        lock.unlock();
+        try {
+            fetcher(path);
+        } catch (const std::exception& e) {
+            LOG_DEBUG("Listing prefetch of " + path + " failed: " + e.what());
+        }
+        lock.lock();
+    }
+}
+
+} // namespace gui
+} // namespace netcopy
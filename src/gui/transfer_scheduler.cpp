@@ -0,0 +1,213 @@
+#include "gui/transfer_scheduler.h"
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+namespace netcopy {
+namespace gui {
+
+namespace {
+
+std::string path_key(const std::string& path) {
+    std::string key = path;
+    std::replace(key.begin(), key.end(), '\\', '/');
+#ifdef _WIN32
+    for (auto& c : key) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+#endif
+    return key;
+}
+
+} // namespace
+
+const char* file_state_name(FileState state) {
+    switch (state) {
+        case FileState::Pending: return "pending";
+        case FileState::Transferring: return "transferring";
+        case FileState::Paused: return "paused";
+        case FileState::Skipped: return "skipped";
+        case FileState::Completed: return "completed";
+        case FileState::Failed: return "failed";
+        case FileState::ExistsExact: return "exists_exact";
+        case FileState::ExistsPartial: return "exists_partial";
+    }
+    return "pending";
+}
+
+bool TransferScheduler::is_finished(FileState state) {
+    return state == FileState::Completed || state == FileState::Skipped || state == FileState::Failed;
+}
+
+bool TransferScheduler::is_ready(size_t index) const {
+    const auto& file = files_[index];
+    return tasks_[index] && file.state == FileState::Pending && file.decision != "none";
+}
+
+void TransferScheduler::count(size_t index, int direction) {
+    const auto& file = files_[index];
+    auto apply = [direction](auto& value, auto amount) {
+        if (direction > 0) {
+            value += amount;
+        } else {
+            value -= amount;
+        }
+    };
+    apply(counters_.by_state[static_cast<size_t>(file.state)], size_t(1));
+    apply(counters_.bytes_transferred, file.bytes_transferred);
+    apply(counters_.total_bytes, file.total_bytes);
+    if (is_ready(index)) {
+        apply(counters_.ready, size_t(1));
+    }
+    if (tasks_[index] && !is_finished(file.state)) {
+        apply(unfinished_tasks_, size_t(1));
+    }
+}
+
+size_t TransferScheduler::add(FileProgress file, bool task) {
+    size_t index;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        index = add_locked(std::move(file), task);
+    }
+    changed_.notify_all();
+    return index;
+}
+
+size_t TransferScheduler::add_locked(FileProgress file, bool task) {
+    size_t index = files_.size();
+    by_path_.emplace(path_key(file.path), index);
+    files_.push_back(std::move(file));
+    tasks_.push_back(task);
+    queued_.push_back(false);
+    ++counters_.files;
+    count(index, +1);
+    if (is_ready(index)) {
+        ready_.push_back(index);
+        queued_[index] = true;
+    }
+    return index;
+}
+
+size_t TransferScheduler::find(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find_locked(path);
+}
+
+size_t TransferScheduler::find_locked(const std::string& path) const {
+    auto it = by_path_.find(path_key(path));
+    return it != by_path_.end() ? it->second : npos;
+}
+
+size_t TransferScheduler::acquire(std::string& decision, const std::function<bool()>& should_stop) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (stopped_ || (should_stop && should_stop())) {
+            return npos;
+        }
+        while (!ready_.empty()) {
+            size_t index = ready_.front();
+            ready_.pop_front();
+            queued_[index] = false;
+            if (!is_ready(index)) {
+                continue; // decided otherwise since it was queued
+            }
+            update_locked(index, [&](FileProgress& file) {
+                file.state = FileState::Transferring;
+                file.popped = true;
+                decision = file.decision;
+            });
+            return index;
+        }
+        if (unfinished_tasks_ == 0) {
+            return npos;
+        }
+        // Cancellation flags outside the scheduler do not signal; poll them
+        changed_.wait_for(lock, std::chrono::seconds(1));
+    }
+}
+
+void TransferScheduler::wait_for(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait_for(lock, timeout, [this]() { return stopped_; });
+}
+
+void TransferScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    changed_.notify_all();
+}
+
+bool TransferScheduler::update_locked(size_t index, const std::function<void(FileProgress&)>& fn) {
+    const FileState old_state = files_[index].state;
+    const bool was_ready = is_ready(index);
+    count(index, -1);
+    fn(files_[index]);
+    count(index, +1);
+    const bool ready = is_ready(index);
+    if (!queued_[index] && ready) {
+        ready_.push_back(index);
+        queued_[index] = true;
+    }
+    // Plain progress updates must not wake every worker
+    return files_[index].state != old_state || ready != was_ready;
+}
+
+void TransferScheduler::update(size_t index, const std::function<void(FileProgress&)>& fn) {
+    bool signal = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index >= files_.size()) {
+            return;
+        }
+        signal = update_locked(index, fn);
+    }
+    if (signal) {
+        changed_.notify_all();
+    }
+}
+
+void TransferScheduler::update_all(const std::function<void(FileProgress&)>& fn) {
+    bool signal = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < files_.size(); ++i) {
+            signal = update_locked(i, fn) || signal;
+        }
+    }
+    if (signal) {
+        changed_.notify_all();
+    }
+}
+
+void TransferScheduler::update_or_add(const std::string& path, const std::function<void(FileProgress&)>& fn) {
+    bool signal = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t index = find_locked(path);
+        if (index == npos) {
+            index = add_locked(FileProgress{path}, false);
+        }
+        signal = update_locked(index, fn);
+    }
+    if (signal) {
+        changed_.notify_all();
+    }
+}
+
+void TransferScheduler::for_each(const std::function<void(const FileProgress&)>& fn) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& file : files_) {
+        fn(file);
+    }
+}
+
+TransferScheduler::Counters TransferScheduler::counters() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return counters_;
+}
+
+} // namespace gui
+} // namespace netcopy
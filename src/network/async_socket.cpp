@@ -1,5 +1,9 @@
 #include "network/async_socket.h"
+#include "network/socket.h"
 #include "logging/logger.h"
+#ifdef NETCOPY_WITH_LINK_EMULATION
+#include "network/link_emulator.h"
+#endif
 #include <iostream>
 
 #ifdef _WIN32
@@ -23,11 +27,48 @@ AsyncSocket::~AsyncSocket() {
     disconnect();
 }
  
-void AsyncSocket::connect(const std::string& host, uint16_t port, std::function<void(ErrorCode)> handler) {
+void AsyncSocket::connect(const std::string& host, uint16_t port, std::function<void(ErrorCode)> handler,
+                          const std::string& local_address) {
     auto self = shared_from_this();
     asio::ip::tcp::resolver resolver(loop_.get_io_context());
+
+    std::string target_host = host;
+    uint16_t target_port = port;
+#ifdef NETCOPY_WITH_LINK_EMULATION
+    LinkEmulator::redirect_if_enabled(target_host, target_port);
+#endif
     
-    auto endpoints = resolver.resolve(host, std::to_string(port));
+    auto endpoints = resolver.resolve(target_host, std::to_string(target_port));
+
+    if (!local_address.empty()) {
+        // async_connect over a range reopens the socket per endpoint, which
+        // would drop the bind; connect to the first endpoint of the local
+        // address's family instead
+        ErrorCode ec;
+        auto local = asio::ip::make_address(local_address, ec);
+        if (!ec) {
+            ec = asio::error::address_family_not_supported;
+            for (const auto& entry : endpoints) {
+                if (entry.endpoint().address().is_v4() != local.is_v4()) {
+                    continue;
+                }
+                ec = {};
+                socket_.open(entry.endpoint().protocol(), ec);
+                if (!ec) {
+                    socket_.bind(asio::ip::tcp::endpoint(local, 0), ec);
+                }
+                if (!ec) {
+                    socket_.async_connect(entry.endpoint(), [self, handler](const ErrorCode& error) {
+                        handler(error);
+                    });
+                    return;
+                }
+                break;
+            }
+        }
+        asio::post(loop_.get_io_context(), [self, handler, ec]() { handler(ec); });
+        return;
+    }
     
     asio::async_connect(socket_, endpoints,
         [self, handler](const ErrorCode& ec, const asio::ip::tcp::endpoint&) {
@@ -184,6 +225,10 @@ void AsyncSocket::async_send_file(const std::string& filepath, uint64_t offset,
 #endif
 }
  
+std::vector<uint8_t> AsyncSocket::export_keying_material(const std::string& label, size_t length) {
+    return tls_export_keying_material(ssl_stream_ ? ssl_stream_->native_handle() : nullptr, label, length);
+}
+
 bool AsyncSocket::is_open() const {
     if (ssl_stream_) {
         return ssl_stream_->lowest_layer().is_open();
@@ -1,5 +1,6 @@
 #include "network/event_loop.h"
 #include "logging/logger.h"
+#include "common/utils.h"
 
 namespace netcopy {
 namespace network {
@@ -25,6 +26,9 @@ void EventLoop::start() {
     running_ = true;
     for (size_t i = 0; i < num_threads_; ++i) {
         workers_.emplace_back([this]() {
+            if (cpu_ >= 0 && !common::pin_current_thread_to_cpu(static_cast<unsigned>(cpu_))) {
+                LOG_DEBUG("EventLoop could not pin its thread to CPU " + std::to_string(cpu_));
+            }
             try {
                 io_context_.run();
             } catch (const std::exception& e) {
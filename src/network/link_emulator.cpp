@@ -0,0 +1,498 @@
+#include "network/link_emulator.h"
+#include "exceptions.h"
+#include "logging/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <random>
+#include <sstream>
+
+namespace netcopy {
+namespace network {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kSegmentBytes = 16 * 1024;
+constexpr uint64_t kMinQueueBytes = 1024 * 1024;
+constexpr uint64_t kUnshapedQueueBytes = 64ull * 1024ull * 1024ull;
+constexpr const char* kEnvVariable = "NETCOPY_LINK_EMULATION";
+
+std::string trim(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t");
+    if (start == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(start, end - start + 1);
+}
+
+std::string lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    return s;
+}
+
+// Splits "150ms" into (150, "ms"); throws on a missing number.
+std::pair<double, std::string> split_number(const std::string& key, const std::string& value) {
+    size_t pos = 0;
+    double number = 0.0;
+    try {
+        number = std::stod(value, &pos);
+    } catch (const std::exception&) {
+        throw ConfigException("Invalid link emulation value for '" + key + "': " + value);
+    }
+    if (number < 0.0) {
+        throw ConfigException("Link emulation value for '" + key + "' must not be negative");
+    }
+    return {number, lower(trim(value.substr(pos)))};
+}
+
+uint32_t parse_duration_ms(const std::string& key, const std::string& value) {
+    auto [number, unit] = split_number(key, value);
+    if (unit.empty() || unit == "ms") return static_cast<uint32_t>(number);
+    if (unit == "s") return static_cast<uint32_t>(number * 1000.0);
+    if (unit == "us") return static_cast<uint32_t>(number / 1000.0);
+    throw ConfigException("Unknown time unit '" + unit + "' for '" + key + "'");
+}
+
+uint64_t parse_rate_bps(const std::string& key, const std::string& value) {
+    auto [number, unit] = split_number(key, value);
+    if (unit.empty() || unit == "bit" || unit == "bps") return static_cast<uint64_t>(number);
+    if (unit == "kbit" || unit == "kbps") return static_cast<uint64_t>(number * 1e3);
+    if (unit == "mbit" || unit == "mbps") return static_cast<uint64_t>(number * 1e6);
+    if (unit == "gbit" || unit == "gbps") return static_cast<uint64_t>(number * 1e9);
+    throw ConfigException("Unknown rate unit '" + unit + "' for '" + key + "'");
+}
+
+uint64_t parse_bytes(const std::string& key, const std::string& value) {
+    auto [number, unit] = split_number(key, value);
+    if (unit.empty() || unit == "b") return static_cast<uint64_t>(number);
+    if (unit == "k" || unit == "kb") return static_cast<uint64_t>(number * 1024.0);
+    if (unit == "m" || unit == "mb") return static_cast<uint64_t>(number * 1024.0 * 1024.0);
+    throw ConfigException("Unknown size unit '" + unit + "' for '" + key + "'");
+}
+
+double parse_probability(const std::string& key, const std::string& value) {
+    auto [number, unit] = split_number(key, value);
+    double p = number;
+    if (unit == "%") {
+        p = number / 100.0;
+    } else if (!unit.empty()) {
+        throw ConfigException("Unknown unit '" + unit + "' for '" + key + "'");
+    }
+    if (p > 1.0) {
+        throw ConfigException("Link emulation '" + key + "' must be between 0 and 100%");
+    }
+    return p;
+}
+
+} // namespace
+
+bool LinkProfile::is_passthrough() const {
+    return rtt_ms == 0 && jitter_ms == 0 && bandwidth_bps == 0 && loss_rate <= 0.0 && reorder_rate <= 0.0;
+}
+
+std::string LinkProfile::to_string() const {
+    std::ostringstream out;
+    out << "rtt=" << rtt_ms << "ms"
+        << ",jitter=" << jitter_ms << "ms"
+        << ",rate=" << bandwidth_bps << "bit"
+        << ",loss=" << (loss_rate * 100.0) << "%"
+        << ",reorder=" << (reorder_rate * 100.0) << "%";
+    if (reorder_delay_ms > 0) out << ",reorder_delay=" << reorder_delay_ms << "ms";
+    if (queue_bytes > 0) out << ",queue=" << queue_bytes;
+    out << ",seed=" << seed;
+    return out.str();
+}
+
+LinkProfile LinkProfile::parse(const std::string& spec) {
+    LinkProfile profile;
+    std::string trimmed = lower(trim(spec));
+    if (trimmed.empty() || trimmed == "off" || trimmed == "none") {
+        return profile;
+    }
+
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = trim(item);
+        if (item.empty()) continue;
+        auto eq = item.find('=');
+        if (eq == std::string::npos) {
+            throw ConfigException("Link emulation entry must be key=value: " + item);
+        }
+        std::string key = lower(trim(item.substr(0, eq)));
+        std::string value = trim(item.substr(eq + 1));
+
+        if (key == "rtt") profile.rtt_ms = parse_duration_ms(key, value);
+        else if (key == "jitter") profile.jitter_ms = parse_duration_ms(key, value);
+        else if (key == "rate" || key == "bandwidth") profile.bandwidth_bps = parse_rate_bps(key, value);
+        else if (key == "loss") profile.loss_rate = parse_probability(key, value);
+        else if (key == "reorder") profile.reorder_rate = parse_probability(key, value);
+        else if (key == "reorder_delay") profile.reorder_delay_ms = parse_duration_ms(key, value);
+        else if (key == "queue") profile.queue_bytes = parse_bytes(key, value);
+        else if (key == "seed") profile.seed = static_cast<uint64_t>(split_number(key, value).first);
+        else throw ConfigException("Unknown link emulation key: " + key);
+    }
+    return profile;
+}
+
+// One shaping direction. The reader thread stamps each segment with its
+// delivery time as it enters the emulated bottleneck; the writer thread
+// releases segments in order once their time has come.
+class LinkEmulator::Pipe {
+public:
+    Pipe(asio::ip::tcp::socket& from, asio::ip::tcp::socket& to, const LinkProfile& profile,
+         uint64_t seed, LinkEmulator& owner)
+        : from_(from), to_(to), profile_(profile), owner_(owner), rng_(seed) {
+        uint64_t rtt_ms = (std::max<uint64_t>)(profile_.rtt_ms, 1);
+        if (profile_.queue_bytes > 0) {
+            queue_limit_ = profile_.queue_bytes;
+        } else if (profile_.bandwidth_bps > 0) {
+            uint64_t bdp = profile_.bandwidth_bps / 8 * rtt_ms / 1000;
+            queue_limit_ = (std::max)(kMinQueueBytes, bdp * 2);
+        } else {
+            queue_limit_ = kUnshapedQueueBytes;
+        }
+        link_free_at_ = Clock::now();
+        last_delivery_ = link_free_at_;
+    }
+
+    ~Pipe() {
+        abort();
+        join();
+    }
+
+    void start() {
+        reader_ = std::thread([this]() { read_loop(); });
+        writer_ = std::thread([this]() { write_loop(); });
+    }
+
+    void abort() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    void join() {
+        if (reader_.joinable()) reader_.join();
+        if (writer_.joinable()) writer_.join();
+    }
+
+    bool finished() const { return finished_.load(); }
+
+private:
+    struct Segment {
+        std::vector<uint8_t> data;
+        Clock::time_point deliver_at;
+    };
+
+    Clock::time_point schedule(size_t bytes) {
+        auto now = Clock::now();
+        auto serialization = std::chrono::nanoseconds(0);
+        if (profile_.bandwidth_bps > 0) {
+            serialization = std::chrono::nanoseconds(
+                static_cast<int64_t>(static_cast<double>(bytes) * 8.0 * 1e9 / static_cast<double>(profile_.bandwidth_bps)));
+        }
+
+        auto tx_start = (std::max)(now, link_free_at_);
+        link_free_at_ = tx_start + serialization;
+
+        int64_t delay_us = static_cast<int64_t>(profile_.rtt_ms) * 1000 / 2;
+        if (profile_.jitter_ms > 0) {
+            std::uniform_int_distribution<int64_t> jitter(-static_cast<int64_t>(profile_.jitter_ms) * 1000,
+                                                          static_cast<int64_t>(profile_.jitter_ms) * 1000);
+            delay_us = (std::max<int64_t>)(0, delay_us + jitter(rng_));
+        }
+
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        if (profile_.loss_rate > 0.0 && coin(rng_) < profile_.loss_rate) {
+            // Lost segment: detected after roughly one RTT of duplicate ACKs and
+            // retransmitted, which costs another serialization slot.
+            delay_us += static_cast<int64_t>((std::max<uint32_t>)(profile_.rtt_ms, 1)) * 1000;
+            link_free_at_ += serialization;
+            owner_.segments_lost_.fetch_add(1);
+        }
+        if (profile_.reorder_rate > 0.0 && coin(rng_) < profile_.reorder_rate) {
+            uint32_t hold_ms = profile_.reorder_delay_ms > 0 ? profile_.reorder_delay_ms
+                                                             : (std::max<uint32_t>)(profile_.rtt_ms / 4, 1);
+            delay_us += static_cast<int64_t>(hold_ms) * 1000;
+            owner_.segments_reordered_.fetch_add(1);
+        }
+
+        // TCP reassembles in order: a delayed segment holds back everything behind it.
+        auto deliver = link_free_at_ + std::chrono::microseconds(delay_us);
+        deliver = (std::max)(deliver, last_delivery_);
+        last_delivery_ = deliver;
+        return deliver;
+    }
+
+    void read_loop() {
+        std::vector<uint8_t> buffer(kSegmentBytes);
+        for (;;) {
+            asio::error_code ec;
+            size_t n = from_.read_some(asio::buffer(buffer), ec);
+            if (ec || n == 0) {
+                break;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&]() { return closed_ || queued_bytes_ + n <= queue_limit_ || queue_.empty(); });
+            if (closed_) {
+                break;
+            }
+            Segment segment;
+            segment.data.assign(buffer.begin(), buffer.begin() + n);
+            segment.deliver_at = schedule(n);
+            queued_bytes_ += n;
+            queue_.push_back(std::move(segment));
+            cv_.notify_all();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            eof_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    void write_loop() {
+        for (;;) {
+            Segment* segment = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&]() { return closed_ || eof_ || !queue_.empty(); });
+                if (closed_ || queue_.empty()) {
+                    break;
+                }
+                // Only this thread pops, so the front element stays valid unlocked.
+                segment = &queue_.front();
+            }
+
+            std::this_thread::sleep_until(segment->deliver_at);
+
+            asio::error_code ec;
+            asio::write(to_, asio::buffer(segment->data), ec);
+            size_t n = segment->data.size();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queue_.pop_front();
+                queued_bytes_ -= n;
+                if (ec) {
+                    closed_ = true;
+                }
+            }
+            cv_.notify_all();
+            if (ec) {
+                break;
+            }
+            owner_.bytes_forwarded_.fetch_add(n);
+        }
+
+        // Propagate the half-close so the peer sees EOF after the last byte
+        asio::error_code ec;
+        to_.shutdown(asio::ip::tcp::socket::shutdown_send, ec);
+        bool aborted = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            aborted = closed_;
+        }
+        if (aborted) {
+            from_.shutdown(asio::ip::tcp::socket::shutdown_receive, ec);
+        }
+        finished_.store(true);
+    }
+
+    asio::ip::tcp::socket& from_;
+    asio::ip::tcp::socket& to_;
+    LinkProfile profile_;
+    LinkEmulator& owner_;
+    std::mt19937_64 rng_;
+    uint64_t queue_limit_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Segment> queue_;
+    uint64_t queued_bytes_ = 0;
+    bool eof_ = false;
+    bool closed_ = false;
+    Clock::time_point link_free_at_;
+    Clock::time_point last_delivery_;
+
+    std::thread reader_;
+    std::thread writer_;
+    std::atomic<bool> finished_{false};
+};
+
+struct LinkEmulator::Connection {
+    asio::ip::tcp::socket downstream;
+    asio::ip::tcp::socket upstream;
+    std::unique_ptr<Pipe> outbound;   // downstream -> upstream
+    std::unique_ptr<Pipe> inbound;    // upstream -> downstream
+
+    explicit Connection(asio::io_context& io) : downstream(io), upstream(io) {}
+
+    bool finished() const {
+        return outbound->finished() && inbound->finished();
+    }
+
+    void stop() {
+        outbound->abort();
+        inbound->abort();
+        asio::error_code ec;
+        downstream.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+        upstream.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+    }
+
+    void join() {
+        outbound->join();
+        inbound->join();
+        asio::error_code ec;
+        downstream.close(ec);
+        upstream.close(ec);
+    }
+};
+
+LinkEmulator::LinkEmulator(const std::string& target_host, uint16_t target_port, const LinkProfile& profile)
+    : target_host_(target_host), target_port_(target_port), profile_(profile) {}
+
+LinkEmulator::~LinkEmulator() {
+    stop();
+}
+
+void LinkEmulator::start(uint16_t listen_port) {
+    if (running_) {
+        return;
+    }
+    asio::ip::tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"), listen_port);
+    acceptor_ = std::make_unique<asio::ip::tcp::acceptor>(io_context_);
+    acceptor_->open(endpoint.protocol());
+    acceptor_->set_option(asio::ip::tcp::acceptor::reuse_address(true));
+    acceptor_->bind(endpoint);
+    acceptor_->listen();
+    // Non-blocking so stop() does not depend on close() waking a blocked accept
+    acceptor_->non_blocking(true);
+    listen_port_ = acceptor_->local_endpoint().port();
+
+    running_ = true;
+    accept_thread_ = std::thread([this]() { accept_loop(); });
+    LOG_INFO("Link emulator on 127.0.0.1:" + std::to_string(listen_port_) + " -> " +
+             target_host_ + ":" + std::to_string(target_port_) + " (" + profile_.to_string() + ")");
+}
+
+void LinkEmulator::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+    asio::error_code ec;
+    acceptor_->close(ec);
+    reap_finished(true);
+}
+
+void LinkEmulator::accept_loop() {
+    while (running_) {
+        auto connection = std::make_unique<Connection>(io_context_);
+        asio::error_code ec;
+        acceptor_->accept(connection->downstream, ec);
+        if (ec == asio::error::would_block || ec == asio::error::try_again) {
+            reap_finished(false);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        if (ec) {
+            if (running_) {
+                LOG_WARNING("Link emulator accept failed: " + ec.message());
+            }
+            continue;
+        }
+
+        try {
+            connection->downstream.non_blocking(false);
+            asio::ip::tcp::resolver resolver(io_context_);
+            asio::connect(connection->upstream, resolver.resolve(target_host_, std::to_string(target_port_)));
+            connection->downstream.set_option(asio::ip::tcp::no_delay(true));
+            connection->upstream.set_option(asio::ip::tcp::no_delay(true));
+        } catch (const std::exception& e) {
+            LOG_WARNING("Link emulator could not reach " + target_host_ + ":" +
+                        std::to_string(target_port_) + ": " + e.what());
+            continue;
+        }
+
+        // Distinct but reproducible seeds per connection and direction
+        uint64_t index = connection_counter_.fetch_add(1);
+        uint64_t base_seed = profile_.seed * 1000003ull + index * 2;
+        connection->outbound = std::make_unique<Pipe>(connection->downstream, connection->upstream, profile_, base_seed, *this);
+        connection->inbound = std::make_unique<Pipe>(connection->upstream, connection->downstream, profile_, base_seed + 1, *this);
+        connection->outbound->start();
+        connection->inbound->start();
+
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_.push_back(std::move(connection));
+    }
+}
+
+void LinkEmulator::reap_finished(bool all) {
+    std::vector<std::unique_ptr<Connection>> done;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            if (all || (*it)->finished()) {
+                done.push_back(std::move(*it));
+                it = connections_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto& connection : done) {
+        if (all) {
+            connection->stop();
+        }
+        connection->join();
+    }
+}
+
+bool LinkEmulator::redirect_if_enabled(std::string& host, uint16_t& port) {
+    const char* spec = std::getenv(kEnvVariable);
+    if (spec == nullptr || *spec == '\0') {
+        return false;
+    }
+
+    static std::mutex registry_mutex;
+    static std::map<std::string, std::unique_ptr<LinkEmulator>> registry;
+
+    LinkProfile profile = LinkProfile::parse(spec);
+    if (profile.is_passthrough()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    // Connections to an emulator's own listener must not be redirected again
+    if (host == "127.0.0.1" || host == "localhost") {
+        for (const auto& entry : registry) {
+            if (entry.second && entry.second->listen_port() == port) {
+                return false;
+            }
+        }
+    }
+
+    std::string key = host + ":" + std::to_string(port);
+    auto& emulator = registry[key];
+    if (!emulator) {
+        emulator = std::make_unique<LinkEmulator>(host, port, profile);
+        emulator->start();
+    }
+    host = "127.0.0.1";
+    port = emulator->listen_port();
+    return true;
+}
+
+} // namespace network
+} // namespace netcopy
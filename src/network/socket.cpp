@@ -1,4 +1,7 @@
 #include "network/socket.h"
+#ifdef NETCOPY_WITH_LINK_EMULATION
+#include "network/link_emulator.h"
+#endif
 #include "crypto/sha3.h"
 #include "exceptions.h"
 #include "common/fast_mem.h"
@@ -365,6 +368,17 @@ void Socket::connect(const std::string& address, uint16_t port) {
         throw NetworkException("UDP connection timed out");
     }
 
+#ifdef NETCOPY_WITH_LINK_EMULATION
+    {
+        std::string emulated_address = address;
+        uint16_t emulated_port = port;
+        if (LinkEmulator::redirect_if_enabled(emulated_address, emulated_port)) {
+            connect(emulated_address, emulated_port);
+            return;
+        }
+    }
+#endif
+
     struct addrinfo hints{};
     hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
@@ -1003,6 +1017,24 @@ void Socket::enable_tls_server(const std::string& cert_file, const std::string&
     is_tls_client_ = false;
 }
 
+std::vector<uint8_t> tls_export_keying_material(SSL* ssl, const std::string& label, size_t length) {
+    std::vector<uint8_t> material;
+#ifdef HAVE_KEYING_MATERIAL
+    if (ssl) {
+        material.resize(length);
+        if (SSL_export_keying_material(ssl, material.data(), length, label.c_str(), label.size(),
+                                       nullptr, 0, 0) != 1) {
+            material.clear();
+        }
+    }
+#else
+    (void)ssl;
+    (void)label;
+    (void)length;
+#endif
+    return material;
+}
+
 void Socket::perform_tls_handshake() {
     if (!ssl_ctx_) {
         throw NetworkException("TLS context not initialized. Call enable_tls_client or enable_tls_server first.");
@@ -10,6 +10,13 @@ namespace protocol {
 // Helper functions for serialization
 namespace {
     constexpr uint32_t FILE_DATA_MAGIC = 0x3144434E; // "NCD1" little-endian
+    // Per-chunk flag byte; older peers only ever send 0 or 1
+    constexpr uint8_t CHUNK_FLAG_COMPRESSED = 0x01;
+    constexpr uint8_t CHUNK_FLAG_HOLE = 0x02;
+
+    uint8_t chunk_flags(bool compressed, bool hole) {
+        return static_cast<uint8_t>((compressed ? CHUNK_FLAG_COMPRESSED : 0) | (hole ? CHUNK_FLAG_HOLE : 0));
+    }
 
     void write_uint32(std::vector<uint8_t>& buffer, uint32_t value) {
         buffer.push_back(value & 0xFF);
@@ -212,6 +219,21 @@ std::unique_ptr<Message> Message::deserialize(const std::vector<uint8_t>& data)
         case MessageType::TRANSFER_STATUS_RESPONSE:
             message = std::make_unique<TransferStatusResponse>();
             break;
+        case MessageType::MERKLE_NODES_REQUEST:
+            message = std::make_unique<MerkleNodesRequest>();
+            break;
+        case MessageType::MERKLE_NODES_RESPONSE:
+            message = std::make_unique<MerkleNodesResponse>();
+            break;
+        case MessageType::BLOCK_COPY_REQUEST:
+            message = std::make_unique<BlockCopyRequest>();
+            break;
+        case MessageType::BLOCK_COPY_RESPONSE:
+            message = std::make_unique<BlockCopyResponse>();
+            break;
+        case MessageType::ADMISSION_UPDATE:
+            message = std::make_unique<AdmissionUpdate>();
+            break;
         default:
             throw ProtocolException("Unknown message type");
     }
@@ -242,6 +264,11 @@ std::vector<uint8_t> HandshakeRequest::serialize_payload() const {
     // Auth fields (appended last for backward compatibility)
     write_string(buffer, username);
     buffer.push_back(auth_method_id);
+    buffer.push_back(accepts_admission_updates ? 1 : 0);
+    buffer.push_back(auto_security_level ? 1 : 0);
+    write_uint32(buffer, cipher_rates.chacha20_poly1305);
+    write_uint32(buffer, cipher_rates.aes_256_gcm);
+    write_bytes(buffer, tls_binding);
     return buffer;
 }
 
@@ -277,6 +304,15 @@ void HandshakeRequest::deserialize_payload(const std::vector<uint8_t>& data) {
     } else {
         auth_method_id = 0;
     }
+    accepts_admission_updates = offset < data.size() && data[offset++] != 0;
+    auto_security_level = offset < data.size() && data[offset++] != 0;
+    if (offset + 2 * sizeof(uint32_t) <= data.size()) {
+        cipher_rates.chacha20_poly1305 = read_uint32(data, offset);
+        cipher_rates.aes_256_gcm = read_uint32(data, offset);
+    }
+    if (offset < data.size()) {
+        tls_binding = read_bytes(data, offset);
+    }
 }
 
 // HandshakeResponse implementation
@@ -296,6 +332,9 @@ std::vector<uint8_t> HandshakeResponse::serialize_payload() const {
     write_uint64(buffer, max_chunk_size);
     write_uint32(buffer, accepted_parallel_streams);
     buffer.push_back(auto_create_directories_allowed ? 1 : 0);
+    write_uint32(buffer, cipher_rates.chacha20_poly1305);
+    write_uint32(buffer, cipher_rates.aes_256_gcm);
+    write_bytes(buffer, tls_binding);
     return buffer;
 }
 
@@ -325,6 +364,13 @@ void HandshakeResponse::deserialize_payload(const std::vector<uint8_t>& data) {
     } else {
         auto_create_directories_allowed = false;
     }
+    if (offset + 2 * sizeof(uint32_t) <= data.size()) {
+        cipher_rates.chacha20_poly1305 = read_uint32(data, offset);
+        cipher_rates.aes_256_gcm = read_uint32(data, offset);
+    }
+    if (offset < data.size()) {
+        tls_binding = read_bytes(data, offset);
+    }
 }
 
 // FileRequest implementation
@@ -349,6 +395,12 @@ std::vector<uint8_t> FileRequest::serialize_payload() const {
 
     // Phase 4 Timestamp preservation
     write_uint64(buffer, last_modified);
+
+    // Merkle verification
+    write_uint64(buffer, merkle_leaf_size);
+
+    // Sparse files
+    buffer.push_back(sparse ? 1 : 0);
     return buffer;
 }
 
@@ -400,6 +452,16 @@ void FileRequest::deserialize_payload(const std::vector<uint8_t>& data) {
     } else {
         last_modified = 0;
     }
+
+    // Merkle verification
+    if (offset < data.size()) {
+        merkle_leaf_size = read_uint64(data, offset);
+    } else {
+        merkle_leaf_size = 0;
+    }
+
+    // Sparse files
+    sparse = offset < data.size() && data[offset++] != 0;
 }
 
 // FileResponse implementation
@@ -412,6 +474,23 @@ std::vector<uint8_t> FileResponse::serialize_payload() const {
     write_uint64(buffer, file_size);
     write_uint64(buffer, resume_offset);
     write_string(buffer, session_id);
+
+    // Range journal for parallel resume
+    buffer.push_back(has_range_journal ? 1 : 0);
+    write_uint32(buffer, static_cast<uint32_t>(completed_ranges.size()));
+    for (const auto& range : completed_ranges) {
+        write_uint64(buffer, range.first);
+        write_uint64(buffer, range.second);
+    }
+
+    // Merkle verification
+    write_uint64(buffer, merkle_leaf_size);
+
+    // Sparse files
+    buffer.push_back(sparse ? 1 : 0);
+
+    // Server-local block copy
+    buffer.push_back(block_copy ? 1 : 0);
     return buffer;
 }
 
@@ -429,6 +508,35 @@ void FileResponse::deserialize_payload(const std::vector<uint8_t>& data) {
     } else {
         session_id = "";
     }
+
+    // Range journal for parallel resume
+    has_range_journal = false;
+    completed_ranges.clear();
+    if (offset < data.size()) {
+        has_range_journal = data[offset++] != 0;
+        uint32_t count = read_uint32(data, offset);
+        if (count > (data.size() - offset) / 16) {
+            throw ProtocolException("Invalid completed range count in file response");
+        }
+        completed_ranges.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint64_t range_offset = read_uint64(data, offset);
+            uint64_t range_length = read_uint64(data, offset);
+            completed_ranges.emplace_back(range_offset, range_length);
+        }
+    }
+
+    // Merkle verification
+    merkle_leaf_size = 0;
+    if (offset < data.size()) {
+        merkle_leaf_size = read_uint64(data, offset);
+    }
+
+    // Sparse files
+    sparse = offset < data.size() && data[offset++] != 0;
+
+    // Server-local block copy
+    block_copy = offset < data.size() && data[offset++] != 0;
 }
 
 // FileData implementation
@@ -445,7 +553,7 @@ std::vector<uint8_t> FileData::Chunk::serialize_payload() const {
     write_uint64(buffer, uncompressed_size);
     write_bytes(buffer, data);
     buffer.push_back(is_last_chunk ? 1 : 0);
-    buffer.push_back(compressed ? 1 : 0);
+    buffer.push_back(chunk_flags(compressed, hole));
     return buffer;
 }
 
@@ -461,7 +569,9 @@ void FileData::Chunk::deserialize_payload(const std::vector<uint8_t>& data_buffe
     if (offset_pos >= data_buffer.size()) {
         throw ProtocolException("Buffer underflow reading compression flag");
     }
-    compressed = data_buffer[offset_pos++] != 0;
+    uint8_t flags = data_buffer[offset_pos++];
+    compressed = (flags & CHUNK_FLAG_COMPRESSED) != 0;
+    hole = (flags & CHUNK_FLAG_HOLE) != 0;
 }
 
 std::vector<uint8_t> FileData::serialize_payload() const {
@@ -485,19 +595,20 @@ std::vector<uint8_t> FileData::serialize_payload() const {
                                    uint64_t chunk_uncompressed_size,
                                    const std::vector<uint8_t>& chunk_data,
                                    bool chunk_is_last,
-                                   bool chunk_compressed) {
+                                   bool chunk_compressed,
+                                   bool chunk_hole) {
         write_uint64(buffer, chunk_offset);
         write_uint64(buffer, chunk_uncompressed_size == 0 ? chunk_data.size() : chunk_uncompressed_size);
         write_bytes(buffer, chunk_data);
         buffer.push_back(chunk_is_last ? 1 : 0);
-        buffer.push_back(chunk_compressed ? 1 : 0);
+        buffer.push_back(chunk_flags(chunk_compressed, chunk_hole));
     };
 
     if (chunks.empty()) {
-        write_chunk_payload(offset, uncompressed_size, data, is_last_chunk, compressed);
+        write_chunk_payload(offset, uncompressed_size, data, is_last_chunk, compressed, hole);
     } else {
         for (const auto& chunk : chunks) {
-            write_chunk_payload(chunk.offset, chunk.uncompressed_size, chunk.data, chunk.is_last_chunk, chunk.compressed);
+            write_chunk_payload(chunk.offset, chunk.uncompressed_size, chunk.data, chunk.is_last_chunk, chunk.compressed, chunk.hole);
         }
     }
     
@@ -531,7 +642,9 @@ void FileData::deserialize_payload(const std::vector<uint8_t>& data_buffer) {
         if (offset_pos >= data_buffer.size()) {
             throw ProtocolException("Buffer underflow reading compression flag");
         }
-        chunk.compressed = data_buffer[offset_pos++] != 0;
+        uint8_t flags = data_buffer[offset_pos++];
+        chunk.compressed = (flags & CHUNK_FLAG_COMPRESSED) != 0;
+        chunk.hole = (flags & CHUNK_FLAG_HOLE) != 0;
         chunks.push_back(chunk);
     }
 
@@ -545,6 +658,7 @@ void FileData::deserialize_payload(const std::vector<uint8_t>& data_buffer) {
     data = first.data;
     is_last_chunk = first.is_last_chunk;
     compressed = first.compressed;
+    hole = first.hole;
 }
 
 // FileAck implementation
@@ -659,6 +773,18 @@ std::vector<uint8_t> DownloadRequest::serialize_payload() const {
     std::vector<uint8_t> buffer;
     write_string(buffer, remote_path);
     write_uint64(buffer, resume_offset);
+
+    // Download compression and delta mode
+    buffer.push_back(accept_compression ? 1 : 0);
+    write_uint64(buffer, delta_block_size);
+    write_uint32(buffer, static_cast<uint32_t>(local_blocks.size()));
+    for (const auto& b : local_blocks) {
+        write_uint64(buffer, b.offset);
+        write_bytes(buffer, b.hash);
+    }
+
+    // Sparse files
+    buffer.push_back(accept_sparse ? 1 : 0);
     return buffer;
 }
 
@@ -670,6 +796,29 @@ void DownloadRequest::deserialize_payload(const std::vector<uint8_t>& data) {
     } else {
         resume_offset = 0;
     }
+
+    // Download compression and delta mode
+    accept_compression = false;
+    delta_block_size = 0;
+    local_blocks.clear();
+    if (offset < data.size()) {
+        accept_compression = data[offset++] != 0;
+        delta_block_size = read_uint64(data, offset);
+        uint32_t count = read_uint32(data, offset);
+        if (count > (data.size() - offset) / 12) {
+            throw ProtocolException("DownloadRequest: invalid block count");
+        }
+        local_blocks.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            BlockHashInfo info;
+            info.offset = read_uint64(data, offset);
+            info.hash = read_bytes(data, offset);
+            local_blocks.push_back(std::move(info));
+        }
+    }
+
+    // Sparse files
+    accept_sparse = offset < data.size() && data[offset++] != 0;
 }
 
 // DownloadResponse implementation
@@ -694,6 +843,12 @@ std::vector<uint8_t> DownloadResponse::serialize_payload() const {
 
     // Phase 4 Timestamp preservation
     write_uint64(buffer, last_modified);
+
+    // Download delta mode
+    buffer.push_back(delta_applied ? 1 : 0);
+
+    // Sparse files
+    buffer.push_back(sparse ? 1 : 0);
     return buffer;
 }
 
@@ -734,6 +889,12 @@ void DownloadResponse::deserialize_payload(const std::vector<uint8_t>& data) {
     } else {
         last_modified = 0;
     }
+
+    // Download delta mode
+    delta_applied = offset < data.size() && data[offset++] != 0;
+
+    // Sparse files
+    sparse = offset < data.size() && data[offset++] != 0;
 }
 
 // ListRequest implementation
@@ -745,6 +906,7 @@ std::vector<uint8_t> ListRequest::serialize_payload() const {
     std::vector<uint8_t> buffer;
     write_string(buffer, remote_path);
     buffer.push_back(recursive ? 1 : 0);
+    write_uint64(buffer, known_version);
     return buffer;
 }
 
@@ -753,6 +915,7 @@ void ListRequest::deserialize_payload(const std::vector<uint8_t>& data) {
     remote_path = read_string(data, offset);
     if (offset >= data.size()) throw ProtocolException("ListRequest: missing recursive byte");
     recursive = data[offset++] != 0;
+    known_version = offset + 8 <= data.size() ? read_uint64(data, offset) : 0;
 }
 
 // ListResponse implementation
@@ -776,6 +939,8 @@ std::vector<uint8_t> ListResponse::serialize_payload() const {
         buffer.push_back(e.is_symlink ? 1 : 0);
         write_string(buffer, e.symlink_target);
     }
+    write_uint64(buffer, version);
+    buffer.push_back(not_modified ? 1 : 0);
     return buffer;
 }
 
@@ -812,6 +977,8 @@ void ListResponse::deserialize_payload(const std::vector<uint8_t>& data) {
         }
         entries.push_back(info);
     }
+    version = offset + 8 <= data.size() ? read_uint64(data, offset) : 0;
+    not_modified = offset < data.size() && data[offset++] != 0;
 }
 
 // Disconnect implementation
@@ -834,6 +1001,7 @@ std::vector<uint8_t> FileVerifyRequest::serialize_payload() const {
     std::vector<uint8_t> buffer;
     write_string(buffer, file_path);
     write_bytes(buffer, expected_hash);
+    write_bytes(buffer, merkle_root);
     return buffer;
 }
 
@@ -841,6 +1009,11 @@ void FileVerifyRequest::deserialize_payload(const std::vector<uint8_t>& data) {
     size_t offset = 0;
     file_path = read_string(data, offset);
     expected_hash = read_bytes(data, offset);
+    if (offset < data.size()) {
+        merkle_root = read_bytes(data, offset);
+    } else {
+        merkle_root.clear();
+    }
 }
 
 // FileVerifyResponse implementation
@@ -853,6 +1026,8 @@ std::vector<uint8_t> FileVerifyResponse::serialize_payload() const {
     buffer.push_back(success ? 1 : 0);
     write_string(buffer, error_message);
     write_bytes(buffer, actual_hash);
+    write_bytes(buffer, merkle_root);
+    buffer.push_back(durable ? 1 : 0);
     return buffer;
 }
 
@@ -862,6 +1037,12 @@ void FileVerifyResponse::deserialize_payload(const std::vector<uint8_t>& data) {
     success = data[offset++] != 0;
     error_message = read_string(data, offset);
     actual_hash = read_bytes(data, offset);
+    if (offset < data.size()) {
+        merkle_root = read_bytes(data, offset);
+    } else {
+        merkle_root.clear();
+    }
+    durable = offset < data.size() && data[offset++] != 0;
 }
 
 // BlockHashesRequest implementation
@@ -968,6 +1149,138 @@ void TransferStatusResponse::deserialize_payload(const std::vector<uint8_t>& dat
     logs = read_string(data, offset);
 }
 
+// MerkleNodesRequest implementation
+MerkleNodesRequest::MerkleNodesRequest() : Message(MessageType::MERKLE_NODES_REQUEST) {}
+
+std::vector<uint8_t> MerkleNodesRequest::serialize_payload() const {
+    std::vector<uint8_t> buffer;
+    write_string(buffer, file_path);
+    write_uint32(buffer, level);
+    write_uint32(buffer, static_cast<uint32_t>(indices.size()));
+    for (uint64_t index : indices) {
+        write_uint64(buffer, index);
+    }
+    return buffer;
+}
+
+void MerkleNodesRequest::deserialize_payload(const std::vector<uint8_t>& data) {
+    size_t offset = 0;
+    file_path = read_string(data, offset);
+    level = read_uint32(data, offset);
+    uint32_t count = read_uint32(data, offset);
+    if (count > (data.size() - offset) / 8) {
+        throw ProtocolException("MerkleNodesRequest: invalid index count");
+    }
+    indices.clear();
+    indices.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        indices.push_back(read_uint64(data, offset));
+    }
+}
+
+// MerkleNodesResponse implementation
+MerkleNodesResponse::MerkleNodesResponse() : Message(MessageType::MERKLE_NODES_RESPONSE) {}
+
+std::vector<uint8_t> MerkleNodesResponse::serialize_payload() const {
+    std::vector<uint8_t> buffer;
+    buffer.push_back(success ? 1 : 0);
+    write_string(buffer, error_message);
+    write_uint32(buffer, static_cast<uint32_t>(hashes.size()));
+    for (const auto& hash : hashes) {
+        write_bytes(buffer, hash);
+    }
+    return buffer;
+}
+
+void MerkleNodesResponse::deserialize_payload(const std::vector<uint8_t>& data) {
+    size_t offset = 0;
+    if (offset >= data.size()) throw ProtocolException("MerkleNodesResponse: missing success byte");
+    success = data[offset++] != 0;
+    error_message = read_string(data, offset);
+    uint32_t count = read_uint32(data, offset);
+    if (count > (data.size() - offset) / 4) {
+        throw ProtocolException("MerkleNodesResponse: invalid hash count");
+    }
+    hashes.clear();
+    hashes.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        hashes.push_back(read_bytes(data, offset));
+    }
+}
+
+// BlockCopyRequest implementation
+BlockCopyRequest::BlockCopyRequest() : Message(MessageType::BLOCK_COPY_REQUEST) {}
+
+std::vector<uint8_t> BlockCopyRequest::serialize_payload() const {
+    std::vector<uint8_t> buffer;
+    write_string(buffer, source_path);
+    write_uint32(buffer, static_cast<uint32_t>(ranges.size()));
+    for (const auto& range : ranges) {
+        write_uint64(buffer, range.source_offset);
+        write_uint64(buffer, range.target_offset);
+        write_uint64(buffer, range.length);
+        write_bytes(buffer, range.hash);
+    }
+    return buffer;
+}
+
+void BlockCopyRequest::deserialize_payload(const std::vector<uint8_t>& data) {
+    size_t offset = 0;
+    source_path = read_string(data, offset);
+    uint32_t count = read_uint32(data, offset);
+    if (count > (data.size() - offset) / 28) {
+        throw ProtocolException("BlockCopyRequest: invalid range count");
+    }
+    ranges.clear();
+    ranges.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        BlockCopyRange range;
+        range.source_offset = read_uint64(data, offset);
+        range.target_offset = read_uint64(data, offset);
+        range.length = read_uint64(data, offset);
+        range.hash = read_bytes(data, offset);
+        ranges.push_back(std::move(range));
+    }
+}
+
+// BlockCopyResponse implementation
+BlockCopyResponse::BlockCopyResponse() : Message(MessageType::BLOCK_COPY_RESPONSE) {}
+
+std::vector<uint8_t> BlockCopyResponse::serialize_payload() const {
+    std::vector<uint8_t> buffer;
+    buffer.push_back(success ? 1 : 0);
+    write_string(buffer, error_message);
+    write_bytes(buffer, copied);
+    write_uint64(buffer, bytes_copied);
+    return buffer;
+}
+
+void BlockCopyResponse::deserialize_payload(const std::vector<uint8_t>& data) {
+    size_t offset = 0;
+    if (offset >= data.size()) throw ProtocolException("BlockCopyResponse: missing success byte");
+    success = data[offset++] != 0;
+    error_message = read_string(data, offset);
+    copied = read_bytes(data, offset);
+    bytes_copied = read_uint64(data, offset);
+}
+
+// AdmissionUpdate implementation
+AdmissionUpdate::AdmissionUpdate() : Message(MessageType::ADMISSION_UPDATE) {}
+
+std::vector<uint8_t> AdmissionUpdate::serialize_payload() const {
+    std::vector<uint8_t> buffer;
+    write_uint32(buffer, max_parallel_streams);
+    write_uint64(buffer, max_chunk_size);
+    write_uint64(buffer, inflight_window_bytes);
+    return buffer;
+}
+
+void AdmissionUpdate::deserialize_payload(const std::vector<uint8_t>& data) {
+    size_t offset = 0;
+    max_parallel_streams = read_uint32(data, offset);
+    max_chunk_size = read_uint64(data, offset);
+    inflight_window_bytes = offset + sizeof(uint64_t) <= data.size() ? read_uint64(data, offset) : 0;
+}
+
 } // namespace protocol
 } // namespace netcopy
-
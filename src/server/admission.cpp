@@ -0,0 +1,202 @@
+#include "server/admission.h"
+#include "common/metrics.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace netcopy {
+namespace server {
+
+namespace {
+
+// Above this average number of outstanding disk operations per core the
+// disks are the bottleneck and more streams only add seeks
+constexpr uint32_t kDiskQueuePerCore = 2;
+constexpr double kCpuSaturated = 0.9;
+
+uint32_t hardware_threads() {
+    unsigned int threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 1u : threads;
+}
+
+// Busy and total ticks since boot, or false where unsupported
+bool read_cpu_ticks(uint64_t& busy, uint64_t& total) {
+#ifdef _WIN32
+    FILETIME idle_time, kernel_time, user_time;
+    if (!GetSystemTimes(&idle_time, &kernel_time, &user_time)) {
+        return false;
+    }
+    auto ticks = [](const FILETIME& ft) {
+        return (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    };
+    // Kernel time includes idle time
+    total = ticks(kernel_time) + ticks(user_time);
+    busy = total - ticks(idle_time);
+    return true;
+#elif defined(__linux__)
+    std::ifstream stat("/proc/stat");
+    std::string line;
+    if (!std::getline(stat, line) || line.compare(0, 4, "cpu ") != 0) {
+        return false;
+    }
+    std::istringstream fields(line.substr(4));
+    uint64_t value = 0;
+    uint64_t idle = 0;
+    total = 0;
+    for (int i = 0; fields >> value; ++i) {
+        total += value;
+        if (i == 3 || i == 4) { // idle, iowait
+            idle += value;
+        }
+    }
+    busy = total - idle;
+    return total > 0;
+#else
+    (void)busy;
+    (void)total;
+    return false;
+#endif
+}
+
+struct AdmissionMetrics {
+    common::MetricGauge& budget;
+    common::MetricGauge& active_streams;
+    common::MetricGauge& disk_queue;
+};
+
+AdmissionMetrics& admission_metrics() {
+    static AdmissionMetrics metrics = []() {
+        auto& r = common::MetricsRegistry::instance();
+        return AdmissionMetrics{
+            r.gauge("netcopy_server_stream_budget", "Parallel streams the server currently grants across all clients"),
+            r.gauge("netcopy_server_streams_active", "Connections counted against the stream budget"),
+            r.gauge("netcopy_server_disk_operations", "Disk reads and writes in progress"),
+        };
+    }();
+    return metrics;
+}
+
+} // namespace
+
+AdmissionController& AdmissionController::instance() {
+    static AdmissionController controller;
+    return controller;
+}
+
+void AdmissionController::configure(int max_active_streams) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    configured_budget_ = max_active_streams > 0
+        ? static_cast<uint32_t>(max_active_streams)
+        : (std::max)(8u, 4 * hardware_threads());
+    update_metrics_locked();
+}
+
+void AdmissionController::add_stream(const std::string& client) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++streams_by_client_[client];
+    ++active_streams_;
+    update_metrics_locked();
+}
+
+void AdmissionController::remove_stream(const std::string& client) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = streams_by_client_.find(client);
+    if (it == streams_by_client_.end()) {
+        return;
+    }
+    if (--it->second == 0) {
+        streams_by_client_.erase(it);
+    }
+    --active_streams_;
+    update_metrics_locked();
+}
+
+uint32_t AdmissionController::budget() {
+    const double cpu = cpu_utilization();
+    const uint32_t disk_queue = disk_queue_average_.load(std::memory_order_relaxed) / 256;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t value = configured_budget_ == 0 ? (std::max)(8u, 4 * hardware_threads()) : configured_budget_;
+    if (cpu >= kCpuSaturated) {
+        value = value * 3 / 4;
+    }
+    if (disk_queue > kDiskQueuePerCore * hardware_threads()) {
+        value /= 2;
+    }
+    return (std::max)(1u, value);
+}
+
+uint32_t AdmissionController::active_streams() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_streams_;
+}
+
+AdmissionController::Grant AdmissionController::grant(const std::string& client,
+                                                       uint32_t requested,
+                                                       size_t max_chunk_size) {
+    const uint32_t total = budget();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    admission_metrics().budget.set(total);
+    // A client asking for the first time is not registered yet
+    size_t clients = streams_by_client_.size();
+    if (streams_by_client_.find(client) == streams_by_client_.end()) {
+        ++clients;
+    }
+    const uint32_t share = (std::max)(1u, static_cast<uint32_t>(total / (std::max)(size_t(1), clients)));
+
+    Grant result;
+    result.streams = (std::max)(1u, (std::min)({requested == 0 ? 1u : requested, kMaxStreamsPerClient, share}));
+    result.max_chunk_size = max_chunk_size;
+    if (active_streams_ > total && max_chunk_size > kMinGrantedChunkSize) {
+        const uint64_t scaled = static_cast<uint64_t>(max_chunk_size) * total / active_streams_;
+        result.max_chunk_size = static_cast<size_t>((std::max)(static_cast<uint64_t>(kMinGrantedChunkSize), scaled));
+    }
+    return result;
+}
+
+double AdmissionController::cpu_utilization() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    if (now - cpu_sampled_at_ < std::chrono::seconds(1)) {
+        return cpu_utilization_;
+    }
+    uint64_t busy = 0;
+    uint64_t total = 0;
+    if (read_cpu_ticks(busy, total)) {
+        if (cpu_total_ticks_ != 0 && total > cpu_total_ticks_) {
+            cpu_utilization_ = static_cast<double>(busy - cpu_busy_ticks_) /
+                               static_cast<double>(total - cpu_total_ticks_);
+        }
+        cpu_busy_ticks_ = busy;
+        cpu_total_ticks_ = total;
+    }
+    cpu_sampled_at_ = now;
+    return cpu_utilization_;
+}
+
+void AdmissionController::update_metrics_locked() {
+    admission_metrics().active_streams.set(active_streams_);
+}
+
+AdmissionController::DiskOperation::DiskOperation() {
+    auto& controller = AdmissionController::instance();
+    uint32_t depth = controller.disk_operations_.fetch_add(1, std::memory_order_relaxed) + 1;
+    admission_metrics().disk_queue.add(1);
+    // Exponential average with weight 1/8; a lost update only delays it
+    uint32_t average = controller.disk_queue_average_.load(std::memory_order_relaxed);
+    controller.disk_queue_average_.store(average - average / 8 + depth * 256 / 8, std::memory_order_relaxed);
+}
+
+AdmissionController::DiskOperation::~DiskOperation() {
+    AdmissionController::instance().disk_operations_.fetch_sub(1, std::memory_order_relaxed);
+    admission_metrics().disk_queue.sub(1);
+}
+
+} // namespace server
+} // namespace netcopy
@@ -0,0 +1,261 @@
+#include "server/chunk_cache.h"
+#include "common/compression.h"
+#include "common/metrics.h"
+#include "logging/logger.h"
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+namespace netcopy {
+namespace server {
+
+namespace {
+
+// Downloads within kHotWindow that make a file worth caching
+constexpr size_t kHotDownloads = 2;
+constexpr std::chrono::minutes kHotWindow{5};
+constexpr size_t kMaxFiles = 1024;
+// Delta block hashes of larger files are recomputed rather than kept
+constexpr size_t kMaxBlockHashes = 65536;
+
+struct CacheMetrics {
+    common::MetricGauge& capacity;
+    common::MetricGauge& used;
+    common::MetricCounter& hits;
+    common::MetricCounter& misses;
+    common::MetricCounter& shared;
+};
+
+CacheMetrics& cache_metrics() {
+    static CacheMetrics metrics = []() {
+        auto& r = common::MetricsRegistry::instance();
+        return CacheMetrics{
+            r.gauge("netcopy_server_chunk_cache_capacity_bytes", "Byte budget of the download chunk cache"),
+            r.gauge("netcopy_server_chunk_cache_bytes", "Bytes held by the download chunk cache"),
+            r.counter("netcopy_server_chunk_cache_hits_total", "Download blocks served from the chunk cache"),
+            r.counter("netcopy_server_chunk_cache_misses_total", "Download blocks read from disk into the chunk cache"),
+            r.counter("netcopy_server_chunk_cache_shared_reads_total", "Download blocks that waited for another connection's read"),
+        };
+    }();
+    return metrics;
+}
+
+} // namespace
+
+ChunkCache::FileKey ChunkCache::FileKey::of(const std::string& path, uint64_t size) {
+    FileKey key;
+    std::error_code ec;
+    auto modified = std::filesystem::last_write_time(std::filesystem::u8path(path), ec);
+    if (ec) {
+        return key;
+    }
+    key.path = path;
+    key.modified = static_cast<uint64_t>(modified.time_since_epoch().count());
+    key.size = size;
+    return key;
+}
+
+std::string ChunkCache::FileKey::id() const {
+    return path + '\n' + std::to_string(modified) + '\n' + std::to_string(size);
+}
+
+ChunkCache& ChunkCache::instance() {
+    static ChunkCache cache;
+    return cache;
+}
+
+void ChunkCache::configure(uint64_t capacity_bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity_bytes;
+        evict_locked();
+    }
+    cache_metrics().capacity.set(static_cast<int64_t>(capacity_bytes));
+    if (capacity_bytes > 0) {
+        LOG_INFO("Download chunk cache: " + std::to_string(capacity_bytes / (1024 * 1024)) + " MB");
+    }
+}
+
+bool ChunkCache::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_ > 0;
+}
+
+bool ChunkCache::note_download(const FileKey& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0) {
+        return false;
+    }
+    FileInfo& info = file_locked(key);
+    const auto now = std::chrono::steady_clock::now();
+    info.downloads.erase(std::remove_if(info.downloads.begin(), info.downloads.end(),
+                                        [now](std::chrono::steady_clock::time_point at) {
+                                            return now - at > kHotWindow;
+                                        }),
+                         info.downloads.end());
+    info.downloads.push_back(now);
+    return info.downloads.size() >= kHotDownloads;
+}
+
+ChunkCache::BlockPtr ChunkCache::block(const FileKey& key, uint64_t index, bool compress, const ReadFn& read) {
+    const std::string id = key.id() + '#' + std::to_string(index);
+    std::promise<BlockPtr> promise;
+    std::shared_future<BlockPtr> pending;
+    BlockPtr uncompressed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = blocks_.find(id);
+        if (it != blocks_.end()) {
+            if (!compress || it->second.block->compression_tried) {
+                lru_.splice(lru_.begin(), lru_, it->second.lru);
+                cache_metrics().hits.add(1);
+                return it->second.block;
+            }
+            // Cached raw; only the compressed form is missing
+            uncompressed = it->second.block;
+        }
+        auto loading = loading_.find(id);
+        if (loading != loading_.end()) {
+            pending = loading->second;
+        } else {
+            loading_[id] = promise.get_future().share();
+        }
+    }
+    if (pending.valid()) {
+        // The block may come back without a compressed form when the first
+        // reader did not want one; the caller compresses its chunk then
+        cache_metrics().shared.add(1);
+        return pending.get();
+    }
+
+    try {
+        BlockPtr loaded = load(key, index, compress, read, uncompressed);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            insert_locked(id, loaded);
+            loading_.erase(id);
+        }
+        promise.set_value(loaded);
+        return loaded;
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            loading_.erase(id);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+ChunkCache::BlockPtr ChunkCache::load(const FileKey& key, uint64_t index, bool compress, const ReadFn& read,
+                                      BlockPtr uncompressed) {
+    auto block = std::make_shared<Block>();
+    if (uncompressed) {
+        block->data = uncompressed->data;
+    } else {
+        const uint64_t offset = index * kBlockSize;
+        const size_t length = offset < key.size ? static_cast<size_t>((std::min)(kBlockSize, key.size - offset)) : 0;
+        block->data.resize(length);
+        size_t filled = 0;
+        while (filled < length) {
+            size_t got = read(offset + filled, block->data.data() + filled, length - filled);
+            if (got == 0) {
+                break;
+            }
+            filled += got;
+        }
+        block->data.resize(filled);
+        cache_metrics().misses.add(1);
+    }
+    if (compress && !block->data.empty()) {
+        auto compressed = common::compress_buffer(block->data.data(), block->data.size());
+        if (compressed.size() < block->data.size()) {
+            block->compressed = std::move(compressed);
+        }
+        block->compression_tried = true;
+    }
+    return block;
+}
+
+void ChunkCache::insert_locked(const std::string& id, BlockPtr block) {
+    if (capacity_ == 0) {
+        return;
+    }
+    const uint64_t bytes = block->data.size() + block->compressed.size();
+    auto it = blocks_.find(id);
+    if (it != blocks_.end()) {
+        used_ -= it->second.bytes;
+        lru_.erase(it->second.lru);
+        blocks_.erase(it);
+    }
+    lru_.push_front(id);
+    blocks_[id] = Entry{std::move(block), bytes, lru_.begin()};
+    used_ += bytes;
+    evict_locked();
+}
+
+void ChunkCache::evict_locked() {
+    while (used_ > capacity_ && !lru_.empty()) {
+        auto it = blocks_.find(lru_.back());
+        used_ -= it->second.bytes;
+        blocks_.erase(it);
+        lru_.pop_back();
+    }
+    cache_metrics().used.set(static_cast<int64_t>(used_));
+}
+
+ChunkCache::FileInfo& ChunkCache::file_locked(const FileKey& key) {
+    const auto now = std::chrono::steady_clock::now();
+    if (files_.size() >= kMaxFiles && files_.find(key.id()) == files_.end()) {
+        auto oldest = std::min_element(files_.begin(), files_.end(), [](const auto& a, const auto& b) {
+            return a.second.used_at < b.second.used_at;
+        });
+        files_.erase(oldest);
+    }
+    FileInfo& info = files_[key.id()];
+    info.used_at = now;
+    return info;
+}
+
+bool ChunkCache::file_hash(const FileKey& key, std::vector<uint8_t>& hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(key.id());
+    if (it == files_.end() || it->second.hash.empty()) {
+        return false;
+    }
+    hash = it->second.hash;
+    return true;
+}
+
+void ChunkCache::store_file_hash(const FileKey& key, const std::vector<uint8_t>& hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ > 0) {
+        file_locked(key).hash = hash;
+    }
+}
+
+bool ChunkCache::block_hashes(const FileKey& key, uint64_t block_size,
+                              std::vector<file::FileManager::BlockHash>& hashes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(key.id());
+    if (it == files_.end()) {
+        return false;
+    }
+    auto found = it->second.block_hashes.find(block_size);
+    if (found == it->second.block_hashes.end()) {
+        return false;
+    }
+    hashes = found->second;
+    return true;
+}
+
+void ChunkCache::store_block_hashes(const FileKey& key, uint64_t block_size,
+                                    const std::vector<file::FileManager::BlockHash>& hashes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ > 0 && hashes.size() <= kMaxBlockHashes) {
+        file_locked(key).block_hashes[block_size] = hashes;
+    }
+}
+
+} // namespace server
+} // namespace netcopy
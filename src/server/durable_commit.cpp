@@ -0,0 +1,365 @@
+#include "server/durable_commit.h"
+#include "common/metrics.h"
+#include "file/file_manager.h"
+#include "logging/logger.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace netcopy {
+namespace server {
+
+namespace {
+
+// Files on one file system from which a single syncfs beats one fdatasync each
+constexpr size_t kSyncfsBatch = 8;
+// Outcomes kept for destinations nobody asked about (clients without E2E verify)
+constexpr size_t kMaxRetainedOutcomes = 4096;
+
+struct CommitMetrics {
+    common::MetricCounter& files;
+    common::MetricCounter& batches;
+    common::MetricCounter& syncs;
+    common::MetricCounter& failures;
+};
+
+CommitMetrics& commit_metrics() {
+    static CommitMetrics metrics = []() {
+        auto& r = common::MetricsRegistry::instance();
+        return CommitMetrics{
+            r.counter("netcopy_server_durable_files_total", "Uploads renamed into place after a flush"),
+            r.counter("netcopy_server_durable_batches_total", "Group commits run"),
+            r.counter("netcopy_server_durable_syncs_total", "File or file system flushes issued by group commits"),
+            r.counter("netcopy_server_durable_failures_total", "Uploads whose flush or rename failed"),
+        };
+    }();
+    return metrics;
+}
+
+std::string errno_text() {
+    return std::strerror(errno);
+}
+
+#ifdef _WIN32
+
+bool flush_file(const std::string& path, std::string& error) {
+    std::wstring wide = std::filesystem::u8path(path).wstring();
+    HANDLE handle = CreateFileW(wide.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path + " to flush it";
+        return false;
+    }
+    bool flushed = FlushFileBuffers(handle) != 0;
+    CloseHandle(handle);
+    if (!flushed) {
+        error = "flush of " + path + " failed";
+    }
+    return flushed;
+}
+
+#else
+
+bool flush_fd(int fd, std::string& error, const std::string& path) {
+#if defined(__APPLE__)
+    // fsync on macOS stops at the drive cache
+    if (fcntl(fd, F_FULLFSYNC) == 0) {
+        return true;
+    }
+#endif
+#if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0 && !defined(__APPLE__)
+    if (fdatasync(fd) == 0) {
+        return true;
+    }
+#else
+    if (fsync(fd) == 0) {
+        return true;
+    }
+#endif
+    error = "flush of " + path + " failed: " + errno_text();
+    return false;
+}
+
+bool flush_file(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path + " to flush it: " + errno_text();
+        return false;
+    }
+    bool flushed = flush_fd(fd, error, path);
+    ::close(fd);
+    return flushed;
+}
+
+#endif
+
+} // namespace
+
+DurableCommitter& DurableCommitter::instance() {
+    static DurableCommitter committer;
+    return committer;
+}
+
+DurableCommitter::~DurableCommitter() {
+    stop();
+}
+
+void DurableCommitter::configure(bool enabled, std::chrono::milliseconds window) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = enabled;
+    window_ = window;
+    if (enabled_ && !thread_.joinable()) {
+        stopping_ = false;
+        thread_ = std::thread(&DurableCommitter::run, this);
+    }
+    if (enabled_) {
+        LOG_INFO("Durable writes enabled, group commit window " + std::to_string(window.count()) + " ms");
+    }
+}
+
+void DurableCommitter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!thread_.joinable()) {
+            return;
+        }
+        stopping_ = true;
+    }
+    queued_.notify_all();
+    // The committer drains the queue before it exits
+    thread_.join();
+}
+
+bool DurableCommitter::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_;
+}
+
+std::string DurableCommitter::stage_path(const std::string& destination) {
+    std::filesystem::path path = std::filesystem::u8path(destination);
+    std::filesystem::path stage = path.parent_path() / std::filesystem::u8path("." + path.filename().u8string() + ".ncpart");
+    return stage.u8string();
+}
+
+void DurableCommitter::begin_stage(const std::string& destination) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_[file::FileManager::normalize_path(destination)] = stage_path(destination);
+}
+
+std::string DurableCommitter::active_stage(const std::string& destination) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = stages_.find(file::FileManager::normalize_path(destination));
+    return it != stages_.end() ? it->second : std::string();
+}
+
+void DurableCommitter::abandon_stage(const std::string& destination) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.erase(file::FileManager::normalize_path(destination));
+}
+
+void DurableCommitter::submit(const std::string& destination) {
+    const std::string key = file::FileManager::normalize_path(destination);
+    Entry entry;
+    bool inline_commit = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = stages_.find(key);
+        if (it == stages_.end()) {
+            return;
+        }
+        entry.stage = it->second;
+        entry.destination = destination;
+        entry.ticket = ++next_ticket_;
+        stages_.erase(it);
+        Outcome& outcome = outcomes_[key];
+        outcome = Outcome{};
+        outcome.ticket = entry.ticket;
+        inline_commit = !thread_.joinable() || stopping_;
+        if (!inline_commit) {
+            queue_.push_back(entry);
+        }
+    }
+#ifdef __linux__
+    // Start writeback now so the flush in the batch mostly waits for I/O
+    // that is already under way
+    int fd = ::open(entry.stage.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+        ::close(fd);
+    }
+#endif
+    if (inline_commit) {
+        std::deque<Entry> batch{entry};
+        commit_batch(batch);
+    } else {
+        queued_.notify_one();
+    }
+}
+
+DurableCommitter::State DurableCommitter::wait(const std::string& destination, std::string* error) {
+    const std::string key = file::FileManager::normalize_path(destination);
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = outcomes_.find(key);
+    if (it == outcomes_.end()) {
+        return State::None;
+    }
+    const uint64_t ticket = it->second.ticket;
+    committed_.wait(lock, [&]() {
+        auto current = outcomes_.find(key);
+        return current == outcomes_.end() || current->second.ticket != ticket || current->second.done;
+    });
+    it = outcomes_.find(key);
+    if (it == outcomes_.end() || it->second.ticket != ticket) {
+        // Superseded by a newer upload of the same file
+        return State::None;
+    }
+    State state = it->second.failed ? State::Failed : State::Durable;
+    if (error) {
+        *error = it->second.error;
+    }
+    outcomes_.erase(it);
+    return state;
+}
+
+void DurableCommitter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        queued_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            break;
+        }
+        if (window_.count() > 0 && !stopping_) {
+            queued_.wait_for(lock, window_, [this]() { return stopping_; });
+        }
+        std::deque<Entry> batch;
+        batch.swap(queue_);
+        lock.unlock();
+        commit_batch(batch);
+        lock.lock();
+    }
+}
+
+void DurableCommitter::commit_batch(std::deque<Entry>& batch) {
+    std::vector<std::string> errors(batch.size());
+    std::vector<bool> flushed(batch.size(), false);
+    uint64_t syncs = 0;
+
+#if defined(__linux__)
+    // Group by file system: past kSyncfsBatch files one syncfs flushes them all
+    std::map<dev_t, std::vector<size_t>> devices;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        struct stat st{};
+        if (::stat(batch[i].stage.c_str(), &st) != 0) {
+            errors[i] = "staging file " + batch[i].stage + " is missing: " + errno_text();
+            continue;
+        }
+        devices[st.st_dev].push_back(i);
+    }
+    for (const auto& device : devices) {
+        const auto& members = device.second;
+        if (members.size() >= kSyncfsBatch) {
+            int fd = ::open(batch[members.front()].stage.c_str(), O_RDONLY);
+            ++syncs;
+            if (fd >= 0 && syncfs(fd) == 0) {
+                for (size_t i : members) {
+                    flushed[i] = true;
+                }
+                ::close(fd);
+                continue;
+            }
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            LOG_WARNING("syncfs failed (" + errno_text() + "); flushing files one by one");
+        }
+        for (size_t i : members) {
+            ++syncs;
+            flushed[i] = flush_file(batch[i].stage, errors[i]);
+        }
+    }
+#else
+    for (size_t i = 0; i < batch.size(); ++i) {
+        ++syncs;
+        flushed[i] = flush_file(batch[i].stage, errors[i]);
+    }
+#endif
+
+    std::set<std::string> directories;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (!flushed[i]) {
+            continue;
+        }
+        std::error_code ec;
+        std::filesystem::rename(std::filesystem::u8path(batch[i].stage),
+                                std::filesystem::u8path(batch[i].destination), ec);
+        if (ec) {
+            flushed[i] = false;
+            errors[i] = "rename of " + batch[i].stage + " failed: " + ec.message();
+            continue;
+        }
+        directories.insert(file::FileManager::get_directory(batch[i].destination));
+    }
+
+#ifndef _WIN32
+    // The renames are only durable once their directories are
+    for (const auto& directory : directories) {
+        int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+        if (fd < 0) {
+            continue;
+        }
+        ++syncs;
+        if (fsync(fd) != 0) {
+            LOG_WARNING("fsync of directory " + directory + " failed: " + errno_text());
+        }
+        ::close(fd);
+    }
+#endif
+
+    uint64_t committed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const std::string key = file::FileManager::normalize_path(batch[i].destination);
+            auto it = outcomes_.find(key);
+            if (!flushed[i]) {
+                LOG_ERROR("Durable commit of " + batch[i].destination + " failed: " + errors[i]);
+            } else {
+                ++committed;
+            }
+            if (it == outcomes_.end() || it->second.ticket != batch[i].ticket) {
+                continue;
+            }
+            it->second.done = true;
+            it->second.failed = !flushed[i];
+            it->second.error = errors[i];
+        }
+        if (outcomes_.size() > kMaxRetainedOutcomes) {
+            for (auto it = outcomes_.begin(); it != outcomes_.end() && outcomes_.size() > kMaxRetainedOutcomes / 2;) {
+                it = it->second.done ? outcomes_.erase(it) : std::next(it);
+            }
+        }
+    }
+    committed_.notify_all();
+
+    auto& metrics = commit_metrics();
+    metrics.batches.add(1);
+    metrics.files.add(committed);
+    metrics.syncs.add(syncs);
+    metrics.failures.add(batch.size() - committed);
+    LOG_DEBUG("Group commit: " + std::to_string(committed) + " of " + std::to_string(batch.size()) +
+              " files with " + std::to_string(syncs) + " flushes");
+}
+
+} // namespace server
+} // namespace netcopy
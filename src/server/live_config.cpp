@@ -0,0 +1,76 @@
+#include "server/live_config.h"
+
+namespace netcopy {
+namespace server {
+
+LiveConfig& LiveConfig::instance() {
+    static LiveConfig live;
+    return live;
+}
+
+void LiveConfig::publish(const config::ServerConfig& config) {
+    auto snapshot = std::make_shared<const config::ServerConfig>(config);
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_ = std::move(snapshot);
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<const config::ServerConfig> LiveConfig::snapshot(uint64_t* generation) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation) {
+        *generation = generation_.load(std::memory_order_relaxed);
+    }
+    return current_;
+}
+
+void LiveConfig::copy_tunables(const config::ServerConfig& from, config::ServerConfig& to) {
+    // Keep in step with ServerConfig::reloadable_keys()
+    to.max_file_size = from.max_file_size;
+    to.max_active_streams = from.max_active_streams;
+    to.memory_budget_bytes = from.memory_budget_bytes;
+    to.chunk_cache_bytes = from.chunk_cache_bytes;
+    to.durable_writes = from.durable_writes;
+    to.durable_commit_window_ms = from.durable_commit_window_ms;
+    to.internal.inflight_window_bytes = from.internal.inflight_window_bytes;
+    to.internal.batch_bytes = from.internal.batch_bytes;
+    to.internal.batch_chunks = from.internal.batch_chunks;
+    to.internal.preallocate_files = from.internal.preallocate_files;
+    to.internal.trusted_skip_zero_fill = from.internal.trusted_skip_zero_fill;
+    to.internal.cache_hints = from.internal.cache_hints;
+    to.internal.streaming_verification = from.internal.streaming_verification;
+    to.internal.tcp_info_window = from.internal.tcp_info_window;
+    to.internal.resume_journal = from.internal.resume_journal;
+    to.internal.sparse_files = from.internal.sparse_files;
+    to.internal.block_copy = from.internal.block_copy;
+}
+
+std::vector<std::string> LiveConfig::restart_only_changes(const config::ServerConfig& running,
+                                                          const config::ServerConfig& loaded) {
+    std::vector<std::string> changed;
+    auto check = [&](bool differs, const char* name) {
+        if (differs) {
+            changed.push_back(name);
+        }
+    };
+    check(running.listen_address != loaded.listen_address || running.listen_port != loaded.listen_port,
+          "listen address");
+    check(running.max_connections != loaded.max_connections, "max_connections");
+    check(running.socket_buffer_size != loaded.socket_buffer_size, "socket_buffer_size");
+    check(running.accept_shards != loaded.accept_shards || running.pin_accept_shards != loaded.pin_accept_shards,
+          "accept_shards");
+    check(running.max_bandwidth_percent != loaded.max_bandwidth_percent, "max_bandwidth_percent");
+    check(running.internal.max_chunk_size != loaded.internal.max_chunk_size, "max_chunk_size");
+    check(running.internal.secret_key != loaded.internal.secret_key ||
+          running.internal.require_auth != loaded.internal.require_auth ||
+          running.internal.auth_method != loaded.internal.auth_method ||
+          running.internal.security_level != loaded.internal.security_level,
+          "[protocol.internal] authentication");
+    check(running.tls.enable != loaded.tls.enable || running.tls.server_cert_file != loaded.tls.server_cert_file ||
+          running.tls.server_key_file != loaded.tls.server_key_file,
+          "[protocol.tls]");
+    check(running.allowed_paths != loaded.allowed_paths, "allowed_paths");
+    return changed;
+}
+
+} // namespace server
+} // namespace netcopy
@@ -3,6 +3,7 @@
 #include "logging/logger.h"
 #include "file/file_manager.h" // Added for FileManager
 #include "daemon/daemon.h" // Added for daemon functionality
+#include "common/trace.h"
 #include <iostream>
 #include <string>
 #include <filesystem> // Added for std::filesystem
@@ -34,6 +35,8 @@ void print_usage(const char* program_name) {
     std::cout << "  --auto-create              Automatically create non-existent directories (default)" << std::endl;
     std::cout << "  --no-auto-create           Disable automatic directory creation" << std::endl;
     std::cout << "  -v, --verbose              Enable verbose logging" << std::endl;
+    std::cout << "  --trace FILE               Write a per-chunk stage trace (Chrome trace JSON)" << std::endl;
+    std::cout << "  --trace-sample N           Trace one chunk in N (default: 1, every chunk)" << std::endl;
     std::cout << "  -h, --help                 Show this help message" << std::endl << std::endl;
     
     std::cout << "Examples:" << std::endl;
@@ -65,6 +68,8 @@ struct CommandLineArgs {
     bool udp = false;
     std::string relay;
     std::string token;
+    std::string trace_file;
+    uint32_t trace_sample = 1;
 };
 
 bool parse_listen_address(const std::string& listen_arg, std::string& address, uint16_t& port) {
@@ -195,6 +200,26 @@ CommandLineArgs parse_arguments(const std::vector<std::string>& arg_list) {
             } else {
                 throw std::runtime_error("Missing token argument");
             }
+        } else if (arg == "--trace") {
+            if (i + 1 < arg_list.size()) {
+                args.trace_file = arg_list[++i];
+            } else {
+                throw std::runtime_error("Missing file argument for --trace");
+            }
+        } else if (arg == "--trace-sample") {
+            if (i + 1 < arg_list.size()) {
+                try {
+                    int sample = std::stoi(arg_list[++i]);
+                    if (sample < 1) {
+                        throw std::runtime_error("must be at least 1");
+                    }
+                    args.trace_sample = static_cast<uint32_t>(sample);
+                } catch (const std::exception& e) {
+                    throw std::runtime_error("Error parsing --trace-sample argument '" + arg_list[i] + "': " + e.what());
+                }
+            } else {
+                throw std::runtime_error("Missing value for --trace-sample");
+            }
         } else {
             throw std::runtime_error("Unknown argument: " + arg);
         }
@@ -298,6 +323,14 @@ int server_main(int argc, char* argv[]) {
         
         server.set_config(config);
         
+        if (!args.trace_file.empty()) {
+            netcopy::common::ChunkTracer::instance().enable("server", args.trace_sample);
+            // Absolute, since daemon mode changes the working directory
+            std::error_code ec;
+            auto trace_path = std::filesystem::absolute(std::filesystem::u8path(args.trace_file), ec);
+            server.set_trace_output(ec ? args.trace_file : trace_path.u8string());
+        }
+        
         // Reconfigure logging after updating config (especially for daemon mode)
         auto& logger = netcopy::logging::Logger::instance();
         logger.set_level(netcopy::logging::Logger::string_to_level(config.logging.level));
@@ -0,0 +1,168 @@
+#include "server/memory_budget.h"
+#include "common/metrics.h"
+#include "logging/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace netcopy {
+namespace server {
+
+namespace {
+
+constexpr uint64_t kMinAutoBudget = 256ull * 1024 * 1024;
+constexpr std::chrono::seconds kMaxWait{30};
+// Smallest window worth advising; matches the transfer window's lower bound
+constexpr uint64_t kMinAdvisedWindow = 4ull * 1024 * 1024;
+
+uint64_t physical_memory() {
+#ifdef _WIN32
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? static_cast<uint64_t>(status.ullTotalPhys) : 0;
+#elif defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    return pages > 0 && page_size > 0 ? static_cast<uint64_t>(pages) * static_cast<uint64_t>(page_size) : 0;
+#else
+    return 0;
+#endif
+}
+
+struct MemoryMetrics {
+    common::MetricGauge& limit;
+    common::MetricGauge& reserved;
+    common::MetricCounter& waits;
+};
+
+MemoryMetrics& memory_metrics() {
+    static MemoryMetrics metrics = []() {
+        auto& r = common::MetricsRegistry::instance();
+        return MemoryMetrics{
+            r.gauge("netcopy_server_memory_budget_bytes", "Memory all connections may hold in transfer buffers"),
+            r.gauge("netcopy_server_memory_reserved_bytes", "Transfer buffer memory currently reserved"),
+            r.counter("netcopy_server_memory_waits_total", "Reservations that had to wait for the memory budget"),
+        };
+    }();
+    return metrics;
+}
+
+} // namespace
+
+MemoryBudget& MemoryBudget::instance() {
+    static MemoryBudget budget;
+    return budget;
+}
+
+void MemoryBudget::configure(uint64_t limit_bytes) {
+    if (limit_bytes == 0) {
+        limit_bytes = (std::max)(kMinAutoBudget, physical_memory() / 4);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        limit_ = limit_bytes;
+    }
+    released_.notify_all();
+    memory_metrics().limit.set(static_cast<int64_t>(limit_bytes));
+    LOG_INFO("Transfer memory budget: " + std::to_string(limit_bytes / (1024 * 1024)) + " MB");
+}
+
+uint64_t MemoryBudget::limit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limit_;
+}
+
+uint64_t MemoryBudget::reserved() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reserved_;
+}
+
+double MemoryBudget::pressure() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limit_ == 0 ? 0.0 : static_cast<double>(reserved_) / static_cast<double>(limit_);
+}
+
+uint64_t MemoryBudget::advised_window(uint64_t configured_window) const {
+    const double level = pressure();
+    if (level < 0.5) {
+        return 0;
+    }
+    uint64_t window = level >= 0.9 ? kMinAdvisedWindow
+                    : level >= 0.75 ? configured_window / 4
+                                    : configured_window / 2;
+    return (std::max)(kMinAdvisedWindow, window);
+}
+
+void MemoryBudget::acquire(uint64_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    // An unconfigured budget (e.g. in tools embedding the server) only counts
+    auto fits = [&]() { return limit_ == 0 || reserved_ == 0 || reserved_ + bytes <= limit_; };
+    if (bytes >= kSmallAllocation && !fits()) {
+        memory_metrics().waits.add();
+        if (!released_.wait_for(lock, kMaxWait, fits)) {
+            LOG_WARNING("Memory budget exhausted for " + std::to_string(kMaxWait.count()) +
+                        " s; overcommitting " + std::to_string(bytes) + " bytes");
+        }
+    }
+    reserved_ += bytes;
+    memory_metrics().reserved.set(static_cast<int64_t>(reserved_));
+}
+
+void MemoryBudget::give_back(uint64_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reserved_ -= (std::min)(bytes, reserved_);
+        memory_metrics().reserved.set(static_cast<int64_t>(reserved_));
+    }
+    released_.notify_all();
+}
+
+MemoryBudget::Reservation::Reservation(uint64_t bytes) {
+    MemoryBudget::instance().acquire(bytes);
+    bytes_ = bytes;
+}
+
+MemoryBudget::Reservation::~Reservation() {
+    release();
+}
+
+MemoryBudget::Reservation::Reservation(Reservation&& other) noexcept
+    : bytes_(std::exchange(other.bytes_, 0)) {}
+
+MemoryBudget::Reservation& MemoryBudget::Reservation::operator=(Reservation&& other) noexcept {
+    if (this != &other) {
+        release();
+        bytes_ = std::exchange(other.bytes_, 0);
+    }
+    return *this;
+}
+
+void MemoryBudget::Reservation::resize(uint64_t bytes) {
+    if (bytes < bytes_) {
+        MemoryBudget::instance().give_back(bytes_ - bytes);
+    } else if (bytes > bytes_) {
+        MemoryBudget::instance().acquire(bytes - bytes_);
+    }
+    bytes_ = bytes;
+}
+
+void MemoryBudget::Reservation::release() {
+    MemoryBudget::instance().give_back(bytes_);
+    bytes_ = 0;
+}
+
+} // namespace server
+} // namespace netcopy
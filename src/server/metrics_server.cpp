@@ -0,0 +1,123 @@
+#include "server/metrics_server.h"
+#include "common/metrics.h"
+#include "common/trace.h"
+#include "logging/logger.h"
+#include "exceptions.h"
+#include <istream>
+
+namespace netcopy {
+namespace server {
+
+namespace {
+
+void send_response(std::shared_ptr<asio::ip::tcp::socket> socket, const std::string& status,
+                   const std::string& content_type, const std::string& body) {
+    std::string response = "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: " + content_type + "\r\n";
+    response += "Content-Length: " + std::to_string(body.length()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+
+    auto res = std::make_shared<std::string>(std::move(response));
+    asio::async_write(*socket, asio::buffer(*res), [res, socket](asio::error_code ec, std::size_t) {
+        socket->close(ec);
+    });
+}
+
+} // namespace
+
+MetricsServer::MetricsServer(const std::string& listen_address, uint16_t port)
+    : listen_address_(listen_address), port_(port) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::start() {
+    event_loop_ = std::make_unique<network::EventLoop>(1);
+    event_loop_->start();
+
+    try {
+        asio::ip::tcp::endpoint endpoint(asio::ip::make_address(listen_address_), port_);
+        acceptor_ = std::make_unique<asio::ip::tcp::acceptor>(event_loop_->get_io_context());
+        acceptor_->open(endpoint.protocol());
+        acceptor_->set_option(asio::ip::tcp::acceptor::reuse_address(true));
+        acceptor_->bind(endpoint);
+        acceptor_->listen();
+        port_ = acceptor_->local_endpoint().port();
+    } catch (const std::exception& e) {
+        stop();
+        throw NetworkException("Failed to start metrics endpoint on " + listen_address_ + ":" +
+                               std::to_string(port_) + ": " + e.what());
+    }
+
+    running_ = true;
+    do_accept();
+    LOG_INFO("Metrics endpoint listening on http://" + listen_address_ + ":" + std::to_string(port_) + "/metrics");
+}
+
+void MetricsServer::stop() {
+    running_ = false;
+    if (acceptor_) {
+        asio::error_code ec;
+        acceptor_->close(ec);
+        acceptor_.reset();
+    }
+    if (event_loop_) {
+        event_loop_->stop();
+        event_loop_.reset();
+    }
+}
+
+void MetricsServer::do_accept() {
+    auto socket = std::make_shared<asio::ip::tcp::socket>(event_loop_->get_io_context());
+    acceptor_->async_accept(*socket, [this, socket](const asio::error_code& ec) {
+        if (!running_) return;
+        if (!ec) {
+            handle(socket);
+        }
+        do_accept();
+    });
+}
+
+void MetricsServer::handle(std::shared_ptr<asio::ip::tcp::socket> socket) {
+    auto buffer = std::make_shared<asio::streambuf>(16 * 1024);
+    asio::async_read_until(*socket, *buffer, "\r\n\r\n",
+        [socket, buffer](const asio::error_code& ec, std::size_t) {
+            if (ec) {
+                return;
+            }
+            std::istream is(buffer.get());
+            std::string request_line;
+            std::getline(is, request_line);
+            if (!request_line.empty() && request_line.back() == '\r') {
+                request_line.pop_back();
+            }
+
+            size_t method_end = request_line.find(' ');
+            size_t path_end = method_end == std::string::npos ? std::string::npos : request_line.find(' ', method_end + 1);
+            if (path_end == std::string::npos) {
+                send_response(socket, "400 Bad Request", "text/plain", "Bad Request\n");
+                return;
+            }
+            std::string method = request_line.substr(0, method_end);
+            std::string path = request_line.substr(method_end + 1, path_end - (method_end + 1));
+            size_t q_pos = path.find('?');
+            if (q_pos != std::string::npos) {
+                path = path.substr(0, q_pos);
+            }
+
+            if (method == "GET" && path == "/metrics") {
+                send_response(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                              common::MetricsRegistry::instance().render());
+            } else if (method == "GET" && path == "/trace" && common::ChunkTracer::instance().enabled()) {
+                send_response(socket, "200 OK", "application/json",
+                              common::ChunkTracer::instance().to_chrome_json());
+            } else {
+                send_response(socket, "404 Not Found", "text/plain", "Not Found\n");
+            }
+        });
+}
+
+} // namespace server
+} // namespace netcopy
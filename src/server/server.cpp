@@ -1,15 +1,21 @@
 #include "server/server.h"
+#include "server/admission.h"
+#include "server/chunk_cache.h"
+#include "server/durable_commit.h"
+#include "server/live_config.h"
 #include "common/fast_mem.h"
 #include "file/file_manager.h"
 #include "logging/logger.h"
 #include "common/utils.h"
 #include "common/compression.h"
+#include "common/trace.h"
 #include "daemon/daemon.h"
 #include "exceptions.h"
 #include "auth/user_db.h"
 #include "auth/auth_engine.h"
 #include "crypto/sha3.h"
 #include "crypto/xxhash64.h"
+#include "crypto/cipher_benchmark.h"
 #include "network/windows_experimental.h"
 #include "logging/audit_log.h"
 #include <algorithm>
@@ -21,8 +27,17 @@
 #include <sstream>
 #include <random>
 #include <unordered_map>
+#include <deque>
 #include <mutex>
 #include <thread>
+#include <filesystem>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/filter.h>
+#include <sys/socket.h>
+#endif
 
 namespace netcopy {
 namespace server {
@@ -52,6 +67,106 @@ size_t normalized_batch_chunks(int configured) {
     value = (std::max)(1, (std::min)(value, config::defaults::kMaxBatchChunks));
     return static_cast<size_t>(value);
 }
+
+// FNV-1a over everything a listing shows, so a client can keep its cached
+// copy while nothing in the directory changed. Never 0, which means unknown.
+uint64_t listing_version(const std::vector<protocol::RemoteFileInfo>& entries) {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](const void* data, size_t length) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+    for (const auto& e : entries) {
+        mix(e.path.data(), e.path.size() + 1);
+        mix(&e.size, sizeof(e.size));
+        mix(&e.last_modified, sizeof(e.last_modified));
+        mix(&e.permissions, sizeof(e.permissions));
+        const uint8_t flags = (e.is_directory ? 1 : 0) | (e.is_symlink ? 2 : 0);
+        mix(&flags, sizeof(flags));
+        mix(e.symlink_target.data(), e.symlink_target.size() + 1);
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+// Merkle trees of uploads in progress. Parallel streams are separate
+// connections, so they find the tree of their destination here; an entry
+// lives only while some connection still holds the tree.
+struct UploadTreeEntry {
+    std::weak_ptr<crypto::MerkleTree> tree;
+    uint64_t last_modified = 0;
+};
+
+std::mutex upload_trees_mutex;
+std::unordered_map<std::string, UploadTreeEntry> upload_trees;
+
+std::shared_ptr<crypto::MerkleTree> acquire_upload_tree(const std::string& path,
+                                                        uint64_t file_size,
+                                                        uint64_t last_modified,
+                                                        uint64_t leaf_size,
+                                                        bool fresh) {
+    std::lock_guard<std::mutex> lock(upload_trees_mutex);
+    auto& entry = upload_trees[file::FileManager::normalize_path(path)];
+    auto tree = entry.tree.lock();
+    if (!fresh && tree && tree->data_size() == file_size && tree->leaf_size() == leaf_size &&
+        entry.last_modified == last_modified) {
+        return tree;
+    }
+    tree = std::make_shared<crypto::MerkleTree>(file_size, leaf_size);
+    entry.tree = tree;
+    entry.last_modified = last_modified;
+    return tree;
+}
+
+// Stops later requests from joining a tree that no longer matches the file
+void release_upload_tree(const std::string& path) {
+    std::lock_guard<std::mutex> lock(upload_trees_mutex);
+    upload_trees.erase(file::FileManager::normalize_path(path));
+}
+
+// Hot-path metrics resolved once per process; every update afterwards is a
+// relaxed atomic on the calling thread's slot.
+struct ServerMetrics {
+    common::MetricGauge& connections_active;
+    common::MetricCounter& connections_total;
+    common::MetricHistogram& ack_latency;
+    common::MetricHistogram& compress_time;
+    common::MetricHistogram& decompress_time;
+    common::MetricHistogram& hash_time;
+    common::MetricHistogram& write_time;
+    common::MetricHistogram& read_time;
+    common::MetricCounter& encrypt_bytes;
+    common::MetricHistogram& encrypt_time;
+    common::MetricCounter& decrypt_bytes;
+    common::MetricHistogram& decrypt_time;
+    common::MetricCounter& block_copy_bytes;
+};
+
+ServerMetrics& server_metrics() {
+    static ServerMetrics metrics = []() {
+        auto& r = common::MetricsRegistry::instance();
+        const auto buckets = common::MetricsRegistry::latency_buckets();
+        const std::string encrypt = common::metric_label("op", "encrypt");
+        const std::string decrypt = common::metric_label("op", "decrypt");
+        return ServerMetrics{
+            r.gauge("netcopy_server_connections_active", "Client connections currently being served"),
+            r.counter("netcopy_server_connections_total", "Client connections accepted since start"),
+            r.histogram("netcopy_server_ack_latency_seconds", "Time from sending a download batch to receiving its ACK", buckets),
+            r.histogram("netcopy_server_compress_seconds", "Time spent compressing one download chunk", buckets),
+            r.histogram("netcopy_server_decompress_seconds", "Time spent decompressing one uploaded chunk", buckets),
+            r.histogram("netcopy_server_hash_seconds", "Time spent in streaming verification hashing per chunk", buckets),
+            r.histogram("netcopy_server_write_seconds", "Time spent writing one uploaded chunk to disk", buckets),
+            r.histogram("netcopy_server_read_seconds", "Time spent reading one download chunk from disk", buckets),
+            r.counter("netcopy_server_crypto_bytes_total", "Bytes passed through the transport cipher", encrypt),
+            r.histogram("netcopy_server_crypto_seconds", "Time spent in the transport cipher per message", buckets, encrypt),
+            r.counter("netcopy_server_crypto_bytes_total", "Bytes passed through the transport cipher", decrypt),
+            r.histogram("netcopy_server_crypto_seconds", "Time spent in the transport cipher per message", buckets, decrypt),
+            r.counter("netcopy_server_block_copy_bytes_total", "Upload bytes filled from files already on the server"),
+        };
+    }();
+    return metrics;
+}
 }
 
 struct ServerTransferSession {
@@ -154,6 +269,8 @@ ConnectionHandler::ConnectionHandler(network::Socket client_socket,
       negotiated_max_chunk_size_(config.internal.max_chunk_size), current_is_symlink_(false), current_symlink_target_(""), current_permissions_(0), current_expected_file_size_(0), current_expected_last_modified_(0),
       cached_block_hash_valid_(false) {
     client_address_ = get_client_address();
+    server_metrics().connections_active.add(1);
+    server_metrics().connections_total.add();
     
     // Load user database
     user_db_ = auth::UserDb::load(config_.internal.users_file);
@@ -171,7 +288,15 @@ ConnectionHandler::ConnectionHandler(network::Socket client_socket,
 }
 
 ConnectionHandler::~ConnectionHandler() {
+    server_metrics().connections_active.sub(1);
+    if (admission_registered_) {
+        AdmissionController::instance().remove_stream(admission_client_);
+    }
     current_file_stream_.close();
+    abandon_stage();
+    if (current_journal_) {
+        current_journal_->persist(true);
+    }
     if (current_session_ && current_session_->is_active) {
         current_session_->is_active = false;
         current_session_->status = "failed";
@@ -194,6 +319,11 @@ void ConnectionHandler::handle() {
         
         perform_handshake();
         
+        auto& registry = common::MetricsRegistry::instance();
+        const std::string user_label = common::metric_label("user", authenticated_user_.empty() ? "anonymous" : authenticated_user_);
+        bytes_received_metric_ = &registry.counter("netcopy_server_bytes_received_total", "File payload bytes received per user", user_label);
+        bytes_sent_metric_ = &registry.counter("netcopy_server_bytes_sent_total", "File payload bytes sent per user", user_label);
+        
         // Main message loop
         while (true) {
             auto message = receive_message();
@@ -242,10 +372,23 @@ void ConnectionHandler::handle() {
                     if (req) handle_transfer_status_request(*req);
                     break;
                 }
+                case protocol::MessageType::MERKLE_NODES_REQUEST: {
+                    auto req = dynamic_cast<protocol::MerkleNodesRequest*>(message.get());
+                    if (req) handle_merkle_nodes_request(*req);
+                    break;
+                }
+                case protocol::MessageType::BLOCK_COPY_REQUEST: {
+                    auto req = dynamic_cast<protocol::BlockCopyRequest*>(message.get());
+                    if (req) handle_block_copy_request(*req);
+                    break;
+                }
                 default:
                     LOG_WARNING("Received unknown message type from " + client_address_);
                     break;
             }
+            // An idle connection holds no budget
+            message.reset();
+            frame_reservation_.release();
         }
         
     } catch (const std::exception& e) {
@@ -275,6 +418,7 @@ void ConnectionHandler::perform_handshake() {
     // Negotiate security level and maximum chunk size
     crypto::SecurityLevel configured_level = crypto::SecurityLevel::HIGH;
     bool enforce_level = false;
+    const bool encrypting = config_.internal.require_auth && !config_.internal.secret_key.empty();
     
     std::string s_level = config_.internal.security_level;
     std::transform(s_level.begin(), s_level.end(), s_level.begin(), ::toupper);
@@ -288,13 +432,31 @@ void ConnectionHandler::perform_handshake() {
     }
     
     negotiated_security_level_ = enforce_level ? configured_level : request->security_level;
+    if (!enforce_level && request->auto_security_level && encrypting) {
+        negotiated_security_level_ = crypto::choose_fastest_cipher(crypto::local_cipher_rates(), request->cipher_rates);
+        LOG_DEBUG("Client cipher rates: ChaCha20-Poly1305 " + std::to_string(request->cipher_rates.chacha20_poly1305) +
+                  " MB/s, AES-256-GCM " + std::to_string(request->cipher_rates.aes_256_gcm) + " MB/s");
+    }
     
     negotiated_max_chunk_size_ = request->max_chunk_size == 0
         ? config_.internal.max_chunk_size
         : (std::min)(config_.internal.max_chunk_size, static_cast<size_t>(request->max_chunk_size));
+
+    // Streams of one client share its address; the port tells them apart
+    admission_client_ = client_address_.substr(0, client_address_.rfind(':'));
+    auto& admission = AdmissionController::instance();
+    requested_streams_ = request->requested_parallel_streams == 0 ? 1 : request->requested_parallel_streams;
+    auto grant = admission.grant(admission_client_, requested_streams_, negotiated_max_chunk_size_);
+    admission.add_stream(admission_client_);
+    admission_registered_ = true;
+    accepts_admission_updates_ = request->accepts_admission_updates;
+    granted_streams_ = grant.streams;
+    granted_chunk_size_ = grant.max_chunk_size;
+    admission_checked_at_ = std::chrono::steady_clock::now();
+    negotiated_max_chunk_size_ = grant.max_chunk_size;
     
     // Create appropriate crypto engine
-    if (config_.internal.require_auth && !config_.internal.secret_key.empty()) {
+    if (encrypting) {
         crypto_engine_ = crypto::create_crypto_engine(negotiated_security_level_, config_.internal.secret_key);
         std::string level_name;
         switch (negotiated_security_level_) {
@@ -321,8 +483,29 @@ void ConnectionHandler::perform_handshake() {
     response.authentication_required = config_.internal.require_auth;
     response.accepted_security_level = negotiated_security_level_;
     response.max_chunk_size = negotiated_max_chunk_size_;
-    response.accepted_parallel_streams = request->requested_parallel_streams == 0 ? 1 : (std::min)(8u, request->requested_parallel_streams);
+    response.accepted_parallel_streams = granted_streams_;
     response.auto_create_directories_allowed = config_.auto_create_directories;
+    if (request->auto_security_level && encrypting) {
+        response.cipher_rates = crypto::local_cipher_rates();
+    }
+    
+    // Under TLS the pre-shared key is bound to the TLS session instead of
+    // encrypting every payload a second time. ML-KEM sessions keep the
+    // inner layer: it is what makes them post-quantum.
+    bool channel_bound = false;
+    if (encrypting && !request->tls_binding.empty() && config_.tls.channel_binding &&
+        client_socket_.is_tls() && static_cast<auth::AuthMethod>(request->auth_method_id) != auth::AuthMethod::MLKEM) {
+        auto exporter = client_socket_.export_keying_material(common::kTlsBindingLabel, common::kTlsBindingExporterSize);
+        if (!exporter.empty()) {
+            if (!common::tls_binding_matches(common::tls_binding_proof(config_.internal.secret_key, exporter, true),
+                                             request->tls_binding)) {
+                throw AuthException("TLS channel binding failed: client does not hold the shared key for this session");
+            }
+            response.tls_binding = common::tls_binding_proof(config_.internal.secret_key, exporter, false);
+            channel_bound = true;
+            LOG_INFO("TLS channel binding accepted; payloads are protected by TLS only");
+        }
+    }
     
     // Save nonces for session key derivation (Task 4)
     server_nonce_from_handshake_ = response.server_nonce;
@@ -330,7 +513,9 @@ void ConnectionHandler::perform_handshake() {
     
     send_message(response);
     
-    if (crypto_engine_ && !config_.internal.secret_key.empty()) {
+    if (channel_bound) {
+        crypto_engine_.reset();
+    } else if (crypto_engine_ && !config_.internal.secret_key.empty()) {
         auto derived = common::derive_session_key(
             config_.internal.secret_key,
             {},
@@ -446,7 +631,53 @@ void ConnectionHandler::perform_handshake() {
     LOG_INFO("Handshake completed with " + client_address_);
 }
 
+bool ConnectionHandler::refresh_tuning() {
+    auto& live = LiveConfig::instance();
+    if (live.generation() == tuning_generation_) {
+        return false;
+    }
+    auto snapshot = live.snapshot(&tuning_generation_);
+    if (!snapshot) {
+        return false;
+    }
+    LiveConfig::copy_tunables(*snapshot, config_);
+    return true;
+}
+
+void ConnectionHandler::send_admission_update_if_changed() {
+    // A new window from a reload reaches the client in the update below
+    refresh_tuning();
+    if (!accepts_admission_updates_) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now - admission_checked_at_ < std::chrono::seconds(1)) {
+        return;
+    }
+    admission_checked_at_ = now;
+    // Chunks larger than the handshake allowed are still accepted, so the
+    // grant may only move within it
+    auto grant = AdmissionController::instance().grant(admission_client_, requested_streams_,
+                                                       (std::min)(config_.internal.max_chunk_size, negotiated_max_chunk_size_));
+    // Under memory pressure clients keep less data in flight
+    const uint64_t window = MemoryBudget::instance().advised_window(normalized_window_bytes(config_.internal.inflight_window_bytes));
+    if (grant.streams == granted_streams_ && grant.max_chunk_size == granted_chunk_size_ && window == granted_window_bytes_) {
+        return;
+    }
+    LOG_DEBUG("Admission for " + admission_client_ + ": " + std::to_string(grant.streams) + " streams, " +
+              std::to_string(grant.max_chunk_size) + " byte chunks, window " + std::to_string(window));
+    granted_streams_ = grant.streams;
+    granted_chunk_size_ = grant.max_chunk_size;
+    granted_window_bytes_ = window;
+    protocol::AdmissionUpdate update;
+    update.max_parallel_streams = grant.streams;
+    update.max_chunk_size = grant.max_chunk_size;
+    update.inflight_window_bytes = window;
+    send_message(update);
+}
+
 void ConnectionHandler::handle_file_request(const protocol::FileRequest& request) {
+    send_admission_update_if_changed();
     // Convert paths to native format for logging
     std::string native_source = common::convert_to_native_path(request.source_path);
     std::string native_dest = common::convert_to_native_path(request.destination_path);
@@ -454,8 +685,14 @@ void ConnectionHandler::handle_file_request(const protocol::FileRequest& request
     LOG_INFO("File request from " + client_address_ + ": " + native_source + " -> " + native_dest);
     
     protocol::FileResponse response;
-    current_transfer_completed_ = false;
     current_file_stream_.close();
+    abandon_stage();
+    current_transfer_completed_ = false;
+    if (current_journal_) {
+        current_journal_->persist(true);
+        current_journal_.reset();
+    }
+    current_upload_tree_.reset();
     
     try {
         // Validate destination path
@@ -487,20 +724,44 @@ void ConnectionHandler::handle_file_request(const protocol::FileRequest& request
         
         current_auto_create_ = request.auto_create_directories;
         current_truncate_on_zero_ = request.truncate_destination;
+        current_stage_path_ = select_stage_path(resolved_path, request);
         current_is_symlink_ = request.is_symlink;
         current_symlink_target_ = request.symlink_target;
         current_permissions_ = request.permissions;
         current_expected_file_size_ = request.file_size;
         current_expected_last_modified_ = request.last_modified;
         current_preallocated_ = false;
+        current_sparse_ = config_.internal.sparse_files && request.sparse && !request.is_symlink;
         current_upload_hash_next_offset_ = 0;
         current_upload_hash_valid_ = config_.internal.streaming_verification && !request.is_symlink && request.resume_offset == 0;
         current_upload_hasher_ = current_upload_hash_valid_ ? std::make_unique<crypto::Sha3Hasher>() : nullptr;
         last_received_file_hash_valid_ = false;
         
-        // Check if this is a resume request
-        if (request.resume_offset > 0) {
-            uint64_t current_size = file::FileManager::get_partial_file_size(resolved_path);
+        const bool use_journal = config_.internal.resume_journal &&
+                                 !request.is_symlink &&
+                                 request.file_size >= config::defaults::kServerResumeJournalMinBytes;
+        if (request.truncate_destination) {
+            file::ResumeJournal::discard(resolved_path);
+            if (write_path() != resolved_path) {
+                file::ResumeJournal::discard(write_path());
+            }
+        }
+        
+        // Check if this is a resume request. The journal describes the file
+        // the bytes go to, which is the staging file under durable_writes.
+        std::shared_ptr<file::ResumeJournal> resume_journal;
+        if (request.resume_offset > 0 && use_journal) {
+            resume_journal = file::ResumeJournal::load(write_path(), request.file_size, request.last_modified);
+        }
+        if (resume_journal) {
+            response.has_range_journal = true;
+            response.completed_ranges = resume_journal->completed();
+            // Older clients only understand a single offset
+            response.resume_offset = resume_journal->contiguous_prefix();
+            LOG_DEBUG("Resume request for " + resolved_path + ", journal has " +
+                      std::to_string(response.completed_ranges.size()) + " completed ranges");
+        } else if (request.resume_offset > 0) {
+            uint64_t current_size = file::FileManager::get_partial_file_size(write_path());
             response.resume_offset = current_size;
             LOG_DEBUG("Resume request for " + resolved_path + ", current size: " + std::to_string(current_size));
         } else {
@@ -520,13 +781,33 @@ void ConnectionHandler::handle_file_request(const protocol::FileRequest& request
                 ? file::FileAccessPattern::Random
                 : file::FileAccessPattern::Normal;
             file::FileStream truncate_stream;
-            if (!truncate_stream.open_write(resolved_path, true, current_auto_create_, write_pattern)) {
-                throw FileException("Failed to truncate destination file for writing: " + resolved_path);
+            if (!truncate_stream.open_write(write_path(), true, current_auto_create_, write_pattern)) {
+                throw FileException("Failed to truncate destination file for writing: " + write_path());
             }
             truncate_stream.close();
             current_truncate_on_zero_ = false;
-            LOG_DEBUG("Truncated destination file before receiving ranged data: " + resolved_path);
+            LOG_DEBUG("Truncated destination file before receiving ranged data: " + write_path());
+        }
+        
+        if (use_journal) {
+            current_journal_ = resume_journal ? resume_journal
+                                              : file::ResumeJournal::open(write_path(), request.file_size, request.last_modified);
+        }
+        
+        if (config_.internal.streaming_verification && request.merkle_leaf_size > 0 && !current_is_symlink_) {
+            uint64_t leaf_size = (std::max)(crypto::MerkleTree::kMinLeafSize,
+                                            (std::min)(request.merkle_leaf_size, crypto::MerkleTree::kMaxLeafSize));
+            // Bytes already on disk (resume) stay unhashed and are read at verify time
+            current_upload_tree_ = acquire_upload_tree(resolved_path, request.file_size, request.last_modified,
+                                                       leaf_size, request.truncate_destination);
+            response.merkle_leaf_size = leaf_size;
+            current_upload_hasher_.reset();
+            current_upload_hash_valid_ = false;
+        } else {
+            release_upload_tree(resolved_path);
         }
+        response.sparse = current_sparse_;
+        response.block_copy = config_.internal.block_copy && !current_is_symlink_;
         
         response.success = true;
         if (!current_is_symlink_ && file::FileManager::exists(resolved_path) && file::FileManager::is_regular_file(resolved_path)) {
@@ -574,15 +855,16 @@ void ConnectionHandler::handle_file_data(const protocol::FileData& data) {
             const std::vector<uint8_t>& data;
             bool is_last_chunk;
             bool compressed;
+            bool hole;
         };
 
         std::vector<TempChunk> chunks_to_process;
         if (!data.chunks.empty()) {
             for (const auto& c : data.chunks) {
-                chunks_to_process.push_back({c.offset, c.uncompressed_size, c.data, c.is_last_chunk, c.compressed});
+                chunks_to_process.push_back({c.offset, c.uncompressed_size, c.data, c.is_last_chunk, c.compressed, c.hole});
             }
         } else {
-            chunks_to_process.push_back({data.offset, data.uncompressed_size, data.data, data.is_last_chunk, data.compressed});
+            chunks_to_process.push_back({data.offset, data.uncompressed_size, data.data, data.is_last_chunk, data.compressed, data.hole});
         }
 
         uint64_t max_bytes_received = 0;
@@ -591,10 +873,28 @@ void ConnectionHandler::handle_file_data(const protocol::FileData& data) {
             LOG_DEBUG("Writing " + std::to_string(chunk.data.size()) + " bytes at offset " + 
                      std::to_string(chunk.offset) + " to file: " + current_file_path_);
             
+            if (chunk.hole) {
+                // The length is the client's word alone and punching a hole
+                // can grow the file, so bound it before anything is written
+                if (!current_sparse_ || chunk.compressed) {
+                    throw ProtocolException("Unexpected hole chunk for " + current_file_path_);
+                }
+                if (chunk.offset > UINT64_MAX - chunk.uncompressed_size ||
+                    chunk.offset + chunk.uncompressed_size > current_expected_file_size_ ||
+                    (config_.max_file_size > 0 && chunk.offset + chunk.uncompressed_size > config_.max_file_size)) {
+                    throw ProtocolException("Hole chunk outside the file: offset " + std::to_string(chunk.offset) +
+                                            ", length " + std::to_string(chunk.uncompressed_size));
+                }
+            }
+
             std::vector<uint8_t> decompressed_payload;
+            MemoryBudget::Reservation decompressed_reservation;
             const uint8_t* payload_ptr = nullptr;
             size_t payload_size = 0;
             if (chunk.compressed) {
+                decompressed_reservation = MemoryBudget::Reservation(chunk.uncompressed_size);
+                common::ScopedMetricTimer timer(server_metrics().decompress_time);
+                common::TraceScope trace(common::TraceStage::Decompress, chunk.offset, chunk.uncompressed_size);
                 decompressed_payload = common::decompress_buffer(chunk.data, static_cast<size_t>(chunk.uncompressed_size));
                 payload_ptr = decompressed_payload.data();
                 payload_size = decompressed_payload.size();
@@ -602,6 +902,8 @@ void ConnectionHandler::handle_file_data(const protocol::FileData& data) {
                 payload_ptr = chunk.data.data();
                 payload_size = chunk.data.size();
             }
+            // Bytes of the file this chunk covers; a hole carries no payload
+            const uint64_t chunk_length = chunk.hole ? chunk.uncompressed_size : payload_size;
 
             if (current_is_symlink_) {
                 std::error_code ec;
@@ -631,17 +933,18 @@ void ConnectionHandler::handle_file_data(const protocol::FileData& data) {
                 }
                 LOG_DEBUG("Processed directory marker, directory created but marker file not saved");
             } else {
-                if (!current_file_stream_.is_open() || current_file_stream_.get_path() != current_file_path_) {
+                if (!current_file_stream_.is_open() || current_file_stream_.get_path() != write_path()) {
                     current_file_stream_.close();
                     file::FileAccessPattern write_pattern = config_.internal.cache_hints
                         ? file::FileAccessPattern::Random
                         : file::FileAccessPattern::Normal;
-                    if (!current_file_stream_.open_write(current_file_path_, current_truncate_on_zero_, current_auto_create_, write_pattern)) {
-                        throw FileException("Failed to open destination file for writing: " + current_file_path_);
+                    if (!current_file_stream_.open_write(write_path(), current_truncate_on_zero_, current_auto_create_, write_pattern)) {
+                        throw FileException("Failed to open destination file for writing: " + write_path());
                     }
-                    if (config_.internal.preallocate_files && !current_preallocated_ && current_expected_file_size_ > 0) {
+                    if (config_.internal.preallocate_files && !current_preallocated_ && !current_sparse_ &&
+                        current_expected_file_size_ > 0) {
                         std::string prealloc_error;
-                        if (!file::FileManager::preallocate_file(current_file_path_,
+                        if (!file::FileManager::preallocate_file(write_path(),
                                                                  current_expected_file_size_,
                                                                  current_auto_create_,
                                                                  config_.internal.trusted_skip_zero_fill,
@@ -653,8 +956,13 @@ void ConnectionHandler::handle_file_data(const protocol::FileData& data) {
                     current_truncate_on_zero_ = false;
                 }
 
-                if (current_upload_hasher_ && payload_size > 0) {
+                if (current_upload_hasher_ && chunk.hole) {
+                    // Hashing gigabytes of zeros would defeat the point; verify re-reads instead
+                    current_upload_hash_valid_ = false;
+                } else if (current_upload_hasher_ && payload_size > 0) {
                     if (current_upload_hash_valid_ && chunk.offset == current_upload_hash_next_offset_) {
+                        common::ScopedMetricTimer timer(server_metrics().hash_time);
+                        common::TraceScope trace(common::TraceStage::Hash, chunk.offset, payload_size);
                         current_upload_hasher_->update(payload_ptr, payload_size);
                         current_upload_hash_next_offset_ += payload_size;
                     } else {
@@ -662,7 +970,27 @@ void ConnectionHandler::handle_file_data(const protocol::FileData& data) {
                     }
                 }
                 
-                current_file_stream_.write(chunk.offset, payload_ptr, payload_size);
+                {
+                    common::ScopedMetricTimer timer(server_metrics().write_time);
+                    common::TraceScope trace(common::TraceStage::Write, chunk.offset, chunk_length);
+                    AdmissionController::DiskOperation disk_operation;
+                    if (chunk.hole) {
+                        current_file_stream_.punch_hole(chunk.offset, chunk_length);
+                    } else {
+                        current_file_stream_.write(chunk.offset, payload_ptr, payload_size);
+                    }
+                }
+                if (current_journal_) {
+                    current_journal_->add_range(chunk.offset, chunk_length);
+                }
+                if (current_upload_tree_ && chunk.hole) {
+                    common::ScopedMetricTimer timer(server_metrics().hash_time);
+                    current_upload_tree_->update_zeros(chunk.offset, chunk_length);
+                } else if (current_upload_tree_ && payload_size > 0) {
+                    common::ScopedMetricTimer timer(server_metrics().hash_time);
+                    common::TraceScope trace(common::TraceStage::Hash, chunk.offset, payload_size);
+                    current_upload_tree_->update(chunk.offset, payload_ptr, payload_size);
+                }
                 
                 // Invalidate the cached block full-hash when data is actually written.
                 // The cached hash from handle_block_hashes_request represented the
@@ -673,7 +1001,7 @@ void ConnectionHandler::handle_file_data(const protocol::FileData& data) {
                 }
             }
 
-            uint64_t end_offset = chunk.offset + payload_size;
+            uint64_t end_offset = chunk.offset + chunk_length;
             chunk_total_payload_size += payload_size;
             // Enforce max_file_size if configured (Task 3)
             if (config_.max_file_size > 0 && end_offset > config_.max_file_size) {
@@ -691,6 +1019,13 @@ void ConnectionHandler::handle_file_data(const protocol::FileData& data) {
         if (current_session_) {
             current_session_->bytes_transferred += chunk_total_payload_size;
         }
+        if (bytes_received_metric_) {
+            bytes_received_metric_->add(chunk_total_payload_size);
+        }
+
+        if (current_journal_) {
+            current_journal_->persist();
+        }
 
         ack.bytes_received = max_bytes_received;
         ack.success = true;
@@ -698,6 +1033,9 @@ void ConnectionHandler::handle_file_data(const protocol::FileData& data) {
 
     } catch (const std::exception& e) {
         current_file_stream_.close();
+        if (current_journal_) {
+            current_journal_->persist(true);
+        }
         if (current_session_) {
             current_session_->is_active = false;
             current_session_->status = "failed";
@@ -710,10 +1048,22 @@ void ConnectionHandler::handle_file_data(const protocol::FileData& data) {
         trigger_webhook("upload", current_session_ ? current_session_->source_path : "", current_file_path_, "failed", current_session_ ? current_session_->bytes_transferred.load() : 0, e.what());
     }
     
-    send_message(ack);
+    {
+        // Time spent getting the ACK for this batch back onto the wire
+        uint64_t first_offset = data.chunks.empty() ? data.offset : data.chunks.front().offset;
+        common::TraceChunkContext trace_chunk(first_offset, ack.bytes_received);
+        common::TraceScope trace(common::TraceStage::Ack);
+        send_admission_update_if_changed();
+        send_message(ack);
+    }
     if (ack.success && message_completes_transfer) {
         current_transfer_completed_ = true;
         current_file_stream_.close();
+        if (current_journal_) {
+            const std::string journal_path = current_journal_->file_path();
+            current_journal_.reset();
+            file::ResumeJournal::discard(journal_path);
+        }
         if (current_session_) {
             current_session_->is_active = false;
             current_session_->status = "completed";
@@ -722,25 +1072,33 @@ void ConnectionHandler::handle_file_data(const protocol::FileData& data) {
         }
         if (!current_is_symlink_ && !is_marker_file) {
             std::error_code ec;
-            uint64_t current_size = file::FileManager::exists(current_file_path_) ? file::FileManager::file_size(current_file_path_) : 0;
+            uint64_t current_size = file::FileManager::exists(write_path()) ? file::FileManager::file_size(write_path()) : 0;
             if (current_size > current_expected_file_size_) {
-                LOG_INFO("Truncating " + current_file_path_ + " from " + std::to_string(current_size) + " to " + std::to_string(current_expected_file_size_));
-                std::filesystem::resize_file(current_file_path_, current_expected_file_size_, ec);
+                LOG_INFO("Truncating " + write_path() + " from " + std::to_string(current_size) + " to " + std::to_string(current_expected_file_size_));
+                std::filesystem::resize_file(write_path(), current_expected_file_size_, ec);
                 if (ec) {
                     LOG_ERROR("Failed to truncate file: " + ec.message());
                 }
             }
         }
         if (current_permissions_ != 0 && !current_is_symlink_) {
-            file::FileManager::set_permissions(current_file_path_, current_permissions_);
+            file::FileManager::set_permissions(write_path(), current_permissions_);
         }
         if (current_expected_last_modified_ != 0 && !current_is_symlink_ && !is_marker_file) {
             try {
-                file::FileManager::set_last_write_time(current_file_path_, current_expected_last_modified_);
+                file::FileManager::set_last_write_time(write_path(), current_expected_last_modified_);
             } catch (const std::exception& e) {
                 LOG_ERROR("Failed to set last write time: " + std::string(e.what()));
             }
         }
+        if (!current_stage_path_.empty()) {
+            // Renamed over the destination by the next group commit; the
+            // E2E verify of this file waits for it. Anything written after
+            // this (a Merkle repair) goes to the destination itself.
+            DurableCommitter::instance().submit(current_file_path_);
+            current_stage_path_.clear();
+            current_stage_owned_ = false;
+        }
         if (current_upload_hasher_ &&
             current_upload_hash_valid_ &&
             current_upload_hash_next_offset_ == current_expected_file_size_ &&
@@ -762,6 +1120,7 @@ void ConnectionHandler::send_message(const protocol::Message& message) {
     auto data = message.serialize();
     
     if (transport_encryption_active_ && (crypto_engine_ || crypto_)) {
+        common::TraceScope trace(common::TraceStage::Encrypt);
         data = encrypt_message(data);
     }
     if (data.size() > config::defaults::kMaxFrameSize) {
@@ -770,6 +1129,7 @@ void ConnectionHandler::send_message(const protocol::Message& message) {
     
     // Send message length first (network byte order)
     uint32_t length = htonl(static_cast<uint32_t>(data.size()));
+    common::TraceScope trace(common::TraceStage::Send);
     client_socket_.send_vectored(&length, sizeof(length), data.data(), data.size());
 }
 
@@ -793,6 +1153,18 @@ std::unique_ptr<protocol::Message> ConnectionHandler::receive_message() {
     }
     
     // Receive message data
+    auto& tracer = common::ChunkTracer::instance();
+    const bool tracing = tracer.enabled();
+    std::chrono::steady_clock::time_point receive_start, decrypt_start, decrypt_end;
+    if (tracing) {
+        receive_start = std::chrono::steady_clock::now();
+    }
+    // Reserve the frame, plus its plaintext while it is decrypted, before
+    // reading it; waiting here leaves the bytes in the socket and so pushes
+    // back on the client
+    const bool decrypting = transport_encryption_active_ && (crypto_engine_ || crypto_);
+    frame_reservation_.release();
+    frame_reservation_ = MemoryBudget::Reservation(decrypting ? 2ull * length : length);
     std::vector<uint8_t> data(length);
     size_t total_received = 0;
     while (total_received < length) {
@@ -803,15 +1175,37 @@ std::unique_ptr<protocol::Message> ConnectionHandler::receive_message() {
         total_received += received;
     }
     
-    if (transport_encryption_active_ && (crypto_engine_ || crypto_)) {
+    if (tracing) {
+        decrypt_start = std::chrono::steady_clock::now();
+    }
+    if (decrypting) {
         data = decrypt_message(data);
+        frame_reservation_.resize(data.size());
+    }
+    if (tracing) {
+        decrypt_end = std::chrono::steady_clock::now();
     }
     
-    return protocol::Message::deserialize(data);
+    auto message = protocol::Message::deserialize(data);
+    // The chunk is only known once the frame is decoded, so receive and
+    // decrypt are recorded after the fact against the batch's first chunk
+    if (tracing && message->get_type() == protocol::MessageType::FILE_DATA) {
+        auto file_data = static_cast<const protocol::FileData*>(message.get());
+        uint64_t chunk_offset = file_data->chunks.empty() ? file_data->offset : file_data->chunks.front().offset;
+        if (tracer.should_sample(chunk_offset)) {
+            tracer.record(common::TraceStage::Receive, chunk_offset, length, receive_start, decrypt_start);
+            if (transport_encryption_active_ && (crypto_engine_ || crypto_)) {
+                tracer.record(common::TraceStage::Decrypt, chunk_offset, length, decrypt_start, decrypt_end);
+            }
+        }
+    }
+    return message;
 }
 
 std::vector<uint8_t> ConnectionHandler::encrypt_message(const std::vector<uint8_t>& data) {
     if (crypto_engine_) {
+        server_metrics().encrypt_bytes.add(data.size());
+        common::ScopedMetricTimer timer(server_metrics().encrypt_time);
         return crypto_engine_->encrypt(data);
     } else if (crypto_) {
         // Fallback to old ChaCha20 implementation
@@ -832,6 +1226,8 @@ std::vector<uint8_t> ConnectionHandler::encrypt_message(const std::vector<uint8_
 
 std::vector<uint8_t> ConnectionHandler::decrypt_message(const std::vector<uint8_t>& data) {
     if (crypto_engine_) {
+        server_metrics().decrypt_bytes.add(data.size());
+        common::ScopedMetricTimer timer(server_metrics().decrypt_time);
         return crypto_engine_->decrypt(data);
     } else if (crypto_) {
         // Fallback to old ChaCha20 implementation
@@ -877,6 +1273,56 @@ bool ConnectionHandler::is_path_allowed(const std::string& path) {
     return false;
 }
 
+const std::string& ConnectionHandler::write_path() const {
+    return current_stage_path_.empty() ? current_file_path_ : current_stage_path_;
+}
+
+// Under durable_writes an upload that replaces or creates the whole file is
+// written to a staging file and renamed into place by the group commit.
+// Requests that patch the existing file (delta sync, or the probe that
+// precedes an overwrite decision) keep writing in place.
+std::string ConnectionHandler::select_stage_path(const std::string& resolved_path,
+                                                 const protocol::FileRequest& request) {
+    auto& committer = DurableCommitter::instance();
+    const std::string filename = file::FileManager::get_filename(resolved_path);
+    if (!committer.enabled() || request.is_symlink ||
+        filename == ".netcopy_dir_marker" || filename == ".netcopy_empty_dir") {
+        return "";
+    }
+    const std::string stage = DurableCommitter::stage_path(resolved_path);
+    if (request.resume_offset > 0) {
+        // Partial data written before durable_writes was enabled stays in place
+        if (!file::FileManager::exists(stage)) {
+            return "";
+        }
+    } else if (!request.truncate_destination) {
+        // Another stream of an upload already staged
+        std::string active = committer.active_stage(resolved_path);
+        if (!active.empty()) {
+            current_stage_owned_ = false;
+            return active;
+        }
+        if (file::FileManager::exists(resolved_path)) {
+            return "";
+        }
+        // A new file: start from an empty staging file, whatever an
+        // interrupted run left behind
+        current_truncate_on_zero_ = true;
+    }
+    committer.begin_stage(resolved_path);
+    current_stage_owned_ = true;
+    LOG_DEBUG("Staging upload of " + resolved_path + " in " + stage);
+    return stage;
+}
+
+void ConnectionHandler::abandon_stage() {
+    if (current_stage_owned_ && !current_transfer_completed_) {
+        DurableCommitter::instance().abandon_stage(current_file_path_);
+    }
+    current_stage_owned_ = false;
+    current_stage_path_.clear();
+}
+
 std::string ConnectionHandler::resolve_path(const std::string& path) {
     // Convert network path (always Unix-style) to native platform path
     std::string native_path = netcopy::common::convert_to_native_path(path);
@@ -912,6 +1358,11 @@ Server::~Server() {
 void Server::load_config(const std::string& config_file) {
     try {
         config_ = config::ServerConfig::load_from_file(config_file);
+        file_config_ = config_;
+        std::error_code path_ec;
+        auto absolute_path = std::filesystem::absolute(std::filesystem::u8path(config_file), path_ec);
+        // Absolute, since daemon mode changes the working directory
+        config_file_ = path_ec ? config_file : absolute_path.u8string();
         
         // Initialize logging
         auto& logger = logging::Logger::instance();
@@ -974,25 +1425,19 @@ const config::ServerConfig& Server::get_config() const {
 void Server::start() {
     try {
         LOG_INFO("Starting NetCopy server...");
-        
-        event_loop_ = std::make_unique<network::EventLoop>(config_.max_connections > 0 ? (std::min)(64, config_.max_connections) : std::thread::hardware_concurrency());
-        event_loop_->start();
+        AdmissionController::instance().configure(config_.max_active_streams);
+        MemoryBudget::instance().configure(config_.memory_budget_bytes);
+        ChunkCache::instance().configure(config_.chunk_cache_bytes);
+        DurableCommitter::instance().configure(config_.durable_writes,
+                                               std::chrono::milliseconds(config_.durable_commit_window_ms));
+        LiveConfig::instance().publish(config_);
+        if (config_.internal.require_auth && !config_.internal.secret_key.empty()) {
+            // Measure (or load) the cipher rates now rather than in the first handshake
+            crypto::local_cipher_rates();
+        }
         
         asio::ip::tcp::endpoint endpoint(asio::ip::address::from_string(config_.listen_address.empty() ? "0.0.0.0" : config_.listen_address), config_.listen_port);
-        acceptor_ = std::make_unique<asio::ip::tcp::acceptor>(event_loop_->get_io_context());
-        
-        acceptor_->open(endpoint.protocol());
-        
-#ifdef _WIN32
-        // On Windows, use exclusive address to prevent multiple servers on same port
-        acceptor_->set_option(asio::ip::tcp::acceptor::reuse_address(false));
-#else
-        // On Unix, SO_REUSEADDR helps with quick restarts
-        acceptor_->set_option(asio::ip::tcp::acceptor::reuse_address(true));
-#endif
-
-        acceptor_->bind(endpoint);
-        acceptor_->listen(config_.max_connections > 0 ? config_.max_connections : asio::socket_base::max_listen_connections);
+        open_accept_shards(endpoint);
         
         running_ = true;
         
@@ -1010,6 +1455,16 @@ void Server::start() {
             }
         }
         
+        if (config_.metrics.enable) {
+            try {
+                metrics_server_ = std::make_unique<MetricsServer>(config_.metrics.listen_address, config_.metrics.port);
+                metrics_server_->start();
+            } catch (const std::exception& e) {
+                LOG_WARNING("Failed to start metrics endpoint: " + std::string(e.what()));
+                metrics_server_.reset();
+            }
+        }
+        
         LOG_INFO("Securely listening on TCP port " + std::to_string(config_.listen_port) + " (async_accept)");
         
         // Log all allowed paths
@@ -1022,10 +1477,17 @@ void Server::start() {
             }
         }
         
-        do_accept();
+        for (auto& shard : accept_shards_) {
+            do_accept(shard);
+        }
         
+        // Daemon mode installed it with the other handlers already
+        daemon::Daemon::setup_reload_handler();
         while (running_) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (daemon::Daemon::take_reload_request()) {
+                reload_config();
+            }
         }
         
     } catch (const std::exception& e) {
@@ -1043,18 +1505,22 @@ void Server::stop() {
             ssh_server_.reset();
         }
         
-        if (acceptor_) {
-            asio::error_code ec;
-            acceptor_->close(ec);
-            acceptor_.reset();
+        if (metrics_server_) {
+            metrics_server_->stop();
+            metrics_server_.reset();
         }
         
-        if (event_loop_) {
-            event_loop_->stop();
-            event_loop_.reset();
+        for (auto& shard : accept_shards_) {
+            asio::error_code ec;
+            shard.acceptor->close(ec);
+        }
+        for (auto& shard : accept_shards_) {
+            shard.event_loop->stop();
         }
+        accept_shards_.clear();
         
         cleanup_threads(true); // Still clean up any remaining worker_threads if we had any
+        flush_trace();
         
         LOG_INFO("Server stopped");
     }
@@ -1076,9 +1542,95 @@ void Server::run_as_daemon() {
     start();
 }
 
-void Server::do_accept() {
-    auto socket = std::make_shared<asio::ip::tcp::socket>(event_loop_->get_io_context());
-    acceptor_->async_accept(*socket, [this, socket](const asio::error_code& ec) {
+void Server::open_accept_shards(const asio::ip::tcp::endpoint& endpoint) {
+    const unsigned cpus = (std::max)(1u, std::thread::hardware_concurrency());
+    size_t shards = config_.accept_shards > 0 ? static_cast<size_t>(config_.accept_shards) : cpus;
+#if !defined(__linux__) || !defined(SO_REUSEPORT)
+    // Elsewhere SO_REUSEPORT either does not exist or hands every connection
+    // to one socket, so extra shards would sit idle
+    if (shards > 1) {
+        LOG_WARNING("accept_shards needs Linux SO_REUSEPORT; using a single acceptor");
+        shards = 1;
+    }
+#endif
+    const int backlog = config_.max_connections > 0 ? config_.max_connections : asio::socket_base::max_listen_connections;
+    // Steering by CPU only keeps a connection on the core that received it
+    // when every CPU has its own shard. With fewer shards it would crowd all
+    // connections onto the first few cores, so the kernel's hash spreading
+    // is left to place them instead.
+    const bool pin = config_.pin_accept_shards && shards > 1 && shards == cpus;
+    if (config_.pin_accept_shards && shards > 1 && !pin) {
+        LOG_INFO("Not pinning accept shards: " + std::to_string(shards) + " shards for " +
+                 std::to_string(cpus) + " CPUs");
+    }
+
+    accept_shards_.clear();
+    accept_shards_.resize(shards);
+    for (size_t i = 0; i < shards; ++i) {
+        AcceptShard& shard = accept_shards_[i];
+        if (shards == 1) {
+            shard.event_loop = std::make_unique<network::EventLoop>(config_.max_connections > 0 ? (std::min)(64, config_.max_connections) : std::thread::hardware_concurrency());
+        } else {
+            // One loop thread per shard: it only accepts, connections get
+            // their own threads
+            shard.event_loop = std::make_unique<network::EventLoop>(1);
+            if (pin) {
+                shard.cpu = static_cast<int>(i);
+                shard.event_loop->set_cpu(shard.cpu);
+            }
+        }
+        shard.event_loop->start();
+
+        shard.acceptor = std::make_unique<asio::ip::tcp::acceptor>(shard.event_loop->get_io_context());
+        shard.acceptor->open(endpoint.protocol());
+
+#ifdef _WIN32
+        // On Windows, use exclusive address to prevent multiple servers on same port
+        shard.acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(false));
+#else
+        // On Unix, SO_REUSEADDR helps with quick restarts
+        shard.acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(true));
+#endif
+#if defined(__linux__) && defined(SO_REUSEPORT)
+        if (shards > 1) {
+            shard.acceptor->set_option(asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+        }
+#endif
+
+        shard.acceptor->bind(endpoint);
+        shard.acceptor->listen(backlog);
+    }
+
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+    if (pin) {
+        // Steer each connection to the shard pinned to the CPU that received
+        // it (the NIC queue's IRQ core), so its packets, handshake and
+        // buffers stay on one core. Sockets are indexed in bind order.
+        struct sock_filter code[] = {
+            {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+            {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(shards)},
+            {BPF_RET | BPF_A, 0, 0, 0},
+        };
+        struct sock_fprog program{};
+        program.len = static_cast<unsigned short>(sizeof(code) / sizeof(code[0]));
+        program.filter = code;
+        if (setsockopt(accept_shards_.front().acceptor->native_handle(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                       &program, sizeof(program)) != 0) {
+            LOG_WARNING("Could not attach the per-CPU accept steering program (" + std::string(std::strerror(errno)) +
+                        "); connections are spread by hash");
+        }
+    }
+#endif
+
+    if (shards > 1) {
+        LOG_INFO("Accepting on " + std::to_string(shards) + " SO_REUSEPORT shards" +
+                 (pin ? ", pinned to CPUs" : ""));
+    }
+}
+
+void Server::do_accept(AcceptShard& shard) {
+    auto socket = std::make_shared<asio::ip::tcp::socket>(shard.event_loop->get_io_context());
+    shard.acceptor->async_accept(*socket, [this, &shard, socket](const asio::error_code& ec) {
         if (!running_) return;
         
         if (!ec) {
@@ -1092,7 +1644,12 @@ void Server::do_accept() {
             // async_accept from firing for new parallel-stream connections.
             cleanup_threads();
             auto finished = std::make_shared<std::atomic<bool>>(false);
-            std::thread t([this, client_sock = std::move(client_socket), finished]() mutable {
+            const int cpu = shard.cpu;
+            std::thread t([this, client_sock = std::move(client_socket), finished, cpu]() mutable {
+                // Stay on the shard's core, where the connection's packets arrive
+                if (cpu >= 0) {
+                    common::pin_current_thread_to_cpu(static_cast<unsigned>(cpu));
+                }
                 handle_client(std::move(client_sock));
                 finished->store(true);
             });
@@ -1104,17 +1661,74 @@ void Server::do_accept() {
             LOG_ERROR("Accept error: " + ec.message());
         }
         
-        do_accept();
+        do_accept(shard);
     });
 }
 
 void Server::handle_client(network::Socket client_socket) {
     try {
-        ConnectionHandler handler(std::move(client_socket), config_, crypto_);
+        // The reloaded configuration when there has been a SIGHUP
+        auto config = LiveConfig::instance().snapshot();
+        ConnectionHandler handler(std::move(client_socket), config ? *config : config_, crypto_);
         handler.handle();
     } catch (const std::exception& e) {
         LOG_ERROR("Client handler error: " + std::string(e.what()));
     }
+    flush_trace();
+}
+
+void Server::reload_config() {
+    LOG_INFO("Received SIGHUP, reloading configuration");
+    if (config_file_.empty()) {
+        LOG_WARNING("Reload ignored: the server was not started from a configuration file");
+        return;
+    }
+    config::ServerConfig loaded;
+    try {
+        loaded = config::ServerConfig::load_from_file(config_file_);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Reload failed, keeping the current settings: " + std::string(e.what()));
+        return;
+    }
+
+    for (const auto& name : LiveConfig::restart_only_changes(file_config_, loaded)) {
+        LOG_WARNING("Reload: " + name + " changed in " + config_file_ + " but only applies after a restart");
+    }
+    file_config_ = loaded;
+
+    config::ServerConfig next = config_;
+    LiveConfig::copy_tunables(loaded, next);
+    AdmissionController::instance().configure(next.max_active_streams);
+    MemoryBudget::instance().configure(next.memory_budget_bytes);
+    ChunkCache::instance().configure(next.chunk_cache_bytes);
+    DurableCommitter::instance().configure(next.durable_writes,
+                                           std::chrono::milliseconds(next.durable_commit_window_ms));
+    // config_ is only read on this thread once the server runs; connections
+    // take the published copy
+    config_ = next;
+    LiveConfig::instance().publish(next);
+
+    LOG_INFO("Configuration reloaded from " + config_file_ + ": inflight_window_bytes=" +
+             std::to_string(next.internal.inflight_window_bytes) + ", batch_bytes=" +
+             std::to_string(next.internal.batch_bytes) + ", batch_chunks=" + std::to_string(next.internal.batch_chunks) +
+             ", max_active_streams=" + std::to_string(next.max_active_streams) + ", memory_budget_bytes=" +
+             std::to_string(next.memory_budget_bytes));
+}
+
+void Server::set_trace_output(const std::string& path) {
+    std::lock_guard<std::mutex> lock(trace_output_mutex_);
+    trace_output_ = path;
+}
+
+void Server::flush_trace() {
+    auto& tracer = common::ChunkTracer::instance();
+    std::lock_guard<std::mutex> lock(trace_output_mutex_);
+    if (trace_output_.empty() || !tracer.enabled()) {
+        return;
+    }
+    if (!tracer.write_chrome_trace(trace_output_)) {
+        LOG_WARNING("Failed to write trace file: " + trace_output_);
+    }
 }
 
 void Server::cleanup_threads(bool force_join_all) {
@@ -1134,6 +1748,7 @@ void Server::cleanup_threads(bool force_join_all) {
 }
 
 void ConnectionHandler::handle_download_request(const protocol::DownloadRequest& request) {
+    send_admission_update_if_changed();
     protocol::DownloadResponse resp;
     std::string native_path = common::convert_to_native_path(request.remote_path);
     std::string resolved = file::FileManager::normalize_path(native_path);
@@ -1171,6 +1786,102 @@ void ConnectionHandler::handle_download_request(const protocol::DownloadRequest&
     resp.success = true;
     last_sent_file_hash_valid_ = false;
 
+    // Hot files share content, hashes and compressed blocks across downloads
+    auto& chunk_cache = ChunkCache::instance();
+    ChunkCache::FileKey cache_key;
+    bool use_cache = false;
+    if (!resp.is_directory && !resp.is_symlink && resp.file_size > 0 && chunk_cache.enabled()) {
+        cache_key = ChunkCache::FileKey::of(resolved, resp.file_size);
+        use_cache = !cache_key.path.empty() && chunk_cache.note_download(cache_key);
+    }
+
+    // Ranges to send. In delta mode only blocks whose hash differs from the
+    // client's copy; otherwise everything after the resume point. Holes of a
+    // sparse source become ranges of their own, sent as hole chunks.
+    struct SendRange {
+        uint64_t offset;
+        uint64_t length;
+        bool hole;
+    };
+    std::vector<SendRange> send_ranges;
+    if (!resp.is_directory && !resp.is_symlink) {
+        if (request.delta_block_size > 0 && !request.local_blocks.empty() &&
+            request.resume_offset == 0 && resp.file_size > 0) {
+            try {
+                std::vector<uint8_t> full_hash;
+                std::vector<file::FileManager::BlockHash> blocks;
+                if (!use_cache || !chunk_cache.block_hashes(cache_key, request.delta_block_size, blocks) ||
+                    !chunk_cache.file_hash(cache_key, full_hash)) {
+                    blocks = file::FileManager::compute_block_hashes(resolved, request.delta_block_size, {}, &full_hash);
+                    if (use_cache) {
+                        chunk_cache.store_block_hashes(cache_key, request.delta_block_size, blocks);
+                        chunk_cache.store_file_hash(cache_key, full_hash);
+                    }
+                }
+                for (size_t i = 0; i < blocks.size(); ++i) {
+                    uint64_t length = (std::min)(request.delta_block_size, resp.file_size - blocks[i].offset);
+                    bool same = i < request.local_blocks.size() &&
+                                request.local_blocks[i].offset == blocks[i].offset &&
+                                request.local_blocks[i].hash == blocks[i].hash;
+                    if (same) {
+                        continue;
+                    }
+                    if (!send_ranges.empty() && send_ranges.back().offset + send_ranges.back().length == blocks[i].offset) {
+                        send_ranges.back().length += length;
+                    } else {
+                        send_ranges.push_back({blocks[i].offset, length, false});
+                    }
+                }
+                // The file is only read, so this hash stays valid for the E2E check
+                cached_block_full_hash_ = std::move(full_hash);
+                cached_block_hash_path_ = resolved;
+                cached_block_hash_valid_ = true;
+                resp.delta_applied = true;
+                uint64_t changed = 0;
+                for (const auto& range : send_ranges) {
+                    changed += range.length;
+                }
+                LOG_INFO("Download delta for " + resolved + ": " + std::to_string(changed) + " of " +
+                         std::to_string(resp.file_size) + " bytes changed");
+            } catch (const std::exception& e) {
+                LOG_WARNING("Download delta skipped for " + resolved + ": " + e.what());
+                send_ranges.clear();
+            }
+        }
+        if (!resp.delta_applied && request.resume_offset < resp.file_size) {
+            send_ranges.push_back({request.resume_offset, resp.file_size - request.resume_offset, false});
+        }
+        if (request.accept_sparse && config_.internal.sparse_files && !send_ranges.empty()) {
+            file::FileStream probe;
+            if (probe.open_read(resolved)) {
+                std::vector<SendRange> split;
+                for (const auto& range : send_ranges) {
+                    const uint64_t range_end = range.offset + range.length;
+                    uint64_t cursor = range.offset;
+                    for (const auto& extent : probe.data_extents(range.offset, range_end)) {
+                        if (extent.first > cursor) {
+                            split.push_back({cursor, extent.first - cursor, true});
+                        }
+                        split.push_back({extent.first, extent.second, false});
+                        cursor = extent.first + extent.second;
+                    }
+                    if (cursor < range_end) {
+                        split.push_back({cursor, range_end - cursor, true});
+                    }
+                }
+                resp.sparse = std::any_of(split.begin(), split.end(), [](const SendRange& r) { return r.hole; });
+                if (resp.sparse) {
+                    send_ranges = std::move(split);
+                }
+            }
+        }
+        // Always finish at the end of the file so the client sees the last chunk
+        if (send_ranges.empty() || send_ranges.back().offset + send_ranges.back().length < resp.file_size) {
+            send_ranges.push_back({resp.file_size, 0, false});
+        }
+    }
+    const bool compress = request.accept_compression && common::is_compressible(resolved);
+
     // Create session
     std::string client_ip = get_client_address();
     current_session_ = SessionRegistry::instance().create_session(
@@ -1222,17 +1933,39 @@ void ConnectionHandler::handle_download_request(const protocol::DownloadRequest&
             std::atomic<bool> ack_thread_failed(false);
             std::mutex ack_mutex;
             std::condition_variable ack_cv;
-            uint64_t configured_window_bytes = normalized_window_bytes(config_.internal.inflight_window_bytes);
-            if (config_.internal.tcp_info_window && !client_socket_.is_tls()) {
-                configured_window_bytes = network::windows_experimental::recommended_tcp_inflight_window(
-                    client_socket_.native_handle(),
-                    configured_window_bytes);
-            }
-            const uint64_t max_window_bytes = configured_window_bytes;
-            const uint64_t max_batch_bytes = normalized_batch_bytes(config_.internal.batch_bytes, configured_window_bytes);
-            const size_t max_batch_chunks = normalized_batch_chunks(config_.internal.batch_chunks);
+            uint64_t max_window_bytes = 0;
+            uint64_t max_batch_bytes = 0;
+            size_t max_batch_chunks = 0;
+            // Sized again when a reload changes the tuning mid-download
+            auto size_batches = [&]() {
+                uint64_t configured_window_bytes = normalized_window_bytes(config_.internal.inflight_window_bytes);
+                if (config_.internal.tcp_info_window && !client_socket_.is_tls()) {
+                    configured_window_bytes = network::windows_experimental::recommended_tcp_inflight_window(
+                        client_socket_.native_handle(),
+                        configured_window_bytes);
+                }
+                max_window_bytes = configured_window_bytes;
+                max_batch_bytes = normalized_batch_bytes(config_.internal.batch_bytes, configured_window_bytes);
+                max_batch_chunks = normalized_batch_chunks(config_.internal.batch_chunks);
+            };
+            size_batches();
             crypto::Sha3Hasher download_hasher;
-            bool download_hash_valid = config_.internal.streaming_verification && request.resume_offset == 0;
+            bool download_hash_valid = config_.internal.streaming_verification && request.resume_offset == 0 &&
+                                       !resp.delta_applied && !resp.sparse;
+            // An earlier download of the same file already hashed it
+            std::vector<uint8_t> cached_download_hash;
+            const bool download_hash_cached = download_hash_valid && use_cache &&
+                                              chunk_cache.file_hash(cache_key, cached_download_hash);
+            // Unacknowledged batches keyed by end offset. Delta ranges leave
+            // gaps, so the window counts payload bytes rather than offsets.
+            struct InflightBatch {
+                uint64_t end_offset;
+                uint64_t bytes;
+                std::chrono::steady_clock::time_point sent_at;
+            };
+            std::deque<InflightBatch> inflight_batches;
+            std::mutex inflight_batches_mutex;
+            std::atomic<uint64_t> inflight_bytes(0);
             
             std::thread ack_thread([&]() {
                 try {
@@ -1246,6 +1979,15 @@ void ConnectionHandler::handle_download_request(const protocol::DownloadRequest&
                             break;
                         }
                         
+                        {
+                            auto now = std::chrono::steady_clock::now();
+                            std::lock_guard<std::mutex> lock(inflight_batches_mutex);
+                            while (!inflight_batches.empty() && inflight_batches.front().end_offset <= ack->bytes_received) {
+                                server_metrics().ack_latency.observe_seconds(now - inflight_batches.front().sent_at);
+                                inflight_bytes -= inflight_batches.front().bytes;
+                                inflight_batches.pop_front();
+                            }
+                        }
                         last_acknowledged_offset = ack->bytes_received;
                         ack_cv.notify_all();
                     }
@@ -1255,41 +1997,124 @@ void ConnectionHandler::handle_download_request(const protocol::DownloadRequest&
                 }
             });
 
-            while (offset < file_size && !ack_thread_failed.load()) {
+            size_t range_index = 0;
+            offset = send_ranges.front().offset;
+            while (range_index < send_ranges.size() && !ack_thread_failed.load()) {
+                if (refresh_tuning()) {
+                    size_batches();
+                }
                 {
                     std::unique_lock<std::mutex> lock(ack_mutex);
                     ack_cv.wait(lock, [&]() {
-                        return (offset - last_acknowledged_offset.load()) < max_window_bytes || ack_thread_failed.load();
+                        return inflight_bytes.load() < max_window_bytes || ack_thread_failed.load();
                     });
                 }
                 
                 if (ack_thread_failed.load()) break;
 
+                MemoryBudget::Reservation batch_reservation(max_batch_bytes);
                 protocol::FileData batch_msg;
                 uint64_t batch_bytes = 0;
                 size_t batch_count = 0;
 
-                while (offset < file_size &&
+                while (range_index < send_ranges.size() &&
                        batch_count < max_batch_chunks &&
                        batch_bytes < max_batch_bytes) {
-                    size_t to_read = static_cast<size_t>((std::min)(static_cast<uint64_t>(CHUNK), file_size - offset));
+                    const SendRange& range = send_ranges[range_index];
+                    const uint64_t range_end = range.offset + range.length;
+                    offset = (std::max)(offset, range.offset);
                     protocol::FileData::Chunk chunk;
                     chunk.offset = offset;
-                    chunk.data.resize(to_read);
-                    size_t nr = fs.read(offset, chunk.data.data(), to_read);
+                    chunk.compressed = false;
+                    if (offset >= range_end) {
+                        // Empty end-of-file marker after the last changed range
+                        chunk.uncompressed_size = 0;
+                        chunk.is_last_chunk = true;
+                        ++range_index;
+                        batch_msg.chunks.push_back(std::move(chunk));
+                        break;
+                    }
+                    if (range.hole) {
+                        chunk.hole = true;
+                        chunk.uncompressed_size = range_end - offset;
+                        chunk.is_last_chunk = range_end >= file_size;
+                        offset = range_end;
+                        ++range_index;
+                        ++batch_count;
+                        batch_msg.chunks.push_back(std::move(chunk));
+                        if (batch_msg.chunks.back().is_last_chunk) {
+                            break;
+                        }
+                        continue;
+                    }
+                    size_t to_read = static_cast<size_t>((std::min)(static_cast<uint64_t>(CHUNK), range_end - offset));
+                    ChunkCache::BlockPtr cached_block;
+                    const uint8_t* raw = nullptr;
+                    size_t nr = 0;
+                    if (use_cache) {
+                        // Cut at block boundaries so the chunk is a slice of one cached block
+                        const size_t within = static_cast<size_t>(offset % ChunkCache::kBlockSize);
+                        to_read = (std::min)(to_read, static_cast<size_t>(ChunkCache::kBlockSize) - within);
+                        cached_block = chunk_cache.block(cache_key, offset / ChunkCache::kBlockSize, compress,
+                                                         [&](uint64_t at, uint8_t* out, size_t length) {
+                            common::ScopedMetricTimer timer(server_metrics().read_time);
+                            common::TraceScope trace(common::TraceStage::Read, at, length);
+                            AdmissionController::DiskOperation disk_operation;
+                            return fs.read(at, out, length);
+                        });
+                        if (within < cached_block->data.size()) {
+                            raw = cached_block->data.data() + within;
+                            nr = (std::min)(to_read, cached_block->data.size() - within);
+                        }
+                    } else {
+                        chunk.data.resize(to_read);
+                        {
+                            common::ScopedMetricTimer timer(server_metrics().read_time);
+                            common::TraceScope trace(common::TraceStage::Read, offset, to_read);
+                            AdmissionController::DiskOperation disk_operation;
+                            nr = fs.read(offset, chunk.data.data(), to_read);
+                        }
+                        raw = chunk.data.data();
+                    }
                     if (nr == 0) {
                         break;
                     }
-                    chunk.data.resize(nr);
                     chunk.uncompressed_size = nr;
-                    chunk.compressed = false;
                     chunk.is_last_chunk = (offset + nr >= file_size);
 
-                    if (download_hash_valid) {
-                        download_hasher.update(chunk.data.data(), chunk.data.size());
+                    if (download_hash_valid && !download_hash_cached) {
+                        common::ScopedMetricTimer timer(server_metrics().hash_time);
+                        common::TraceScope trace(common::TraceStage::Hash, chunk.offset, nr);
+                        download_hasher.update(raw, nr);
+                    }
+                    const bool whole_block = cached_block && raw == cached_block->data.data() &&
+                                             nr == cached_block->data.size();
+                    if (cached_block) {
+                        if (compress && whole_block && cached_block->compression_tried && !cached_block->compressed.empty()) {
+                            chunk.data = cached_block->compressed;
+                            chunk.compressed = true;
+                        } else {
+                            chunk.data.assign(raw, raw + nr);
+                        }
+                    } else {
+                        chunk.data.resize(nr);
+                    }
+                    // Same per-chunk rule as uploads: keep the compressed
+                    // form only when it is actually smaller
+                    if (compress && !chunk.compressed && !(whole_block && cached_block->compression_tried)) {
+                        common::ScopedMetricTimer timer(server_metrics().compress_time);
+                        common::TraceScope trace(common::TraceStage::Compress, chunk.offset, nr);
+                        auto compressed_data = common::compress_buffer(chunk.data.data(), nr);
+                        if (compressed_data.size() < nr) {
+                            chunk.data = std::move(compressed_data);
+                            chunk.compressed = true;
+                        }
                     }
 
                     offset += nr;
+                    if (offset >= range_end) {
+                        ++range_index;
+                    }
                     batch_bytes += nr;
                     ++batch_count;
                     batch_msg.chunks.push_back(std::move(chunk));
@@ -1311,13 +2136,26 @@ void ConnectionHandler::handle_download_request(const protocol::DownloadRequest&
                     batch_msg.data = std::move(only.data);
                     batch_msg.compressed = only.compressed;
                     batch_msg.is_last_chunk = only.is_last_chunk;
+                    batch_msg.hole = only.hole;
                 }
 
-                send_message(batch_msg);
+                {
+                    std::lock_guard<std::mutex> lock(inflight_batches_mutex);
+                    inflight_batches.push_back({offset, batch_bytes, std::chrono::steady_clock::now()});
+                    inflight_bytes += batch_bytes;
+                }
+                {
+                    uint64_t first_offset = batch_msg.chunks.empty() ? batch_msg.offset : batch_msg.chunks.front().offset;
+                    common::TraceChunkContext trace_chunk(first_offset, batch_bytes);
+                    send_message(batch_msg);
+                }
                 
                 if (current_session_) {
                     current_session_->bytes_transferred = offset;
                 }
+                if (bytes_sent_metric_) {
+                    bytes_sent_metric_->add(batch_bytes);
+                }
             }
             
             if (ack_thread.joinable()) {
@@ -1334,9 +2172,12 @@ void ConnectionHandler::handle_download_request(const protocol::DownloadRequest&
                 trigger_webhook("download", resolved, request.remote_path, "failed", offset, "Download failed: missing or invalid ACK from client.");
             }
             if (!ack_thread_failed.load() && download_hash_valid && offset >= file_size) {
-                last_sent_file_hash_ = download_hasher.finalize();
+                last_sent_file_hash_ = download_hash_cached ? cached_download_hash : download_hasher.finalize();
                 last_sent_file_hash_path_ = resolved;
                 last_sent_file_hash_valid_ = true;
+                if (use_cache && !download_hash_cached) {
+                    chunk_cache.store_file_hash(cache_key, last_sent_file_hash_);
+                }
             } else {
                 last_sent_file_hash_valid_ = false;
             }
@@ -1420,6 +2261,11 @@ void ConnectionHandler::handle_list_request(const protocol::ListRequest& request
             info.symlink_target = e.symlink_target;
             resp.entries.push_back(std::move(info));
         }
+        resp.version = listing_version(resp.entries);
+        if (request.known_version != 0 && request.known_version == resp.version) {
+            resp.entries.clear();
+            resp.not_modified = true;
+        }
     } catch (const std::exception& e) {
         resp.success = false;
         resp.error_message = e.what();
@@ -1438,10 +2284,23 @@ void ConnectionHandler::handle_file_verify_request(const protocol::FileVerifyReq
             throw FileException("Access denied: " + request.file_path);
         }
         
+        std::string commit_error;
+        auto durability = DurableCommitter::instance().wait(resolved, &commit_error);
+        if (durability == DurableCommitter::State::Failed) {
+            throw FileException("Failed to commit " + resolved + ": " + commit_error);
+        }
+        response.durable = durability == DurableCommitter::State::Durable;
+        
         if (!file::FileManager::exists(resolved)) {
             throw FileException("File not found: " + resolved);
         }
         
+        if (!request.merkle_root.empty()) {
+            response.success = verify_merkle_root(resolved, request, response);
+            send_message(response);
+            return;
+        }
+        
         std::vector<uint8_t> actual_hash;
         if (config_.internal.streaming_verification &&
             last_received_file_hash_valid_ &&
@@ -1491,6 +2350,213 @@ void ConnectionHandler::handle_file_verify_request(const protocol::FileVerifyReq
     send_message(response);
 }
 
+bool ConnectionHandler::verify_merkle_root(const std::string& resolved,
+                                           const protocol::FileVerifyRequest& request,
+                                           protocol::FileVerifyResponse& response) {
+    if (!current_upload_tree_ ||
+        file::FileManager::normalize_path(current_file_path_) != file::FileManager::normalize_path(resolved)) {
+        throw FileException("No Merkle tree for " + resolved);
+    }
+
+    // Only leaves that were written out of order (or were already on disk)
+    // are read back; everything else was hashed as it arrived
+    uint64_t pending = current_upload_tree_->pending_leaves();
+    if (pending > 0) {
+        file::FileStream reader;
+        if (!reader.open_read(resolved, file::FileAccessPattern::Sequential)) {
+            throw FileException("Failed to open file for hashing: " + resolved);
+        }
+        common::ScopedMetricTimer timer(server_metrics().hash_time);
+        bool complete = current_upload_tree_->finish([&](uint64_t offset, uint8_t* out, size_t length) {
+            return reader.read(offset, out, length);
+        });
+        if (!complete) {
+            throw FileException("File is shorter than the uploaded size: " + resolved);
+        }
+    }
+    LOG_INFO("Merkle verification of " + resolved + " re-read " + std::to_string(pending) + " of " +
+             std::to_string(current_upload_tree_->leaf_count()) + " leaves");
+
+    response.merkle_root = current_upload_tree_->root();
+    if (response.merkle_root != request.merkle_root) {
+        // Keep the tree so the client can locate the bad leaves
+        response.error_message = "Integrity check failed: Merkle root mismatch";
+        LOG_ERROR("E2E integrity check failed for " + resolved + " - Merkle root mismatch!");
+        return false;
+    }
+    release_upload_tree(current_file_path_);
+    current_upload_tree_.reset();
+    LOG_INFO("E2E integrity check successful for " + resolved);
+    return true;
+}
+
+void ConnectionHandler::handle_merkle_nodes_request(const protocol::MerkleNodesRequest& request) {
+    constexpr size_t kMaxNodesPerRequest = 1u << 20;
+    protocol::MerkleNodesResponse response;
+
+    try {
+        if (!is_path_allowed(request.file_path)) {
+            throw FileException("Access denied: " + request.file_path);
+        }
+        std::string resolved = resolve_path(request.file_path);
+        if (!current_upload_tree_ ||
+            file::FileManager::normalize_path(current_file_path_) != file::FileManager::normalize_path(resolved)) {
+            throw FileException("No Merkle tree for " + resolved);
+        }
+        if (request.indices.size() > kMaxNodesPerRequest) {
+            throw ProtocolException("Too many Merkle nodes requested");
+        }
+        response.hashes = current_upload_tree_->nodes(request.level, request.indices);
+        response.success = true;
+    } catch (const std::exception& e) {
+        response.success = false;
+        response.error_message = e.what();
+        LOG_ERROR("Merkle node request error: " + std::string(e.what()));
+    }
+
+    send_message(response);
+}
+
+void ConnectionHandler::handle_block_copy_request(const protocol::BlockCopyRequest& request) {
+    protocol::BlockCopyResponse response;
+    response.copied.assign(request.ranges.size(), 0);
+    std::string stage_path;
+
+    try {
+        if (!config_.internal.block_copy) {
+            throw FileException("Server-side block copy is disabled");
+        }
+        if (current_file_path_.empty() || current_is_symlink_ || current_transfer_completed_) {
+            throw FileException("No file transfer in progress");
+        }
+        if (!is_path_allowed(request.source_path)) {
+            throw FileException("Access denied to path: " + request.source_path);
+        }
+        if (!authenticated_user_.empty() && user_db_.is_loaded()) {
+            const auto* user = user_db_.find_user(authenticated_user_);
+            if (user && !user->can_access_path(request.source_path)) {
+                throw FileException("User '" + authenticated_user_ + "' does not have access to: " + request.source_path);
+            }
+        }
+        const std::string source = resolve_path(request.source_path);
+        if (!file::FileManager::is_regular_file(source) || file::FileManager::is_symlink(source)) {
+            throw FileException("Block copy source is not a regular file: " + source);
+        }
+        // A staged upload copies out of the old destination into the
+        // staging file, which is never the same file
+        const bool same_file = file::FileManager::normalize_path(source) ==
+                               file::FileManager::normalize_path(write_path());
+        if (current_truncate_on_zero_) {
+            if (same_file) {
+                throw FileException("Block copy source is being replaced: " + source);
+            }
+            // Truncating when the stream opens would discard the copies
+            file::FileStream truncate_stream;
+            if (!truncate_stream.open_write(write_path(), true, current_auto_create_)) {
+                throw FileException("Failed to truncate destination file for writing: " + write_path());
+            }
+            truncate_stream.close();
+            current_truncate_on_zero_ = false;
+        }
+
+        // Within one file a copy may overwrite the source of another, so
+        // such sources are first staged aside (a reflink where possible)
+        std::vector<uint64_t> staged_offset(request.ranges.size(), UINT64_MAX);
+        if (same_file) {
+            uint64_t stage_size = 0;
+            for (size_t i = 0; i < request.ranges.size(); ++i) {
+                const auto& range = request.ranges[i];
+                bool overlaps = std::any_of(request.ranges.begin(), request.ranges.end(), [&](const protocol::BlockCopyRange& other) {
+                    return range.source_offset < other.target_offset + other.length &&
+                           other.target_offset < range.source_offset + range.length;
+                });
+                if (overlaps && range.source_offset != range.target_offset) {
+                    staged_offset[i] = stage_size;
+                    stage_size += range.length;
+                }
+            }
+            if (stage_size > 0) {
+                stage_path = write_path() + ".netcopy-stage";
+                std::remove(stage_path.c_str());
+                for (size_t i = 0; i < request.ranges.size(); ++i) {
+                    if (staged_offset[i] != UINT64_MAX) {
+                        file::FileManager::copy_range(source, request.ranges[i].source_offset,
+                                                      stage_path, staged_offset[i], request.ranges[i].length);
+                    }
+                }
+            }
+        }
+
+        std::map<file::FileManager::CopyMethod, uint64_t> bytes_by_method;
+        for (size_t i = 0; i < request.ranges.size(); ++i) {
+            const auto& range = request.ranges[i];
+            if (range.length == 0 || range.target_offset + range.length > current_expected_file_size_) {
+                continue;
+            }
+            const bool staged = staged_offset[i] != UINT64_MAX;
+            const std::string& from = staged ? stage_path : source;
+            const uint64_t from_offset = staged ? staged_offset[i] : range.source_offset;
+            {
+                // The source may have changed since the client saw its hashes
+                common::ScopedMetricTimer timer(server_metrics().hash_time);
+                if (file::FileManager::hash_range(from, from_offset, range.length) != range.hash) {
+                    continue;
+                }
+            }
+            if (!same_file || range.source_offset != range.target_offset) {
+                common::ScopedMetricTimer timer(server_metrics().write_time);
+                common::TraceScope trace(common::TraceStage::Write, range.target_offset, range.length);
+                AdmissionController::DiskOperation disk_operation;
+                auto method = file::FileManager::copy_range(from, from_offset, write_path(), range.target_offset, range.length);
+                bytes_by_method[method] += range.length;
+            }
+            if (current_upload_tree_) {
+                current_upload_tree_->invalidate(range.target_offset, range.length);
+            }
+            if (current_journal_) {
+                current_journal_->add_range(range.target_offset, range.length);
+            }
+            response.copied[i] = 1;
+            response.bytes_copied += range.length;
+        }
+        if (!stage_path.empty()) {
+            std::remove(stage_path.c_str());
+            stage_path.clear();
+        }
+
+        if (response.bytes_copied > 0) {
+            // Written behind the stream's back: the linear hash and any
+            // cached whole-file hash no longer describe the file
+            current_upload_hash_valid_ = false;
+            if (cached_block_hash_valid_ &&
+                file::FileManager::normalize_path(cached_block_hash_path_) == file::FileManager::normalize_path(current_file_path_)) {
+                cached_block_hash_valid_ = false;
+            }
+            if (current_journal_) {
+                current_journal_->persist();
+            }
+            server_metrics().block_copy_bytes.add(response.bytes_copied);
+        }
+        LOG_INFO("Block copy into " + current_file_path_ + " from " + source + ": " +
+                 std::to_string(response.bytes_copied) + " bytes (" +
+                 std::to_string(bytes_by_method[file::FileManager::CopyMethod::Reflink]) + " reflinked, " +
+                 std::to_string(bytes_by_method[file::FileManager::CopyMethod::Kernel]) + " in-kernel, " +
+                 std::to_string(bytes_by_method[file::FileManager::CopyMethod::Buffered]) + " buffered)");
+        response.success = true;
+    } catch (const std::exception& e) {
+        if (!stage_path.empty()) {
+            std::remove(stage_path.c_str());
+        }
+        response.success = false;
+        response.error_message = e.what();
+        std::fill(response.copied.begin(), response.copied.end(), 0);
+        response.bytes_copied = 0;
+        LOG_ERROR("Block copy error: " + std::string(e.what()));
+    }
+
+    send_message(response);
+}
+
 void ConnectionHandler::handle_block_hashes_request(const protocol::BlockHashesRequest& request) {
     protocol::BlockHashesResponse response;
     response.success = false;